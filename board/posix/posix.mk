@@ -0,0 +1,73 @@
+###############################################################################
+# 
+# This file is included from root Makefile.
+# Build rules for POSIX host (operating system runs tasks as threads).
+#
+###############################################################################
+#
+# Compiller    GCC
+# Host         Linux
+#
+# Build with "make BOARD=posix". 32-bit code is generated (BASE_TYPE of
+# operating system holds pointers), so 32-bit C library is required.
+#
+###############################################################################
+
+#########################
+#
+# Environment variables used by project itself and libraries.
+#
+#########################
+export PORT = POSIX
+
+#########################
+#
+# Toolchain config
+#
+#########################
+export CC = gcc
+export LD = gcc
+export AR = ar
+export RM = rm -f
+
+CFLAGS += -m32
+CFLAGS += -pthread
+CFLAGS += -g
+CFLAGS += -Wall
+CFLAGS += -DPORT_$(PORT)
+CFLAGS += -DOS_CONFIGURATION_HEADER=\"../../../$(BOARD_DIR)/src/os_config.h\"
+
+LDFLAGS += -m32
+LDFLAGS += -pthread
+
+export CFLAGS
+export LDFLAGS
+
+#########################
+#
+# Directories required to build project. SUBDIRS relative to root directory.
+# NOTE sub-directory with BOARD_DIR should be last (for proper dependencies
+# build).
+#
+#########################
+
+SUBDIRS += lib/misc
+SUBDIRS += lib/os
+SUBDIRS += $(BOARD_DIR)
+
+#########################
+#
+# Custom build targets
+#
+#########################
+
+.PHONY: run
+run: all
+	$(BOARD_DIR)/main
+
+# benchmark of task switch with N blocked and N ready tasks
+BENCH_TASKS = 0 1 2 4 8 16 29
+
+.PHONY: bench
+bench: all
+	for n in $(BENCH_TASKS); do $(BOARD_DIR)/schedbench $$n || exit 1; done
@@ -0,0 +1,112 @@
+/* 
+ *     This file is part of K11, hardware multimedia player.
+ * 
+ * Copyright (C) 2014 Dmitry Kobylin
+ * 
+ * This program is free software: you can redistribute it and/or modify
+ * it under the terms of the GNU General Public License as published by
+ * the Free Software Foundation, either version 3 of the License, or
+ * (at your option) any later version.
+ * 
+ * This program is distributed in the hope that it will be useful,
+ * but WITHOUT ANY WARRANTY; without even the implied warranty of
+ * MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the
+ * GNU General Public License for more details.
+ * 
+ * You should have received a copy of the GNU General Public License
+ * along with this program.  If not, see <http://www.gnu.org/licenses/>.
+ *
+ */
+
+/*
+ * Operating system on POSIX host. Two tasks pass messages through queue,
+ * number of messages passed is printed every second.
+ */
+#include <stdio.h>
+#include <debug.h>
+#include <os.h>
+
+#define TASK_STACK_SIZE    1024
+
+static uint8 ping_stack[TASK_STACK_SIZE];
+static uint8 pong_stack[TASK_STACK_SIZE];
+static uint8 stat_stack[TASK_STACK_SIZE];
+
+static struct os_queue_t *queue;
+static volatile uint32 count;
+
+static void ping_task();
+static void pong_task();
+static void stat_task();
+
+/*
+ * used by dprint()
+ */
+int putChar(int c)
+{
+    return putchar(c);
+}
+
+/*
+ *
+ */
+int main(void)
+{
+    os_init();
+
+    queue = os_queue_init(16, sizeof(BASE_TYPE));
+
+    OS_TASK_INIT("STAT", stat_stack, TASK_STACK_SIZE, 1, stat_task, NULL);
+    OS_TASK_INIT("PING", ping_stack, TASK_STACK_SIZE, 2, ping_task, NULL);
+    OS_TASK_INIT("PONG", pong_stack, TASK_STACK_SIZE, 2, pong_task, NULL);
+
+    os_start();
+
+    return 0;
+}
+
+/*
+ *
+ */
+static void ping_task()
+{
+    BASE_TYPE n;
+
+    n = 0;
+    while (1)
+    {
+        os_queue_add(queue, OS_FLAG_NONE, OS_WAIT_FOREVER, &n, sizeof(n));
+        n++;
+    }
+}
+
+/*
+ *
+ */
+static void pong_task()
+{
+    BASE_TYPE n, len;
+
+    while (1)
+    {
+        os_queue_remove(queue, OS_FLAG_NONE, OS_WAIT_FOREVER, &n, &len);
+        count++;
+    }
+}
+
+/*
+ *
+ */
+static void stat_task()
+{
+    uint32 last;
+
+    last = count;
+    while (1)
+    {
+        os_wait_ms(1000);
+        dprint("s4dn", "messages per second ", count - last);
+        fflush(stdout);
+        last = count;
+    }
+}
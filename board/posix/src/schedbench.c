@@ -0,0 +1,194 @@
+/*
+ *     This file is part of K11, hardware multimedia player.
+ *
+ * Copyright (C) 2014 Dmitry Kobylin
+ *
+ * This program is free software: you can redistribute it and/or modify
+ * it under the terms of the GNU General Public License as published by
+ * the Free Software Foundation, either version 3 of the License, or
+ * (at your option) any later version.
+ *
+ * This program is distributed in the hope that it will be useful,
+ * but WITHOUT ANY WARRANTY; without even the implied warranty of
+ * MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the
+ * GNU General Public License for more details.
+ *
+ * You should have received a copy of the GNU General Public License
+ * along with this program.  If not, see <http://www.gnu.org/licenses/>.
+ *
+ */
+
+/*
+ * Benchmark of task switch versus number of tasks. Two tasks (PING and
+ * PONG) pass control to each other with events, every pass is one switch
+ * of task. Time per switch is measured with N additional tasks:
+ *
+ *     blocked    N tasks wait for event (in wait list of scheduler)
+ *     ready      N tasks are ready, with priority lower than PING/PONG
+ *
+ * Usage:
+ *     schedbench N
+ *
+ * "make BOARD=posix bench" runs benchmark for several N. Time includes
+ * switch of threads by POSIX port, so compare rows of one run (growth with
+ * N), not absolute values with target.
+ */
+#include <stdio.h>
+#include <stdlib.h>
+#include <time.h>
+#include <debug.h>
+#include <os.h>
+
+#define TASK_STACK_SIZE    1024
+/* tasks of benchmark (control, PING, PONG) */
+#define BENCH_TASKS        3
+#define BENCH_MAX_LOAD     (OS_CONFIG_TASK_COUNT - BENCH_TASKS)
+
+#define BENCH_WARMUP_MS    100
+#define BENCH_MEASURE_MS   1000
+
+/* priorities of tasks */
+#define BENCH_PRIO_CTL      0
+#define BENCH_PRIO_PINGPONG 1
+#define BENCH_PRIO_LOAD     2
+
+#define BENCH_EVENT_PING   (1 << 0)
+#define BENCH_EVENT_PONG   (1 << 1)
+#define BENCH_EVENT_START  (1 << 2)
+#define BENCH_EVENT_GATE   (1 << 0)
+
+static uint8 ctl_stack[TASK_STACK_SIZE];
+static uint8 ping_stack[TASK_STACK_SIZE];
+static uint8 pong_stack[TASK_STACK_SIZE];
+static uint8 load_stack[BENCH_MAX_LOAD][TASK_STACK_SIZE];
+
+static BASE_TYPE pingpong;           /* events of PING/PONG */
+static BASE_TYPE gate;               /* load tasks wait for it, raised to make them ready */
+static volatile uint32 rounds;       /* PING -> PONG -> PING passes */
+static int nload;
+
+static void ctl_task();
+static void ping_task();
+static void pong_task();
+static void load_task();
+
+/*
+ * used by dprint()
+ */
+int putChar(int c)
+{
+    return putchar(c);
+}
+
+/*
+ *
+ */
+int main(int argc, char **argv)
+{
+    int i;
+
+    if (argc != 2 || (nload = atoi(argv[1])) < 0 || nload > BENCH_MAX_LOAD)
+    {
+        fprintf(stderr, "usage: %s N, N is 0..%d\n", argv[0], BENCH_MAX_LOAD);
+        return 2;
+    }
+
+    os_init();
+
+    OS_TASK_INIT("CTL",  ctl_stack,  TASK_STACK_SIZE, BENCH_PRIO_CTL,      ctl_task,  NULL);
+    OS_TASK_INIT("PING", ping_stack, TASK_STACK_SIZE, BENCH_PRIO_PINGPONG, ping_task, NULL);
+    OS_TASK_INIT("PONG", pong_stack, TASK_STACK_SIZE, BENCH_PRIO_PINGPONG, pong_task, NULL);
+    for (i = 0; i < nload; i++)
+        OS_TASK_INIT("LOAD", load_stack[i], TASK_STACK_SIZE, BENCH_PRIO_LOAD, load_task, NULL);
+
+    os_start();
+
+    return 0;
+}
+
+/*
+ * RETURN
+ *     nanoseconds of monotonic clock
+ */
+static uint64 bench_ns()
+{
+    struct timespec ts;
+
+    clock_gettime(CLOCK_MONOTONIC, &ts);
+    return ts.tv_sec * 1000000000ULL + ts.tv_nsec;
+}
+
+/*
+ * measure time of switch with current state of load tasks
+ */
+static void bench_measure(char *state)
+{
+    uint64 t;
+    uint32 r;
+
+    t = bench_ns();
+    r = rounds;
+    os_wait_ms(BENCH_MEASURE_MS);
+    t = bench_ns() - t;
+    r = rounds - r;
+
+    /* two switches per round */
+    dprint("s2d_ss4ds4dn", "tasks ", nload, state,
+            " switches ", r * 2, " ns per switch ", r ? (uint32)(t / (r * 2)) : 0);
+    fflush(stdout);
+}
+
+/*
+ *
+ */
+static void ctl_task()
+{
+    /* NOTE load tasks run only while PING waits for start, they block on gate */
+    os_wait_ms(BENCH_WARMUP_MS);
+    os_event_raise(&pingpong, BENCH_EVENT_START);
+    os_wait_ms(BENCH_WARMUP_MS);
+    bench_measure("blocked");
+
+    /* load tasks leave wait, they are never run while PING or PONG is ready */
+    os_event_raise(&gate, BENCH_EVENT_GATE);
+    os_wait_ms(BENCH_WARMUP_MS);
+    bench_measure("ready  ");
+
+    exit(0);
+}
+
+/*
+ *
+ */
+static void ping_task()
+{
+    os_event_wait(&pingpong, BENCH_EVENT_START, OS_FLAG_CLEAR, OS_WAIT_FOREVER);
+    while (1)
+    {
+        os_event_raise(&pingpong, BENCH_EVENT_PONG);
+        os_event_wait(&pingpong, BENCH_EVENT_PING, OS_FLAG_CLEAR, OS_WAIT_FOREVER);
+        rounds++;
+    }
+}
+
+/*
+ *
+ */
+static void pong_task()
+{
+    while (1)
+    {
+        os_event_wait(&pingpong, BENCH_EVENT_PONG, OS_FLAG_CLEAR, OS_WAIT_FOREVER);
+        os_event_raise(&pingpong, BENCH_EVENT_PING);
+    }
+}
+
+/*
+ *
+ */
+static void load_task()
+{
+    os_event_wait(&gate, BENCH_EVENT_GATE, OS_FLAG_NONE, OS_WAIT_FOREVER);
+    while (1)
+        ;
+}
@@ -9,7 +9,8 @@ src/main.o: src/main.c ../../lib/misc/src/debug.h ../../lib/lpc17xx/types.h \
  ../../lib/os/src/os_queue.h ../../lib/os/src/os_mem.h \
  ../../lib/os/src/os_multi.h src/osw_objects.h src/net/net.h \
  src/net/net_def.h src/net/../eth_def.h src/net/net_def.h src/version.h
-src/it.o: src/it.c
+src/it.o: src/it.c \
+ ../../lib/misc/src/debug.h ../../lib/mlpc17xx/src/uart.h ../../lib/lpc17xx/LPC177x_8x.h
 src/startup.o: src/startup.c src/startup.h
 src/gtask.o: src/gtask.c ../../lib/os/src/os.h ../../lib/lpc17xx/types.h \
  ../../lib/os/src/os_config.h \
@@ -38,7 +39,17 @@ src/osw_objects.o: src/osw_objects.c ../../lib/os/src/os.h \
  src/player/../fat_io_lib/fat_access.h \
  src/player/../fat_io_lib/fat_defs.h src/player/../fat_io_lib/fat_types.h \
  src/player/../fat_io_lib/fat_list.h src/sdcard/sdcard.h \
- src/sdcard/sdcard_hw.h src/buttons.h src/vs1053b/decoder.h src/gpioirq.h
+ src/sdcard/sdcard_hw.h src/buttons.h src/vs1053b/decoder.h src/gpioirq.h \
+ ../../lib/lpc17xx/LPC177x_8x.h ../../lib/lpc17xx/core_cm3.h ../../lib/lpc17xx/LPC177x_8x_bits.h src/irqp.h \
+ ../../lib/os/src/os_pool.h \
+ ../../lib/os/src/os_rmutex.h \
+ ../../lib/os/src/os_trace.h \
+ ../../lib/os/src/os_cpustat.h \
+ src/gui/gsload.h \
+ ../../lib/os/src/os_irqstat.h \
+ ../../lib/os/src/os_timer.h ../../lib/os/src/os_work.h ../../lib/os/src/os_mbox.h \
+ src/osw_stack.h \
+ ../../lib/mlpc17xx/src/uart.h
 src/eth.o: src/eth.c ../../lib/lpc17xx/LPC177x_8x.h \
  ../../lib/lpc17xx/core_cm3.h ../../lib/lpc17xx/LPC177x_8x_bits.h \
  ../../lib/misc/src/debug.h ../../lib/lpc17xx/types.h \
@@ -49,7 +60,10 @@ src/eth.o: src/eth.c ../../lib/lpc17xx/LPC177x_8x.h \
  ../../lib/os/src/os_queue.h ../../lib/os/src/os_mem.h \
  ../../lib/os/src/os_multi.h src/osw_objects.h src/net/net.h \
  src/net/net_def.h src/net/../eth_def.h src/net/net_def.h src/irqp.h \
- src/eth.h src/eth_def.h
+ src/eth.h src/eth_def.h \
+ ../../lib/os/src/os_cpustat.h \
+ ../../lib/os/src/os_irqstat.h \
+ ../../lib/os/src/os_timer.h ../../lib/os/src/os_work.h ../../lib/os/src/os_mbox.h
 src/net/net.o: src/net/net.c ../../lib/mlpc17xx/src/stimer.h \
  ../../lib/lpc17xx/types.h ../../lib/misc/src/debug.h src/net/../eth.h \
  src/net/net.h src/net/net_def.h src/net/../eth_def.h \
@@ -60,7 +74,9 @@ src/net/net.o: src/net/net.c ../../lib/mlpc17xx/src/stimer.h \
  ../../lib/os/src/os_multi.h src/net/arp.h src/net/udp.h src/net/ipv4.h \
  src/net/icmp.h src/net/../osw_objects.h src/net/../net/net.h \
  src/net/../net/net_def.h src/net/../upload.h src/net/../usbdev/usbdev.h \
- src/net/../usbdev/usbdev_hw.h src/net/../upload_shared.h
+ src/net/../usbdev/usbdev_hw.h src/net/../upload_shared.h \
+ ../../lib/os/src/os_pool.h \
+ ../../lib/os/src/os_timer.h ../../lib/os/src/os_work.h ../../lib/os/src/os_mbox.h
 src/net/net_def.o: src/net/net_def.c src/net/net_def.h ../../lib/lpc17xx/types.h \
  src/net/../eth_def.h
 src/net/udp.o: src/net/udp.c ../../lib/misc/src/debug.h ../../lib/lpc17xx/types.h \
@@ -113,7 +129,12 @@ src/dma.o: src/dma.c ../../lib/lpc17xx/LPC177x_8x.h \
  ../../lib/os/src/../../../board/sk-mlpc1788/src/os_config.h \
  ../../lib/os/src/os_flags.h ../../lib/os/src/os_bitobj.h \
  ../../lib/os/src/os_queue.h ../../lib/os/src/os_mem.h \
- ../../lib/os/src/os_multi.h src/irqp.h src/dma.h
+ ../../lib/os/src/os_multi.h src/irqp.h src/dma.h \
+ ../../lib/os/src/os_trace.h \
+ ../../lib/os/src/os_cpustat.h \
+ ../../lib/os/src/os_irqstat.h \
+ ../../lib/os/src/os_timer.h ../../lib/os/src/os_work.h ../../lib/os/src/os_mbox.h \
+ ../../lib/mlpc17xx/src/uart.h
 src/gs/gs.o: src/gs/gs.c ../../lib/misc/src/debug.h ../../lib/lpc17xx/types.h \
  ../../lib/os/src/os.h ../../lib/os/src/os_config.h \
  ../../lib/os/src/../../../board/sk-mlpc1788/src/os_config.h \
@@ -139,7 +160,9 @@ src/gs/gsp.o: src/gs/gsp.c ../../lib/lpc17xx/clk_cfg.h \
  src/gs/gs_util.h src/gs/gs_widget.h src/gs/widget/gs_wlist.h \
  src/gs/widget/../gs.h src/gs/widget/gs_wpbar.h src/gs/widget/gs_wtext.h \
  src/gs/widget/gs_wpixmap.h src/gs/widget/gs_wvolume.h src/gs/../dma.h \
- src/gs/../irqp.h
+ src/gs/../irqp.h \
+ ../../lib/os/src/os_trace.h ../../lib/os/src/os_cpustat.h ../../lib/os/src/os_irqstat.h \
+ ../../lib/os/src/os_timer.h ../../lib/os/src/os_work.h ../../lib/os/src/os_mbox.h
 src/gs/gs_font.o: src/gs/gs_font.c src/gs/gs.h ../../lib/lpc17xx/types.h \
  src/gs/gs_font.h src/gs/gs_config.h src/gs/gs_text.h src/gs/gs_image.h \
  src/gs/gs_prim.h src/gs/gs_util.h src/gs/gs_widget.h \
@@ -252,7 +275,9 @@ src/buttons.o: src/buttons.c ../../lib/lpc17xx/LPC177x_8x.h \
  src/player/../fat_io_lib/fat_opts.h \
  src/player/../fat_io_lib/fat_access.h \
  src/player/../fat_io_lib/fat_defs.h src/player/../fat_io_lib/fat_types.h \
- src/player/../fat_io_lib/fat_list.h src/gpioirq.h
+ src/player/../fat_io_lib/fat_list.h src/gpioirq.h \
+ ../../lib/os/src/os_pt.h \
+ ../../lib/os/src/os_timer.h ../../lib/os/src/os_work.h ../../lib/os/src/os_mbox.h
 src/gpioirq.o: src/gpioirq.c ../../lib/lpc17xx/LPC177x_8x.h \
  ../../lib/lpc17xx/core_cm3.h ../../lib/lpc17xx/LPC177x_8x_bits.h \
  ../../lib/misc/src/debug.h ../../lib/lpc17xx/types.h \
@@ -261,10 +286,32 @@ src/gpioirq.o: src/gpioirq.c ../../lib/lpc17xx/LPC177x_8x.h \
  ../../lib/os/src/os_flags.h ../../lib/os/src/os_bitobj.h \
  ../../lib/os/src/os_queue.h ../../lib/os/src/os_mem.h \
  ../../lib/os/src/os_multi.h src/gpioirq.h src/irqp.h src/buttons.h \
- src/vs1053b/vs1053b_hw.h
+ src/vs1053b/vs1053b_hw.h \
+ ../../lib/os/src/os_trace.h \
+ ../../lib/os/src/os_cpustat.h \
+ ../../lib/os/src/os_irqstat.h \
+ ../../lib/os/src/os_timer.h ../../lib/os/src/os_work.h ../../lib/os/src/os_mbox.h
 src/nvram.o: src/nvram.c ../../lib/lpc17xx/LPC177x_8x.h \
  ../../lib/lpc17xx/core_cm3.h ../../lib/lpc17xx/LPC177x_8x_bits.h \
  ../../lib/misc/src/debug.h ../../lib/lpc17xx/types.h src/nvram.h
+src/gui/gsload.o: src/gui/gsload.c ../../lib/os/src/os.h \
+ ../../lib/lpc17xx/types.h ../../lib/os/src/os_config.h \
+ ../../lib/os/src/../../../board/sk-mlpc1788/src/os_config.h \
+ ../../lib/os/src/os_flags.h ../../lib/os/src/os_bitobj.h \
+ ../../lib/os/src/os_rmutex.h ../../lib/os/src/os_queue.h \
+ ../../lib/os/src/os_mem.h ../../lib/os/src/os_multi.h \
+ ../../lib/os/src/os_pool.h ../../lib/os/src/os_pt.h \
+ ../../lib/os/src/os_trace.h ../../lib/os/src/os_cpustat.h \
+ ../../lib/misc/src/debug.h src/gui/gsload.h src/gui/../gs/gs.h \
+ src/gui/../gs/gs_font.h src/gui/../gs/gs_config.h \
+ src/gui/../gs/gs_text.h src/gui/../gs/gs_image.h src/gui/../gs/gs.h \
+ src/gui/../gs/gs_prim.h src/gui/../gs/gs_util.h \
+ src/gui/../gs/gs_widget.h src/gui/../gs/widget/gs_wlist.h \
+ src/gui/../gs/widget/../gs.h src/gui/../gs/widget/gs_wpbar.h \
+ src/gui/../gs/widget/gs_wtext.h src/gui/../gs/widget/gs_wpixmap.h \
+ src/gui/../gs/widget/gs_wvolume.h \
+ ../../lib/os/src/os_irqstat.h \
+ ../../lib/os/src/os_timer.h ../../lib/os/src/os_work.h ../../lib/os/src/os_mbox.h
 src/usbdev/usbdev.o: src/usbdev/usbdev.c ../../lib/os/src/os.h \
  ../../lib/lpc17xx/types.h ../../lib/os/src/os_config.h \
  ../../lib/os/src/../../../board/sk-mlpc1788/src/os_config.h \
@@ -273,7 +320,8 @@ src/usbdev/usbdev.o: src/usbdev/usbdev.c ../../lib/os/src/os.h \
  ../../lib/os/src/os_multi.h ../../lib/misc/src/debug.h \
  src/usbdev/../upload.h src/usbdev/../usbdev/usbdev.h \
  src/usbdev/../usbdev/usbdev_hw.h src/usbdev/../upload_shared.h \
- src/usbdev/usbdev.h src/usbdev/usbdev_proto.h
+ src/usbdev/usbdev.h src/usbdev/usbdev_proto.h \
+ ../../lib/os/src/os_work.h ../../lib/os/src/os_mbox.h
 src/usbdev/usbdev_hw.o: src/usbdev/usbdev_hw.c ../../lib/lpc17xx/LPC177x_8x.h \
  ../../lib/lpc17xx/core_cm3.h ../../lib/lpc17xx/LPC177x_8x_bits.h \
  ../../lib/mlpc17xx/src/gpio.c ../../lib/mlpc17xx/src/gpio.h \
@@ -284,7 +332,10 @@ src/usbdev/usbdev_hw.o: src/usbdev/usbdev_hw.c ../../lib/lpc17xx/LPC177x_8x.h \
  ../../lib/os/src/os_queue.h ../../lib/os/src/os_mem.h \
  ../../lib/os/src/os_multi.h ../../lib/misc/src/debug.h \
  src/usbdev/../irqp.h src/usbdev/usbdev.h src/usbdev/usbdev_hw.h \
- src/usbdev/usbdev_proto.h
+ src/usbdev/usbdev_proto.h \
+ ../../lib/os/src/os_cpustat.h \
+ ../../lib/os/src/os_irqstat.h \
+ ../../lib/os/src/os_timer.h ../../lib/os/src/os_work.h ../../lib/os/src/os_mbox.h
 src/usbdev/usbdev_proto.o: src/usbdev/usbdev_proto.c ../../lib/misc/src/debug.h \
  ../../lib/lpc17xx/types.h src/usbdev/usbdev.h ../../lib/os/src/os.h \
  ../../lib/os/src/os_config.h \
@@ -318,7 +369,9 @@ src/player/player.o: src/player/player.c ../../lib/misc/src/debug.h \
  src/player/../gs/widget/gs_wvolume.h src/player/../sdcard/sdcard.h \
  src/player/../sdcard/sdcard_hw.h src/player/../image/image.h \
  src/player/../buttons.h src/player/../vs1053b/vs1053b.h \
- src/player/../vs1053b/decoder.h src/player/../nvram.h
+ src/player/../vs1053b/decoder.h src/player/../nvram.h \
+ ../../lib/os/src/os_rmutex.h \
+ ../../lib/os/src/os_timer.h ../../lib/os/src/os_work.h ../../lib/os/src/os_mbox.h
 src/player/player_bartist.o: src/player/player_bartist.c ../../lib/lpc17xx/types.h \
  ../../lib/misc/src/debug.h src/player/player_bartist.h \
  src/player/player.h ../../lib/os/src/os.h ../../lib/os/src/os_config.h \
@@ -392,7 +445,9 @@ src/vs1053b/decoder.o: src/vs1053b/decoder.c ../../lib/os/src/os.h \
  src/vs1053b/../player/../fat_io_lib/fat_defs.h \
  src/vs1053b/../player/../fat_io_lib/fat_types.h \
  src/vs1053b/../player/../fat_io_lib/fat_list.h \
- src/vs1053b/../fat_io_lib/fat_filelib.h
+ src/vs1053b/../fat_io_lib/fat_filelib.h \
+ ../../lib/os/src/os_trace.h \
+ ../../lib/os/src/os_timer.h ../../lib/os/src/os_work.h ../../lib/os/src/os_mbox.h
 src/vs1053b/vs1053b.o: src/vs1053b/vs1053b.c ../../lib/misc/src/debug.h \
  ../../lib/lpc17xx/types.h ../../lib/os/src/os.h \
  ../../lib/os/src/os_config.h \
@@ -418,7 +473,11 @@ src/vs1053b/vs1053b_hw.o: src/vs1053b/vs1053b_hw.c ../../lib/misc/src/debug.h \
  ../../lib/os/src/os_queue.h ../../lib/os/src/os_mem.h \
  ../../lib/os/src/os_multi.h ../../lib/mlpc17xx/src/gpio.h \
  ../../lib/mlpc17xx/src/gpio.h ../../lib/mlpc17xx/src/stimer.h \
- src/vs1053b/../irqp.h src/vs1053b/vs1053b_hw.h
+ src/vs1053b/../irqp.h src/vs1053b/vs1053b_hw.h \
+ ../../lib/os/src/os_trace.h \
+ ../../lib/os/src/os_cpustat.h \
+ ../../lib/os/src/os_irqstat.h \
+ ../../lib/os/src/os_timer.h ../../lib/os/src/os_work.h ../../lib/os/src/os_mbox.h
 src/sdcard/sdcard.o: src/sdcard/sdcard.c ../../lib/lpc17xx/LPC177x_8x.h \
  ../../lib/lpc17xx/core_cm3.h ../../lib/misc/src/debug.h \
  ../../lib/lpc17xx/types.h ../../lib/os/src/os.h \
@@ -442,13 +501,19 @@ src/sdcard/sdcard_hw.o: src/sdcard/sdcard_hw.c ../../lib/lpc17xx/LPC177x_8x.h \
  ../../lib/os/src/os_multi.h ../../lib/misc/src/debug.h \
  ../../lib/mlpc17xx/src/gpio.h ../../lib/mlpc17xx/src/gpio.h \
  src/sdcard/sdcard.h src/sdcard/sdcard_hw.h src/sdcard/../dma.h \
- src/sdcard/../irqp.h
+ src/sdcard/../irqp.h \
+ ../../lib/os/src/os_trace.h \
+ ../../lib/os/src/os_cpustat.h \
+ ../../lib/os/src/os_irqstat.h \
+ ../../lib/os/src/os_timer.h ../../lib/os/src/os_work.h ../../lib/os/src/os_mbox.h
 src/fat_io_lib/fat_access.o: src/fat_io_lib/fat_access.c ../../lib/misc/src/debug.h \
  ../../lib/lpc17xx/types.h src/fat_io_lib/fat_defs.h \
  src/fat_io_lib/fat_opts.h src/fat_io_lib/fat_types.h \
  src/fat_io_lib/fat_access.h src/fat_io_lib/fat_table.h \
  src/fat_io_lib/fat_misc.h src/fat_io_lib/fat_write.h \
- src/fat_io_lib/fat_string.h
+ src/fat_io_lib/fat_string.h \
+ src/fat_io_lib/fat_wcache.h \
+ src/fat_io_lib/fat_exfat.h
 src/fat_io_lib/fat_cache.o: src/fat_io_lib/fat_cache.c src/fat_io_lib/fat_cache.h \
  src/fat_io_lib/fat_filelib.h src/fat_io_lib/fat_opts.h \
  src/fat_io_lib/fat_access.h src/fat_io_lib/fat_defs.h \
@@ -461,7 +526,8 @@ src/fat_io_lib/fat_filelib.o: src/fat_io_lib/fat_filelib.c ../../lib/misc/src/de
  src/fat_io_lib/fat_misc.h src/fat_io_lib/fat_write.h \
  src/fat_io_lib/fat_string.h src/fat_io_lib/fat_filelib.h \
  src/fat_io_lib/fat_list.h src/fat_io_lib/fat_cache.h \
- src/fat_io_lib/fat_list2.h
+ src/fat_io_lib/fat_list2.h \
+ src/fat_io_lib/fat_wcache.h
 src/fat_io_lib/fat_format.o: src/fat_io_lib/fat_format.c src/fat_io_lib/fat_defs.h \
  src/fat_io_lib/fat_opts.h src/fat_io_lib/fat_types.h \
  ../../lib/lpc17xx/types.h src/fat_io_lib/fat_access.h \
@@ -475,12 +541,23 @@ src/fat_io_lib/fat_string.o: src/fat_io_lib/fat_string.c src/fat_io_lib/fat_stri
 src/fat_io_lib/fat_table.o: src/fat_io_lib/fat_table.c src/fat_io_lib/fat_defs.h \
  src/fat_io_lib/fat_opts.h src/fat_io_lib/fat_types.h \
  ../../lib/lpc17xx/types.h src/fat_io_lib/fat_access.h \
- src/fat_io_lib/fat_table.h src/fat_io_lib/fat_misc.h
+ src/fat_io_lib/fat_table.h src/fat_io_lib/fat_misc.h \
+ src/fat_io_lib/fat_wcache.h \
+ src/fat_io_lib/fat_exfat.h
 src/fat_io_lib/fat_write.o: src/fat_io_lib/fat_write.c src/fat_io_lib/fat_defs.h \
  src/fat_io_lib/fat_opts.h src/fat_io_lib/fat_types.h \
  ../../lib/lpc17xx/types.h src/fat_io_lib/fat_access.h \
  src/fat_io_lib/fat_table.h src/fat_io_lib/fat_misc.h \
  src/fat_io_lib/fat_write.h src/fat_io_lib/fat_string.h
+src/fat_io_lib/fat_exfat.o: src/fat_io_lib/fat_exfat.c \
+ src/fat_io_lib/fat_defs.h src/fat_io_lib/fat_opts.h \
+ src/fat_io_lib/fat_types.h ../../lib/lpc17xx/types.h \
+ src/fat_io_lib/fat_access.h src/fat_io_lib/fat_exfat.h
+src/fat_io_lib/fat_wcache.o: src/fat_io_lib/fat_wcache.c \
+ ../../lib/misc/src/debug.h ../../lib/lpc17xx/types.h \
+ ../../lib/mlpc17xx/src/stimer.h src/fat_io_lib/fat_defs.h \
+ src/fat_io_lib/fat_opts.h src/fat_io_lib/fat_types.h \
+ src/fat_io_lib/fat_access.h src/fat_io_lib/fat_wcache.h
 src/image/pcx.o: src/image/pcx.c ../../lib/lpc17xx/types.h \
  ../../lib/misc/src/debug.h src/image/pcx.h
 src/image/image.o: src/image/image.c ../../lib/misc/src/debug.h \
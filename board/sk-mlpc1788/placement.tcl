@@ -0,0 +1,100 @@
+#
+# report where code and data of program landed (on-chip SRAM, SDRAM, flash)
+#
+# Usage:
+#     tclsh placement.tcl nm program.out report.txt
+#
+# Summary (code and data bytes per memory) is printed, report lists every
+# symbol by memory and address. Memories are taken from src/lpc17xx.ld, hot
+# paths are placed to SRAM by OS_RAMFUNC, OS_FASTDATA and OS_FASTBSS.
+#
+
+# name, start, size
+set place_mems {
+    SRAM    0x10000000 0x10000
+    AHBSRAM 0x20000000 0x8000
+    SDRAM   0xA0000000 0x2000000
+    FLASH   0x00000000 0x80000
+}
+
+proc place_mem {addr} {
+    global place_mems
+
+    foreach {name start size} $place_mems {
+        if {$addr >= $start && $addr < $start + $size} {
+            return $name
+        }
+    }
+    return {}
+}
+
+#
+# kind of symbol by type of nm
+#
+proc place_kind {type} {
+    switch -- [string tolower $type] {
+        t - w   { return code }
+        r       { return rodata }
+        d       { return data }
+        b - v   { return bss }
+    }
+    return {}
+}
+
+proc placement {nm elf out} {
+    global place_mems
+
+    set syms {}
+    foreach line [split [exec $nm -S -n --defined-only $elf] "\n"] {
+        # symbols without size (labels, linker script symbols) are skipped
+        if {[llength $line] != 4} {
+            continue
+        }
+        lassign $line addr size type name
+        set addr [expr {"0x$addr"}]
+        set size [expr {"0x$size"}]
+        set kind [place_kind $type]
+        set mem  [place_mem $addr]
+        if {$kind eq "" || $mem eq "" || !$size} {
+            continue
+        }
+        lappend syms [list $mem $addr $size $kind $name]
+        if {![info exists total($mem,$kind)]} {
+            set total($mem,$kind) 0
+        }
+        incr total($mem,$kind) $size
+    }
+
+    puts [format "%-8s %9s %9s %9s %9s" memory code rodata data bss]
+    foreach {name start size} $place_mems {
+        set l [format "%-8s" $name]
+        foreach kind {code rodata data bss} {
+            if {[info exists total($name,$kind)]} {
+                append l [format " %9d" $total($name,$kind)]
+            } else {
+                append l [format " %9d" 0]
+            }
+        }
+        puts $l
+    }
+
+    set fd [open $out w]
+    foreach {name start size} $place_mems {
+        puts $fd "$name:"
+        foreach s $syms {
+            lassign $s mem addr size kind sym
+            if {$mem eq $name} {
+                puts $fd [format "    0x%08X %8d %-6s %s" $addr $size $kind $sym]
+            }
+        }
+    }
+    close $fd
+}
+
+if {[info exists argv0] && [file tail $argv0] eq [file tail [info script]]} {
+    if {[llength $argv] != 3} {
+        puts stderr "usage: tclsh placement.tcl nm program.out report.txt"
+        exit 1
+    }
+    placement {*}$argv
+}
@@ -38,6 +38,7 @@ export AS = $(TOOLCHAIN)-as
 export CP = $(TOOLCHAIN)-objcopy
 export OD = $(TOOLCHAIN)-objdump
 export SZ = $(TOOLCHAIN)-size
+export NM = $(TOOLCHAIN)-nm
 export RM = rm -f
 
 # XXX
@@ -48,9 +49,16 @@ CFLAGS += -mthumb
 CFLAGS += -mcpu=cortex-m3
 CFLAGS += -g
 CFLAGS += -Wall
+# inline functions of os.h (os_disable_irq()) have GNU89 semantics, C99 is
+# default since GCC 5
+CFLAGS += -fgnu89-inline
 CFLAGS += -DPORT_$(PORT)
 CFLAGS += -DMCU_$(MCU)
 CFLAGS += -DOS_CONFIGURATION_HEADER=\"../../../$(BOARD_DIR)/src/os_config.h\"
+ifeq ($(STACK_USAGE), 1)
+    CFLAGS += -fstack-usage
+    CFLAGS += -fcallgraph-info=su
+endif
 
 LDFLAGS += -nostartfiles
 LDFLAGS += -mcpu=cortex-m3
@@ -82,7 +90,7 @@ SUBDIRS += $(BOARD_DIR)
 #
 #########################
 
-.PHONY: prog list image debug
+.PHONY: prog list image debug stack
 prog: all
 	$(TCL_SHELL) $(UTIL_PATH)/mforeach.tcl $(BOARD_DIR) prog
 
@@ -95,3 +103,6 @@ image: all
 debug: all
 	$(TCL_SHELL) $(UTIL_PATH)/mforeach.tcl $(BOARD_DIR) debug
 
+stack: all
+	$(TCL_SHELL) $(UTIL_PATH)/mforeach.tcl $(BOARD_DIR) stack
+
@@ -77,14 +77,35 @@ struct button_t {
 #define BUTTON_CHECK_TO     20
 #define BUTTON_CHECK_COUNT  5
 #define BUTTON_REPEAT_TO    200
-    int state;
+    int state;    /* number of samples with pressed button */
     const struct gpio_t *pg;
 };
 
 static struct button_t button[BUTTON_COUNT];
 
-static void check_buttons();
-static void check_encoder();
+/*
+ * While some button is pressed buttons are sampled by timer every
+ * BUTTON_CHECK_TO, code of pressed buttons is decided by majority of
+ * BUTTON_CHECK_COUNT samples.
+ */
+static struct os_timer_t btimer;
+#define BUTTONS_EVENT_SAMPLED    (1 << 0)
+static BASE_TYPE bevent;
+static int bsamples;           /* number of samples taken */
+static uint32 bcode;           /* code of pressed buttons of last BUTTON_CHECK_COUNT samples */
+
+static void sample_buttons(void *arg);
+
+/*
+ * Buttons and encoder are serviced by protothreads hosted by this task,
+ * so encoder is not blocked while buttons are debounced.
+ */
+static struct os_pt_host_t pthost;
+static struct os_pt_t ptbuttons;
+static struct os_pt_t ptencoder;
+
+static BASE_TYPE check_buttons(struct os_pt_t *pt);
+static BASE_TYPE check_encoder(struct os_pt_t *pt);
 
 /*
  *
@@ -105,138 +126,170 @@ void buttons_task()
     button[4].code = BUTTON_ENTER;
     button[5].code = BUTTON_BACK;
 
+    os_timer_init(&btimer, sample_buttons, NULL);
+
     /* take some pause for initialization of player message queue */
     os_event_wait(&player.event, PLAYER_EVENT_INIT, OS_FLAG_NONE, OS_WAIT_FOREVER);
 
-    while (1)
-    {
-        os_event_wait(&gpioirq.evirq, GPIOIRQ_EVENT_BUTTON | GPIOIRQ_EVENT_ENCODER, OS_FLAG_NONE, OS_WAIT_FOREVER);
+    os_pt_host_init(&pthost, 2, 0);
+    os_pt_start(&pthost, &ptbuttons, check_buttons, NULL);
+    os_pt_start(&pthost, &ptencoder, check_encoder, NULL);
 
-        if (os_event_wait(&gpioirq.evirq, GPIOIRQ_EVENT_BUTTON,
-                    OS_FLAG_NOWAIT | OS_FLAG_CLEAR, OS_WAIT_FOREVER) == OS_ERR_NONE)
-        {
-            check_buttons();
-        } else if (os_event_wait(&gpioirq.evirq, GPIOIRQ_EVENT_ENCODER,
-                    OS_FLAG_NOWAIT | OS_FLAG_CLEAR, OS_WAIT_FOREVER) == OS_ERR_NONE) {
-            check_encoder();
-        }
+    os_pt_host_run(&pthost);
+}
+
+/*
+ * Called from interrupt of timer.
+ */
+static void sample_buttons(void *arg)
+{
+    uint32 code;
+    int i;
+
+    for (i = 0; i < BUTTON_COUNT; i++)
+        if (BPRESSED(&button[i]))
+            button[i].state++;
+
+    if (++bsamples < BUTTON_CHECK_COUNT)
+        return;
+
+    code = 0;
+    for (i = 0; i < BUTTON_COUNT; i++)
+    {
+        if (button[i].state > (BUTTON_CHECK_COUNT / 2))
+            code |= button[i].code;
+        button[i].state = 0;
     }
+    bsamples = 0;
+    bcode    = code;
+    os_event_raise(&bevent, BUTTONS_EVENT_SAMPLED);
 }
 
 /*
  *
  */
-static void
-check_buttons()
+static BASE_TYPE
+check_buttons(struct os_pt_t *pt)
 {
-    int i, n, fpress;
-    uint32 code;
+    /* NOTE static, should be kept across waits of protothread */
+    static int fpress;
+    static uint32 code;
+    static uint32 timeout;
     struct player_msg_t msg;
-    uint32 timeout;
+    int i;
+
+    OS_PT_BEGIN(pt);
+    while (1)
+    {
+        OS_PT_WAIT_EVENT(pt, &gpioirq.evirq, GPIOIRQ_EVENT_BUTTON, OS_FLAG_CLEAR, OS_WAIT_FOREVER);
 
-    fpress = 1;
-    do {
-        code = 0;
+        /* NOTE timer is stopped */
         for (i = 0; i < BUTTON_COUNT; i++)
             button[i].state = 0;
+        bsamples = 0;
+        os_event_clear(&bevent, BUTTONS_EVENT_SAMPLED);
+        os_timer_start_ms(&btimer, BUTTON_CHECK_TO, BUTTON_CHECK_TO);
 
-        n = BUTTON_CHECK_COUNT;
-        while (n--)
-        {
-            os_wait_ms(BUTTON_CHECK_TO);
-            for (i = 0; i < BUTTON_COUNT; i++)
-                if (BPRESSED(&button[i]))
-                    button[i].state++;
-        }
-
-        for (i = 0; i < BUTTON_COUNT; i++)
-            if (button[i].state > (BUTTON_CHECK_COUNT / 2))
-                code |= button[i].code;
+        fpress = 1;
+        do {
+            OS_PT_WAIT_EVENT(pt, &bevent, BUTTONS_EVENT_SAMPLED, OS_FLAG_CLEAR, OS_WAIT_FOREVER);
+            code = bcode;
 
-        if (code)
-        {
-            if (fpress || stimer_deltatime(timeout) >= BUTTON_REPEAT_TO)
+            if (code)
             {
-                stimer_settime(&timeout);
-                fpress = 0;
+                if (fpress || stimer_deltatime(timeout) >= BUTTON_REPEAT_TO)
+                {
+                    stimer_settime(&timeout);
+                    fpress = 0;
 #ifdef DEBUG_KEY
-                DPRINT("s_", "pressed:");
-                if (code & BUTTON_UP    ) DPRINT("s_", "BUTTON_UP");
-                if (code & BUTTON_DOWN  ) DPRINT("s_", "BUTTON_DOWN");
-                if (code & BUTTON_PGUP  ) DPRINT("s_", "BUTTON_PGUP");
-                if (code & BUTTON_PGDOWN) DPRINT("s_", "BUTTON_PGDOWN");
-                if (code & BUTTON_ENTER ) DPRINT("s_", "BUTTON_ENTER");
-                if (code & BUTTON_BACK  ) DPRINT("s_", "BUTTON_BACK");
-                DPRINT("sn","");
+                    DPRINT("s_", "pressed:");
+                    if (code & BUTTON_UP    ) DPRINT("s_", "BUTTON_UP");
+                    if (code & BUTTON_DOWN  ) DPRINT("s_", "BUTTON_DOWN");
+                    if (code & BUTTON_PGUP  ) DPRINT("s_", "BUTTON_PGUP");
+                    if (code & BUTTON_PGDOWN) DPRINT("s_", "BUTTON_PGDOWN");
+                    if (code & BUTTON_ENTER ) DPRINT("s_", "BUTTON_ENTER");
+                    if (code & BUTTON_BACK  ) DPRINT("s_", "BUTTON_BACK");
+                    DPRINT("sn","");
 #endif
-                msg.id = PLAYER_MSG_ID_BUTTON;
-                msg.button.code = code;
-                PLAYER_SEND_MSG(&msg, pmsg_button_t);
+                    msg.id = PLAYER_MSG_ID_BUTTON;
+                    msg.button.code = code;
+                    PLAYER_SEND_MSG(&msg, pmsg_button_t);
+                }
             }
-        }
-    } while (code);
+        } while (code);
+
+        os_timer_stop(&btimer);
 
 #ifdef BUTTON_PORT0_INTMASK
-    LPC_GPIOINT->IO0IntClr  = BUTTON_PORT0_INTMASK;
-    LPC_GPIOINT->IO0IntEnF |= BUTTON_PORT0_INTMASK;
+        LPC_GPIOINT->IO0IntClr  = BUTTON_PORT0_INTMASK;
+        LPC_GPIOINT->IO0IntEnF |= BUTTON_PORT0_INTMASK;
 #endif
 #ifdef BUTTON_PORT2_INTMASK
-    LPC_GPIOINT->IO2IntClr  = BUTTON_PORT2_INTMASK;
-    LPC_GPIOINT->IO2IntEnF |= BUTTON_PORT2_INTMASK;
+        LPC_GPIOINT->IO2IntClr  = BUTTON_PORT2_INTMASK;
+        LPC_GPIOINT->IO2IntEnF |= BUTTON_PORT2_INTMASK;
 #endif
+    }
+    OS_PT_END(pt);
 }
 
 
 /*
  *
  */
-static void
-check_encoder()
+static BASE_TYPE
+check_encoder(struct os_pt_t *pt)
 {
     struct player_msg_t msg;
     int cntsample;
     int dirsample;
     int n;
 
-#define SAMPLE_COUNT 16
-    cntsample = 0;
-    dirsample = 0;
-    os_disable_irq();
+    OS_PT_BEGIN(pt);
+    while (1)
     {
-//        for (n = 0; n < SAMPLE_COUNT; n++)
-//            asm volatile("nop");
+        OS_PT_WAIT_EVENT(pt, &gpioirq.evirq, GPIOIRQ_EVENT_ENCODER, OS_FLAG_CLEAR, OS_WAIT_FOREVER);
 
-        for (n = 0; n < SAMPLE_COUNT; n++)
+#define SAMPLE_COUNT 16
+        cntsample = 0;
+        dirsample = 0;
+        os_disable_irq();
         {
-            if (gpio_read(ENC_DIR_PIN))
-                dirsample++;
-            asm volatile("nop");
-        }
+//            for (n = 0; n < SAMPLE_COUNT; n++)
+//                asm volatile("nop");
+
+            for (n = 0; n < SAMPLE_COUNT; n++)
+            {
+                if (gpio_read(ENC_DIR_PIN))
+                    dirsample++;
+                asm volatile("nop");
+            }
 
-        for (n = 0; n < SAMPLE_COUNT; n++)
+            for (n = 0; n < SAMPLE_COUNT; n++)
+            {
+                asm volatile("nop");
+                if (gpio_read(ENC_CNT_PIN))
+                    cntsample++;
+            }
+        }
+        os_enable_irq();
+        if (cntsample == n)
         {
-            asm volatile("nop");
-            if (gpio_read(ENC_CNT_PIN))
-                cntsample++;
+            msg.id = PLAYER_MSG_ID_BUTTON;
+            if (dirsample < (SAMPLE_COUNT / 2))
+                msg.button.code = ENCODER_PLUS;
+            else
+                msg.button.code = ENCODER_MINUS;
+            PLAYER_SEND_MSG(&msg, pmsg_button_t);
         }
-    }
-    os_enable_irq();
-    if (cntsample == n)
-    {
-        msg.id = PLAYER_MSG_ID_BUTTON;
-        if (dirsample < (SAMPLE_COUNT / 2))
-            msg.button.code = ENCODER_PLUS;
-        else
-            msg.button.code = ENCODER_MINUS;
-        PLAYER_SEND_MSG(&msg, pmsg_button_t);
-    }
 
-    /* NOTE some delay */
-    os_wait_ms(20);
+        /* NOTE some delay */
+        OS_PT_SLEEP(pt, OS_MS2TICK(20));
 
 #ifdef ENCODER_PORT0_INTMASK
-    LPC_GPIOINT->IO0IntClr  = ENCODER_PORT0_INTMASK;
-    LPC_GPIOINT->IO0IntEnR |= ENCODER_PORT0_INTMASK;
+        LPC_GPIOINT->IO0IntClr  = ENCODER_PORT0_INTMASK;
+        LPC_GPIOINT->IO0IntEnR |= ENCODER_PORT0_INTMASK;
 #endif
+    }
+    OS_PT_END(pt);
 }
 
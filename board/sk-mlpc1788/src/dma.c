@@ -23,6 +23,7 @@
 #include <stimer.h>
 #include <debug.h>
 #include <os.h>
+#include <uart.h>
 #include "irqp.h"
 #include "dma.h"
 
@@ -83,7 +84,9 @@ struct dma_chan_t dma_chan[DMA_CHAN_NUM];
 #define DMA_CCONFIG_DESTPERIPHERAL(val)                      (val << 6)  /* 10: 6, destinaiton peripheral */
 #define DMA_CCONFIG_TRANSFERTYPE(val)                        (val << 11) /* 13:11, type of transfer and flow controller */
 #define DMA_CCONFIG_TRANSFERTYPE_MEMORY2MEMORY               (0   << 11)
+#define DMA_CCONFIG_TRANSFERTYPE_MEMORY2PERIPH_FLOW_DMA      (1   << 11)
 #define DMA_CCONFIG_TRANSFERTYPE_PERIPH2MEMORY_FLOW_DMA      (2   << 11)
+#define DMA_CCONFIG_TRANSFERTYPE_MEMORY2PERIPH_FLOW_PERIPH   (5   << 11)
 #define DMA_CCONFIG_TRANSFERTYPE_PERIPH2MEMORY_FLOW_PERIPH   (6   << 11)
 #define DMA_CCONFIG_IE                                       (1   << 14) /*    14, when cleared, masks out error interrupt  */
 #define DMA_CCONFIG_ITC                                      (1   << 15) /*    15, when cleared, masks out terminal count interrupt */
@@ -101,9 +104,12 @@ void dma_init()
 
     LPC_GPDMA->Config = (1 << 0); /* enable DMA controller */
 
+    /* request input 10 is UART0 TX, not match of TIMER1 */
+    LPC_SC->DMAREQSEL &= ~(1 << DMA_REQUEST_UART0TX);
+
     NVIC_EnableIRQ(DMA_IRQn);
     NVIC_SetPriority(DMA_IRQn, DMA_IRQP);
-    dma_free = DMA_ALLCHAN_MASK;
+    dma_free = DMA_ALLCHAN_MASK & ~DMA_CHMASK_DLOG; /* NOTE channel of debug output is never free */
 
     for (i = 0; i < DMA_CHAN_NUM; i++)
     {
@@ -151,10 +157,11 @@ struct dma_chan_t *dma_mask2ch(int mask)
 /*
  *
  */
-void DMA_Handler()
+OS_RAMFUNC void DMA_Handler()
 {
     int mask;
 
+    os_irq_enter(DMA_IRQn);
 //    dprint("sn", "DMA Handler");
     for (mask = 0x80; mask != 0x00; mask >>= 1)
     {
@@ -163,12 +170,18 @@ void DMA_Handler()
             if (LPC_GPDMA->IntTCStat & mask)
             {
                 LPC_GPDMA->IntTCClear = mask;
-                os_event_raise(&dma_free, mask);
+                if (mask == DMA_CHMASK_DLOG)
+                    uart_dbg_done();
+                else
+                    os_event_raise(&dma_free, mask);
                 continue;
             }
             if (LPC_GPDMA->IntErrStat & mask)
             {
                 LPC_GPDMA->IntErrClr = mask;
+                /* NOTE part of debug output is lost */
+                if (mask == DMA_CHMASK_DLOG)
+                    uart_dbg_done();
                 /* NOTE
                  * Event should not raised in such situation.
                  * Timeout in dma_wait_chan() will signal process
@@ -182,6 +195,7 @@ void DMA_Handler()
             }
         }
     }
+    os_irq_exit(DMA_IRQn);
 }
 
 /*
@@ -206,7 +220,7 @@ int dma_wait_chan(int chmask, uint32 to)
         {
             dmach->p->CConfig |= DMA_CCONFIG_H;
             while (dmach->p->CConfig & DMA_CCONFIG_A)
-                os_wait(1);
+                os_wait_ms(1);
             dmach->p->CConfig = 0;
         }
 
@@ -380,6 +394,75 @@ int dma_sd_read(void *dst)
     return mask;
 }
 
+/*
+ * start transfer of data from memory to SD card FIFO
+ *
+ * ARGS
+ *     src    source buffer, one or more blocks of data
+ *
+ * NOTE
+ * SD card controller is flow controller, so number of transferred
+ * words is determined by DATALEN register of controller (multiple
+ * blocks may be transferred with one request).
+ *
+ * RETURN
+ *     mask of DMA channel that was used, 0 on error
+ */
+int dma_sd_write(void *src)
+{
+    int mask;
+    struct dma_chan_t *dmach;
+
+    mask = DMA_CHMASK_SD;
+
+    /* clear event */
+    os_event_wait(&dma_free, mask, OS_FLAG_CLEAR, OS_WAIT_FOREVER);
+
+    /* NOTE */
+    LPC_GPDMA->IntTCClear = mask;
+    LPC_GPDMA->IntErrClr = mask;
+
+    /* sanity check */
+    if (LPC_GPDMA->EnbldChns & mask)
+    {
+        /* NOTREACHED */
+        dprint("s1xn", ERR_PREFIX "DMA chan still busy, mask ", mask);
+        dprint("s1xn", ERR_PREFIX "free ", dma_free);
+        return 0;
+    }
+
+    dmach = dma_mask2ch(mask);
+    if (!dmach)
+    {
+        dprint("sn", ERR_PREFIX "dmach error");
+        return 0;
+    }
+
+    dmach->p->CSrcAddr  = (uint32)src;
+    dmach->p->CDestAddr = (uint32)&LPC_MCI->FIFO;
+    dmach->p->CLLI     = 0;
+
+    /* NOTE TRANSFERSIZE not used if peripheral is flow controller */
+    dmach->p->CControl = 
+        DMA_CCONTROL_TRANSFERSIZE(512) |
+        DMA_CCONTROL_SBSIZE_8 |
+        DMA_CCONTROL_DBSIZE_8 |
+        DMA_CCONTROL_SWIDTH_WORD |
+        DMA_CCONTROL_DWIDTH_WORD |
+        DMA_CCONTROL_SI |
+        DMA_CCONTROL_I;
+    dmach->p->CConfig  =
+        DMA_CCONFIG_DESTPERIPHERAL(DMA_REQUEST_SD) |
+        DMA_CCONFIG_E |
+        DMA_CCONFIG_TRANSFERTYPE_MEMORY2PERIPH_FLOW_PERIPH |
+        DMA_CCONFIG_IE | 
+        DMA_CCONFIG_ITC;
+
+    asm volatile ("dmb\r\n"); /* NOTE */
+
+    return mask;
+}
+
 /*
  * cancel SD card dma transfer
  */
@@ -399,3 +482,70 @@ void dma_sd_cancel()
     dmach->p->CConfig &= ~DMA_CCONFIG_E;
 }
 
+static uint32 dma_dlog_len; /* length of current transfer of debug output */
+
+/*
+ * start transfer of output of debug port to UART0, called by uart_dbg
+ * with interrupts disabled
+ *
+ * RETURN
+ *     number of characters taken
+ */
+uint32 dma_dlog_start(uint8 *buf, uint32 len)
+{
+    struct dma_chan_t *dmach;
+
+    dmach = dma_mask2ch(DMA_CHMASK_DLOG);
+
+    if (len > DMA_CCONTROL_TRANSFERSIZE_MASK)
+        len = DMA_CCONTROL_TRANSFERSIZE_MASK;
+    dma_dlog_len = len;
+
+    LPC_GPDMA->IntTCClear = DMA_CHMASK_DLOG;
+    LPC_GPDMA->IntErrClr  = DMA_CHMASK_DLOG;
+
+    dmach->p->CSrcAddr  = (uint32)buf;
+    dmach->p->CDestAddr = (uint32)&LPC_UART0->THR;
+    dmach->p->CLLI      = 0;
+    dmach->p->CControl  =
+        DMA_CCONTROL_TRANSFERSIZE(len) |
+        DMA_CCONTROL_SBSIZE_1 |
+        DMA_CCONTROL_DBSIZE_1 |
+        DMA_CCONTROL_SWIDTH_BYTE |
+        DMA_CCONTROL_DWIDTH_BYTE |
+        DMA_CCONTROL_SI |
+        DMA_CCONTROL_I;
+    dmach->p->CConfig  =
+        DMA_CCONFIG_DESTPERIPHERAL(DMA_REQUEST_UART0TX) |
+        DMA_CCONFIG_E |
+        DMA_CCONFIG_TRANSFERTYPE_MEMORY2PERIPH_FLOW_DMA |
+        DMA_CCONFIG_IE |
+        DMA_CCONFIG_ITC;
+
+    return len;
+}
+
+/*
+ * stop transfer of output of debug port, characters that are in FIFO of
+ * channel are sent
+ *
+ * RETURN
+ *     number of characters sent
+ */
+uint32 dma_dlog_stop()
+{
+    struct dma_chan_t *dmach;
+
+    dmach = dma_mask2ch(DMA_CHMASK_DLOG);
+
+    dmach->p->CConfig |= DMA_CCONFIG_H;
+    while (dmach->p->CConfig & DMA_CCONFIG_A)
+        ;
+    dmach->p->CConfig = 0;
+
+    /* NOTE no interrupt from stopped transfer */
+    LPC_GPDMA->IntTCClear = DMA_CHMASK_DLOG;
+    LPC_GPDMA->IntErrClr  = DMA_CHMASK_DLOG;
+
+    return dma_dlog_len - (dmach->p->CControl & DMA_CCONTROL_TRANSFERSIZE_MASK);
+}
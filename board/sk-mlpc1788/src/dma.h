@@ -27,12 +27,17 @@ void dma_init();
 int dma_copy_window(void *dst, uint32 dstwidth, void *src, uint32 srclen, uint32 srcwidth, uint32 lines);
 int dma_wait_chan(int chmask, uint32 to);
 int dma_sd_read(void *dst);
+int dma_sd_write(void *src);
 void dma_sd_cancel();
+uint32 dma_dlog_start(uint8 *buf, uint32 len);
+uint32 dma_dlog_stop();
 
-#define DMA_REQUEST_SD    1
+#define DMA_REQUEST_SD        1
+#define DMA_REQUEST_UART0TX   10
 
 #define DMA_CHMASK_WINDOW   0x80
 #define DMA_CHMASK_SD       0x40
+#define DMA_CHMASK_DLOG     0x20 /* output of debug port (uart_dbg_async()) */
 
 #endif
 
@@ -47,6 +47,7 @@ static int phy_init();
 static void emacTxDescriptorInit();
 static void emacRxDescriptorInit();
 static void emac_rx();
+static void eth_handler_bh(void *arg);
 //static void emac_tx();
 static int emac_start_xmit(void* buf, int length);
 
@@ -61,6 +62,8 @@ int eth_init()
     ethernet.link = 0;
     stimer_settime(&ethernet.to);
 
+    os_work_init(&ethernet.work, &osw_workq, OSW_WORK_PRIO_NET, eth_handler_bh, NULL, "ENET");
+
     {
         int i;
 
@@ -609,17 +612,17 @@ static void emacRxDescriptorInit()
  */
 void Ethernet_Handler()
 {
-//    volatile uint32 regValue = 0;
-    os_event_raise(&net.events, NET_EVENT_MASK_NET_IRQ);
-
-//    debug_str("-irq\r\n");
+    os_irq_enter(ENET_IRQn);
+    /* NOTE interrupt is enabled by bottom half when status is cleared */
     NVIC_DisableIRQ(ENET_IRQn);
+    os_work_post(&ethernet.work);
+    os_irq_exit(ENET_IRQn);
 }
 
 /*
- *
+ * bottom half of ethernet interrupt, run by worker of osw_workq
  */
-void eth_handler_bh()
+static void eth_handler_bh(void *arg)
 {
     volatile uint32 regValue = 0;
 
@@ -22,6 +22,7 @@
 #define ETH_H
 
 #include <types.h>
+#include <os.h>
 
 struct ethernet_t {
     uint8 phyaddr;
@@ -39,6 +40,8 @@ struct ethernet_t {
 #define ETHERNET_STATE_IDLE             0x00
 #define ETHERNET_STATE_AUTOAN           0x01
     uint8 state;
+
+    struct os_work_t work;  /* bottom half of interrupt */
 };
 
 extern struct ethernet_t ethernet;
@@ -46,7 +49,6 @@ extern struct ethernet_t ethernet;
 int eth_init();
 int eth_linkup();
 int eth_txready();
-void eth_handler_bh();
 void eth_send(uint8 *packet, uint32 len);
 
 void Ethernet_Handler();
@@ -37,6 +37,8 @@
 #include "fat_write.h"
 #include "fat_string.h"
 #include "fat_misc.h"
+#include "fat_wcache.h"
+#include "fat_exfat.h"
 
 //-----------------------------------------------------------------------------
 // fatfs_init: Load FAT Parameters
@@ -92,6 +94,9 @@ int fatfs_init(struct fatfs *fs)
         case 0x0E: 
         case 0x0F: 
         case 0x05: 
+#if FATFS_INC_EXFAT_SUPPORT
+        case 0x07: 
+#endif
             valid_partition = 1;
         break;
         case 0x00:
@@ -115,6 +120,12 @@ int fatfs_init(struct fatfs *fs)
     if (!fs->disk_io.read_media(fs->lba_begin, fs->currentsector.sector, 1))
         return FAT_INIT_MEDIA_ACCESS_ERROR;
 
+#if FATFS_INC_EXFAT_SUPPORT
+    // exFAT has no BPB, it is detected by file system name
+    if (fatfs_exfat_detect(fs))
+        return fatfs_exfat_init(fs);
+#endif
+
     // Make sure there are 512 bytes per cluster
     if (GET_16BIT_WORD(fs->currentsector.sector, 0x0B) != FAT_SECTOR_SIZE) 
         return FAT_INIT_INVALID_SECTOR_SIZE;
@@ -167,6 +178,11 @@ int fatfs_init(struct fatfs *fs)
     {
         count_of_clusters = data_sectors / fs->sectors_per_cluster;
 
+#ifdef FAT_FREEMAP_CLUSTERS
+        // Size of free cluster bitmap, it is built on demand
+        fs->freemap.entries = count_of_clusters + 2;
+#endif
+
         if(count_of_clusters < 4085) 
             // Volume is FAT12 
             return FAT_INIT_WRONG_FILESYS_TYPE;
@@ -195,6 +211,11 @@ int fatfs_init(struct fatfs *fs)
 //-----------------------------------------------------------------------------
 uint32 fatfs_lba_of_cluster(struct fatfs *fs, uint32 Cluster_Number)
 {
+#if FATFS_INC_EXFAT_SUPPORT
+    if (fs->fat_type == FAT_TYPE_EXFAT)
+        Cluster_Number &= ~FAT_EXFAT_NOFATCHAIN;
+#endif
+
     if (fs->fat_type == FAT_TYPE_16)
         return (fs->cluster_begin_lba + (fs->root_entry_count * 32 / FAT_SECTOR_SIZE) + ((Cluster_Number-2) * fs->sectors_per_cluster));
     else
@@ -205,14 +226,34 @@ uint32 fatfs_lba_of_cluster(struct fatfs *fs, uint32 Cluster_Number)
 //-----------------------------------------------------------------------------
 int fatfs_sector_read(struct fatfs *fs, uint32 lba, uint8 *target, uint32 count)
 {
+#ifdef FAT_WCACHE_SECTORS
+    return fatfs_wcache_read(fs, lba, target, count);
+#else
     return fs->disk_io.read_media(lba, target, count);
+#endif
 }
 //-----------------------------------------------------------------------------
-// fatfs_sector_write: 
+// fatfs_sector_write: Write file data sectors
 //-----------------------------------------------------------------------------
 int fatfs_sector_write(struct fatfs *fs, uint32 lba, uint8 *target, uint32 count)
 {
+#ifdef FAT_WCACHE_SECTORS
+    return fatfs_wcache_write(fs, lba, target, count, 0);
+#else
     return fs->disk_io.write_media(lba, target, count);
+#endif
+}
+//-----------------------------------------------------------------------------
+// fatfs_sector_write_meta: Write FAT, FSINFO or directory sectors (with
+// write-back cache these are written to media after file data)
+//-----------------------------------------------------------------------------
+int fatfs_sector_write_meta(struct fatfs *fs, uint32 lba, uint8 *target, uint32 count)
+{
+#ifdef FAT_WCACHE_SECTORS
+    return fatfs_wcache_write(fs, lba, target, count, 1);
+#else
+    return fs->disk_io.write_media(lba, target, count);
+#endif
 }
 //-----------------------------------------------------------------------------
 // fatfs_sector_reader: From the provided startcluster and sector offset
@@ -244,6 +285,16 @@ int fatfs_sector_reader(struct fatfs *fs, uint32 start_cluster, uint32 offset, u
         cluster_to_read = offset / fs->sectors_per_cluster;      
         sector_to_read = offset - (cluster_to_read*fs->sectors_per_cluster);
 
+#if FATFS_INC_EXFAT_SUPPORT
+        // exFAT directory without FAT chain, clusters are contiguous
+        if (cluster_chain & FAT_EXFAT_NOFATCHAIN)
+        {
+            cluster_chain = (cluster_chain & ~FAT_EXFAT_NOFATCHAIN) + cluster_to_read;
+            if (cluster_chain >= fs->exfat.cluster_count + 2)
+                return 0;
+        }
+        else
+#endif
         // Follow chain to find cluster to read
         for (i=0; i<cluster_to_read; i++)
             cluster_chain = fatfs_find_next_cluster(fs, cluster_chain);
@@ -258,12 +309,12 @@ int fatfs_sector_reader(struct fatfs *fs, uint32 start_cluster, uint32 offset, u
 
     // User provided target array
     if (target)
-        return fs->disk_io.read_media(lba, target, 1);
+        return fatfs_sector_read(fs, lba, target, 1);
     // Else read sector if not already loaded
     else if (lba != fs->currentsector.address)
     {
         fs->currentsector.address = lba;
-        return fs->disk_io.read_media(fs->currentsector.address, fs->currentsector.sector, 1);
+        return fatfs_sector_read(fs, fs->currentsector.address, fs->currentsector.sector, 1);
     }
     else
         return 1;
@@ -289,7 +340,7 @@ int fatfs_read_sector(struct fatfs *fs, uint32 cluster, uint32 sector, uint8 *ta
         if (target)
         {
             // Read from disk
-            return fs->disk_io.read_media(lba, target, 1);
+            return fatfs_sector_read(fs, lba, target, 1);
         }
         else
         {
@@ -297,7 +348,7 @@ int fatfs_read_sector(struct fatfs *fs, uint32 cluster, uint32 sector, uint8 *ta
             fs->currentsector.address = lba;
 
             // Read from disk
-            return fs->disk_io.read_media(fs->currentsector.address, fs->currentsector.sector, 1);
+            return fatfs_sector_read(fs, fs->currentsector.address, fs->currentsector.sector, 1);
         }
     }
     // FAT16/32 Other
@@ -310,7 +361,7 @@ int fatfs_read_sector(struct fatfs *fs, uint32 cluster, uint32 sector, uint8 *ta
             uint32 lba = fatfs_lba_of_cluster(fs, cluster) + sector;
 
             // Read from disk
-            return fs->disk_io.read_media(lba, target, 1);
+            return fatfs_sector_read(fs, lba, target, 1);
         }
         else
         {
@@ -318,7 +369,7 @@ int fatfs_read_sector(struct fatfs *fs, uint32 cluster, uint32 sector, uint8 *ta
             fs->currentsector.address = fatfs_lba_of_cluster(fs, cluster)+sector;
 
             // Read from disk
-            return fs->disk_io.read_media(fs->currentsector.address, fs->currentsector.sector, 1);
+            return fatfs_sector_read(fs, fs->currentsector.address, fs->currentsector.sector, 1);
         }
     }
 }
@@ -348,7 +399,7 @@ int fatfs_write_sector(struct fatfs *fs, uint32 cluster, uint32 sector, uint8 *t
         if (target)
         {
             // Write to disk
-            return fs->disk_io.write_media(lba, target, 1);
+            return fatfs_sector_write_meta(fs, lba, target, 1);
         }
         else
         {
@@ -356,7 +407,7 @@ int fatfs_write_sector(struct fatfs *fs, uint32 cluster, uint32 sector, uint8 *t
             fs->currentsector.address = lba;
 
             // Write to disk
-            return fs->disk_io.write_media(fs->currentsector.address, fs->currentsector.sector, 1);
+            return fatfs_sector_write_meta(fs, fs->currentsector.address, fs->currentsector.sector, 1);
         }
     }
     // FAT16/32 Other
@@ -369,7 +420,7 @@ int fatfs_write_sector(struct fatfs *fs, uint32 cluster, uint32 sector, uint8 *t
             uint32 lba = fatfs_lba_of_cluster(fs, cluster) + sector;
 
             // Write to disk
-            return fs->disk_io.write_media(lba, target, 1);
+            return fatfs_sector_write_meta(fs, lba, target, 1);
         }
         else
         {
@@ -377,7 +428,7 @@ int fatfs_write_sector(struct fatfs *fs, uint32 cluster, uint32 sector, uint8 *t
             fs->currentsector.address = fatfs_lba_of_cluster(fs, cluster)+sector;
 
             // Write to disk
-            return fs->disk_io.write_media(fs->currentsector.address, fs->currentsector.sector, 1);
+            return fatfs_sector_write_meta(fs, fs->currentsector.address, fs->currentsector.sector, 1);
         }
     }
 }
@@ -388,7 +439,7 @@ int fatfs_write_sector(struct fatfs *fs, uint32 cluster, uint32 sector, uint8 *t
 void fatfs_show_details(struct fatfs *fs)
 {
     dprint("sn",   "FAT details:");
-    dprint("ssn",  " Type = ", (fs->fat_type == FAT_TYPE_32) ? "FAT32": "FAT16");
+    dprint("ssn",  " Type = ", (fs->fat_type == FAT_TYPE_EXFAT) ? "exFAT" : (fs->fat_type == FAT_TYPE_32) ? "FAT32": "FAT16");
     dprint("s4xn", " Root Dir First Cluster = 0x", fs->rootdir_first_cluster);
     dprint("s4xn", " FAT Begin LBA          = 0x", fs->fat_begin_lba);
     dprint("s4xn", " Cluster Begin LBA      = 0x", fs->cluster_begin_lba);
@@ -424,6 +475,11 @@ uint32 fatfs_get_file_entry(struct fatfs *fs, uint32 Cluster, char *name_to_find
     int dotRequired = 0;
     struct fat_dir_entry *directoryEntry;
 
+#if FATFS_INC_EXFAT_SUPPORT
+    if (fs->fat_type == FAT_TYPE_EXFAT)
+        return fatfs_exfat_get_file_entry(fs, Cluster, name_to_find, sfEntry);
+#endif
+
     fatfs_lfn_cache_init(&lfn, 1);
 
     // Main cluster following loop
@@ -619,7 +675,7 @@ int fatfs_update_file_length(struct fatfs *fs, uint32 Cluster, char *shortname,
                         memcpy((uint8*)(fs->currentsector.sector+recordoffset), (uint8*)directoryEntry, sizeof(struct fat_dir_entry));                    
 
                         // Write sector back
-                        return fs->disk_io.write_media(fs->currentsector.address, fs->currentsector.sector, 1);
+                        return fatfs_sector_write_meta(fs, fs->currentsector.address, fs->currentsector.sector, 1);
                     }
                 }
             } // End of if
@@ -685,7 +741,7 @@ int fatfs_mark_file_deleted(struct fatfs *fs, uint32 Cluster, char *shortname)
                         memcpy((uint8*)(fs->currentsector.sector+recordoffset), (uint8*)directoryEntry, sizeof(struct fat_dir_entry));                    
 
                         // Write sector back
-                        return fs->disk_io.write_media(fs->currentsector.address, fs->currentsector.sector, 1);
+                        return fatfs_sector_write_meta(fs, fs->currentsector.address, fs->currentsector.sector, 1);
                     }
                 }
             } // End of if
@@ -723,6 +779,11 @@ int fatfs_list_directory_next(struct fatfs *fs, struct fs_dir_list_status *dirls
     struct lfn_cache lfn;
     int dotRequired = 0;
     int result = 0;
+
+#if FATFS_INC_EXFAT_SUPPORT
+    if (fs->fat_type == FAT_TYPE_EXFAT)
+        return fatfs_exfat_list_directory_next(fs, dirls, entry);
+#endif
  
     // Initialise LFN cache first
     fatfs_lfn_cache_init(&lfn, 0);
@@ -48,16 +48,63 @@ struct fat_buffer
     struct fat_buffer       *next;
 };
 
+#ifdef FAT_WCACHE_SECTORS
+struct fat_wcache
+{
+    uint8                   sector[FAT_WCACHE_SECTORS][FAT_SECTOR_SIZE];
+    uint32                  address[FAT_WCACHE_SECTORS];
+    // Sector holds FAT or directory entries
+    uint8                   meta[FAT_WCACHE_SECTORS];
+    // Slots sorted by sector address
+    uint16                  order[FAT_WCACHE_SECTORS];
+    int                     count;
+
+    // Statistics
+    uint32                  dirty_max;
+    uint32                  flushes;
+    uint32                  flush_runs;
+    uint32                  flush_sectors;
+    uint32                  flush_time_last;
+    uint32                  flush_time_max;
+};
+#endif
+
+#ifdef FAT_FREEMAP_CLUSTERS
+struct fat_freemap
+{
+    // Bit is set if cluster is free
+    uint32                  map[FAT_FREEMAP_CLUSTERS / 32];
+    // Number of FAT entries (clusters + 2 reserved entries)
+    uint32                  entries;
+    uint32                  free;
+    int                     valid;
+};
+#endif
+
+#if FATFS_INC_EXFAT_SUPPORT
+struct fat_exfat
+{
+    uint32                  cluster_count;
+    // Allocation bitmap
+    uint32                  bitmap_cluster;
+    uint32                  bitmap_length;
+    // Up-case table for first characters (names are compared with low byte
+    // of UTF-16 character, same as LFN)
+    uint16                  upcase[256];
+};
+#endif
+
 typedef enum eFatType
 {
     FAT_TYPE_16,
-    FAT_TYPE_32
+    FAT_TYPE_32,
+    FAT_TYPE_EXFAT
 } tFatType;
 
 struct fatfs
 {
     // Filesystem globals
-    uint8                   sectors_per_cluster;
+    uint16                  sectors_per_cluster;
     uint32                  cluster_begin_lba;
     uint32                  rootdir_first_cluster;
     uint32                  rootdir_first_sector;
@@ -85,6 +132,21 @@ struct fatfs
     // FAT Buffer
     struct fat_buffer        *fat_buffer_head;
     struct fat_buffer        fat_buffers[FAT_BUFFERS];
+
+#ifdef FAT_WCACHE_SECTORS
+    // Write-back sector cache
+    struct fat_wcache        wcache;
+#endif
+
+#ifdef FAT_FREEMAP_CLUSTERS
+    // Free cluster bitmap
+    struct fat_freemap       freemap;
+#endif
+
+#if FATFS_INC_EXFAT_SUPPORT
+    // exFAT volume parameters
+    struct fat_exfat         exfat;
+#endif
 };
 
 struct fs_dir_list_status
@@ -110,6 +172,7 @@ uint32  fatfs_lba_of_cluster(struct fatfs *fs, uint32 Cluster_Number);
 int     fatfs_sector_reader(struct fatfs *fs, uint32 Startcluster, uint32 offset, uint8 *target);
 int     fatfs_sector_read(struct fatfs *fs, uint32 lba, uint8 *target, uint32 count);
 int     fatfs_sector_write(struct fatfs *fs, uint32 lba, uint8 *target, uint32 count);
+int     fatfs_sector_write_meta(struct fatfs *fs, uint32 lba, uint8 *target, uint32 count);
 int     fatfs_read_sector(struct fatfs *fs, uint32 cluster, uint32 sector, uint8 *target);
 int     fatfs_write_sector(struct fatfs *fs, uint32 cluster, uint32 sector, uint8 *target);
 void    fatfs_show_details(struct fatfs *fs);
@@ -45,6 +45,16 @@
 #define BS_FAT32_VOLLAB         71    // Length = 11
 #define BS_FAT32_FILSYSTYPE     82    // Length = 8
 
+// exFAT Boot Sector
+#define BS_EXFAT_FATOFFSET      80    // Length = 4
+#define BS_EXFAT_FATLENGTH      84    // Length = 4
+#define BS_EXFAT_CLUSHEAPOFFSET 88    // Length = 4
+#define BS_EXFAT_CLUSCOUNT      92    // Length = 4
+#define BS_EXFAT_ROOTCLUS       96    // Length = 4
+#define BS_EXFAT_BYTSPERSECSH   108   // Length = 1
+#define BS_EXFAT_SECPERCLUSSH   109   // Length = 1
+#define BS_EXFAT_NUMFATS        110   // Length = 1
+
 //-----------------------------------------------------------------------------
 // FAT Types
 //-----------------------------------------------------------------------------
@@ -83,6 +93,35 @@
 #define FILE_TYPE_DIR                   0x10
 #define FILE_TYPE_FILE                  0x20
 
+//-----------------------------------------------------------------------------
+// exFAT Directory Entries
+//-----------------------------------------------------------------------------
+#define EXFAT_ENTRY_END                 0x00
+#define EXFAT_ENTRY_INUSE               0x80
+#define EXFAT_ENTRY_BITMAP              0x81
+#define EXFAT_ENTRY_UPCASE              0x82
+#define EXFAT_ENTRY_FILE                0x85
+#define EXFAT_ENTRY_STREAM              0xC0
+#define EXFAT_ENTRY_NAME                0xC1
+
+// Offsets within entries
+#define EXFAT_FILE_SECONDARYCOUNT       1     // Length = 1
+#define EXFAT_FILE_ATTRIBUTES           4     // Length = 2
+#define EXFAT_STREAM_FLAGS              1     // Length = 1
+#define EXFAT_STREAM_NAMELENGTH         3     // Length = 1
+#define EXFAT_STREAM_VALIDDATALENGTH    8     // Length = 8
+#define EXFAT_STREAM_FIRSTCLUSTER       20    // Length = 4
+#define EXFAT_STREAM_DATALENGTH         24    // Length = 8
+#define EXFAT_NAME_CHARS                2     // Length = 30
+#define EXFAT_NAME_CHARS_PER_ENTRY      15
+
+#define EXFAT_FLAG_NOFATCHAIN           0x02
+#define EXFAT_NAME_MAX                  255
+
+// Set in cluster number of file or directory which has no FAT chain
+// (data is contiguous starting from this cluster)
+#define FAT_EXFAT_NOFATCHAIN            0x80000000
+
 //-----------------------------------------------------------------------------
 // Other Defines
 //-----------------------------------------------------------------------------
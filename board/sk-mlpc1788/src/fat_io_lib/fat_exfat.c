@@ -0,0 +1,392 @@
+//-----------------------------------------------------------------------------
+//-----------------------------------------------------------------------------
+//                            FAT16/32 File IO Library
+//                                    V2.6
+//                              Ultra-Embedded.com
+//                            Copyright 2003 - 2012
+//
+//                         Email: admin@ultra-embedded.com
+//
+//                                License: GPL
+//   If you would like a version with a more permissive license for use in
+//   closed source commercial applications please contact me for details.
+//-----------------------------------------------------------------------------
+//
+// This file is part of FAT File IO Library.
+//
+// FAT File IO Library is free software; you can redistribute it and/or modify
+// it under the terms of the GNU General Public License as published by
+// the Free Software Foundation; either version 2 of the License, or
+// (at your option) any later version.
+//
+// FAT File IO Library is distributed in the hope that it will be useful,
+// but WITHOUT ANY WARRANTY; without even the implied warranty of
+// MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the
+// GNU General Public License for more details.
+//
+// You should have received a copy of the GNU General Public License
+// along with FAT File IO Library; if not, write to the Free Software
+// Foundation, Inc., 59 Temple Place, Suite 330, Boston, MA  02111-1307  USA
+//-----------------------------------------------------------------------------
+#include <string.h>
+#include "fat_defs.h"
+#include "fat_access.h"
+#include "fat_exfat.h"
+
+// exFAT read support.
+// exFAT volume is mounted read only. Directory entry sets (file, stream
+// extension and name entries) are converted to FAT directory entries, so
+// rest of library opens files and walks directories unchanged. Files and
+// directories which have no FAT chain are marked with FAT_EXFAT_NOFATCHAIN
+// in cluster number and are read as a single extent without FAT lookups.
+
+#if FATFS_INC_EXFAT_SUPPORT
+
+// Entry set being parsed
+struct exfat_set
+{
+    uint8   remaining;
+    uint8   stream;
+    uint8   attr;
+    uint8   flags;
+    uint8   name_length;
+    uint8   name_pos;
+    uint32  cluster;
+    uint32  size;
+    char    name[EXFAT_NAME_MAX + 1];
+};
+
+#define EXFAT_GET_16BIT_WORD(p, o)  ((uint16)(p)[o] | ((uint16)(p)[(o) + 1] << 8))
+#define EXFAT_GET_32BIT_WORD(p, o)  ((uint32)EXFAT_GET_16BIT_WORD(p, o) | ((uint32)EXFAT_GET_16BIT_WORD(p, (o) + 2) << 16))
+
+//-----------------------------------------------------------------------------
+// fatfs_exfat_detect: Check if boot sector in working buffer is exFAT one
+//-----------------------------------------------------------------------------
+int fatfs_exfat_detect(struct fatfs *fs)
+{
+    return memcmp(fs->currentsector.sector + BS_OEMNAME, "EXFAT   ", 8) == 0;
+}
+//-----------------------------------------------------------------------------
+// fatfs_exfat_load_upcase: Decompress start of up-case table
+//-----------------------------------------------------------------------------
+static void fatfs_exfat_load_upcase(struct fatfs *fs, uint32 cluster, uint32 length)
+{
+    uint16 *upcase = fs->exfat.upcase;
+    uint32 ch;
+    uint32 pos;
+    uint16 value;
+    int run = 0;
+
+    // Identity mapping with ASCII letters if table is missing
+    for (ch = 0; ch < 256; ch++)
+        upcase[ch] = (ch >= 'a' && ch <= 'z') ? (uint16)(ch - 'a' + 'A') : (uint16)ch;
+
+    if (cluster == 0)
+        return;
+
+    ch = 0;
+    for (pos = 0; pos < length && ch < 256; pos += 2)
+    {
+        // Load next sector of table
+        if ((pos % FAT_SECTOR_SIZE) == 0)
+            if (!fatfs_sector_reader(fs, cluster, pos / FAT_SECTOR_SIZE, 0))
+                return;
+
+        value = EXFAT_GET_16BIT_WORD(fs->currentsector.sector, pos % FAT_SECTOR_SIZE);
+
+        // Identity run, value is run length
+        if (run)
+        {
+            ch += value;
+            run = 0;
+        }
+        else if (value == 0xFFFF)
+            run = 1;
+        else
+            upcase[ch++] = value;
+    }
+}
+//-----------------------------------------------------------------------------
+// fatfs_exfat_init: Load exFAT parameters from boot sector in working buffer
+// and find allocation bitmap and up-case table in root directory
+//-----------------------------------------------------------------------------
+int fatfs_exfat_init(struct fatfs *fs)
+{
+    uint8 *sector = fs->currentsector.sector;
+    uint8 *entry;
+    uint32 upcase_cluster = 0;
+    uint32 upcase_length = 0;
+    uint32 x;
+    int item;
+
+    // Only 512 byte sectors
+    if (sector[BS_EXFAT_BYTSPERSECSH] != 9)
+        return FAT_INIT_INVALID_SECTOR_SIZE;
+
+    // Up to 128KB clusters
+    if (sector[BS_EXFAT_SECPERCLUSSH] > 8)
+        return FAT_INIT_WRONG_FILESYS_TYPE;
+
+    fs->sectors_per_cluster = 1 << sector[BS_EXFAT_SECPERCLUSSH];
+    fs->num_of_fats = sector[BS_EXFAT_NUMFATS];
+    fs->fat_begin_lba = fs->lba_begin + EXFAT_GET_32BIT_WORD(sector, BS_EXFAT_FATOFFSET);
+    fs->fat_sectors = EXFAT_GET_32BIT_WORD(sector, BS_EXFAT_FATLENGTH);
+    fs->cluster_begin_lba = fs->lba_begin + EXFAT_GET_32BIT_WORD(sector, BS_EXFAT_CLUSHEAPOFFSET);
+    fs->rootdir_first_cluster = EXFAT_GET_32BIT_WORD(sector, BS_EXFAT_ROOTCLUS);
+    fs->rootdir_first_sector = 0;
+    fs->rootdir_sectors = 0;
+    fs->root_entry_count = 0;
+    fs->fs_info_sector = 0;
+    fs->exfat.cluster_count = EXFAT_GET_32BIT_WORD(sector, BS_EXFAT_CLUSCOUNT);
+    fs->exfat.bitmap_cluster = 0;
+    fs->exfat.bitmap_length = 0;
+    fs->fat_type = FAT_TYPE_EXFAT;
+
+    // Cluster number flag should not be valid cluster number
+    if (fs->exfat.cluster_count >= FAT_EXFAT_NOFATCHAIN - 2)
+        return FAT_INIT_WRONG_FILESYS_TYPE;
+
+    // NOTE working buffer holds boot sector, not sector at its address
+    fs->currentsector.address = FAT32_INVALID_CLUSTER;
+
+    // Find allocation bitmap and up-case table in root directory
+    for (x = 0; fatfs_sector_reader(fs, fs->rootdir_first_cluster, x, 0); x++)
+    {
+        for (item = 0; item < FAT_DIR_ENTRIES_PER_SECTOR; item++)
+        {
+            entry = fs->currentsector.sector + item * FAT_DIR_ENTRY_SIZE;
+
+            if (entry[0] == EXFAT_ENTRY_END)
+                goto done;
+
+            // First bitmap (second one is for second FAT)
+            if (entry[0] == EXFAT_ENTRY_BITMAP && !fs->exfat.bitmap_cluster)
+            {
+                fs->exfat.bitmap_cluster = EXFAT_GET_32BIT_WORD(entry, EXFAT_STREAM_FIRSTCLUSTER);
+                fs->exfat.bitmap_length = EXFAT_GET_32BIT_WORD(entry, EXFAT_STREAM_DATALENGTH);
+            }
+            else if (entry[0] == EXFAT_ENTRY_UPCASE)
+            {
+                upcase_cluster = EXFAT_GET_32BIT_WORD(entry, EXFAT_STREAM_FIRSTCLUSTER);
+                upcase_length = EXFAT_GET_32BIT_WORD(entry, EXFAT_STREAM_DATALENGTH);
+            }
+        }
+    }
+
+done:
+    if (!fs->exfat.bitmap_cluster)
+        return FAT_INIT_WRONG_FILESYS_TYPE;
+
+    fatfs_exfat_load_upcase(fs, upcase_cluster, upcase_length);
+
+    return FAT_INIT_OK;
+}
+//-----------------------------------------------------------------------------
+// fatfs_exfat_parse: Feed directory entry to entry set parser.
+// Returns 1 when complete file entry set is parsed, -1 on end of directory,
+// 0 otherwise.
+//-----------------------------------------------------------------------------
+static int fatfs_exfat_parse(struct exfat_set *set, uint8 *entry)
+{
+    int i;
+    uint16 ch;
+
+    switch (entry[0])
+    {
+        case EXFAT_ENTRY_END:
+            return -1;
+        case EXFAT_ENTRY_FILE:
+            // Stream extension and at least one name entry
+            set->remaining = entry[EXFAT_FILE_SECONDARYCOUNT];
+            if (set->remaining < 2)
+                set->remaining = 0;
+            set->stream = 0;
+            set->attr = entry[EXFAT_FILE_ATTRIBUTES];
+            set->name_pos = 0;
+            return 0;
+    }
+
+    if (!set->remaining)
+        return 0;
+
+    // Deleted or primary entry breaks the set
+    if (!(entry[0] & EXFAT_ENTRY_INUSE) || !(entry[0] & 0x40))
+    {
+        set->remaining = 0;
+        return 0;
+    }
+
+    if (entry[0] == EXFAT_ENTRY_STREAM && !set->stream)
+    {
+        set->stream = 1;
+        set->flags = entry[EXFAT_STREAM_FLAGS];
+        set->name_length = entry[EXFAT_STREAM_NAMELENGTH];
+        set->cluster = EXFAT_GET_32BIT_WORD(entry, EXFAT_STREAM_FIRSTCLUSTER);
+
+        // Limit to 4GB, bytes past valid data length are not readable
+        if (EXFAT_GET_32BIT_WORD(entry, EXFAT_STREAM_VALIDDATALENGTH + 4))
+            set->size = 0xFFFFFFFF;
+        else
+            set->size = EXFAT_GET_32BIT_WORD(entry, EXFAT_STREAM_VALIDDATALENGTH);
+
+        // Directory size is size of its allocation
+        if (set->attr & FILE_ATTR_DIRECTORY)
+            set->size = EXFAT_GET_32BIT_WORD(entry, EXFAT_STREAM_DATALENGTH);
+
+        // Contiguous data
+        if ((set->flags & EXFAT_FLAG_NOFATCHAIN) && set->cluster)
+            set->cluster |= FAT_EXFAT_NOFATCHAIN;
+    }
+    else if (entry[0] == EXFAT_ENTRY_NAME && set->stream)
+    {
+        for (i = 0; i < EXFAT_NAME_CHARS_PER_ENTRY && set->name_pos < set->name_length; i++)
+        {
+            ch = EXFAT_GET_16BIT_WORD(entry, EXFAT_NAME_CHARS + i * 2);
+
+            // NOTE only low byte is used, same as for LFN
+            set->name[set->name_pos++] = (char)(ch & 0xFF);
+        }
+    }
+
+    if (--set->remaining)
+        return 0;
+
+    // Entry set complete
+    if (!set->stream || set->name_pos != set->name_length || !set->name_length)
+        return 0;
+
+    set->name[set->name_pos] = 0;
+    return 1;
+}
+//-----------------------------------------------------------------------------
+// fatfs_exfat_to_dir_entry: Fill FAT directory entry with parsed entry set
+//-----------------------------------------------------------------------------
+static void fatfs_exfat_to_dir_entry(struct exfat_set *set, struct fat_dir_entry *sfEntry)
+{
+    memset(sfEntry, 0, sizeof(struct fat_dir_entry));
+    memset(sfEntry->Name, ' ', sizeof(sfEntry->Name));
+
+    sfEntry->Attr = set->attr;
+    sfEntry->FstClusHI = FAT_HTONS((uint16)(set->cluster >> 16));
+    sfEntry->FstClusLO = FAT_HTONS((uint16)(set->cluster & 0xFFFF));
+    sfEntry->FileSize = FAT_HTONL(set->size);
+}
+//-----------------------------------------------------------------------------
+// fatfs_exfat_compare_names: Compare names using up-case table
+//-----------------------------------------------------------------------------
+static int fatfs_exfat_compare_names(struct fatfs *fs, char *name, char *name_to_find)
+{
+    uint16 *upcase = fs->exfat.upcase;
+
+    while (*name && *name_to_find)
+    {
+        if (upcase[(uint8)*name++] != upcase[(uint8)*name_to_find++])
+            return 0;
+    }
+
+    return *name == *name_to_find;
+}
+//-----------------------------------------------------------------------------
+// fatfs_exfat_get_file_entry: Find the file entry for a filename
+//-----------------------------------------------------------------------------
+uint32 fatfs_exfat_get_file_entry(struct fatfs *fs, uint32 Cluster, char *name_to_find, struct fat_dir_entry *sfEntry)
+{
+    struct exfat_set set;
+    uint32 x;
+    int item;
+    int res;
+
+    set.remaining = 0;
+
+    for (x = 0; fatfs_sector_reader(fs, Cluster, x, 0); x++)
+    {
+        for (item = 0; item < FAT_DIR_ENTRIES_PER_SECTOR; item++)
+        {
+            res = fatfs_exfat_parse(&set, fs->currentsector.sector + item * FAT_DIR_ENTRY_SIZE);
+            if (res < 0)
+                return 0;
+
+            if (res && fatfs_exfat_compare_names(fs, set.name, name_to_find))
+            {
+                fatfs_exfat_to_dir_entry(&set, sfEntry);
+                return 1;
+            }
+        }
+    }
+
+    return 0;
+}
+//-----------------------------------------------------------------------------
+// fatfs_exfat_list_directory_next: Get the next entry in the directory.
+// Returns: 1 = found, 0 = end of listing
+//-----------------------------------------------------------------------------
+#if FATFS_DIR_LIST_SUPPORT
+int fatfs_exfat_list_directory_next(struct fatfs *fs, struct fs_dir_list_status *dirls, struct fs_dir_ent *entry)
+{
+    struct exfat_set set;
+    int item;
+    int res;
+
+    set.remaining = 0;
+
+    while (fatfs_sector_reader(fs, dirls->cluster, dirls->sector, 0))
+    {
+        for (item = dirls->offset; item < FAT_DIR_ENTRIES_PER_SECTOR; item++)
+        {
+            res = fatfs_exfat_parse(&set, fs->currentsector.sector + item * FAT_DIR_ENTRY_SIZE);
+            if (res < 0)
+                return 0;
+
+            if (res)
+            {
+                strncpy(entry->filename, set.name, FATFS_MAX_LONG_FILENAME-1);
+                entry->is_dir = (set.attr & FILE_ATTR_DIRECTORY) ? 1 : 0;
+                entry->size = set.size;
+                entry->cluster = set.cluster;
+
+                // Next starting position
+                dirls->offset = item + 1;
+                return 1;
+            }
+        }
+
+        // If reached end of the dir move onto next sector
+        dirls->sector++;
+        dirls->offset = 0;
+    }
+
+    return 0;
+}
+#endif
+//-----------------------------------------------------------------------------
+// fatfs_exfat_count_free_clusters: Count free clusters in allocation bitmap
+//-----------------------------------------------------------------------------
+uint32 fatfs_exfat_count_free_clusters(struct fatfs *fs)
+{
+    uint32 used = 0;
+    uint32 bytes;
+    uint32 pos;
+    uint8 bits;
+
+    bytes = (fs->exfat.cluster_count + 7) / 8;
+    if (bytes > fs->exfat.bitmap_length)
+        bytes = fs->exfat.bitmap_length;
+
+    for (pos = 0; pos < bytes; pos++)
+    {
+        if ((pos % FAT_SECTOR_SIZE) == 0)
+            if (!fatfs_sector_reader(fs, fs->exfat.bitmap_cluster, pos / FAT_SECTOR_SIZE, 0))
+                break;
+
+        bits = fs->currentsector.sector[pos % FAT_SECTOR_SIZE];
+
+        // Bits past last cluster are not used
+        if (pos == bytes - 1 && (fs->exfat.cluster_count % 8))
+            bits &= (1 << (fs->exfat.cluster_count % 8)) - 1;
+
+        used += __builtin_popcount(bits);
+    }
+
+    return fs->exfat.cluster_count - used;
+}
+#endif
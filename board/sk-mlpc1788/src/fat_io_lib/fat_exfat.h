@@ -0,0 +1,18 @@
+#ifndef __FAT_EXFAT_H__
+#define __FAT_EXFAT_H__
+
+#include "fat_opts.h"
+#include "fat_access.h"
+
+//-----------------------------------------------------------------------------
+// Prototypes
+//-----------------------------------------------------------------------------
+#if FATFS_INC_EXFAT_SUPPORT
+int     fatfs_exfat_detect(struct fatfs *fs);
+int     fatfs_exfat_init(struct fatfs *fs);
+uint32  fatfs_exfat_get_file_entry(struct fatfs *fs, uint32 Cluster, char *name_to_find, struct fat_dir_entry *sfEntry);
+int     fatfs_exfat_list_directory_next(struct fatfs *fs, struct fs_dir_list_status *dirls, struct fs_dir_ent *entry);
+uint32  fatfs_exfat_count_free_clusters(struct fatfs *fs);
+#endif
+
+#endif
@@ -40,6 +40,7 @@
 #include "fat_string.h"
 #include "fat_filelib.h"
 #include "fat_cache.h"
+#include "fat_wcache.h"
 #include "fat_list2.h"
 
 //-----------------------------------------------------------------------------
@@ -51,6 +52,10 @@ static int                _filelib_valid = 0;
 static struct fatfs       _fs;
 static struct fat_list    _open_file_list;
 static struct fat_list    _free_file_list;
+#ifdef FATFS_FILE_BUFFER_POOL
+static uint8              _fbuf_pool[FATFS_FILE_BUFFER_POOL][FAT_SECTOR_SIZE];
+static FL_FILE*           _fbuf_owner[FATFS_FILE_BUFFER_POOL];
+#endif
 
 //-----------------------------------------------------------------------------
 // Macros
@@ -62,10 +67,16 @@ static struct fat_list    _free_file_list;
 #define FL_LOCK(a)          do { if ((a)->fl_lock) (a)->fl_lock(); } while (0)
 #define FL_UNLOCK(a)        do { if ((a)->fl_unlock) (a)->fl_unlock(); } while (0)
 
+// Discard content of file buffer
+#define FILE_BUFFER_INVALIDATE(f)   do { (f)->file_data_address = 0xFFFFFFFF; (f)->file_data_count = 0; (f)->file_data_dirty = 0; } while (0)
+// Check if sector of file is in file buffer
+#define FILE_BUFFER_HIT(f, s)       ((uint32)((s) - (f)->file_data_address) < (f)->file_data_count)
+
 //-----------------------------------------------------------------------------
 // Local Functions
 //-----------------------------------------------------------------------------
 //static void                _fl_init();
+static void                 _flush_file(FL_FILE *file);
 
 //-----------------------------------------------------------------------------
 // _allocate_file: Find a slot in the open files buffer for a new file
@@ -75,11 +86,21 @@ static FL_FILE* _allocate_file(void)
     // Allocate free file
     struct fat_node *node = fat_list_pop_head(&_free_file_list);
 
+    FL_FILE *file;
+
+    if (!node)
+        return NULL;
+
     // Add to open list
-    if (node)
-        fat_list_insert_last(&_open_file_list, node);
+    fat_list_insert_last(&_open_file_list, node);
+
+    // Use own one sector buffer
+    file = fat_list_entry(node, FL_FILE, list_node);
+    file->file_data = file->file_data_sector;
+    file->file_data_size = 1;
+    FILE_BUFFER_INVALIDATE(file);
 
-    return fat_list_entry(node, FL_FILE, list_node);
+    return file;
 }
 //-----------------------------------------------------------------------------
 // _check_file_open: Returns true if the file is already open
@@ -107,8 +128,13 @@ static int _check_file_open(FL_FILE* file)
 //-----------------------------------------------------------------------------
 // _free_file: Free open file handle
 //-----------------------------------------------------------------------------
+static void _release_buffer(FL_FILE* file);
+
 static void _free_file(FL_FILE* file)
 {
+    // Return buffer to pool
+    _release_buffer(file);
+
     // Remove from open list
     fat_list_remove(&_open_file_list, &file->list_node);
 
@@ -116,6 +142,59 @@ static void _free_file(FL_FILE* file)
     fat_list_insert_last(&_free_file_list, &file->list_node);
 }
 
+//-----------------------------------------------------------------------------
+// _release_buffer: Return pool buffer of file, file uses own sector buffer
+//-----------------------------------------------------------------------------
+static void _release_buffer(FL_FILE* file)
+{
+#ifdef FATFS_FILE_BUFFER_POOL
+    int i;
+
+    for (i=0;i<FATFS_FILE_BUFFER_POOL;i++)
+        if (_fbuf_owner[i] == file)
+            _fbuf_owner[i] = NULL;
+#endif
+
+    file->file_data = file->file_data_sector;
+    file->file_data_size = 1;
+    FILE_BUFFER_INVALIDATE(file);
+}
+//-----------------------------------------------------------------------------
+// _alloc_buffer: Take specified number of contiguous sectors from pool
+//-----------------------------------------------------------------------------
+#ifdef FATFS_FILE_BUFFER_POOL
+static int _alloc_buffer(FL_FILE* file, uint32 sectors)
+{
+    uint32 i, run;
+
+    run = 0;
+    for (i=0;i<FATFS_FILE_BUFFER_POOL;i++)
+    {
+        if (_fbuf_owner[i])
+        {
+            run = 0;
+            continue;
+        }
+
+        // First fit
+        if (++run == sectors)
+        {
+            i = i + 1 - sectors;
+
+            for (run=0;run<sectors;run++)
+                _fbuf_owner[i + run] = file;
+
+            file->file_data = _fbuf_pool[i];
+            file->file_data_size = sectors;
+            FILE_BUFFER_INVALIDATE(file);
+            return 1;
+        }
+    }
+
+    return 0;
+}
+#endif
+
 //-----------------------------------------------------------------------------
 //                                Low Level
 //-----------------------------------------------------------------------------
@@ -225,10 +304,10 @@ static int _create_directory(char *path)
     }
 
     // Erase new directory cluster
-    memset(file->file_data_sector, 0x00, FAT_SECTOR_SIZE);
+    memset(file->file_data, 0x00, FAT_SECTOR_SIZE);
     for (i=0;i<_fs.sectors_per_cluster;i++)
     {
-        if (!fatfs_write_sector(&_fs, file->startcluster, i, file->file_data_sector))
+        if (!fatfs_write_sector(&_fs, file->startcluster, i, file->file_data))
         {
             _free_file(file);
             return 0;
@@ -306,8 +385,7 @@ static int _create_directory(char *path)
     // General
     file->filelength = 0;
     file->bytenum = 0;
-    file->file_data_address = 0xFFFFFFFF;
-    file->file_data_dirty = 0;
+    FILE_BUFFER_INVALIDATE(file);
     file->filelength_changed = 0;
     
     // Quick lookup for next link in the chain
@@ -315,6 +393,9 @@ static int _create_directory(char *path)
     file->last_fat_lookup.CurrentCluster = 0xFFFFFFFF;
     
     fatfs_fat_purge(&_fs);
+#ifdef FAT_WCACHE_SECTORS
+    fatfs_wcache_flush(&_fs);
+#endif
 
     _free_file(file);
     return 1;
@@ -374,8 +455,7 @@ static FL_FILE* _open_file(const char *path)
             file->filelength = FAT_HTONL(sfEntry.FileSize);
             file->bytenum = 0;
             file->startcluster = ((FAT_HTONS((uint32)sfEntry.FstClusHI))<<16) + FAT_HTONS(sfEntry.FstClusLO);
-            file->file_data_address = 0xFFFFFFFF;
-            file->file_data_dirty = 0;
+            FILE_BUFFER_INVALIDATE(file);
             file->filelength_changed = 0;
 
             // Quick lookup for next link in the chain
@@ -529,8 +609,7 @@ static FL_FILE* _create_file(const char *filename)
     // General
     file->filelength = 0;
     file->bytenum = 0;
-    file->file_data_address = 0xFFFFFFFF;
-    file->file_data_dirty = 0;
+    FILE_BUFFER_INVALIDATE(file);
     file->filelength_changed = 0;
 
     // Quick lookup for next link in the chain
@@ -563,6 +642,17 @@ static uint32 _read_sectors(FL_FILE* file, uint32 offset, uint8 *buffer, uint32
     if ((Sector + count) > _fs.sectors_per_cluster)
         count = _fs.sectors_per_cluster - Sector;
 
+#if FATFS_INC_EXFAT_SUPPORT
+    // exFAT file without FAT chain is single extent, no FAT lookups
+    if (file->startcluster & FAT_EXFAT_NOFATCHAIN)
+    {
+        if (ClusterIdx > (file->filelength - 1) / (_fs.sectors_per_cluster * FAT_SECTOR_SIZE))
+            Cluster = FAT32_LAST_CLUSTER;
+        else
+            Cluster = file->startcluster + ClusterIdx;
+    }
+    else
+#endif
     // Quick lookup for next link in the chain
     if (ClusterIdx == file->last_fat_lookup.ClusterIdx)
         Cluster = file->last_fat_lookup.CurrentCluster;
@@ -677,6 +767,12 @@ int fl_attach_media(fn_diskio_read rd, fn_diskio_write wr)
         return res;
     }
 
+#if FATFS_INC_EXFAT_SUPPORT
+    // exFAT is supported read only
+    if (_fs.fat_type == FAT_TYPE_EXFAT)
+        _fs.disk_io.write_media = NULL;
+#endif
+
     _filelib_valid = 1;
     return FAT_INIT_OK;
 }
@@ -690,9 +786,59 @@ void fl_shutdown(void)
 
     FL_LOCK(&_fs);
     fatfs_fat_purge(&_fs);
+#ifdef FAT_WCACHE_SECTORS
+    fatfs_wcache_flush(&_fs);
+#endif
     FL_UNLOCK(&_fs);
 }
 //-----------------------------------------------------------------------------
+// fl_setvbuf: Attach buffer of specified number of sectors from pool to file.
+// Reads shorter than buffer fill whole buffer, so sequential small reads
+// are served with one media access per buffer. Longer reads go to target
+// buffer directly, but with at most buffer size per media access, so
+// file system lock is given to readers of other files between them.
+// Returns 0 on success, -1 if no space in pool (file keeps one sector
+// buffer).
+//-----------------------------------------------------------------------------
+#ifdef FATFS_FILE_BUFFER_POOL
+int fl_setvbuf(void *f, uint32 sectors)
+{
+    FL_FILE *file = (FL_FILE *)f;
+    int res = 0;
+
+    if (!file)
+        return -1;
+
+    // No use of buffer larger than cluster, reads do not cross cluster boundary
+    if (sectors > _fs.sectors_per_cluster)
+        sectors = _fs.sectors_per_cluster;
+
+    FL_LOCK(&_fs);
+
+    // Flush un-written data to file
+    _flush_file(file);
+
+    _release_buffer(file);
+
+    if (sectors > 1 && !_alloc_buffer(file, sectors))
+        res = -1;
+
+    FL_UNLOCK(&_fs);
+
+    return res;
+}
+#endif
+//-----------------------------------------------------------------------------
+// fl_show_wcache: Show statistics of write-back sector cache
+//-----------------------------------------------------------------------------
+#ifdef FAT_WCACHE_SECTORS
+void fl_show_wcache(void)
+{
+    // NOTE called from debug interface, statistics are read without lock
+    fatfs_wcache_show_details(&_fs);
+}
+#endif
+//-----------------------------------------------------------------------------
 // fopen: Open or Create a file for reading or writing
 //-----------------------------------------------------------------------------
 void* fl_fopen(const char *path, const char *mode)
@@ -897,6 +1043,30 @@ static uint32 _write_sectors(FL_FILE* file, uint32 offset, uint8 *buf, uint32 co
 }
 #endif
 //-----------------------------------------------------------------------------
+// _flush_file: Write back buffered sector of file (to write-back cache if used)
+//-----------------------------------------------------------------------------
+static void _flush_file(FL_FILE *file)
+{
+#if FATFS_INC_WRITE_SUPPORT
+    uint32 written;
+    uint32 i;
+
+    // If some write data still in buffer
+    if (file->file_data_dirty)
+    {
+        // Write back buffered sectors before loading next
+        for (i=0;i<file->file_data_count;i+=written)
+        {
+            written = _write_sectors(file, file->file_data_address + i, file->file_data + i * FAT_SECTOR_SIZE, file->file_data_count - i);
+            if (!written)
+                return;
+        }
+
+        file->file_data_dirty = 0;
+    }
+#endif
+}
+//-----------------------------------------------------------------------------
 // fl_fflush: Flush un-written data to the file
 //-----------------------------------------------------------------------------
 int fl_fflush(void *f)
@@ -911,13 +1081,11 @@ int fl_fflush(void *f)
     {
         FL_LOCK(&_fs);
 
-        // If some write data still in buffer
-        if (file->file_data_dirty)
-        {
-            // Write back current sector before loading next
-            if (_write_sectors(file, file->file_data_address, file->file_data_sector, 1))
-                file->file_data_dirty = 0;
-        }
+        _flush_file(file);
+
+#ifdef FAT_WCACHE_SECTORS
+        fatfs_wcache_flush(&_fs);
+#endif
 
         FL_UNLOCK(&_fs);
     }
@@ -939,7 +1107,7 @@ void fl_fclose(void *f)
         FL_LOCK(&_fs);
 
         // Flush un-written data to file
-        fl_fflush(f);
+        _flush_file(file);
 
         // File size changed?
         if (file->filelength_changed)
@@ -954,8 +1122,7 @@ void fl_fclose(void *f)
         file->bytenum = 0;
         file->filelength = 0;
         file->startcluster = 0;
-        file->file_data_address = 0xFFFFFFFF;
-        file->file_data_dirty = 0;
+        FILE_BUFFER_INVALIDATE(file);
         file->filelength_changed = 0;
 
         // Free file handle
@@ -963,6 +1130,11 @@ void fl_fclose(void *f)
 
         fatfs_fat_purge(&_fs);
 
+#ifdef FAT_WCACHE_SECTORS
+        // NOTE file data, FAT and directory entry are written with one flush
+        fatfs_wcache_flush(&_fs);
+#endif
+
         FL_UNLOCK(&_fs);
     }
 }
@@ -1054,13 +1226,33 @@ int fl_fread(void * buffer, int size, int length, void *f )
     // Offset to start copying data from first sector
     offset = file->bytenum % FAT_SECTOR_SIZE;
 
+    // NOTE file system lock is taken only for media access, data which is
+    // in file buffer is copied without it. So file handle should not be
+    // shared between tasks without external locking.
     while (bytesRead < count)
     {        
-        // Read whole sector, read from media directly into target buffer
-        if ((offset == 0) && ((count - bytesRead) >= FAT_SECTOR_SIZE))
+        // Read at least size of file buffer, read from media directly into target buffer
+        if ((offset == 0) && ((count - bytesRead) >= FAT_SECTOR_SIZE * file->file_data_size) && !FILE_BUFFER_HIT(file, sector))
         {
+            uint32 sectorsRead;
+            uint32 sectorsLeft;
+
+            // File with pool buffer takes lock for at most buffer size
+            sectorsLeft = (count - bytesRead) / FAT_SECTOR_SIZE;
+            if (file->file_data_size > 1 && sectorsLeft > file->file_data_size)
+                sectorsLeft = file->file_data_size;
+
+            FL_LOCK(&_fs);
+
+            // Flush un-written data to file
+            if (file->file_data_dirty)
+                _flush_file(file);
+
             // Read as many sectors as possible into target buffer
-            uint32 sectorsRead = _read_sectors(file, sector, (uint8*)((uint8*)buffer + bytesRead), (count - bytesRead) / FAT_SECTOR_SIZE);        
+            sectorsRead = _read_sectors(file, sector, (uint8*)((uint8*)buffer + bytesRead), sectorsLeft);        
+
+            FL_UNLOCK(&_fs);
+
             if (sectorsRead)
             {
                 // We have upto one sector to copy
@@ -1076,19 +1268,35 @@ int fl_fread(void * buffer, int size, int length, void *f )
         else
         {
             // Do we need to re-read the sector?
-            if (file->file_data_address != sector)
+            if (!FILE_BUFFER_HIT(file, sector))
             {
+                uint32 sectorsRead;
+                uint32 sectorsLeft;
+
+                FL_LOCK(&_fs);
+
                 // Flush un-written data to file
                 if (file->file_data_dirty)
-                    fl_fflush(file);
+                    _flush_file(file);
+
+                FILE_BUFFER_INVALIDATE(file);
+
+                // Fill buffer, but not past end of file
+                sectorsLeft = (file->filelength + FAT_SECTOR_SIZE - 1) / FAT_SECTOR_SIZE - sector;
+                if (sectorsLeft > file->file_data_size)
+                    sectorsLeft = file->file_data_size;
 
                 // Get LBA of sector offset within file
-                if (!_read_sectors(file, sector, file->file_data_sector, 1))
+                sectorsRead = _read_sectors(file, sector, file->file_data, sectorsLeft);
+
+                FL_UNLOCK(&_fs);
+
+                if (!sectorsRead)
                     // Read failed - out of range (probably)
                     break;
 
                 file->file_data_address = sector;
-                file->file_data_dirty = 0;
+                file->file_data_count = sectorsRead;
             }
         
             // We have upto one sector to copy
@@ -1099,7 +1307,7 @@ int fl_fread(void * buffer, int size, int length, void *f )
                 copyCount = (count - bytesRead);
 
             // Copy to application buffer
-            memcpy( (uint8*)((uint8*)buffer + bytesRead), (uint8*)(file->file_data_sector + offset), copyCount);
+            memcpy( (uint8*)((uint8*)buffer + bytesRead), (uint8*)(file->file_data + (sector - file->file_data_address) * FAT_SECTOR_SIZE + offset), copyCount);
 
             // Move onto next sector and reset copy offset
             sector++;
@@ -1134,9 +1342,11 @@ int fl_fseek( void *f, long offset, int origin )
 
     FL_LOCK(&_fs);
 
+    // Flush un-written data to file
+    _flush_file(file);
+
     // Invalidate file buffer
-    file->file_data_address = 0xFFFFFFFF;
-    file->file_data_dirty = 0;
+    FILE_BUFFER_INVALIDATE(file);
 
     if (origin == SEEK_SET)
     {
@@ -1299,15 +1509,14 @@ int fl_fwrite(const void * data, int size, int count, void *f )
         {
             uint32 sectorsWrote;
 
-            // Buffered sector, flush back to disk
-            if (file->file_data_address != 0xFFFFFFFF)
+            // Buffered sectors, flush back to disk
+            if (file->file_data_count)
             {
                 // Flush un-written data to file
                 if (file->file_data_dirty)
-                    fl_fflush(file);
+                    _flush_file(file);
 
-                file->file_data_address = 0xFFFFFFFF;
-                file->file_data_dirty = 0;
+                FILE_BUFFER_INVALIDATE(file);
             }
 
             // Write as many sectors as possible
@@ -1337,11 +1546,14 @@ int fl_fwrite(const void * data, int size, int count, void *f )
                 copyCount = (length - bytesWritten);
 
             // Do we need to read a new sector?
-            if (file->file_data_address != sector)
+            if (!FILE_BUFFER_HIT(file, sector))
             {
                 // Flush un-written data to file
                 if (file->file_data_dirty)
-                    fl_fflush(file);
+                    _flush_file(file);
+
+                // NOTE writes load single sector into buffer
+                FILE_BUFFER_INVALIDATE(file);
 
                 // If we plan to overwrite the whole sector, we don't need to read it first!
                 if (copyCount != FAT_SECTOR_SIZE)
@@ -1351,16 +1563,16 @@ int fl_fwrite(const void * data, int size, int count, void *f )
                     // allocate some more space for new data.
 
                     // Get LBA of sector offset within file
-                    if (!_read_sectors(file, sector, file->file_data_sector, 1))
-                        memset(file->file_data_sector, 0x00, FAT_SECTOR_SIZE);    
+                    if (!_read_sectors(file, sector, file->file_data, 1))
+                        memset(file->file_data, 0x00, FAT_SECTOR_SIZE);    
                 }
 
                 file->file_data_address = sector;
-                file->file_data_dirty = 0;
+                file->file_data_count = 1;
             }
 
             // Copy from application buffer into sector buffer
-            memcpy((uint8*)(file->file_data_sector + offset), (uint8*)(buffer + bytesWritten), copyCount);
+            memcpy((uint8*)(file->file_data + (sector - file->file_data_address) * FAT_SECTOR_SIZE + offset), (uint8*)(buffer + bytesWritten), copyCount);
 
             // Mark buffer as dirty
             file->file_data_dirty = 1;
@@ -1417,6 +1629,10 @@ int fl_remove( const char * filename )
     FL_FILE* file;
     int res = -1;
 
+    // Read only media
+    if (!_fs.disk_io.write_media)
+        return -1;
+
     FL_LOCK(&_fs);
 
     // Use read_file as this will check if the file is already open!
@@ -1454,6 +1670,10 @@ int fl_createdirectory(const char *path)
     // If first call to library, initialise
     CHECK_FL_INIT();
 
+    // Read only media
+    if (!_fs.disk_io.write_media)
+        return 0;
+
     FL_LOCK(&_fs);
     res =_create_directory((char*)path);
     FL_UNLOCK(&_fs);
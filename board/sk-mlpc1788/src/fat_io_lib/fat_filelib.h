@@ -56,7 +56,12 @@ typedef struct sFL_FILE
 
     // Read/Write sector buffer
     uint8                   file_data_sector[FAT_SECTOR_SIZE];
+    // Buffer in use (file_data_sector or buffer from pool)
+    uint8                  *file_data;
+    // First buffered sector, number of valid sectors and buffer size
     uint32                  file_data_address; 
+    uint32                  file_data_count;
+    uint32                  file_data_size;
     int                     file_data_dirty;
 
     // File fopen flags
@@ -110,6 +115,12 @@ int                 fl_closedir(FL_DIR* dir);
 void                fl_listdirectory(const char *path);
 int                 fl_createdirectory(const char *path);
 int                 fl_is_dir(const char *path);
+#ifdef FAT_WCACHE_SECTORS
+void                fl_show_wcache(void);
+#endif
+#ifdef FATFS_FILE_BUFFER_POOL
+int                 fl_setvbuf(void *file, uint32 sectors);
+#endif
 
 // Test hooks
 #ifdef FATFS_INC_TEST_HOOKS
@@ -21,9 +21,16 @@
 
 // Max open files (reduce to lower memory requirements)
 #ifndef FATFS_MAX_OPEN_FILES
-    #define FATFS_MAX_OPEN_FILES            2
+    #define FATFS_MAX_OPEN_FILES            8
 #endif
 
+// Sectors in pool of per-file read buffers (can be undefined)
+// Mem used = FATFS_FILE_BUFFER_POOL * FAT_SECTOR_SIZE
+// Buffer is attached to opened file with fl_setvbuf(), file without
+// pool buffer uses its own one sector buffer
+// (player: PLAYER_TRACK_VBUF + PLAYER_IMAGE_VBUF, rest for other readers)
+#define FATFS_FILE_BUFFER_POOL            48
+
 // Number of sectors per FAT_BUFFER (min 1)
 #ifndef FAT_BUFFER_SECTORS
     #define FAT_BUFFER_SECTORS              1
@@ -40,6 +47,17 @@
 // Improves access speed considerably
 #define FAT_CLUSTER_CACHE_ENTRIES         128
 
+// Size of write-back sector cache in sectors (can be undefined)
+// Mem used = FAT_WCACHE_SECTORS * (FAT_SECTOR_SIZE + 8)
+// Dirty sectors are written to media in ascending LBA runs on flush
+#define FAT_WCACHE_SECTORS                512
+
+// Max clusters covered by in-memory free cluster bitmap (can be undefined)
+// Mem used = FAT_FREEMAP_CLUSTERS / 8
+// Bitmap is built from FAT on first allocation or free space query,
+// volumes with more clusters use linear scan of FAT
+#define FAT_FREEMAP_CLUSTERS              (2 * 1024 * 1024)
+
 // Include support for writing files (1 / 0)? 
 #ifndef FATFS_INC_WRITE_SUPPORT
     #define FATFS_INC_WRITE_SUPPORT         1
@@ -61,6 +79,12 @@
     #define FATFS_INC_FORMAT_SUPPORT        1
 #endif
 
+// Support reading of exFAT volumes (1 / 0)?
+// (exFAT volumes are mounted read only)
+#ifndef FATFS_INC_EXFAT_SUPPORT
+    #define FATFS_INC_EXFAT_SUPPORT         1
+#endif
+
 // Sector size used
 #define FAT_SECTOR_SIZE                     512
 
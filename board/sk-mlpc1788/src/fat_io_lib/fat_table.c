@@ -33,6 +33,8 @@
 #include "fat_defs.h"
 #include "fat_access.h"
 #include "fat_table.h"
+#include "fat_wcache.h"
+#include "fat_exfat.h"
 
 #ifndef FAT_BUFFERS
     #define FAT_BUFFERS 1
@@ -64,6 +66,17 @@ void fatfs_fat_init(struct fatfs *fs)
     // FAT buffer chain head
     fs->fat_buffer_head = NULL;
 
+#ifdef FAT_WCACHE_SECTORS
+    // Discard sectors which are not written back
+    fatfs_wcache_init(fs);
+#endif
+
+#ifdef FAT_FREEMAP_CLUSTERS
+    // Free cluster bitmap should be rebuilt
+    fs->freemap.valid = 0;
+    fs->freemap.entries = 0;
+#endif
+
     for (i=0;i<FAT_BUFFERS;i++)
     {
         // Initialise buffers to invalid
@@ -98,7 +111,7 @@ static int fatfs_fat_writeback(struct fatfs *fs, struct fat_buffer *pcur)
                 else
                     sectors = fs->fat_sectors - offset;
 
-                if (!fs->disk_io.write_media(pcur->address, pcur->sector, sectors))
+                if (!fatfs_sector_write_meta(fs, pcur->address, pcur->sector, sectors))
                     return 0;
             }
                 
@@ -163,7 +176,7 @@ static struct fat_buffer *fatfs_fat_read_sector(struct fatfs *fs, uint32 sector)
     pcur->address = sector;
 
     // Read next sector
-    if (!fs->disk_io.read_media(pcur->address, pcur->sector, FAT_BUFFER_SECTORS))
+    if (!fatfs_sector_read(fs, pcur->address, pcur->sector, FAT_BUFFER_SECTORS))
     {
         // Read failed, invalidate buffer address
         pcur->address = FAT32_INVALID_CLUSTER;
@@ -194,6 +207,122 @@ int fatfs_fat_purge(struct fatfs *fs)
     return 1;
 }
 
+//-----------------------------------------------------------------------------
+//                          Free Cluster Bitmap
+//-----------------------------------------------------------------------------
+#ifdef FAT_FREEMAP_CLUSTERS
+//-----------------------------------------------------------------------------
+// fatfs_freemap_build: Build free cluster bitmap with one pass over FAT (if
+// not built yet). Returns 1 if bitmap can be used.
+//-----------------------------------------------------------------------------
+static int fatfs_freemap_build(struct fatfs *fs)
+{
+    struct fat_freemap *fm = &fs->freemap;
+    struct fat_buffer *pbuf;
+    uint32 entries_per_sector;
+    uint32 cluster;
+    uint32 value;
+    uint32 i, j;
+
+    if (fm->valid)
+        return 1;
+
+    // Volume not mounted or too large for bitmap
+    if (fm->entries == 0 || fm->entries > FAT_FREEMAP_CLUSTERS)
+        return 0;
+
+    memset(fm->map, 0x00, sizeof(fm->map));
+    fm->free = 0;
+
+    if (fs->fat_type == FAT_TYPE_16)
+        entries_per_sector = FAT_SECTOR_SIZE / 2;
+    else
+        entries_per_sector = FAT_SECTOR_SIZE / 4;
+
+    cluster = 0;
+    for (i = 0; i < fs->fat_sectors && cluster < fm->entries; i++)
+    {
+        // Read FAT sector into buffer
+        pbuf = fatfs_fat_read_sector(fs, fs->fat_begin_lba + i);
+        if (!pbuf)
+            return 0;
+
+        for (j = 0; j < entries_per_sector && cluster < fm->entries; j++, cluster++)
+        {
+            if (fs->fat_type == FAT_TYPE_16)
+                value = FAT16_GET_16BIT_WORD(pbuf, (uint16)(j * 2));
+            else
+                value = FAT32_GET_32BIT_WORD(pbuf, (uint16)(j * 4)) & 0x0FFFFFFF;
+
+            // NOTE first two entries are reserved
+            if (value == 0 && cluster >= 2)
+            {
+                fm->map[cluster / 32] |= (1UL << (cluster % 32));
+                fm->free++;
+            }
+        }
+    }
+
+    fm->valid = 1;
+    return 1;
+}
+//-----------------------------------------------------------------------------
+// fatfs_freemap_set: Update bitmap when FAT entry is changed
+//-----------------------------------------------------------------------------
+static void fatfs_freemap_set(struct fatfs *fs, uint32 cluster, uint32 next_cluster)
+{
+    struct fat_freemap *fm = &fs->freemap;
+    uint32 mask;
+
+    if (!fm->valid || cluster < 2 || cluster >= fm->entries)
+        return;
+
+    mask = 1UL << (cluster % 32);
+
+    if (next_cluster == 0)
+    {
+        if (!(fm->map[cluster / 32] & mask))
+        {
+            fm->map[cluster / 32] |= mask;
+            fm->free++;
+        }
+    }
+    else
+    {
+        if (fm->map[cluster / 32] & mask)
+        {
+            fm->map[cluster / 32] &= ~mask;
+            fm->free--;
+        }
+    }
+}
+//-----------------------------------------------------------------------------
+// fatfs_freemap_next: Find first free (or used if free = 0) cluster starting
+// from specified one. Returns number of FAT entries if not found.
+//-----------------------------------------------------------------------------
+static uint32 fatfs_freemap_next(struct fatfs *fs, uint32 cluster, int free)
+{
+    struct fat_freemap *fm = &fs->freemap;
+    uint32 bits;
+
+    while (cluster < fm->entries)
+    {
+        bits = free ? fm->map[cluster / 32] : ~fm->map[cluster / 32];
+        bits &= 0xFFFFFFFF << (cluster % 32);
+
+        if (bits)
+        {
+            cluster = (cluster & ~31) + __builtin_ctz(bits);
+            break;
+        }
+
+        cluster = (cluster & ~31) + 32;
+    }
+
+    return cluster < fm->entries ? cluster : fm->entries;
+}
+#endif
+
 //-----------------------------------------------------------------------------
 //                        General FAT Table Operations
 //-----------------------------------------------------------------------------
@@ -212,6 +341,17 @@ uint32 fatfs_find_next_cluster(struct fatfs *fs, uint32 current_cluster)
     if (current_cluster == 0) 
         current_cluster = 2;
 
+#if FATFS_INC_EXFAT_SUPPORT
+    // exFAT file without FAT chain, clusters are contiguous
+    if (current_cluster & FAT_EXFAT_NOFATCHAIN)
+    {
+        if ((current_cluster & ~FAT_EXFAT_NOFATCHAIN) + 1 >= fs->exfat.cluster_count + 2)
+            return (FAT32_LAST_CLUSTER);
+
+        return current_cluster + 1;
+    }
+#endif
+
     // Find which sector of FAT table to read
     if (fs->fat_type == FAT_TYPE_16)
         fat_sector_offset = current_cluster / 256;
@@ -274,7 +414,7 @@ void fatfs_set_fs_info_next_free_cluster(struct fatfs *fs, uint32 newValue)
 
         // Write back FSINFO sector to disk
         if (fs->disk_io.write_media)
-            fs->disk_io.write_media(pbuf->address, pbuf->sector, 1);    
+            fatfs_sector_write_meta(fs, pbuf->address, pbuf->sector, 1);    
 
         // Invalidate cache entry
         pbuf->address = FAT32_INVALID_CLUSTER;
@@ -292,6 +432,18 @@ int fatfs_find_blank_cluster(struct fatfs *fs, uint32 start_cluster, uint32 *fre
     uint32 current_cluster = start_cluster;
     struct fat_buffer *pbuf;
 
+#ifdef FAT_FREEMAP_CLUSTERS
+    if (fatfs_freemap_build(fs))
+    {
+        current_cluster = fatfs_freemap_next(fs, current_cluster < 2 ? 2 : current_cluster, 1);
+        if (current_cluster >= fs->freemap.entries)
+            return 0;
+
+        *free_cluster = current_cluster;
+        return 1;
+    }
+#endif
+
     do
     {
         // Find which sector of FAT table to read
@@ -342,6 +494,62 @@ int fatfs_find_blank_cluster(struct fatfs *fs, uint32 start_cluster, uint32 *fre
 } 
 #endif
 //-----------------------------------------------------------------------------
+// fatfs_find_blank_run: Find a free cluster for chain which last cluster is
+// prev_cluster (0 for new chain) and which needs count clusters more. Cluster
+// which follows prev_cluster is preferred, then first run of at least count
+// free clusters, then longest run found. So written files stay contiguous.
+//-----------------------------------------------------------------------------
+#if FATFS_INC_WRITE_SUPPORT
+int fatfs_find_blank_run(struct fatfs *fs, uint32 prev_cluster, uint32 count, uint32 *free_cluster)
+{
+#ifdef FAT_FREEMAP_CLUSTERS
+    uint32 cluster, end;
+    uint32 best, best_len;
+
+    if (fatfs_freemap_build(fs))
+    {
+        // Continue chain in place
+        if (prev_cluster >= 2 && fatfs_freemap_next(fs, prev_cluster + 1, 1) == (prev_cluster + 1))
+        {
+            *free_cluster = prev_cluster + 1;
+            return 1;
+        }
+
+        best = 0;
+        best_len = 0;
+
+        cluster = fatfs_freemap_next(fs, 2, 1);
+        while (cluster < fs->freemap.entries)
+        {
+            end = fatfs_freemap_next(fs, cluster, 0);
+
+            if ((end - cluster) >= count)
+            {
+                *free_cluster = cluster;
+                return 1;
+            }
+
+            if ((end - cluster) > best_len)
+            {
+                best = cluster;
+                best_len = end - cluster;
+            }
+
+            cluster = fatfs_freemap_next(fs, end, 1);
+        }
+
+        if (best_len == 0)
+            return 0;
+
+        *free_cluster = best;
+        return 1;
+    }
+#endif
+
+    return fatfs_find_blank_cluster(fs, fs->rootdir_first_cluster, free_cluster);
+}
+#endif
+//-----------------------------------------------------------------------------
 // fatfs_fat_set_cluster: Set a cluster link in the chain. NOTE: Immediate
 // write (slow).
 //-----------------------------------------------------------------------------
@@ -379,6 +587,11 @@ int fatfs_fat_set_cluster(struct fatfs *fs, uint32 cluster, uint32 next_cluster)
         FAT32_SET_32BIT_WORD(pbuf, (uint16)position, next_cluster);     
     }
 
+#ifdef FAT_FREEMAP_CLUSTERS
+    // Keep free cluster bitmap in sync
+    fatfs_freemap_set(fs, cluster, next_cluster);
+#endif
+
     return 1;                     
 } 
 #endif
@@ -448,6 +661,16 @@ uint32 fatfs_count_free_clusters(struct fatfs *fs)
     uint32 count = 0;
     struct fat_buffer *pbuf;
 
+#if FATFS_INC_EXFAT_SUPPORT
+    if (fs->fat_type == FAT_TYPE_EXFAT)
+        return fatfs_exfat_count_free_clusters(fs);
+#endif
+
+#ifdef FAT_FREEMAP_CLUSTERS
+    if (fatfs_freemap_build(fs))
+        return fs->freemap.free;
+#endif
+
     for (i = 0; i < fs->fat_sectors; i++)
     {
         // Read FAT sector into buffer
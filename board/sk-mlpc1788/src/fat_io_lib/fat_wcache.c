@@ -0,0 +1,258 @@
+//-----------------------------------------------------------------------------
+//-----------------------------------------------------------------------------
+//                            FAT16/32 File IO Library
+//                                    V2.6
+//                              Ultra-Embedded.com
+//                            Copyright 2003 - 2012
+//
+//                         Email: admin@ultra-embedded.com
+//
+//                                License: GPL
+//   If you would like a version with a more permissive license for use in
+//   closed source commercial applications please contact me for details.
+//-----------------------------------------------------------------------------
+//
+// This file is part of FAT File IO Library.
+//
+// FAT File IO Library is free software; you can redistribute it and/or modify
+// it under the terms of the GNU General Public License as published by
+// the Free Software Foundation; either version 2 of the License, or
+// (at your option) any later version.
+//
+// FAT File IO Library is distributed in the hope that it will be useful,
+// but WITHOUT ANY WARRANTY; without even the implied warranty of
+// MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the
+// GNU General Public License for more details.
+//
+// You should have received a copy of the GNU General Public License
+// along with FAT File IO Library; if not, write to the Free Software
+// Foundation, Inc., 59 Temple Place, Suite 330, Boston, MA  02111-1307  USA
+//-----------------------------------------------------------------------------
+#include <string.h>
+#include <debug.h>
+#include <stimer.h>
+#include "fat_defs.h"
+#include "fat_access.h"
+#include "fat_wcache.h"
+
+// Write-back sector cache.
+// Sectors written by the library are kept in memory until flush, when they
+// are written to media as runs of consecutive sectors (multiple block
+// writes). File data is always written before FAT and directory sectors,
+// so interrupted flush does not leave metadata which refers to unwritten
+// data.
+
+#ifdef FAT_WCACHE_SECTORS
+
+//-----------------------------------------------------------------------------
+// fatfs_wcache_init: Discard all cached sectors and reset statistics
+//-----------------------------------------------------------------------------
+void fatfs_wcache_init(struct fatfs *fs)
+{
+    struct fat_wcache *wc = &fs->wcache;
+
+    wc->count = 0;
+
+    wc->dirty_max = 0;
+    wc->flushes = 0;
+    wc->flush_runs = 0;
+    wc->flush_sectors = 0;
+    wc->flush_time_last = 0;
+    wc->flush_time_max = 0;
+}
+//-----------------------------------------------------------------------------
+// fatfs_wcache_find: Return position in sorted list of first sector which
+// address is not less than lba
+//-----------------------------------------------------------------------------
+static int fatfs_wcache_find(struct fatfs *fs, uint32 lba)
+{
+    struct fat_wcache *wc = &fs->wcache;
+    int lo = 0;
+    int hi = wc->count;
+    int mid;
+
+    while (lo < hi)
+    {
+        mid = (lo + hi) / 2;
+
+        if (wc->address[wc->order[mid]] < lba)
+            lo = mid + 1;
+        else
+            hi = mid;
+    }
+
+    return lo;
+}
+//-----------------------------------------------------------------------------
+// fatfs_wcache_read: Read sectors from media, sectors which are not written
+// back yet are taken from cache
+//-----------------------------------------------------------------------------
+int fatfs_wcache_read(struct fatfs *fs, uint32 lba, uint8 *target, uint32 count)
+{
+    struct fat_wcache *wc = &fs->wcache;
+    uint32 slot;
+    int first, last;
+    int i;
+
+    // Find cached sectors within requested range
+    first = fatfs_wcache_find(fs, lba);
+    for (last = first; last < wc->count; last++)
+        if (wc->address[wc->order[last]] >= (lba + count))
+            break;
+
+    // Read from media unless whole range is cached
+    if ((uint32)(last - first) != count)
+        if (!fs->disk_io.read_media(lba, target, count))
+            return 0;
+
+    for (i = first; i < last; i++)
+    {
+        slot = wc->order[i];
+        memcpy(target + (wc->address[slot] - lba) * FAT_SECTOR_SIZE, wc->sector[slot], FAT_SECTOR_SIZE);
+    }
+
+    return 1;
+}
+//-----------------------------------------------------------------------------
+// fatfs_wcache_write: Put sectors to cache, cache is flushed if there is no
+// free space
+//-----------------------------------------------------------------------------
+int fatfs_wcache_write(struct fatfs *fs, uint32 lba, uint8 *target, uint32 count, int meta)
+{
+    struct fat_wcache *wc = &fs->wcache;
+    uint32 slot;
+    int i;
+
+    // No write access?
+    if (!fs->disk_io.write_media)
+        return 0;
+
+    while (count--)
+    {
+        i = fatfs_wcache_find(fs, lba);
+
+        // Sector already cached, overwrite it
+        if (i < wc->count && wc->address[wc->order[i]] == lba)
+            slot = wc->order[i];
+        else
+        {
+            if (wc->count == FAT_WCACHE_SECTORS)
+            {
+                if (!fatfs_wcache_flush(fs))
+                    return 0;
+                i = 0;
+            }
+
+            // NOTE slots are allocated sequentially, so sectors of
+            // sequentially written file are adjacent in memory too
+            slot = wc->count;
+
+            // Insert into sorted list
+            memmove(&wc->order[i + 1], &wc->order[i], (wc->count - i) * sizeof(wc->order[0]));
+            wc->order[i] = slot;
+            wc->address[slot] = lba;
+            wc->meta[slot] = 0;
+
+            wc->count++;
+            if (wc->count > wc->dirty_max)
+                wc->dirty_max = wc->count;
+        }
+
+        memcpy(wc->sector[slot], target, FAT_SECTOR_SIZE);
+        if (meta)
+            wc->meta[slot] = 1;
+
+        lba++;
+        target += FAT_SECTOR_SIZE;
+    }
+
+    return 1;
+}
+//-----------------------------------------------------------------------------
+// fatfs_wcache_writeback: Write cached sectors of one kind (data or meta) to
+// media, in ascending order of address
+//-----------------------------------------------------------------------------
+static int fatfs_wcache_writeback(struct fatfs *fs, int meta)
+{
+    struct fat_wcache *wc = &fs->wcache;
+    uint32 slot, next;
+    int i, n;
+
+    i = 0;
+    while (i < wc->count)
+    {
+        slot = wc->order[i];
+        if (wc->meta[slot] != meta)
+        {
+            i++;
+            continue;
+        }
+
+        // Extend run while both sector address and slot are consecutive
+        for (n = 1; (i + n) < wc->count; n++)
+        {
+            next = wc->order[i + n];
+
+            if (wc->meta[next] != meta || next != (slot + n) || wc->address[next] != (wc->address[slot] + n))
+                break;
+        }
+
+        if (!fs->disk_io.write_media(wc->address[slot], wc->sector[slot], n))
+            return 0;
+
+        wc->flush_runs++;
+        wc->flush_sectors += n;
+
+        i += n;
+    }
+
+    return 1;
+}
+//-----------------------------------------------------------------------------
+// fatfs_wcache_flush: Write all cached sectors to media
+//-----------------------------------------------------------------------------
+int fatfs_wcache_flush(struct fatfs *fs)
+{
+    struct fat_wcache *wc = &fs->wcache;
+    uint32 t;
+
+    if (wc->count == 0)
+        return 1;
+
+    stimer_settime(&t);
+
+    // Data first, FAT and directory entries after
+    // NOTE on error sectors are kept in cache, rewrite of sector is harmless
+    if (!fatfs_wcache_writeback(fs, 0))
+        return 0;
+    if (!fatfs_wcache_writeback(fs, 1))
+        return 0;
+
+    wc->count = 0;
+
+    t = stimer_deltatime(t);
+    wc->flush_time_last = t;
+    if (t > wc->flush_time_max)
+        wc->flush_time_max = t;
+    wc->flushes++;
+
+    return 1;
+}
+//-----------------------------------------------------------------------------
+// fatfs_wcache_show_details: Show statistics of write-back cache
+//-----------------------------------------------------------------------------
+void fatfs_wcache_show_details(struct fatfs *fs)
+{
+    struct fat_wcache *wc = &fs->wcache;
+
+    dprint("sn",    "FAT write cache:");
+    dprint("s4dn",  " Dirty sectors          = ", wc->count);
+    dprint("s4dn",  " Dirty sectors max      = ", wc->dirty_max);
+    dprint("s4dn",  " Flushes                = ", wc->flushes);
+    dprint("s4dn",  " Flushed sectors        = ", wc->flush_sectors);
+    dprint("s4dn",  " Media writes           = ", wc->flush_runs);
+    dprint("s4dsn", " Last flush time        = ", wc->flush_time_last, " ms");
+    dprint("s4dsn", " Max flush time         = ", wc->flush_time_max, " ms");
+}
+
+#endif
@@ -0,0 +1,18 @@
+#ifndef __FAT_WCACHE_H__
+#define __FAT_WCACHE_H__
+
+#include "fat_opts.h"
+#include "fat_access.h"
+
+//-----------------------------------------------------------------------------
+// Prototypes
+//-----------------------------------------------------------------------------
+#ifdef FAT_WCACHE_SECTORS
+void    fatfs_wcache_init(struct fatfs *fs);
+int     fatfs_wcache_read(struct fatfs *fs, uint32 lba, uint8 *target, uint32 count);
+int     fatfs_wcache_write(struct fatfs *fs, uint32 lba, uint8 *target, uint32 count, int meta);
+int     fatfs_wcache_flush(struct fatfs *fs);
+void    fatfs_wcache_show_details(struct fatfs *fs);
+#endif
+
+#endif
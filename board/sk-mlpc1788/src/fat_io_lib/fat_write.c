@@ -54,8 +54,8 @@ int fatfs_add_free_space(struct fatfs *fs, uint32 *startCluster, uint32 clusters
 
     for (i=0;i<clusters;i++)
     {
-        // Start looking for free clusters from the beginning
-        if (fatfs_find_blank_cluster(fs, fs->rootdir_first_cluster, &nextcluster))
+        // Prefer cluster next to end of chain or contiguous run of free clusters
+        if (fatfs_find_blank_run(fs, start, clusters - i, &nextcluster))
         {
             // Point last to this
             fatfs_fat_set_cluster(fs, start, nextcluster);
@@ -103,7 +103,7 @@ int fatfs_allocate_free_space(struct fatfs *fs, int newFile, uint32 *startCluste
     // Allocated first link in the chain if a new file
     if (newFile)
     {
-        if (!fatfs_find_blank_cluster(fs, fs->rootdir_first_cluster, &nextcluster))
+        if (!fatfs_find_blank_run(fs, 0, clusterCount, &nextcluster))
             return 0;
 
         // If this is all that is needed then all done
@@ -334,7 +334,7 @@ int fatfs_add_file_entry(struct fatfs *fs, uint32 dirCluster, char *filename, ch
                         memcpy(&fs->currentsector.sector[recordoffset], &shortEntry, sizeof(shortEntry));
 
                         // Writeback
-                        return fs->disk_io.write_media(fs->currentsector.address, fs->currentsector.sector, 1);
+                        return fatfs_sector_write_meta(fs, fs->currentsector.address, fs->currentsector.sector, 1);
                     }
 #if FATFS_INC_LFN_SUPPORT
                     else
@@ -352,7 +352,7 @@ int fatfs_add_file_entry(struct fatfs *fs, uint32 dirCluster, char *filename, ch
             // Write back to disk before loading another sector
             if (dirtySector)
             {
-                if (!fs->disk_io.write_media(fs->currentsector.address, fs->currentsector.sector, 1))
+                if (!fatfs_sector_write_meta(fs, fs->currentsector.address, fs->currentsector.sector, 1))
                     return 0;
 
                 dirtySector = 0;
@@ -60,6 +60,7 @@ void gpioirq_init()
  */
 void GPIO_Handler(void)
 {
+    os_irq_enter(GPIO_IRQn);
 //    dprint("sn", "Handler");
     /*
      * Buttons
@@ -109,5 +110,6 @@ void GPIO_Handler(void)
         if (enc)
             os_event_raise(&gpioirq.evirq, GPIOIRQ_EVENT_ENCODER);
     }
+    os_irq_exit(GPIO_IRQn);
 }
 
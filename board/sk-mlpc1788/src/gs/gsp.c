@@ -508,6 +508,7 @@ void gsp_wait_vsync()
  */
 void LCD_Handler(void)
 {
+    os_irq_enter(LCD_IRQn);
     if (LPC_LCD->INTSTAT & LCD_INTMSK_LNBUI)
     {
         LPC_LCD->INTCLR = LCD_INTMSK_LNBUI;
@@ -515,8 +516,8 @@ void LCD_Handler(void)
         NVIC_DisableIRQ(LCD_IRQn);
 #endif
         os_event_raise(&gsp.event, GSP_EVENT_MASK_VSYNC);
-        return;
     }
+    os_irq_exit(LCD_IRQn);
 }
 
 /*
@@ -0,0 +1,138 @@
+/* 
+ *     This file is part of K11, hardware multimedia player.
+ * 
+ * Copyright (C) 2014 Dmitry Kobylin
+ * 
+ * This program is free software: you can redistribute it and/or modify
+ * it under the terms of the GNU General Public License as published by
+ * the Free Software Foundation, either version 3 of the License, or
+ * (at your option) any later version.
+ * 
+ * This program is distributed in the hope that it will be useful,
+ * but WITHOUT ANY WARRANTY; without even the implied warranty of
+ * MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the
+ * GNU General Public License for more details.
+ * 
+ * You should have received a copy of the GNU General Public License
+ * along with this program.  If not, see <http://www.gnu.org/licenses/>.
+ *
+ */
+
+/*
+ * Overlay with CPU load (look at os_cpustat.h), enabled in "tinfo" of
+ * osw_objects.c.
+ */
+#include <os.h>
+#include <debug.h>
+#include "gsload.h"
+#include "../gs/gs.h"
+
+#define GSLOAD_TOP        3     /* number of most loaded tasks to show */
+
+#define GSLOAD_FONT       GS_FONT_7X8
+#define GSLOAD_FONT_COLOR GS_COLOR_YELLOW
+#define GSLOAD_PADX       4
+#define GSLOAD_PADY       4
+
+#define GSLOAD_WIN_WIDTH  (18 * 7 + GSLOAD_PADX * 2)
+#define GSLOAD_WIN_HEIGHT ((2 + GSLOAD_TOP) * 8 + GSLOAD_PADY * 2)
+#define GSLOAD_WIN_POSX   (GS_RES_HORIZONTAL - GSLOAD_WIN_WIDTH)
+#define GSLOAD_WIN_POSY   (0)
+
+#ifdef OS_CONFIG_USE_CPUSTAT
+static void gsload_line(char *line, char *name, struct os_cpuload_t *ld);
+#endif
+
+/*
+ *
+ */
+void gsload_task()
+{
+#ifdef OS_CONFIG_USE_CPUSTAT
+#define LINE_SIZE_MAX    64
+    char line[LINE_SIZE_MAX];
+    int i, n, t, y, count, idx[OS_CONFIG_TASK_COUNT + 1];
+    struct gs_win_t *win;
+
+    while (!gs_initialized())
+        os_wait_ms(10);
+
+    /* first window of statistics is not complete yet */
+    os_wait_ms(1000);
+
+    win = gs_win_create(GSLOAD_WIN_POSX, GSLOAD_WIN_POSY, GSLOAD_WIN_WIDTH, GSLOAD_WIN_HEIGHT);
+    if (!win)
+    {
+        dprint("sn", ERR_PREFIX "Failed to create load window");
+        os_wait(OS_WAIT_FOREVER);
+    }
+    gs_win_set_border(win, 1, GS_COLOR_WHITE);
+
+    while (1)
+    {
+        /* most loaded tasks first, idle task is skipped */
+        for (i = 1; i < os_cpustat.ntasks; i++)
+            idx[i - 1] = i;
+        count = os_cpustat.ntasks - 1;
+        for (n = 0; n < GSLOAD_TOP && n < count; n++)
+        {
+            for (i = n + 1; i < count; i++)
+            {
+                if (os_cpustat.load[OS_CPUSTAT_TASK(idx[i])].load1 >
+                        os_cpustat.load[OS_CPUSTAT_TASK(idx[n])].load1)
+                {
+                    t      = idx[n];
+                    idx[n] = idx[i];
+                    idx[i] = t;
+                }
+            }
+        }
+
+        gs_win_clear(win);
+        y = GSLOAD_PADY;
+        gsload_line(line, "CPU", &os_cpustat.load[OS_CPUSTAT_TOTAL]);
+        gs_text_put(win, line, GSLOAD_PADX, y, GSLOAD_FONT_COLOR, win->bgcolor.value, GSLOAD_FONT);
+        y += GSLOAD_FONT->height;
+        gsload_line(line, "IRQ", &os_cpustat.load[OS_CPUSTAT_IRQ]);
+        gs_text_put(win, line, GSLOAD_PADX, y, GSLOAD_FONT_COLOR, win->bgcolor.value, GSLOAD_FONT);
+        y += GSLOAD_FONT->height;
+        for (n = 0; n < GSLOAD_TOP && n < count; n++)
+        {
+            gsload_line(line, os_cpustat.names[idx[n]], &os_cpustat.load[OS_CPUSTAT_TASK(idx[n])]);
+            gs_text_put(win, line, GSLOAD_PADX, y, GSLOAD_FONT_COLOR, win->bgcolor.value, GSLOAD_FONT);
+            y += GSLOAD_FONT->height;
+        }
+        gs_win_refresh(win);
+
+        os_wait_ms(1000);
+    }
+#else
+    os_wait(OS_WAIT_FOREVER);
+#endif
+}
+
+#ifdef OS_CONFIG_USE_CPUSTAT
+/*
+ * "name     xx.x% (xx.x%)", load of last second and of last 10 seconds
+ */
+static void gsload_line(char *line, char *name, struct os_cpuload_t *ld)
+{
+    char sname[9];
+    int i;
+
+    /* name is cut or padded to 8 symbols */
+    for (i = 0; i < sizeof(sname) - 1; i++)
+    {
+        if (name && *name)
+            sname[i] = *name++;
+        else
+            sname[i] = ' ';
+    }
+    sname[i] = 0;
+
+    sprint(line, "sd*.ds*(d*.ds",
+            sname,
+            ld->load1 / 10, ld->load1 % 10, "% ",
+            ld->load10 / 10, ld->load10 % 10, "%)");
+}
+#endif
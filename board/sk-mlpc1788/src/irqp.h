@@ -24,13 +24,14 @@
 /*
  * look at "lib/os/src/port/ARMv7-M/port.c" for split to group/sub priorities
  *
- * Systick has 1 as group priority. DPort has 0 as group priority.
- * Don't use this groups.
+ * Systick and OS clock (TIMER2) have 1 as group priority. DPort has 0 as
+ * group priority. Don't use this groups.
  *
  */
 #define GROUP_PRIORITY(n) (n << 5) /* 8 values (3 bits) */
 #define SUB_PRIORITY(n)   (n << 3) /* 4 values (2 bits) */
 
+#define OSCLK_IRQP (GROUP_PRIORITY(1) | SUB_PRIORITY(0))
 #define EINT0_IRQP (GROUP_PRIORITY(2) | SUB_PRIORITY(0))
 #define MCI_IRQP   (GROUP_PRIORITY(2) | SUB_PRIORITY(0))
 #define DMA_IRQP   (GROUP_PRIORITY(3) | SUB_PRIORITY(0))
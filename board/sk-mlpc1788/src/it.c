@@ -18,6 +18,9 @@
  *
  */
 
+#include <debug.h>
+#include <uart.h>
+
 /*
  * interrupt vectors definitions
  */
@@ -51,6 +54,7 @@ void UART3_Handler(void);
 void USB_Handler(void);
 void SDCard_Handler(void);
 void GPIO_Handler(void);
+void OSClock_Handler(void);
 
 void SSP1_Handler(void);
 
@@ -80,7 +84,7 @@ unsigned int * myvectors[] __attribute__ ((section("vectors")))= {
     (unsigned int *)Default_Handler,      /* 0  / 16, WatchDog Timer              */
     (unsigned int *)Default_Handler,      /* 1  / 17, Timer0                      */
     (unsigned int *)Default_Handler,      /* 2  / 18, Timer1                      */
-    (unsigned int *)Default_Handler,      /* 3  / 19, Timer2                      */
+    (unsigned int *)OSClock_Handler,      /* 3  / 19, Timer2                      */
     (unsigned int *)Default_Handler,      /* 4  / 20, Timer3                      */
     (unsigned int *)DPort_Handler,        /* 5  / 21, UART0                       */
     (unsigned int *)UART1_Handler,        /* 6  / 22, UART1                       */
@@ -139,6 +143,8 @@ void NMI_Handler(void)
  */
 void HF_Handler(void)
 {
+    uart_dbg_sync();
+    dprint("sn", ERR_PREFIX "hard fault");
     while (1);
 }
 
@@ -147,6 +153,8 @@ void HF_Handler(void)
  */
 void MEM_Handler(void)
 {
+    uart_dbg_sync();
+    dprint("sn", ERR_PREFIX "memory management fault");
     while (1);
 }
 
@@ -155,6 +163,8 @@ void MEM_Handler(void)
  */
 void BUS_Handler(void)
 {
+    uart_dbg_sync();
+    dprint("sn", ERR_PREFIX "bus fault");
     while (1);
 }
 
@@ -163,6 +173,8 @@ void BUS_Handler(void)
  */
 void UF_Handler(void)
 {
+    uart_dbg_sync();
+    dprint("sn", ERR_PREFIX "usage fault");
     while (1);
 }
 
@@ -173,6 +185,18 @@ void UF_Handler(void)
  */
 void __attribute__((naked)) DPort_Handler()
 {
+    /*
+     * stop DMA output of debug port, so it is not mixed with replies of DPort
+     * (characters that were not sent are sent after them)
+     *
+     * NOTE r0 is pushed for alignment of stack
+     */
+    asm volatile(
+        "push {r0, lr}     \n"
+        "bl   uart_dbg_pause\n"
+        "pop  {r0, lr}     \n"
+        : : : "r0", "r1", "r2", "r3", "r12"
+    );
     /*
      * call real handler function
      *
@@ -19,7 +19,6 @@
  */
 
 #include <string.h>
-#include <stimer.h>
 #include <debug.h>
 #include "../eth.h"
 #include "net.h"
@@ -45,7 +44,7 @@ static void net_arp_gratuitous();
  */
 void net_task()
 {
-    struct net_eth_frame_t frame;
+    struct net_eth_frame_t *frame;
     BASE_TYPE len;
     struct os_multi_event_t *mevent;
 
@@ -78,28 +77,27 @@ void net_task()
     net.qproc = os_queue_init(OSW_NETQUEUE_LEN, OSW_NETQUEUE_MSIZE);
 
     mevent = os_multi_init(2);
-    os_multi_add_event(mevent, &net.events, NET_EVENT_MASK_NET_IRQ);
+    os_multi_add_event(mevent, &net.events, NET_EVENT_MASK_ARP);
     os_multi_add_queue(mevent, net.qtx, OS_MULTI_QUEUE_NOT_EMPTY);
 
     os_event_raise(&net.events, NET_EVENT_MASK_INIT);
 
-    stimer_settime(&net.arpto);
+    os_timer_init_event(&net.arptimer, &net.events, NET_EVENT_MASK_ARP);
+    os_timer_start_ms(&net.arptimer, NET_ARP_SEND_TO, NET_ARP_SEND_TO);
     while (1)
     {
         if (eth_linkup())
         {
             if (os_multi_wait(mevent, OS_MULTI_LOCK_OR, OS_MS2TICK(1000)) == OS_ERR_NONE)
             {
-                if (os_event_wait(&net.events, NET_EVENT_MASK_NET_IRQ,
-                            OS_FLAG_NOWAIT | OS_FLAG_CLEAR, 0) == OS_ERR_NONE)
-                    eth_handler_bh();
-
                 if (eth_txready())
                 {
-                    if (os_queue_remove(net.qtx, OS_FLAG_NOWAIT, 0 /* don't care */,
-                                &frame, &len) == OS_ERR_NONE)
+                    /* send frame directly from queue */
+                    frame = os_queue_peek(net.qtx, OS_FLAG_NOWAIT, 0 /* don't care */, &len);
+                    if (frame)
                     {
-                        eth_send((uint8*)&frame, len);
+                        eth_send((uint8*)frame, len);
+                        os_queue_release(net.qtx, frame);
                     }
                 } else {
                     /* should not reached */
@@ -108,13 +106,13 @@ void net_task()
             }
 
             /* ARP gratuitous */
-            if (stimer_deltatime(net.arpto) >= NET_ARP_SEND_TO)
-            {
-                stimer_settime(&net.arpto);
+            if (os_event_wait(&net.events, NET_EVENT_MASK_ARP,
+                        OS_FLAG_NOWAIT | OS_FLAG_CLEAR, 0) == OS_ERR_NONE)
                 net_arp_gratuitous();
-            }
         } else {
-            stimer_settime(&net.arpto);
+            /* first ARP gratuitous is sent after NET_ARP_SEND_TO of link up */
+            os_timer_start_ms(&net.arptimer, NET_ARP_SEND_TO, NET_ARP_SEND_TO);
+            os_event_clear(&net.events, NET_EVENT_MASK_ARP);
             os_wait_ms(100);
         }
     }
@@ -129,8 +127,13 @@ error:
  */
 static void net_arp_gratuitous()
 {
-    struct net_eth_frame_t frame;
-    net_send(&frame, arp_gratuitous(&frame));
+    struct net_eth_frame_t *frame;
+
+    frame = os_pool_alloc(OS_POOL_NETFRAME);
+    if (!frame)
+        return;
+    net_send(frame, arp_gratuitous(frame));
+    os_pool_free(OS_POOL_NETFRAME, frame);
 }
 
 /*
@@ -178,20 +181,21 @@ void net_receive(struct net_eth_frame_t *frame, int len)
  */
 void net_process_task()
 {
-    struct net_eth_frame_t frame; /* NOTE be care of task stack, frame is large enough (1536) */
+    struct net_eth_frame_t *frame;
     struct ipv4_packet_t *ipv4;
     int len;
 
     os_event_wait(&net.events, NET_EVENT_MASK_INIT, OS_FLAG_NONE, OS_WAIT_FOREVER);
     while (1)
     {
-        os_queue_remove(net.qproc, OS_FLAG_NONE, OS_WAIT_FOREVER, &frame, &len);
+        /* process frame in place */
+        frame = os_queue_peek(net.qproc, OS_FLAG_NONE, OS_WAIT_FOREVER, &len);
 
-        switch (NET_HTONS(frame.head.ethertype))
+        switch (NET_HTONS(frame->head.ethertype))
         {
             case NET_ETHERTYPE_IPV4:
                 {
-                    ipv4 = (struct ipv4_packet_t *)frame.payload;
+                    ipv4 = (struct ipv4_packet_t *)frame->payload;
                     if (ipv4->head.protocol == IPV4_PROTOCOL_UDP)
                         udp_process(ipv4);
                 }
@@ -199,6 +203,7 @@ void net_process_task()
             default:
                 dprint("sn", WARN_PREFIX "net_process, unknown frame");
         }
+        os_queue_release(net.qproc, frame);
     }
 }
 
@@ -30,13 +30,13 @@
 //#define DEBUGNET
 
 struct net_t {
-    uint32 arpto;
+    struct os_timer_t arptimer;  /* period of ARP gratuitous */
 
     struct os_queue_t *qtx;
     struct os_queue_t *qproc;
 
 #define NET_EVENT_MASK_INIT    (1 << 0)
-#define NET_EVENT_MASK_NET_IRQ (1 << 1)
+#define NET_EVENT_MASK_ARP     (1 << 1)
     BASE_TYPE events;
 #define NET_MUTEX_MASK_ARP     (1 << 0)
 #define NET_MUTEX_MASK_UDP     (1 << 1)
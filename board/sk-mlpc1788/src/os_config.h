@@ -24,36 +24,61 @@
 
 #define OS_CONFIG_TASK_COUNT      16           /* number of tasks */
 #define OS_CONFIG_TICK_PERIOD     10000        /* period of system timer, us */
+#define OS_CONFIG_TICKLESS                     /* timeouts in microseconds, TIMER2 alarm (look at osw_clock_alarm()) */
 #define OS_CONFIG_USE_WAIT                     /* enable os_wait() functionality */
 
 #define OS_CONFIG_TASK_NAME_SIZE  16
 
 #define OS_CONFIG_USE_PRIORITY                 /* use priorities for tasks */
+#define OS_CONFIG_USE_DEADLINE                 /* deadline class for decoder (EDF) */
+#define OS_CONFIG_USE_SCHEDSTAT                /* collect cost of scheduler calls in CPU cycles */
+#define OS_CONFIG_USE_CPUSTAT                  /* measure CPU load of tasks and interrupts ("pst" and "pcpu" of dport) */
+#define OS_CONFIG_USE_IRQSTAT                  /* length of interrupt handlers and masked sections ("pirq" of dport) */
+#define OS_CONFIG_IRQSTAT_IRQS    41           /* number of interrupts of LPC178x */
+#define OS_CONFIG_IRQSTAT_CALLERS 8            /* number of callers of os_disable_irq() */
 
 //#define OS_CONFIG_USE_TASK_SLICE                 /* task's time slice support */
 //#define OS_CONFIG_DEFAULT_TASK_SLICE  (20 * 1000 /*us */ / OS_CONFIG_TICK_PERIOD)
 //#define OS_CONFIG_USE_VARIABLE_TASK_SLICE        /* enable set of time slice of current task dynamicly */
 
 #define OS_CONFIG_USE_MUTEX                    /* enable os_mutex_lock(), os_mutex_unlock() functionality */
+#define OS_CONFIG_USE_RMUTEX                   /* enable recursive mutexes with priority inheritance */
 #define OS_CONFIG_USE_EVENT                    /* enable os_event_raise(), os_event_wait() functionality */
 
 #define OS_CONFIG_USE_QUEUE                    /* enable os_queue_ functionality */
 
 #define OS_CONFIG_USE_DYNMEM                        /* enable dynamic memory functions */
 #define OS_CONFIG_DYNMEM_SIZE  (16 * 1024 * 1024)   /* size of dynamic memory */
-#define OS_CONFIG_DYNMEM_1                          /* first implementation of dynamic memory */
+//#define OS_CONFIG_DYNMEM_1                          /* first implementation of dynamic memory */
 //#define OS_CONFIG_DYNMEM_2                          /* second implementation of dynamic memory */
-//#define OS_CONFIG_DYNMEM_3                          /* third implementation of dynamic memory */
+#define OS_CONFIG_DYNMEM_3                          /* third implementation of dynamic memory (TLSF) */
+#define OS_CONFIG_DYNMEM_TAG                        /* save address of os_malloc() caller in block */
 
 #define OS_CONFIG_USE_MULTI                    /* enable multiple events funcitons */
+#define OS_CONFIG_USE_PT                       /* enable protothreads hosted by task */
+#define OS_CONFIG_USE_TIMER                    /* software timers, expired by TIMER2 alarm */
+#define OS_CONFIG_USE_WORK                     /* bottom halves of interrupts run by "Work" task (osw_workq) */
+#define OS_CONFIG_WORK_PRIOS      2
+#define OS_CONFIG_USE_MBOX                     /* state of decoder to player, commands of player to decoder */
+#define OS_CONFIG_USE_RAMFUNC                  /* scheduler, audio path and interrupts in SRAM, out of way of LCD DMA on SDRAM */
+
+#define OS_CONFIG_USE_POOL                     /* enable pools of fixed-size blocks */
+/* OS_POOL(name, size of block, number of blocks) */
+#define OS_CONFIG_POOL_TABLE                       \
+    OS_POOL(NETFRAME, 0x600 /* EMAC_BLOCK_SIZE */, 2)
 //
 //#define OS_CONFIG_USE_TRACE
 
+#define OS_CONFIG_USE_TRACEBUF                 /* enable ring buffer of scheduler events, dumped by dport "ptrace" */
+#define OS_CONFIG_TRACEBUF_SIZE   8192         /* number of events in ring buffer, power of 2 */
+
 #define OS_CONFIG_TRAP_SCHEDQ          /* trap on scheduler queue errors */
 #define OS_CONFIG_TRAP_BITOBJ          /* trap on bitobjects errors (mutexes, events) */
 #define OS_CONFIG_TRAP_DYNMEM          /* trap on dynamic memory errors */
 #define OS_CONFIG_TRAP_QUEUE           /* trap on queue errors */
 #define OS_CONFIG_TRAP_MULTI           /* trap on multiple events errors */
+#define OS_CONFIG_TRAP_POOL            /* trap on free of pointer not belonging to pool */
+#define OS_CONFIG_TRAP_RMUTEX          /* trap on unlock of recursive mutex by task that does not own it */
 
 #endif
 
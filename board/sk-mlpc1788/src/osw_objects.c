@@ -22,16 +22,20 @@
  * OS objects definitions, wrappers, startup routines.
  */
 #include <string.h>
+#include <LPC177x_8x.h>
+#include <LPC177x_8x_bits.h>
 #include <os.h>
 #include <os_private.h>
 #include <port/ARMv7-M/port.h>
 #include <debug.h>
+#include <uart.h>
 #include "osw_objects.h"
 #include "net/net.h"
 #include "gs/gs.h"
 #include "testgs.h"
 #include "slog.h"
 #include "gui/gslog.h"
+#include "gui/gsload.h"
 #include "upload.h"
 #include "usbdev/usbdev.h"
 #include "gtask.h"
@@ -41,53 +45,67 @@
 #include "buttons.h"
 #include "vs1053b/decoder.h"
 #include "gpioirq.h"
+#include "fat_io_lib/fat_filelib.h"
+#include "irqp.h"
+#include "osw_stack.h"
 
-#define DEFAULT_STACK_SIZE (32 * 1024)
+/* stack size of task, OSW_STACK_<entry> of osw_stack.h (see "make stack") */
+#define OSW_STACK_SIZE(entry)   OSW_STACK_##entry
 
 struct osw_task_info_t {
     char name[16];
     char enabled;       /* 1 - initialize task, 0 - not initialize */
     BASE_TYPE ssize;    /* size of stack */
-    BASE_TYPE priority; /* NOTE not implemented */
+    BASE_TYPE priority; /* lower number - higher priority, 31 and above - lowest */
     void (*entry)();
     void *context;
 };
 
 static const struct osw_task_info_t tinfo[OS_CONFIG_TASK_COUNT] = {
-    /* task's name    enabled    stack size            priority,     entry point,       context */
-    {"General  ",      0,         DEFAULT_STACK_SIZE,          0,    gtask,             NULL},
-    {"Net      ",      0,         DEFAULT_STACK_SIZE,          0,    net_task,          NULL},
-    {"Net Proc ",      0,         DEFAULT_STACK_SIZE,          1,    net_process_task,  NULL},
-    {"GS       ",      1,         DEFAULT_STACK_SIZE,          3,    gs_task,           NULL},
-    {"GS Test  ",      0,         DEFAULT_STACK_SIZE,          3,    testgs_task,       NULL},
-    {"USB Dev  ",      0,         DEFAULT_STACK_SIZE,          0,    usbdev_task,       NULL},
-    {"Player   ",      1,         DEFAULT_STACK_SIZE,          1,    player_task,       NULL},
-    {"Decoder  ",      1,         DEFAULT_STACK_SIZE,          0,    decoder_task,      NULL},
-    {"Buttons  ",      1,         DEFAULT_STACK_SIZE,        255,    buttons_task,      NULL},
-    {"         ",      0,         DEFAULT_STACK_SIZE,          0,    NULL,              NULL},
-    {"         ",      0,         DEFAULT_STACK_SIZE,          0,    NULL,              NULL},
-    {"         ",      0,         DEFAULT_STACK_SIZE,          0,    NULL,              NULL},
-    {"         ",      0,         DEFAULT_STACK_SIZE,          0,    NULL,              NULL},
-    {"         ",      0,         DEFAULT_STACK_SIZE,          0,    NULL,              NULL},
-    {"         ",      0,         DEFAULT_STACK_SIZE,          0,    NULL,              NULL},
-    {"         ",      0,         DEFAULT_STACK_SIZE,          0,    NULL,              NULL},
+    /* task's name    enabled    stack size                      priority,  entry point,       context */
+    {"General  ",     0,         OSW_STACK_SIZE(gtask),               0,    gtask,             NULL},
+    {"Net      ",     0,         OSW_STACK_SIZE(net_task),            0,    net_task,          NULL},
+    {"Net Proc ",     0,         OSW_STACK_SIZE(net_process_task),    1,    net_process_task,  NULL},
+    {"GS       ",     1,         OSW_STACK_SIZE(gs_task),             3,    gs_task,           NULL},
+    {"GS Test  ",     0,         OSW_STACK_SIZE(testgs_task),         3,    testgs_task,       NULL},
+    {"USB Dev  ",     0,         OSW_STACK_SIZE(usbdev_task),         0,    usbdev_task,       NULL},
+    {"Player   ",     1,         OSW_STACK_SIZE(player_task),         1,    player_task,       NULL},
+    {"Decoder  ",     1,         OSW_STACK_SIZE(decoder_task),        0,    decoder_task,      NULL},
+    {"Buttons  ",     1,         OSW_STACK_SIZE(buttons_task),      255,    buttons_task,      NULL},
+    {"CPU Load ",     0,         OSW_STACK_SIZE(gsload_task),         3,    gsload_task,       NULL},
+    {"Work     ",     1,         OSW_STACK_SIZE(os_workq_task),       0,    os_workq_task,     &osw_workq},
+    {"         ",     0,         0,                                   0,    NULL,              NULL},
+    {"         ",     0,         0,                                   0,    NULL,              NULL},
+    {"         ",     0,         0,                                   0,    NULL,              NULL},
+    {"         ",     0,         0,                                   0,    NULL,              NULL},
+    {"         ",     0,         0,                                   0,    NULL,              NULL},
 };
 
-#define OSW_STACK_SPOOL_SIZE    (DEFAULT_STACK_SIZE * OS_CONFIG_TASK_COUNT)
+struct os_workq_t osw_workq;
+
 uint8 sspool[OSW_STACK_SPOOL_SIZE] __attribute__((section("tstack")));
 
 
+#ifdef OS_CONFIG_TICKLESS
+static void osw_clock_init();
+#endif
 static void osw_print_tasks_state();
-static void osw_void_handler();
+static void osw_print_stats();
+#ifdef OS_CONFIG_USE_CPUSTAT
+static void osw_print_load(char *name, struct os_cpuload_t *ld);
+#endif
+static void osw_print_heap();
+static void osw_trace_toggle();
+static void osw_print_stack();
 
 extern uint32 *_uvect_start;
 extern uint32 *_uvect_size;
 
 void * userfunctions[] = {
     &osw_print_tasks_state, /* 0 */
-    &osw_void_handler,      /* 1 */
-    &osw_void_handler,      /* 2 */
-    &osw_void_handler,      /* 3 */
+    &osw_print_stats,       /* 1 */
+    &osw_print_heap,        /* 2 */
+    &osw_trace_toggle,      /* 3 */
 };
 
 /*
@@ -115,6 +133,8 @@ void osw_init()
         memcpy(table, userfunctions, size);
     }
 
+    os_workq_init(&osw_workq);
+
     /*
      * Initialize tasks
      */
@@ -161,12 +181,72 @@ void osw_init()
         sstart += ti->ssize;
     }
 
+#ifdef OS_CONFIG_TICKLESS
+    osw_clock_init();
+#endif
+
     /* NOTE initialize DMA */
     dma_init();
+    /* NOTE output of debug port is sent by DMA from now */
+    uart_dbg_async(dma_dlog_start, dma_dlog_stop);
 
     gpioirq_init();
 }
 
+#ifdef OS_CONFIG_TICKLESS
+/*
+ * OS clock. TIMER2 is free running 1us timer (initialized by stimer_init()),
+ * match register 0 is used as alarm.
+ */
+static void osw_clock_init()
+{
+    LPC_TIM2->MCR = 0;
+    LPC_TIM2->IR  = TIM_IR_MR0;
+
+    NVIC_SetPriority(TIMER2_IRQn, OSCLK_IRQP);
+    NVIC_EnableIRQ(TIMER2_IRQn);
+}
+
+/*
+ * RETURN
+ *     current time, us
+ */
+BASE_TYPE osw_clock_time()
+{
+    return LPC_TIM2->TC;
+}
+
+/*
+ * set alarm
+ *
+ * ARGS
+ *     time    time of alarm, us
+ *
+ * NOTE called by OS during interrupts disabled
+ */
+void osw_clock_alarm(BASE_TYPE time)
+{
+    LPC_TIM2->MR0  = time;
+    LPC_TIM2->IR   = TIM_IR_MR0;
+    LPC_TIM2->MCR |= TIM_MCR_MR0I;
+
+    /* match occurs on equality only, time can be passed already */
+    if ((BASE_TYPE)(time - LPC_TIM2->TC) <= 0)
+        NVIC_SetPendingIRQ(TIMER2_IRQn);
+}
+
+/*
+ *
+ */
+OS_RAMFUNC void OSClock_Handler(void)
+{
+    os_irq_enter(TIMER2_IRQn);
+    LPC_TIM2->IR = TIM_IR_MR0;
+    os_alarm();
+    os_irq_exit(TIMER2_IRQn);
+}
+#endif
+
 /*
  * print tasks state
  */
@@ -211,6 +291,12 @@ static void osw_print_tasks_state()
 #ifdef OS_USE_TIMEOUT
         dprint("tt<timeout  >4xsn", ptcb->timeout, ptcb->timeout ? "" : " (FOREVER)");
 #endif
+#ifdef OS_CONFIG_USE_PRIORITY
+        dprint("tt<priority >4dn", ptcb->priority);
+    #ifdef OS_CONFIG_USE_RMUTEX
+        dprint("tt<bpriority>4dn", ptcb->bpriority);
+    #endif
+#endif
 #ifdef OS_CONFIG_USE_TASK_SLICE
         dprint("tt<tslice   >4xn", ptcb->tslice);
 #ifdef OS_CONFIG_USE_VARIABLE_TASK_SLICE
@@ -237,6 +323,7 @@ static void osw_print_lock_state(struct os_task_lock_t *lock)
         case OS_TASK_STATE_LOCKED_QUEUE_FULL : lname = "LOCKED QUEUE FULL";  break;
         case OS_TASK_STATE_LOCKED_QUEUE_EMPTY: lname = "LOCKED QUEUE EMPTY"; break;
         case OS_TASK_STATE_LOCKED_MULTI      : lname = "LOCKED MULTI";       break;
+        case OS_TASK_STATE_LOCKED_RMUTEX     : lname = "LOCKED RMUTEX";      break;
 #endif
         default:
             lname = "";
@@ -254,6 +341,19 @@ static void osw_print_lock_state(struct os_task_lock_t *lock)
             dprint("tt<mask     >4xn",  lock->mask);
             break;
 #endif
+#ifdef OS_CONFIG_USE_RMUTEX
+        case OS_TASK_STATE_LOCKED_RMUTEX:
+            {
+                struct os_rmutex_t *m;
+                m = (struct os_rmutex_t*)lock->pobj;
+
+                dprint("tt<pobj     >4xn",  lock->pobj);
+                dprint("ttsn","-rmutex-");
+                dprint("ttt<owner     >4xn",  m->owner);
+                dprint("ttt<count     >4xn",  m->count);
+            }
+            break;
+#endif
 #ifdef OS_CONFIG_USE_EVENT
         case OS_TASK_STATE_LOCKED_EVENT:
             dprint("tt<pobj     >4xn",  lock->pobj);
@@ -268,9 +368,10 @@ static void osw_print_lock_state(struct os_task_lock_t *lock)
 
                 dprint("tt<pobj     >4xn",  lock->pobj);
                 dprint("ttsn","-queue-");
-                dprint("ttt<mutex     >4xn",  q->mutex);
                 dprint("ttt<qsize     >4xn",  q->qsize);
                 dprint("ttt<msize     >4xn",  q->msize);
+                dprint("ttt<used      >4xn",  q->used);
+                dprint("ttt<reserved  >4xn",  q->reserved);
                 dprint("ttt<count     >4xn",  q->count);
                 dprint("ttt<wp        >4xn",  q->wp);
                 dprint("ttt<spool     >4xn",  q->spool);
@@ -283,9 +384,10 @@ static void osw_print_lock_state(struct os_task_lock_t *lock)
 
                 dprint("tt<pobj     >4xn",  lock->pobj);
                 dprint("ttsn","-queue-");
-                dprint("ttt<mutex     >4xn",  q->mutex);
                 dprint("ttt<qsize     >4xn",  q->qsize);
                 dprint("ttt<msize     >4xn",  q->msize);
+                dprint("ttt<used      >4xn",  q->used);
+                dprint("ttt<reserved  >4xn",  q->reserved);
                 dprint("ttt<count     >4xn",  q->count);
                 dprint("ttt<wp        >4xn",  q->wp);
                 dprint("ttt<spool     >4xn",  q->spool);
@@ -323,11 +425,199 @@ static void osw_print_lock_state(struct os_task_lock_t *lock)
 }
 
 /*
- *
+ * print statistics of subsystems
+ */
+static void osw_print_stats()
+{
+#ifdef OS_CONFIG_USE_SCHEDSTAT
+    {
+        int i;
+
+        /* 
+         * Cost of task switch depending on number of locked tasks, compare
+         * with different number of enabled tasks in "tinfo".
+         */
+        dprint("sn",    "Scheduler:");
+        dprint("s4dn",  " Switches               = ", os_schedstat.switches);
+        dprint("s4dsn", " Last switch            = ", os_schedstat.cycles_last, " cycles");
+        for (i = 0; i <= OS_CONFIG_TASK_COUNT; i++)
+        {
+            if (os_schedstat.cycles_max[i] == 0)
+                continue;
+            dprint("s2ds4dsn", " Max switch, locked ", i, "  = ", os_schedstat.cycles_max[i], " cycles");
+        }
+    }
+#endif
+#ifdef OS_CONFIG_USE_DEADLINE
+    {
+        volatile struct os_taskcb_t *ptcb;
+        int i;
+
+        /* time in microseconds */
+        dprint("sn", "Deadline class (period, budget, jobs, misses, overruns, max used, max response):");
+        ptcb = os_tasks;
+        for (i = 0; i < os_taskidx; i++, ptcb++)
+        {
+            if (ptcb->dl.period == 0 && ptcb->dl.jobs == 0)
+                continue;
+            dprint("_s_4d_4d_4d_4d_4d_4d_4dn", ptcb->name,
+                    ptcb->dl.period, ptcb->dl.budget, ptcb->dl.jobs,
+                    ptcb->dl.misses, ptcb->dl.overruns,
+                    ptcb->dl.used_max, ptcb->dl.resp_max);
+        }
+    }
+#endif
+#ifdef OS_CONFIG_DYNMEM_3
+    {
+        struct os_dmem_stat_t st;
+
+        os_mem_stat(&st);
+        dprint("sn",    "Dynamic memory:");
+        dprint("s4dn",  " Size                   = ", st.size);
+        dprint("s4dn",  " Used                   = ", st.used);
+        dprint("s4dn",  " Peak                   = ", st.peak);
+        dprint("s4dn",  " Largest free block     = ", st.largest);
+        dprint("s4dn",  " Busy blocks            = ", st.busy_blocks);
+        dprint("s4dn",  " Free blocks            = ", st.free_blocks);
+    }
+#endif
+#ifdef OS_CONFIG_USE_POOL
+    {
+        struct os_pool_stat_t st;
+        int i;
+
+        dprint("sn", "Pools (size, used/count, peak, fails):");
+        for (i = 0; i < OS_POOL_COUNT; i++)
+        {
+            os_pool_stat(i, &st);
+            dprint("_s_4d_4d*/4d_4d_4dn", st.name, st.size, st.used, st.count,
+                    st.peak, st.fails);
+        }
+    }
+#endif
+#ifdef OS_CONFIG_USE_CPUSTAT
+    {
+        int i;
+
+        dprint("sn", "CPU load, % (last second, last 10 seconds):");
+        osw_print_load("Total", &os_cpustat.load[OS_CPUSTAT_TOTAL]);
+        osw_print_load("IRQ",   &os_cpustat.load[OS_CPUSTAT_IRQ]);
+        for (i = 0; i < os_cpustat.ntasks; i++)
+            osw_print_load(os_cpustat.names[i], &os_cpustat.load[OS_CPUSTAT_TASK(i)]);
+    }
+#endif
+#ifdef OS_CONFIG_USE_WORK
+    {
+        struct os_work_t *w;
+        uint32 mhz;
+
+        /* latency is time from post to start of handler, us */
+        mhz = PORT_CYCCNT_HZ / 1000000;
+        dprint("sn", "Work (runs, coalesced, avg latency, max latency, max run):");
+        for (w = os_work_list; w; w = w->lnext)
+        {
+            dprint("_s_4d_4d_4d_4d_4dn", w->name, w->runs, w->coalesced,
+                    w->runs ? (uint32)(w->latsum / w->runs) / mhz : 0,
+                    w->latmax / mhz, w->runmax / mhz);
+        }
+    }
+#endif
+    dprint("sn",   "Debug port:");
+    dprint("s4dn", " Dropped                = ", uart_dbg.dropped);
+    osw_print_stack();
+#ifdef FAT_WCACHE_SECTORS
+    fl_show_wcache();
+#endif
+}
+
+#ifdef OS_CONFIG_USE_CPUSTAT
+static void osw_print_load(char *name, struct os_cpuload_t *ld)
+{
+    dprint("_gsd*.dsd*.dsdsn", 12, name ? name : "",
+            ld->load1  / 10, ld->load1  % 10, " ",
+            ld->load10 / 10, ld->load10 % 10, " ",
+            ld->cycles, " cycles");
+}
+#endif
+
+#ifdef OS_CONFIG_DYNMEM_3
+/*
+ * NOTE tag is address in caller of os_malloc(), use addr2line to find
+ *      source line
  */
-static void osw_void_handler()
+static void osw_print_block(void *p, BASE_TYPE size, void *tag)
 {
+    dprint("s4xs4ds4xn", " ", (uint32)p, " ", size, " ", (uint32)tag);
+}
+#endif
 
+/*
+ * print busy blocks of dynamic memory
+ */
+static void osw_print_heap()
+{
+#ifdef OS_CONFIG_DYNMEM_3
+    dprint("sn", " Address    Size       Tag");
+    os_mem_walk(osw_print_block);
+#endif
+}
 
+/*
+ * print high-water mark of stacks of tasks, stack grows down so bytes of
+ * initial fill (0xAB) that are left at start of stack are never used
+ */
+static void osw_print_stack()
+{
+    int i;
+    BASE_TYPE sstart;
+    BASE_TYPE nfree;
+
+    dprint("sn", "Stack (size, used, free):");
+    sstart = 0;
+    for (i = 0; i < OS_CONFIG_TASK_COUNT; i++)
+    {
+        const struct osw_task_info_t *ti;
+
+        ti = &tinfo[i];
+        if ((sstart + ti->ssize) > OSW_STACK_SPOOL_SIZE)
+            break;
+
+        if (ti->enabled && ti->entry != NULL)
+        {
+            for (nfree = 0; nfree < ti->ssize; nfree++)
+            {
+                if (sspool[sstart + nfree] != 0xAB)
+                    break;
+            }
+            /* NOTE mark task that used more than 90% of its stack */
+            dprint("_gsg4dg4d4dsn",
+                    11, ti->name,
+                    8, ti->ssize,
+                    8, ti->ssize - nfree,
+                    nfree,
+                    (nfree < ti->ssize / 10) ? " (!)" : "");
+        }
+
+        sstart += ti->ssize;
+    }
+}
+
+/*
+ * start or stop recording of OS events to trace buffer
+ */
+static void osw_trace_toggle()
+{
+#ifdef OS_CONFIG_USE_TRACEBUF
+    if (os_tracebuf.enabled)
+    {
+        os_trace_stop();
+        dprint("sn", "Trace stopped");
+    }
+    else
+    {
+        os_trace_start();
+        dprint("s4xn", "Trace started, buffer at ", (uint32)&os_tracebuf);
+    }
+#endif
 }
 
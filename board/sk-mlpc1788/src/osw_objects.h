@@ -22,10 +22,16 @@
 #define OSW_OBJECTS_H
 
 #include <types.h>
+#include <os.h>
 #include "net/net.h"
 #include "net/net_def.h"
 
 void osw_init();
 
+/* queue of bottom halves of interrupts, served by "Work" task */
+extern struct os_workq_t osw_workq;
+/* priorities of work in osw_workq */
+#define OSW_WORK_PRIO_NET    0
+
 #endif
 
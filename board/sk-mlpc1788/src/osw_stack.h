@@ -0,0 +1,37 @@
+/*
+ * Stack sizes of tasks, generated by util/stackusage.tcl ("make stack"),
+ * do not edit.
+ *
+ * Not analyzed yet, all tasks have default size.
+ */
+#ifndef OSW_STACK_H
+#define OSW_STACK_H
+
+#define OSW_STACK_DEFAULT    (32 * 1024)
+
+/* gtask not analyzed */
+#define OSW_STACK_gtask                  OSW_STACK_DEFAULT
+/* net_task not analyzed */
+#define OSW_STACK_net_task               OSW_STACK_DEFAULT
+/* net_process_task not analyzed */
+#define OSW_STACK_net_process_task       OSW_STACK_DEFAULT
+/* gs_task not analyzed */
+#define OSW_STACK_gs_task                OSW_STACK_DEFAULT
+/* testgs_task not analyzed */
+#define OSW_STACK_testgs_task            OSW_STACK_DEFAULT
+/* usbdev_task not analyzed */
+#define OSW_STACK_usbdev_task            OSW_STACK_DEFAULT
+/* player_task not analyzed */
+#define OSW_STACK_player_task            OSW_STACK_DEFAULT
+/* decoder_task not analyzed */
+#define OSW_STACK_decoder_task           OSW_STACK_DEFAULT
+/* buttons_task not analyzed */
+#define OSW_STACK_buttons_task           OSW_STACK_DEFAULT
+/* gsload_task not analyzed */
+#define OSW_STACK_gsload_task            OSW_STACK_DEFAULT
+/* os_workq_task not analyzed */
+#define OSW_STACK_os_workq_task          OSW_STACK_DEFAULT
+
+#define OSW_STACK_SPOOL_SIZE (OSW_STACK_gtask + OSW_STACK_net_task + OSW_STACK_net_process_task + OSW_STACK_gs_task + OSW_STACK_testgs_task + OSW_STACK_usbdev_task + OSW_STACK_player_task + OSW_STACK_decoder_task + OSW_STACK_buttons_task + OSW_STACK_gsload_task + OSW_STACK_os_workq_task)
+
+#endif
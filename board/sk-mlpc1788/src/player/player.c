@@ -56,6 +56,14 @@
 #define LARGE_MSG_FONT       GS_FONT_9X16
 
 #define FILEBUF_SIZE         (1 * 1024 * 1024)
+/*
+ * Sectors of read buffers of files (fl_setvbuf()). Track is read ahead with
+ * large buffer, so file cache is filled with one media access per several
+ * entries. Image is read with small buffer, so SD card is given to track
+ * between parts of image.
+ */
+#define PLAYER_TRACK_VBUF    32
+#define PLAYER_IMAGE_VBUF    8
 #define ARTIST_NAME_MAXLEN   64
 #define ARTIST_ENTRIES_MAX   4096
 #define ALBUM_NAME_MAXLEN    128
@@ -68,32 +76,23 @@
 #define TRACK_ENTRIES_MAX    256 /* Agoraphobic Nosebleed - Altered States of America. 100 tracks */
 
 #define PLAYER_QUEUE_LENGTH    4
-#define DECODER_QUEUE_LENGTH   4
 
 /*********************************************/
 
-/* XXX for recursive locking functionality */
-extern volatile struct os_taskcb_t *os_current_taskcb;          /* pointer to current task's control block */
-
-struct fs_mutex_t {
-#define FS_MUTEX_0  (1 << 0)
-#define FS_MUTEX_1  (1 << 1)
-    BASE_TYPE mutex;
-    volatile struct os_taskcb_t *owner;
-    int cnt;
-};
-
 struct player_t player;
 //static struct file_cache_t fcache __attribute__((section("sram")));
 static struct file_cache_t fcache;
-static struct fs_mutex_t fsmutex;
+static struct os_rmutex_t fsmutex;
 
 static void player_init();
 #define MEDIA_INSERT    0
 #define MEDIA_REMOVE    1
 void player_large_msg(char *st);
+static void player_media_check(void *arg);
 static int player_wait_media(int state);
 static void player_browser();
+static void player_procmsg(struct player_msg_t *msg);
+static void player_decoder_state();
 static int player_load_sys();
 static int player_read_full_file(char *path);
 
@@ -142,9 +141,13 @@ static void player_init()
     struct gs_win_t *win;
     struct gs_wlist_init_info_t linfo;
 
+#define CARD_DETECT_POLL_TO    200
     nvram_load();
     sdcard_hw_init();
 
+    os_timer_init(&player.mtimer, player_media_check, NULL);
+    os_timer_start_ms(&player.mtimer, 0, CARD_DETECT_POLL_TO);
+
     while (!gs_initialized())
         os_wait_ms(10);
 
@@ -327,8 +330,16 @@ static void player_init()
         goto error;
     }
 
-    player.qplayer  = os_queue_init(PLAYER_QUEUE_LENGTH, sizeof(struct player_msg_t));
-    player.qdecoder = os_queue_init(DECODER_QUEUE_LENGTH, sizeof(struct decoder_msg_t));
+    player.qplayer   = os_queue_init(PLAYER_QUEUE_LENGTH, sizeof(struct player_msg_t));
+    player.mposition = os_mbox_init(sizeof(struct pmsg_position_t), &player.event, PLAYER_EVENT_DECODER);
+    player.mvolume   = os_mbox_init(sizeof(struct pmsg_volume_t), &player.event, PLAYER_EVENT_DECODER);
+    player.mstate    = os_mbox_init(sizeof(int), &player.event, PLAYER_EVENT_DECODER);
+    player.cdecoder  = os_chan_init(sizeof(struct decoder_msg_t));
+
+    player.mevent = os_multi_init(3);
+    os_multi_add_queue(player.mevent, player.qplayer, OS_MULTI_QUEUE_NOT_EMPTY);
+    os_multi_add_event(player.mevent, &player.event, PLAYER_EVENT_MEDIA);
+    os_multi_add_event(player.mevent, &player.event, PLAYER_EVENT_DECODER);
 
     fl_init();
     fl_attach_locks(player_fs_lock, player_fs_unlock);
@@ -353,6 +364,22 @@ void player_large_msg(char *st)
     DEBUG_IMSGF("Player LARGE: ", "sn", st);
 }
 
+/*
+ * Sample card slot, called from interrupt of timer. Player is notified
+ * only when card is inserted or removed.
+ */
+static void player_media_check(void *arg)
+{
+    int media;
+
+    media = card_detect();
+    if (media != player.media)
+    {
+        player.media = media;
+        os_event_raise(&player.event, PLAYER_EVENT_MEDIA);
+    }
+}
+
 /*
  *
  * RETURN
@@ -360,7 +387,6 @@ void player_large_msg(char *st)
  */
 static int player_wait_media(int state)
 {
-#define CARD_DETECT_POLL_TO    500
 #define CARD_INIT_PAUSE_TO     500
     if (state == MEDIA_INSERT)
     {
@@ -368,7 +394,7 @@ static int player_wait_media(int state)
 
         /* wait for card to be inserted */
         while (!card_detect())
-            os_wait_ms(CARD_DETECT_POLL_TO);
+            os_event_wait(&player.event, PLAYER_EVENT_MEDIA, OS_FLAG_CLEAR, OS_WAIT_FOREVER);
         DEBUG_IMSG("SD card detect");
 
         os_wait_ms(CARD_INIT_PAUSE_TO);
@@ -387,7 +413,7 @@ static int player_wait_media(int state)
     } else {
         /* wait when card will be removed */
         while (card_detect())
-            os_wait_ms(CARD_DETECT_POLL_TO);
+            os_event_wait(&player.event, PLAYER_EVENT_MEDIA, OS_FLAG_CLEAR, OS_WAIT_FOREVER);
         DEBUG_IMSG("SD card was removed");
         os_wait_ms(CARD_INIT_PAUSE_TO);
         return 0;
@@ -402,7 +428,6 @@ static void player_browser()
     BASE_TYPE msglen;
     struct player_msg_t msg;
     struct decoder_msg_t dmsg;
-    int newmode;
 
     if (!player_load_sys(&player))
         return;
@@ -410,56 +435,32 @@ static void player_browser()
     if (!player_scan_artists(&player))
         return;
 
-    newmode = PLAYER_MODE_ARTIST_BROWSER;
-    player.mode = newmode;
+    player.mode = PLAYER_MODE_ARTIST_BROWSER;
     player_bartist_onenter();
 
     while (1)
     {
         /*
-         * Get event from queue.
+         * Get event from queue or state of decoder, wake also on remove
+         * of card.
          */
-        if (os_queue_remove(player.qplayer, OS_FLAG_NONE, OS_MS2TICK(200),
+        os_multi_wait(player.mevent, OS_MULTI_LOCK_OR, OS_WAIT_FOREVER);
+        if (os_queue_remove(player.qplayer, OS_FLAG_NOWAIT, 0,
                     &msg, &msglen) == OS_ERR_NONE)
-        {
-            /*
-             * Process event by specific handler.
-             */
-            switch (player.mode)
-            {
-                case PLAYER_MODE_ARTIST_BROWSER: newmode = player_bartist_procmsg(&msg); break;
-                case PLAYER_MODE_ALBUM_BROWSER:  newmode = player_balbum_procmsg(&msg);  break;
-                case PLAYER_MODE_TRACK_BROWSER:  newmode = player_btrack_procmsg(&msg);  break;
-                default:
-                    /* UNREACHED */
-                    DEBUG_EMSGF("unknown mode", "*(1d*)n", player.mode);
-            }
+            player_procmsg(&msg);
 
-            /*
-             * Redraw widgets on mode change.
-             */
-            if (newmode != player.mode)
-            {
-                switch (newmode)
-                {
-                    case PLAYER_MODE_ARTIST_BROWSER: player_bartist_onenter(); break;
-                    case PLAYER_MODE_ALBUM_BROWSER:  player_balbum_onenter(); break;
-                    case PLAYER_MODE_TRACK_BROWSER:  player_btrack_onenter(); break;
-                }
-
-                player.mode = newmode;
-            }
-        }
+        player_decoder_state();
 
         /* 
          * Check card.
          */
-        if (!card_detect())
+        if (os_event_wait(&player.event, PLAYER_EVENT_MEDIA,
+                    OS_FLAG_NOWAIT | OS_FLAG_CLEAR, 0) == OS_ERR_NONE && !card_detect())
         {
             /* stop decoder */
             {
                 dmsg.id = DECODER_MSG_ID_STOP;
-                DECODER_SEND_MSG(&dmsg, dmsg_empty_t);
+                DECODER_SEND_MSG(&dmsg);
             }
 
             DEBUG_IMSG("Card lost");
@@ -469,6 +470,68 @@ static void player_browser()
     player.mode = PLAYER_MODE_NOP;
 }
 
+/*
+ * process message by handler of current mode
+ */
+static void player_procmsg(struct player_msg_t *msg)
+{
+    int newmode;
+
+    switch (player.mode)
+    {
+        case PLAYER_MODE_ARTIST_BROWSER: newmode = player_bartist_procmsg(msg); break;
+        case PLAYER_MODE_ALBUM_BROWSER:  newmode = player_balbum_procmsg(msg);  break;
+        case PLAYER_MODE_TRACK_BROWSER:  newmode = player_btrack_procmsg(msg);  break;
+        default:
+            /* UNREACHED */
+            DEBUG_EMSGF("unknown mode", "*(1d*)n", player.mode);
+            return;
+    }
+
+    /*
+     * Redraw widgets on mode change.
+     */
+    if (newmode != player.mode)
+    {
+        switch (newmode)
+        {
+            case PLAYER_MODE_ARTIST_BROWSER: player_bartist_onenter(); break;
+            case PLAYER_MODE_ALBUM_BROWSER:  player_balbum_onenter(); break;
+            case PLAYER_MODE_TRACK_BROWSER:  player_btrack_onenter(); break;
+        }
+
+        player.mode = newmode;
+    }
+}
+
+/*
+ * Process state posted by decoder since last check. Only latest state of
+ * every mailbox is processed, position and volume before play state (in
+ * order of posts by decoder).
+ */
+static void player_decoder_state()
+{
+    struct player_msg_t msg;
+
+    /* NOTE event is cleared before read, post after read raises it again */
+    if (os_event_wait(&player.event, PLAYER_EVENT_DECODER,
+                OS_FLAG_NOWAIT | OS_FLAG_CLEAR, 0) != OS_ERR_NONE)
+        return;
+
+    if (os_mbox_read(player.mposition, &msg.position) == OS_ERR_NONE)
+    {
+        msg.id = PLAYER_MSG_ID_DEC_POSITION;
+        player_procmsg(&msg);
+    }
+    if (os_mbox_read(player.mvolume, &msg.volume) == OS_ERR_NONE)
+    {
+        msg.id = PLAYER_MSG_ID_DEC_VOLUME;
+        player_procmsg(&msg);
+    }
+    if (os_mbox_read(player.mstate, &msg.id) == OS_ERR_NONE)
+        player_procmsg(&msg);
+}
+
 /*
  * load system data (images, ...)
  *
@@ -560,6 +623,10 @@ static int player_read_full_file(char *path)
     ret = 0;
     if (file)
     {
+#ifdef FATFS_FILE_BUFFER_POOL
+        if (fl_setvbuf(file, PLAYER_IMAGE_VBUF) < 0)
+            DEBUG_WMSG("no file buffer");
+#endif
         if (file->filelength <= FILEBUF_SIZE)
         {
             ret = fl_fread(player.filebuf, FILEBUF_SIZE, 1, file);
@@ -1089,6 +1156,10 @@ uint32 player_fcache_open(char *path)
         ret = 0;
         goto out;
     }
+#ifdef FATFS_FILE_BUFFER_POOL
+    if (fl_setvbuf(fcache.file, PLAYER_TRACK_VBUF) < 0)
+        DEBUG_WMSG("no file buffer");
+#endif
     ret = fcache.file->filelength;
 
 out:
@@ -1162,7 +1233,7 @@ void player_fcache_remove()
 /*
  * get pointer to first entry in cache
  */
-struct fcache_entry_t * player_fcache_get(int *drained)
+OS_RAMFUNC struct fcache_entry_t * player_fcache_get(int *drained)
 {
     struct fcache_entry_t *ret;
     int rp;
@@ -1195,18 +1266,7 @@ out:
 static void
 player_fs_lock(void)
 {
-    os_mutex_lock(&fsmutex.mutex, FS_MUTEX_0, OS_FLAG_NONE, OS_WAIT_FOREVER);
-    if (fsmutex.cnt == 0 || fsmutex.owner != os_current_taskcb)
-    {
-        os_mutex_unlock(&fsmutex.mutex, FS_MUTEX_0);
-
-        os_mutex_lock(&fsmutex.mutex, FS_MUTEX_1, OS_FLAG_NONE, OS_WAIT_FOREVER);
-
-        os_mutex_lock(&fsmutex.mutex, FS_MUTEX_0, OS_FLAG_NONE, OS_WAIT_FOREVER);
-        fsmutex.owner = os_current_taskcb;
-    }
-    fsmutex.cnt++;
-    os_mutex_unlock(&fsmutex.mutex, FS_MUTEX_0);
+    os_rmutex_lock(&fsmutex, OS_FLAG_NONE, OS_WAIT_FOREVER);
 }
 
 /*
@@ -1215,19 +1275,6 @@ player_fs_lock(void)
 static void
 player_fs_unlock(void)
 {
-    os_mutex_lock(&fsmutex.mutex, FS_MUTEX_0, OS_FLAG_NONE, OS_WAIT_FOREVER);
-    if (fsmutex.cnt == 0)
-    {
-        DEBUG_EMSG("unlock zero referenced mutex");
-        goto out;
-    }
-    fsmutex.cnt--;
-    if (fsmutex.cnt == 0)
-    {
-        fsmutex.owner = NULL;
-        os_mutex_unlock(&fsmutex.mutex, FS_MUTEX_1);
-    }
-out:
-    os_mutex_unlock(&fsmutex.mutex, FS_MUTEX_0);
+    os_rmutex_unlock(&fsmutex);
 }
 
@@ -78,27 +78,26 @@ struct decoder_msg_t {
 
 /*
  * NOTE
- * Messages sended to player in non-blocking mode to prevent
- * interlock of player and decoder.
+ * State of decoder (position, volume, play state) is posted to mailboxes
+ * of player, newest state overwrites unread one, so decoder never waits
+ * for player. Commands are sent to decoder over channel, they are passed
+ * directly to decoder if it waits for them.
  */
 
 #define PLAYER_MSG_SIZE(m) (sizeof(int) + sizeof(struct m))
 #define PLAYER_SEND_MSG(pm, size) \
             os_queue_add(player.qplayer, OS_FLAG_NOWAIT, OS_WAIT_FOREVER, pm, PLAYER_MSG_SIZE(size));
-#define PLAYER_SEND_MSG_BLOCKING(pm, size) \
-            os_queue_add(player.qplayer, OS_FLAG_NONE, OS_WAIT_FOREVER, pm, PLAYER_MSG_SIZE(size));
 #define PLAYER_QUEUE_FLUSH(player) \
             os_queue_flush(player.qplayer)
 
-#define DECODER_MSG_SIZE(m) (sizeof(int) + sizeof(struct m))
-#define DECODER_SEND_MSG(pm, size) \
-            os_queue_add(player.qdecoder, OS_FLAG_NONE, OS_WAIT_FOREVER, pm, DECODER_MSG_SIZE(size));
-#define DECODER_QUEUE_FLUSH(player) \
-            os_queue_flush(player.qdecoder)
+#define DECODER_SEND_MSG(pm) \
+            os_chan_send(player.cdecoder, pm, OS_FLAG_NONE, OS_WAIT_FOREVER);
 
 struct player_t {
 
 #define PLAYER_EVENT_INIT     (1 << 0)
+#define PLAYER_EVENT_MEDIA    (1 << 1) /* card was inserted or removed */
+#define PLAYER_EVENT_DECODER  (1 << 2) /* state of decoder was posted */
     BASE_TYPE event;
     struct gs_win_t *mwin;
     uint8 *filebuf;
@@ -144,9 +143,15 @@ struct player_t {
 
     char *path;   /* temporary path location */
 
-    /* player and decoder event queues */
-    struct os_queue_t *qplayer;
-    struct os_queue_t *qdecoder;
+    struct os_queue_t *qplayer;      /* buttons */
+    struct os_mbox_t *mposition;     /* struct pmsg_position_t */
+    struct os_mbox_t *mvolume;       /* struct pmsg_volume_t */
+    struct os_mbox_t *mstate;        /* PLAYER_MSG_ID_DEC_{PLAY,PAUSED,STOPPED,NEXTTRACK} */
+    struct os_chan_t *cdecoder;      /* commands to decoder, struct decoder_msg_t */
+    struct os_multi_event_t *mevent; /* message in player queue, PLAYER_EVENT_MEDIA or PLAYER_EVENT_DECODER */
+
+    struct os_timer_t mtimer;        /* samples card slot */
+    int media;                       /* card is present on slot, last sample */
 };
 
 #define FILE_CACHE_ENTRY_SIZE    2048
@@ -232,20 +232,20 @@ int player_btrack_procmsg(struct player_msg_t *msg)
                     /* befor playback can be started we should stop decoder */
                     {
                         dmsg.id = DECODER_MSG_ID_STOP;
-                        DECODER_SEND_MSG(&dmsg, dmsg_empty_t);
+                        DECODER_SEND_MSG(&dmsg);
                     }
                     BITMASK_SET(btrack.cmd, PLAYER_CMD_PLAY);
                 } else if (BUTTON_PRESSED(button, BTRACK_BUTTON_PAUSE)) {
                     /* pause decoder */
                     {
                         dmsg.id = DECODER_MSG_ID_PAUSE;
-                        DECODER_SEND_MSG(&dmsg, dmsg_empty_t);
+                        DECODER_SEND_MSG(&dmsg);
                     }
                 } else if (BUTTON_PRESSED(button, BTRACK_BUTTON_BACK)) {
                     /* stop decoder */
                     {
                         dmsg.id = DECODER_MSG_ID_STOP;
-                        DECODER_SEND_MSG(&dmsg, dmsg_empty_t);
+                        DECODER_SEND_MSG(&dmsg);
                     }
                     BITMASK_SET(btrack.cmd, PLAYER_CMD_BACK);
                 } else if (BUTTON_PRESSED(button, BTRACK_BUTTON_DOWN)) {
@@ -278,14 +278,14 @@ int player_btrack_procmsg(struct player_msg_t *msg)
                     dmsg.id           = DECODER_MSG_ID_VOLUME;
                     dmsg.volume.value = (player.volume + VOLUME_INCREMENT) < 100 ?
                         (player.volume + VOLUME_INCREMENT) : 100;
-                    DECODER_SEND_MSG(&dmsg, dmsg_volume_t);
+                    DECODER_SEND_MSG(&dmsg);
                 } else if (BUTTON_PRESSED(button, ENCODER_MINUS)) {
 //                    dprint("sn", "encoder-");
 
                     dmsg.id           = DECODER_MSG_ID_VOLUME;
                     dmsg.volume.value = (player.volume - VOLUME_INCREMENT) > 0 ?
                         (player.volume - VOLUME_INCREMENT) : 0;
-                    DECODER_SEND_MSG(&dmsg, dmsg_volume_t);
+                    DECODER_SEND_MSG(&dmsg);
                 }
             }
             break;
@@ -453,7 +453,7 @@ static void player_btrack_playfile(int next)
         {
             dmsg.id = DECODER_MSG_ID_PLAY;
             dmsg.play.flen = flen;
-            DECODER_SEND_MSG(&dmsg, dmsg_play_t);
+            DECODER_SEND_MSG(&dmsg);
         }
     } else {
         gs_wlist_set_sel(player.widget.trcklist, GS_WLIST_SET_SEL_VALUE, -1);
@@ -31,6 +31,7 @@
 #include <debug.h>
 #include <string.h>
 #include <os.h>
+#include <stimer.h>
 #include "sdcard.h" 
 #include "sdcard_hw.h"
 #include "../fat_io_lib/fat_filelib.h"
@@ -57,6 +58,10 @@ static int sdcard_checkstatus();
 static int sdcard_stop_transmission();
 static int sdcard_cmd_read_block(uint32 baddr);
 static int sdcard_read_block(uint32 bnum, uint8 *data);
+static int sdcard_acmd23_send(uint32 count);
+static int sdcard_cmd_write_block(uint32 baddr, uint32 count);
+static int sdcard_wait_ready(uint32 state);
+static int sdcard_write_blocks(uint32 bnum, uint8 *data, uint32 count);
 
 struct card_state_t cardstate;
 
@@ -198,6 +203,25 @@ int sdcard_read(uint32 bnum, uint8 *data)
     return sdcard_read_block(bnum, data);
 }
 
+/*
+ * write blocks of data to card
+ *
+ * ARGS
+ *     bnum     number of first block
+ *     data     source data, count * 512 bytes
+ *     count    number of blocks
+ *
+ * RETURN
+ *    1 on success, 0 otherwise
+ */
+int sdcard_write(uint32 bnum, uint8 *data, uint32 count)
+{
+    if (!count)
+        return 1;
+
+    return sdcard_write_blocks(bnum, data, count);
+}
+
 
 /*
  * CMD8 command (SEND_IF_COND)
@@ -555,6 +579,44 @@ static int sdcard_acmd6_send()
     return 0;
 }
 
+/*
+ * ACMD23 (SET_WR_BLK_ERASE_COUNT)
+ *
+ * ARGS
+ *     count    number of blocks to be pre-erased before writing
+ *
+ * NOTE
+ * Pre-erase is only a hint for card and it is reset after multiple
+ * block write command, so ACMD23 should precede every CMD25.
+ *
+ * RETURN
+ *     1 if valid response was received, 0 otherwise
+ */
+static int sdcard_acmd23_send(uint32 count)
+{
+    int retry;
+    int ret;
+    union sd_argument_t arg;
+    union sd_response_t resp;
+
+    arg.value = 0;
+    arg.acmd23.count = count;
+
+    retry = 20;
+    while (retry--)
+    {
+        if (sdcard_cmd55_send() == 0)
+            continue;
+
+        ret = sdcard_hw_send_cmd(SD_ACMD23_SET_WR_BLK_ERASE_COUNT, SD_CMDFLAG_EXPECT_SHORT, &arg, &resp);
+        if (ret == 0)
+        {
+            return 1;
+        }
+    }
+    return 0;
+}
+
 /*
  * NOTE following code is based on code from u-boot-1.1.6, patches from EA for
  * LPC2468 OEM Board
@@ -739,6 +801,176 @@ int sdcard_read_block(uint32 bnum, uint8 *data)
 }
 
 
+/*
+ * CMD24 (WRITE_BLOCK) or CMD25 (WRITE_MULTIPLE_BLOCK)
+ *
+ * ARGS
+ *     baddr    number of first block
+ *     count    number of blocks, CMD24 is used if count is 1
+ *
+ * RETURN
+ *     1 if valid response was received, 0 otherwise
+ */
+static int sdcard_cmd_write_block(uint32 baddr, uint32 count)
+{
+    union sd_argument_t arg;
+    union sd_response_t resp;
+    int retry;
+    uint8 cmd;
+
+    arg.value = baddr;
+    cmd = count > 1 ? SD_CMD25_WRITE_MULTIPLE_BLOCK : SD_CMD24_WRITE_BLOCK;
+
+    retry = 0x20;
+    while (retry--)
+    {
+        if (sdcard_hw_send_cmd(cmd, SD_CMDFLAG_EXPECT_SHORT, &arg, &resp) == 0)
+        {
+            if (resp.R1.wp_violation || resp.R1.address_error || resp.R1.out_of_range)
+            {
+                DEBUG_EMSGF("write", "<resp >4xn", resp.sresp);
+                return 0;
+            }
+            if (resp.R1.ready_for_data)
+                return 1;
+        }
+    }
+
+    return 0;
+}
+
+/*
+ * wait while card programs data (card leaves PRG state)
+ *
+ * NOTE
+ * SD card controller does not generate interrupt at end of busy signal
+ * on DAT0 line, so card status is requested with CMD13. Responses are
+ * received on interrupt and task sleeps between requests, so other tasks
+ * are not blocked by long programming of card.
+ *
+ * ARGS
+ *     state    state of card that ends wait, R1_CURRENT_STATE_TRAN at end
+ *              of write, R1_CURRENT_STATE_RCV between data phases of
+ *              multiple block write
+ *
+ * RETURN
+ *     1 if card in "state" and ready for data, 0 on timeout or error
+ */
+#define SD_WRITE_BUSY_TIMEOUT    1000 /* ms */
+static int sdcard_wait_ready(uint32 state)
+{
+    union sd_argument_t arg;
+    union sd_response_t resp;
+    uint32 to;
+
+    arg.value = 0;
+    arg.ac.rca = cardstate.rca;
+
+    stimer_settime(&to);
+    while (1)
+    {
+        if (sdcard_hw_send_cmd(SD_CMD13_SEND_STATUS, SD_CMDFLAG_EXPECT_SHORT, &arg, &resp) == 0)
+        {
+            if (resp.R1.ready_for_data && resp.R1.current_state == state)
+                return 1;
+            if (resp.R1.current_state != R1_CURRENT_STATE_PRG &&
+                    resp.R1.current_state != R1_CURRENT_STATE_RCV)
+            {
+                DEBUG_EMSGF("busy", "<state >1dn", resp.R1.current_state);
+                return 0;
+            }
+        }
+
+        if (stimer_deltatime(to) > SD_WRITE_BUSY_TIMEOUT)
+        {
+            DEBUG_EMSG("busy timeout");
+            return 0;
+        }
+
+        os_wait_ms(1);
+    }
+}
+
+/*
+ * write blocks of data with one CMD25 (CMD24 for single block)
+ *
+ * NOTE
+ * Number of blocks of one data transfer of controller is limited
+ * (SD_WRITE_MAX_BLOCKS), so long run is sent as several data phases of
+ * same CMD25: before next phase card should leave busy state and return
+ * to RCV state. Multiple block write is terminated by one CMD12 after
+ * last phase.
+ *
+ * RETURN
+ *     1 on success, 0 otherwise
+ */
+static int sdcard_write_blocks(uint32 bnum, uint8 *data, uint32 count)
+{
+    int retry;
+    int ret;
+    uint32 done, n;
+
+    retry = 3;
+    while (retry--)
+    {
+        if (!sdcard_wait_ready(R1_CURRENT_STATE_TRAN))
+        {
+            DPRINT("sn", "(E) card not ready for write");
+            sdcard_stop_transmission();
+            return 0;
+        }
+
+        /* NOTE pre-erase is only a hint, failure is not fatal */
+        if (count > 1 && !sdcard_acmd23_send(count))
+            DEBUG_WMSG("ACMD23 failed");
+
+        /*
+         * NOTE
+         * for SDHC/SDXC cards parameter is block number, for SDSC
+         * parameter is byte unit address
+         *
+         * XXX only SDHC/SDXC implemented
+         */
+        if (!sdcard_cmd_write_block(bnum, count))
+        {
+            DPRINT("sn", "(E) sdcard_cmd_write_block failed");
+            return 0;
+        }
+
+        ret = 1;
+        for (done = 0; ret && done < count; done += n)
+        {
+            n = count - done;
+            if (n > SD_WRITE_MAX_BLOCKS)
+                n = SD_WRITE_MAX_BLOCKS;
+
+            if (done && !sdcard_wait_ready(R1_CURRENT_STATE_RCV))
+            {
+                ret = 0;
+                break;
+            }
+            ret = sdcard_hw_write_blocks(data + done * 512, n);
+        }
+
+        /* multiple block write is terminated by CMD12 */
+        if (count > 1 && !sdcard_cmd12_send())
+        {
+            DEBUG_EMSG("CMD12 FAILED");
+            return 0;
+        }
+
+        if (ret)
+        {
+            /* NOTE wait end of programming, so error of write will not be lost */
+            return sdcard_wait_ready(R1_CURRENT_STATE_TRAN);
+        } else {
+            DEBUG_EMSGF("hwwrite", "<block >4xn", bnum + done);
+        }
+    }
+
+    return 0;
+}
+
 /******************************************************
  * high level functions for fat_io_lib
  ******************************************************
@@ -763,19 +995,10 @@ int media_read(uint32 sector, uint8 *buffer, uint32 sector_count)
 
 int media_write(uint32 sector, uint8 *buffer, uint32 sector_count)
 {
-    unsigned long i;
-
-    dprint("sn", "media write not implemented");
-    return 0;
-
-    for (i=0;i<sector_count;i++)
+    if (!sdcard_write(sector, buffer, sector_count))
     {
-        // ...
-        // Add platform specific sector (512 bytes) write code here
-        //..
-
-        sector ++;
-        buffer += 512;
+        dprint("sn", "(E) sdcard write error");
+        return 0;
     }
 
     return 1;
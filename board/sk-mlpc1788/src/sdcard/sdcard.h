@@ -48,6 +48,14 @@ extern struct card_state_t cardstate;
 //void sdcard_task();
 int sdcard_start();
 int sdcard_read(uint32 bnum, uint8 *data);
+/*
+ * NOTE
+ * DATALEN register of controller is 16-bit wide, so number of blocks
+ * transferred with one data transfer of controller is limited. Longer
+ * writes are sent as several data transfers of one CMD25.
+ */
+#define SD_WRITE_MAX_BLOCKS    64
+int sdcard_write(uint32 bnum, uint8 *data, uint32 count);
 
 int media_read(uint32 sector, uint8 *buffer, uint32 sector_count);
 int media_write(uint32 sector, uint8 *buffer, uint32 sector_count);
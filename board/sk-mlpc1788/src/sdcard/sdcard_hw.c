@@ -38,6 +38,7 @@
 #endif
 
 static int waitfor(uint32 mask);
+static int waitfor_tm(uint32 mask, uint32 to);
 
 static struct gpio_t detect = {LPC_GPIO1, (1 << 13)};
 #define EVENT_MASK_IRQ    (1 << 0)
@@ -303,6 +304,82 @@ out:
     return ret;
 }
 
+/*
+ * write one or more blocks of data to card, CMD24 or CMD25 should be
+ * already sent
+ *
+ * ARGS
+ *     data     source buffer, count * blocklen bytes
+ *     count    number of blocks
+ *
+ * NOTE
+ * Data timeout of controller is reloaded for each block. SDHC/SDXC card
+ * should complete programming of block in 250ms, but host should not
+ * wait for busy more than 500ms (Physical Layer Simplified Specification
+ * v4.10, 4.6.2.2).
+ *
+ * NOTE
+ * Controller does not signal end of busy (programming) state of the card,
+ * caller should wait for TRAN state with CMD13 after data transfer.
+ *
+ * RETURN
+ *     1 on success, 0 otherwise
+ */
+#define DATA_TIMER_WRITE_VALUE    (500 * (SD_HI_CLK / 1000)) /* in unit of SD_CLK */
+#define WAITFOR_WRITE_TIMEOUT     500 /* ms, per block */
+int sdcard_hw_write_blocks(uint8 *data, uint32 count)
+{
+    int ret;
+
+    ret = 1;
+
+    LPC_MCI->CLEAR    = SD_CLEAR_MASK;
+    LPC_MCI->DATATMR  = DATA_TIMER_WRITE_VALUE;
+    LPC_MCI->DATALEN  = cardstate.blocklen * count;
+
+    if (!dma_sd_write(data))
+    {
+        ret = 0;
+        goto out;
+    }
+
+    LPC_MCI->DATACTRL = 
+        SD_DATACTRL_ENABLE |
+        SD_DATACTRL_DMAENABLE |
+        SD_DATACTRL_DIRECTION_WRITE | 
+        SD_DATACTRL_BLOCKSIZE(9); /* XXX fixed to 512 bytes */
+
+    if (!waitfor_tm(SD_STATUS_DATAEND | SD_STATUS_TXUNDERRUN |
+                SD_STATUS_DATATIMEOUT | SD_STATUS_DATACRCFAIL, WAITFOR_WRITE_TIMEOUT * count))
+    {
+        dma_sd_cancel();
+        ret = 0;
+        goto out;
+    }
+
+    if (LPC_MCI->STATUS & (SD_STATUS_TXUNDERRUN | SD_STATUS_DATATIMEOUT | SD_STATUS_DATACRCFAIL))
+    {
+        if (LPC_MCI->STATUS & SD_STATUS_TXUNDERRUN)
+            DEBUG_EMSG("TXUNDERRUN");
+        if (LPC_MCI->STATUS & SD_STATUS_DATATIMEOUT)
+            DEBUG_EMSG("DATATIMEOUT");
+        /* NOTE negative CRC status token from card */
+        if (LPC_MCI->STATUS & SD_STATUS_DATACRCFAIL)
+            DEBUG_EMSG("DATACRCFAIL");
+
+        dma_sd_cancel();
+        ret = 0;
+        goto out;
+    }
+
+    if (!dma_wait_chan(DMA_CHMASK_SD, SD_CARD_DMA_TIMEOUT))
+        ret = 0;
+
+out:
+    LPC_MCI->DATACTRL = 0; /* NOTE */
+    return ret;
+}
+
 
 /*
  * wait for status
@@ -312,16 +389,31 @@ out:
  *
  */
 static int waitfor(uint32 mask)
+{
+#define WAITFOR_TIMEOUT    (100 + 20) /* ms */
+    return waitfor_tm(mask, WAITFOR_TIMEOUT);
+}
+
+/*
+ * wait for status with specified timeout
+ *
+ * ARGS
+ *     mask    status bits
+ *     to      timeout in ms
+ *
+ * RETURN
+ *     1 on success, 0 otherwise
+ *
+ */
+static int waitfor_tm(uint32 mask, uint32 to)
 {
     NVIC_ClearPendingIRQ(MCI_IRQn);
     LPC_MCI->MASK0 = mask;
     NVIC_EnableIRQ(MCI_IRQn);
 
-#define WAITFOR_TIMEOUT    (100 + 20) /* ms */
-
     /* NOTE wait with timeout */
     if (os_event_wait(&event, EVENT_MASK_IRQ, 
-            OS_FLAG_CLEAR, OS_MS2TICK(WAITFOR_TIMEOUT)) != OS_ERR_NONE)
+            OS_FLAG_CLEAR, OS_MS2TICK(to)) != OS_ERR_NONE)
     {
         DEBUG_EMSG("timeout");
     }
@@ -341,10 +433,12 @@ static int waitfor(uint32 mask)
 /*
  *
  */
-void SDCard_Handler(void)
+OS_RAMFUNC void SDCard_Handler(void)
 {
+    os_irq_enter(MCI_IRQn);
     NVIC_DisableIRQ(MCI_IRQn);
     os_event_raise(&event, EVENT_MASK_IRQ);
+    os_irq_exit(MCI_IRQn);
 }
 
 /*
@@ -115,8 +115,11 @@
 #define SD_CMD12_STOP_TRANSMISSION   12   /* ac   response R1b */
 #define SD_CMD13_SEND_STATUS         13   /* ac   response R1  */
 #define SD_CMD17_READ_SINGLE_BLOCK   17   /* ac   response R1  */
+#define SD_CMD24_WRITE_BLOCK         24   /* adtc response R1  */
+#define SD_CMD25_WRITE_MULTIPLE_BLOCK 25  /* adtc response R1  */
 #define SD_CMD55_APP_CMD             55   /* ac   response R1  */
 #define SD_ACMD6_SET_BUS_WISTH       6    /* ac   response R1  */
+#define SD_ACMD23_SET_WR_BLK_ERASE_COUNT 23 /* ac response R1  */
 #define SD_ACMD41_SD_SEND_OP_COND    41   /* bcr  response R3  */
 
 #pragma pack(push, 1)
@@ -166,6 +169,11 @@ union sd_argument_t {
         uint32 rca        : 16;
     } cmd55;
 
+    struct {
+        uint32 count      : 23; /* 0 - 22   number of blocks to be pre-erased */
+        uint32 reserved   : 9;  /* 23 - 31 */
+    } acmd23;
+
     uint32 value;
 };
 
@@ -356,6 +364,7 @@ void sdcard_hw_init();
 void sdcard_hw_set_lo_clk();
 void sdcard_hw_set_hi_clk();
 int sdcard_hw_read_block(uint8 *data);
+int sdcard_hw_write_blocks(uint8 *data, uint32 count);
 int card_detect();
 
 #define SD_CMDFLAG_NO_RESPONSE      0
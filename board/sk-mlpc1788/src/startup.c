@@ -27,6 +27,12 @@ extern unsigned long _edata;  /* end address for the .data section. defined in l
 extern unsigned long _sbss; /* start address for the .bss section. defined in linker script */
 extern unsigned long _ebss; /* end address for the .bss section. defined in linker script */
 
+extern unsigned long _sifast;   /* start address of image of .fast section (code and data placed to SRAM) */
+extern unsigned long _sfast;    /* start address for the .fast section */
+extern unsigned long _efast;    /* end address for the .fast section */
+extern unsigned long _sfastbss; /* start address for the .fastbss section */
+extern unsigned long _efastbss; /* end address for the .fastbss section */
+
 extern unsigned int *myvectors[];
 
 int main(void);
@@ -74,6 +80,20 @@ void __attribute__((naked)) Reset_Handler()
         *(pulDest++) = 0;
     }
 
+    /*
+     * Copy hot code and data to on-chip SRAM and zero fill its bss, nothing
+     * from there (OS_RAMFUNC) may be called before.
+     */
+    pulSrc = &_sifast;
+    for(pulDest = &_sfast; pulDest < &_efast; )
+    {
+        *(pulDest++) = *(pulSrc++);
+    }
+    for(pulDest = &_sfastbss; pulDest < &_efastbss; )
+    {
+        *(pulDest++) = 0;
+    }
+
     /* call the application's entry point */
     main();
 
@@ -22,6 +22,7 @@
 #include <string.h>
 #include <debug.h>
 #include "../upload.h"
+#include "../osw_objects.h"
 #include "usbdev.h"
 #include "usbdev_proto.h"
 
@@ -43,14 +44,12 @@ void usbdev_task()
     usbdev.ep[1].out_cb   = upload_usb_receive;
     usbdev.ep[1].in.abuf  = os_malloc(USBDEV_MAX_BUF_SIZE);
 
+    os_workq_init(&usbdev.wq);
+    os_work_init(&usbdev.work, &usbdev.wq, 0, usbdev_hw_bh, NULL, "USB");
     usbdev_hw_init();
 
-    while (1)
-    {
-        if (os_event_wait(&usbdev.event, USBDEV_EVENT_MASK_IRQ,
-                    OS_FLAG_CLEAR, OS_WAIT_FOREVER) == OS_ERR_NONE)
-            usbdev_hw_bh();
-    }
+    /* NOTE task is only worker of own queue, bottom halves of other devices are not run here */
+    os_workq_run(&usbdev.wq);
 }
 
 /*
@@ -29,8 +29,8 @@ void usbdev_task();
 #define EP_MAX_PACKET_SIZE  64
 
 struct usbdev_t {
-#define USBDEV_EVENT_MASK_IRQ    (1 << 0) 
-    BASE_TYPE event;
+    struct os_workq_t wq;   /* queue of bottom half, served by usbdev_task */
+    struct os_work_t work;  /* bottom half of interrupt */
 
 #define REALIZED_ENDPOINTS   2
     struct usbdev_ep_t {
@@ -191,14 +191,17 @@ static void pllfeed()
  */
 void USB_Handler(void)
 {
-    os_event_raise(&usbdev.event, USBDEV_EVENT_MASK_IRQ);
+    os_irq_enter(USB_IRQn);
+    /* NOTE interrupt is enabled by bottom half when status is cleared */
     NVIC_DisableIRQ(USB_IRQn);
+    os_work_post(&usbdev.work);
+    os_irq_exit(USB_IRQn);
 }
 
 /*
- * bottom half of USB interrupt
+ * bottom half of USB interrupt, run by usbdev_task
  */
-void usbdev_hw_bh()
+void usbdev_hw_bh(void *arg)
 {
     uint32 devintst;
     int i;
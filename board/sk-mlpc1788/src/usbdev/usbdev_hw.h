@@ -25,7 +25,7 @@
 #define USBDEVHW_H
 
 void usbdev_hw_init();
-void usbdev_hw_bh();
+void usbdev_hw_bh(void *arg);
 
 //#define EP0_PACKET_SIZE     8
 //#define EP1_PACKET_SIZE     64
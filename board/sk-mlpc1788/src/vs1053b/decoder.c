@@ -39,18 +39,28 @@
 #endif
 
 
+/* markers of OS trace buffer */
+#define DECODER_TRACE_UNDERFLOW    1   /* cache underflow, value - file position */
+#define DECODER_TRACE_DREQ_WAIT    2   /* buffer of vs1053 is full, value - file position */
+#define DECODER_TRACE_DREQ_HIGH    3   /* DREQ is raised, feed continues */
+
 #define DECODER_FEED_END        0
 #define DECODER_FEED_STOPPED    1
 static int decoder_feed();
 #define DECODER_SEND_POSITION_NORMAL   0
 #define DECODER_SEND_POSITION_NONE     1
 static void decoder_send_position(int none);
+static void decoder_position_due(void *arg);
+static void decoder_start_position();
 #define DECODER_SET_PLAY_SPEED_NORMAL   0
 #define DECODER_SET_PLAY_SPEED_FAST     1
 static void decoder_set_play_speed(int fast);
 #define DECODER_PROCMSG_NOP     0
 #define DECODER_PROCMSG_STOP    1
 static int decoder_process_msg();
+static void decoder_set_deadline();
+static void decoder_post_state(int state);
+static void decoder_post_volume(int value);
 
 #ifdef DEC_TEST_GPIO
 const struct gpio_t dec_testpins[2] = {
@@ -64,8 +74,9 @@ struct decoder_t {
     uint32 flen;    /* whole file length */
     uint32 fpos;    /* current decode position */
 
-    uint32 posto;   /* send position timer */
-    uint32 intrto;  /* interrupt timer */
+    struct os_timer_t postimer;  /* send position timer */
+    volatile int posdue;         /* set by timer, position should be sent */
+    uint32 intrto;               /* interrupt timer */
 
 #define DECODER_CMD_PAUSE    (1 << 0) /* pause playback */
 #define DECODER_CMD_FASTP    (1 << 1) /* fast playback */
@@ -83,13 +94,13 @@ static struct decoder_t decoder;
 void decoder_task()
 {
     struct decoder_msg_t dmsg;
-    struct player_msg_t pmsg;
-    BASE_TYPE msglen;
     int play;
 
     os_event_wait(&player.event, PLAYER_EVENT_INIT, OS_FLAG_NONE, OS_WAIT_FOREVER);
 //    vs1053b_set_volume(30);
 
+    os_timer_init(&decoder.postimer, decoder_position_due, NULL);
+
 #ifdef DEC_TEST_GPIO
     gpio_setdir(DECTEST_GPIO0, GPIO_DIR_OUTPUT);
     gpio_setdir(DECTEST_GPIO1, GPIO_DIR_OUTPUT);
@@ -108,39 +119,28 @@ void decoder_task()
         play = 0;
         do
         {
-            if (os_queue_remove(player.qdecoder, OS_FLAG_NONE, OS_WAIT_FOREVER,
-                        &dmsg, &msglen) == OS_ERR_NONE)
+            if (os_chan_recv(player.cdecoder, &dmsg, OS_FLAG_NONE, OS_WAIT_FOREVER) == OS_ERR_NONE)
             {
                 switch (dmsg.id)
                 {
                     case DECODER_MSG_ID_PLAY:
                         decoder.flen  = dmsg.play.flen;
                         decoder.fpos  = 0;
-                        stimer_settime(&decoder.posto);
                         play = 1;
 
-                        /* send message that we are started playback */
-                        pmsg.id = PLAYER_MSG_ID_DEC_PLAY;
-                        PLAYER_SEND_MSG_BLOCKING(&pmsg, pmsg_empty_t);
+                        /* notify that we are started playback */
+                        decoder_post_state(PLAYER_MSG_ID_DEC_PLAY);
 
                         break;
                     case DECODER_MSG_ID_INTR_PLAY:
                         /* FALLTHROUGH */
                     case DECODER_MSG_ID_STOP:
-                        /* send confirm that we are idle and player can initialize playback */
-                        pmsg.id = PLAYER_MSG_ID_DEC_STOPPED;
-                        PLAYER_SEND_MSG(&pmsg, pmsg_empty_t);
+                        /* confirm that we are idle and player can initialize playback */
+                        decoder_post_state(PLAYER_MSG_ID_DEC_STOPPED);
                         break;
                     case DECODER_MSG_ID_VOLUME:
-                        {
-                            int value;
-                            value = decoder_set_volume(dmsg.volume.value);
-
-                            /* send real volume information */
-                            pmsg.id           = PLAYER_MSG_ID_DEC_VOLUME;
-                            pmsg.volume.value = value;
-                            PLAYER_SEND_MSG_BLOCKING(&pmsg, pmsg_volume_t);
-                        }
+                        /* notify real volume */
+                        decoder_post_volume(decoder_set_volume(dmsg.volume.value));
                         break;
                     default:
                         DEBUG_WMSGF("0. odd message", "1xn", dmsg.id);
@@ -155,28 +155,23 @@ void decoder_task()
         vs1053b_set_hi_fclk();
 
         /* 
-         * query next track or send stopped message
+         * query next track or notify that playback was stopped
          */
         if (decoder_feed() == DECODER_FEED_STOPPED)
-        {
-            pmsg.id = PLAYER_MSG_ID_DEC_STOPPED;
-            PLAYER_SEND_MSG(&pmsg, pmsg_empty_t);
-        } else {
-            /* NOTE send in blocking mode */
-            pmsg.id = PLAYER_MSG_ID_DEC_NEXTTRACK;
-            PLAYER_SEND_MSG_BLOCKING(&pmsg, pmsg_empty_t);
-        }
+            decoder_post_state(PLAYER_MSG_ID_DEC_STOPPED);
+        else
+            decoder_post_state(PLAYER_MSG_ID_DEC_NEXTTRACK);
 
         vs1053b_cancel();
     }
 }
 
 /*
- * send position information to player
+ * post position information to player
  */
 static void decoder_send_position(int none)
 {
-    struct player_msg_t pmsg;
+    struct pmsg_position_t position;
 
 #define DECODER_NORMAL_SEND_POSITION_TO    1000
 #define DECODER_FAST_SEND_POSITION_TO      200
@@ -184,23 +179,62 @@ static void decoder_send_position(int none)
 
     if (none)
     {
-        pmsg.id = PLAYER_MSG_ID_DEC_POSITION;
-        pmsg.position.time  = 0;
-        pmsg.position.value = 0;
-        PLAYER_SEND_MSG(&pmsg, pmsg_position_t);
-    } else if (stimer_deltatime(decoder.posto) >= DECODER_SEND_POSITION_TO) {
-        stimer_settime(&decoder.posto);
-        pmsg.id = PLAYER_MSG_ID_DEC_POSITION;
+        position.time  = 0;
+        position.value = 0;
+        os_mbox_post(player.mposition, &position);
+    } else if (decoder.posdue) {
+        decoder.posdue = 0;
 
         vs1053b_set_low_fclk();
-        pmsg.position.time = vs1053b_get_decode_time();
+        position.time = vs1053b_get_decode_time();
         vs1053b_set_hi_fclk();
 
-        pmsg.position.value = decoder.fpos * 100 / decoder.flen;
-        PLAYER_SEND_MSG(&pmsg, pmsg_position_t);
+        position.value = decoder.fpos * 100 / decoder.flen;
+        os_mbox_post(player.mposition, &position);
+
+        /* byte rate of stream is known after start of decoding */
+        decoder_set_deadline();
     }
 }
 
+/*
+ * post play state to player (PLAYER_MSG_ID_DEC_*), state that was not
+ * processed by player yet is overwritten
+ */
+static void decoder_post_state(int state)
+{
+    os_mbox_post(player.mstate, &state);
+}
+
+/*
+ * post volume to player
+ */
+static void decoder_post_volume(int value)
+{
+    struct pmsg_volume_t volume;
+
+    volume.value = value;
+    os_mbox_post(player.mvolume, &volume);
+}
+
+/*
+ * Called from interrupt of timer, position is sent from feed loop when
+ * buffer of vs1053 is full.
+ */
+static void decoder_position_due(void *arg)
+{
+    decoder.posdue = 1;
+}
+
+/*
+ * (re)start timer of position, period depends on playback speed
+ */
+static void decoder_start_position()
+{
+    decoder.posdue = 0;
+    os_timer_start_ms(&decoder.postimer, DECODER_SEND_POSITION_TO, DECODER_SEND_POSITION_TO);
+}
+
 /*
  * set playback speed
  */
@@ -237,7 +271,7 @@ decoder_set_volume(int value)
  * RETURN
  *    1 if playback was stopped, 0 if full file was exhausted
  */
-static int decoder_feed()
+OS_RAMFUNC static int decoder_feed()
 {
     struct fcache_entry_t *entry;
     uint8 *buf;
@@ -248,6 +282,9 @@ static int decoder_feed()
     /* NOTE precache */
     player_fcache_fill();
 
+    decoder_set_deadline();
+    decoder_start_position();
+
 //    decoder_send_position(DECODER_SEND_POSITION_NONE);
 
     ret = DECODER_FEED_END;
@@ -267,6 +304,7 @@ static int decoder_feed()
             }
 
             DEBUG_WMSG("cache underflow");
+            os_trace_mark(DECODER_TRACE_UNDERFLOW, decoder.fpos);
 
             /* fill cache */
             player_fcache_fill();
@@ -320,10 +358,14 @@ static int decoder_feed()
                     goto out;
                 }
 
+                /* buffer of vs1053 is full, job is done until DREQ */
+                os_deadline_end();
 #ifdef DEC_TEST_GPIO
                 gpio_drive(DECTEST_GPIO1, 1);
 #endif
+                os_trace_mark(DECODER_TRACE_DREQ_WAIT, decoder.fpos);
                 vs1053b_wait_dreq();
+                os_trace_mark(DECODER_TRACE_DREQ_HIGH, 0);
 #ifdef DEC_TEST_GPIO
                 gpio_drive(DECTEST_GPIO1, 0);
 #endif
@@ -333,17 +375,45 @@ static int decoder_feed()
     }
 
 out:
+    os_timer_stop(&decoder.postimer);
+    os_deadline_set(0, 0);
     decoder_send_position(DECODER_SEND_POSITION_NONE);
     return ret;
 }
 
+/*
+ * Place decoder to deadline class of scheduler. When DREQ is raised feed
+ * should be done before vs1053 drains it's buffer, so period of job is
+ * time of playback of buffer at current byte rate.
+ */
+#define DECODER_VS1053_BUFSIZE      2048          /* size of stream buffer of vs1053 */
+#define DECODER_DREQ_FREE           32            /* DREQ is raised when buffer has this space free */
+#define DECODER_DEFAULT_BYTE_RATE   (320000 / 8)  /* used until byte rate of stream is known */
+static void decoder_set_deadline()
+{
+    uint32 rate;
+    uint32 period;
+
+    vs1053b_set_low_fclk();
+    rate = vs1053b_get_byte_rate();
+    vs1053b_set_hi_fclk();
+
+    if (rate == 0)
+        rate = DECODER_DEFAULT_BYTE_RATE;
+    if (decoder.cmd & DECODER_CMD_FASTP)
+        rate *= DECODER_FAST_PLAY_SPEED;
+
+    period = (DECODER_VS1053_BUFSIZE - DECODER_DREQ_FREE) * 1000000 / rate;
+    /* half of period is allowed to feed, rest is for player and others */
+    os_deadline_set(OS_US2TICK(period), OS_US2TICK(period / 2));
+}
+
 
 /*
  * Return 1 if decoder should be stopped
  */
 static int decoder_process_msg()
 {
-    struct player_msg_t pmsg;
     struct decoder_msg_t dmsg;
     BASE_TYPE qres;
 
@@ -353,9 +423,13 @@ static int decoder_process_msg()
     while (1)
     {
         if (decoder.cmd & (DECODER_CMD_PAUSE | DECODER_CMD_INTRP))
-            qres = os_queue_remove(player.qdecoder, OS_FLAG_NONE, OS_MS2TICK(MESSAGE_CHECK_TO), &dmsg, NULL);
-        else
-            qres = os_queue_remove(player.qdecoder, OS_FLAG_NOWAIT, OS_WAIT_FOREVER, &dmsg, NULL);
+        {
+            /* playback is paused, there is no deadline while waiting */
+            os_deadline_end();
+            qres = os_chan_recv(player.cdecoder, &dmsg, OS_FLAG_NONE, OS_MS2TICK(MESSAGE_CHECK_TO));
+        } else {
+            qres = os_chan_recv(player.cdecoder, &dmsg, OS_FLAG_NOWAIT, OS_WAIT_FOREVER);
+        }
         if (qres == OS_ERR_NONE)
         {
             switch (dmsg.id)
@@ -377,21 +451,16 @@ static int decoder_process_msg()
 
                     decoder_set_play_speed(decoder.cmd & DECODER_CMD_FASTP ?
                             DECODER_SET_PLAY_SPEED_FAST : DECODER_SET_PLAY_SPEED_NORMAL);
+                    decoder_set_deadline();
+                    decoder_start_position();
                     break;
                 case DECODER_MSG_ID_INTR_PLAY:
                     BITMASK_SET(decoder.cmd, DECODER_CMD_INTRP);
                     stimer_settime(&decoder.intrto);
                     break;
                 case DECODER_MSG_ID_VOLUME:
-                    {
-                        int value;
-                        value = decoder_set_volume(dmsg.volume.value);
-
-                        /* send real volume information */
-                        pmsg.id           = PLAYER_MSG_ID_DEC_VOLUME;
-                        pmsg.volume.value = value;
-                        PLAYER_SEND_MSG_BLOCKING(&pmsg, pmsg_volume_t);
-                    }
+                    /* notify real volume */
+                    decoder_post_volume(decoder_set_volume(dmsg.volume.value));
                     break;
                 default:
                     DEBUG_WMSGF("1. odd message", "1xn", dmsg.id);
@@ -400,12 +469,9 @@ static int decoder_process_msg()
 
         if (decoder.cmd & (DECODER_CMD_PAUSE | DECODER_CMD_INTRP))
         {
-            /* send confirm that we are paused */
+            /* confirm that we are paused */
             if (qres == OS_ERR_NONE)
-            {
-                pmsg.id = PLAYER_MSG_ID_DEC_PAUSED;
-                PLAYER_SEND_MSG_BLOCKING(&pmsg, pmsg_empty_t);
-            }
+                decoder_post_state(PLAYER_MSG_ID_DEC_PAUSED);
 
             if (decoder.cmd & DECODER_CMD_INTRP)
             {
@@ -415,12 +481,9 @@ static int decoder_process_msg()
 
 //            os_wait_ms(150);
         } else {
-            /* send message that we resume playback */
+            /* notify that we resume playback */
             if (qres == OS_ERR_NONE)
-            {
-                pmsg.id = PLAYER_MSG_ID_DEC_PLAY;
-                PLAYER_SEND_MSG_BLOCKING(&pmsg, pmsg_empty_t);
-            }
+                decoder_post_state(PLAYER_MSG_ID_DEC_PLAY);
             break;
         }
     }
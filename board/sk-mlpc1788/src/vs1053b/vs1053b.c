@@ -52,6 +52,7 @@
 
 //#define SCI_RAM_DREQ          0xC012
 #define SCI_RAM_PLAYSPEED     0x1e04
+#define SCI_RAM_BYTERATE      0x1e05
 #define SCI_RAM_ENDFILLBYTE   0x1e06
 
 //#define SCI_REG_STATUS_SS_REFERENCE_SEL (1 << 0)
@@ -273,7 +274,7 @@ void vs1053b_cancel()
         /* write 32 bytes of data */
         if (!vs1053b_check_dreq())
         {
-            os_wait(1);
+            os_wait_ms(1);
             continue;
         }
 
@@ -321,6 +322,15 @@ int vs1053b_get_decode_time()
     return vs1053b_hw_readsci(SCI_REG_DECODE_TIME);
 }
 
+/*
+ * return average byte rate of stream (bytes per second), zero if it is not
+ * known yet
+ */
+int vs1053b_get_byte_rate()
+{
+    return vs1053b_rram(SCI_RAM_BYTERATE);
+}
+
 /*
  * set decode time
  */
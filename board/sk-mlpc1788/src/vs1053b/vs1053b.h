@@ -31,6 +31,7 @@ void vs1053b_cancel();
 void vs1053b_set_hi_fclk();
 void vs1053b_set_low_fclk();
 int vs1053b_get_decode_time();
+int vs1053b_get_byte_rate();
 void vs1053b_set_decode_time(uint16 time);
 void vs1053b_set_play_speed(uint16 value);
 int vs1053b_set_volume(int value);
@@ -65,7 +65,7 @@ static const struct gpio_t vsgpio[VSGPIO_COUNT] = {
 
 #define SSP1_EVENT_DONE      (1 << 0)
 #define EINT_EVENT_DREQ_HIGH (1 << 1)
-static BASE_TYPE mevent;
+static BASE_TYPE mevent OS_FASTBSS;
 
 /*
  *
@@ -199,7 +199,7 @@ int vs1053b_hw_init()
 
     stimer_settime(&to);
     while (!VS1053B_GET_DREQ() && stimer_deltatime(to) < INIT_TO)
-        os_wait(1);
+        os_wait_ms(1);
 
     if (stimer_deltatime(to) >= INIT_TO)
     {
@@ -225,10 +225,11 @@ struct ssp_state_t {
     uint8 *rxp;
 };
 
-static struct ssp_state_t ssp_state;
+static struct ssp_state_t ssp_state OS_FASTBSS;
 
-void SSP1_Handler(void)
+OS_RAMFUNC void SSP1_Handler(void)
 {
+    os_irq_enter(SSP1_IRQn);
     if (LPC_SSP1->MIS & SSP_MIS_RTMIS)
         LPC_SSP1->ICR  = SSP_ICR_RTIC;
     if (LPC_SSP1->MIS & SSP_MIS_RORMIS)
@@ -252,16 +253,18 @@ void SSP1_Handler(void)
                 LPC_SSP1->IMSC = 0;
                 NVIC_DisableIRQ(SSP1_IRQn);
                 os_event_raise(&mevent, SSP1_EVENT_DONE);
+                os_irq_exit(SSP1_IRQn);
                 return;
             }
         }
     }
+    os_irq_exit(SSP1_IRQn);
 }
 
 /*
  *
  */
-static void ssp_wr(uint8 *tx, uint8 *rx, uint32 len)
+OS_RAMFUNC static void ssp_wr(uint8 *tx, uint8 *rx, uint32 len)
 {
     int n;
 
@@ -373,7 +376,7 @@ uint16 vs1053b_hw_readsci(uint8 addr)
 
     /* wait when DREQ will go high */
     while (!VS1053B_GET_DREQ())
-        os_wait(1);
+        os_wait_ms(1);
 
 //    DEBUG_IMSG("DREQ high");
 
@@ -399,7 +402,7 @@ void vs1053b_hw_writesci(uint8 addr, uint16 value)
 
     /* wait when DREQ will go high */
     while (!VS1053B_GET_DREQ())
-        os_wait(1);
+        os_wait_ms(1);
 
 //    DEBUG_IMSG("DREQ high");
 
@@ -417,7 +420,7 @@ void vs1053b_hw_writesci(uint8 addr, uint16 value)
 /*
  * NOTE no check of DREQ
  */
-void vs1053b_hw_writesdi(uint8 *data, int len)
+OS_RAMFUNC void vs1053b_hw_writesdi(uint8 *data, int len)
 {
     VS1053B_XDCS_ON();
     ssp_wr(data, NULL, len);
@@ -449,8 +452,9 @@ void vs1053b_hw_wait_dreq()
 /*
  *
  */
-void EINT0_Handler(void)
+OS_RAMFUNC void EINT0_Handler(void)
 {
+    os_irq_enter(EINT0_IRQn);
     if (vs1053b_hw_check_dreq())
     {
         os_event_raise(&mevent, EINT_EVENT_DREQ_HIGH);
@@ -458,9 +462,11 @@ void EINT0_Handler(void)
 
         NVIC_DisableIRQ(EINT0_IRQn);
         NVIC_ClearPendingIRQ(EINT0_IRQn);
+        os_irq_exit(EINT0_IRQn);
         return;
     }
 
     dprint("sn", "unhopped irq");
+    os_irq_exit(EINT0_IRQn);
 }
 
@@ -0,0 +1,315 @@
+/*
+ *     This file is part of K11, hardware multimedia player.
+ *
+ * Copyright (C) 2014 Dmitry Kobylin
+ *
+ * This program is free software: you can redistribute it and/or modify
+ * it under the terms of the GNU General Public License as published by
+ * the Free Software Foundation, either version 3 of the License, or
+ * (at your option) any later version.
+ *
+ * This program is distributed in the hope that it will be useful,
+ * but WITHOUT ANY WARRANTY; without even the implied warranty of
+ * MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the
+ * GNU General Public License for more details.
+ *
+ * You should have received a copy of the GNU General Public License
+ * along with this program.  If not, see <http://www.gnu.org/licenses/>.
+ *
+ */
+
+/*
+ * Host test of fat_io_lib. Image of SD card is mounted with fat_io_lib and
+ * compared with reference tree on host (tree that was copied to image):
+ * every directory is listed and every file is read with different sizes of
+ * reads, with and without pool buffer (fl_setvbuf()), and opened by upper
+ * case path. Image is mounted read only, any write to media is error.
+ *
+ * Usage:
+ *     fattest image refdir
+ *
+ * Image is created by mkimg.sh.
+ */
+
+#include <stdlib.h>
+#include <string.h>
+#include <stdio.h>
+#include <ctype.h>
+#include <dirent.h>
+#include <sys/stat.h>
+#include <types.h>
+#include "fat_filelib.h"
+#include "fat_table.h"
+#include "stimer.h"
+
+#define FATTEST_PATH_MAX   8192
+#define FATTEST_VBUF       8
+
+static FILE *fattest_img;
+static int fattest_writes;
+static int fattest_errors;
+static int fattest_files;
+static int fattest_dirs;
+
+/* sizes of reads, 0 ends list */
+static int fattest_rdsize[] = {1, 777, 2048, 65536, 0};
+
+/*
+ * for dprint
+ */
+int putChar(int c)
+{
+    return putchar(c);
+}
+
+void stimer_settime(uint32 *t)
+{
+    *t = 0;
+}
+
+uint32 stimer_deltatime(uint32 t)
+{
+    return 0;
+}
+
+static int fattest_read(uint32 sector, uint8 *buffer, uint32 count)
+{
+    if (fseek(fattest_img, (long)sector * FAT_SECTOR_SIZE, SEEK_SET) != 0)
+        return 0;
+    if (fread(buffer, FAT_SECTOR_SIZE, count, fattest_img) != count)
+        return 0;
+    return 1;
+}
+
+static int fattest_write(uint32 sector, uint8 *buffer, uint32 count)
+{
+    fattest_writes++;
+    return 0;
+}
+
+static void fattest_fail(const char *path, const char *msg)
+{
+    printf("FAIL %s: %s\n", path, msg);
+    fattest_errors++;
+}
+
+/*
+ * read whole file from host
+ *
+ * RETURN
+ *     buffer with file data (free() it), NULL on error
+ */
+static uint8 *fattest_load(const char *hpath, long *len)
+{
+    FILE *f;
+    uint8 *buf;
+
+    f = fopen(hpath, "rb");
+    if (!f)
+        return NULL;
+    fseek(f, 0, SEEK_END);
+    *len = ftell(f);
+    rewind(f);
+    buf = malloc(*len + 1);
+    if (buf && fread(buf, 1, *len, f) != (size_t)*len)
+    {
+        free(buf);
+        buf = NULL;
+    }
+    fclose(f);
+
+    return buf;
+}
+
+/*
+ * read file with fat_io_lib by parts of "rdsize" bytes and compare with
+ * reference
+ */
+static void fattest_cmpfile(const char *path, uint8 *ref, long len, int rdsize, int vbuf)
+{
+    FL_FILE *file;
+    uint8 *buf;
+    long pos;
+    int rd;
+    char msg[128];
+
+    file = fl_fopen(path, "r");
+    if (!file)
+    {
+        fattest_fail(path, "open");
+        return;
+    }
+    if (vbuf && fl_setvbuf(file, vbuf) < 0)
+        fattest_fail(path, "no pool buffer");
+
+    buf = malloc(len + rdsize);
+    pos = 0;
+    while (1)
+    {
+        rd = fl_fread(buf + pos, 1, rdsize, file);
+        if (rd <= 0)
+            break;
+        pos += rd;
+        if (pos > len)
+            break;
+    }
+    fl_fclose(file);
+
+    if (pos != len)
+    {
+        sprintf(msg, "read %ld of %ld bytes (reads of %d, vbuf %d)", pos, len, rdsize, vbuf);
+        fattest_fail(path, msg);
+    } else if (memcmp(buf, ref, len) != 0) {
+        sprintf(msg, "data differs (reads of %d, vbuf %d)", rdsize, vbuf);
+        fattest_fail(path, msg);
+    }
+    free(buf);
+}
+
+static void fattest_file(const char *path, const char *hpath)
+{
+    FL_FILE *file;
+    uint8 *ref;
+    long len;
+    int i;
+    char upath[FATTEST_PATH_MAX];
+
+    ref = fattest_load(hpath, &len);
+    if (!ref)
+    {
+        fattest_fail(hpath, "can't read reference");
+        return;
+    }
+
+    for (i = 0; fattest_rdsize[i]; i++)
+    {
+        fattest_cmpfile(path, ref, len, fattest_rdsize[i], 0);
+        fattest_cmpfile(path, ref, len, fattest_rdsize[i], FATTEST_VBUF);
+    }
+
+    /* names are matched case-insensitive */
+    for (i = 0; path[i]; i++)
+        upath[i] = toupper((unsigned char)path[i]);
+    upath[i] = 0;
+    file = fl_fopen(upath, "r");
+    if (!file || file->filelength != (uint32)len)
+        fattest_fail(upath, "open by upper case path");
+    if (file)
+        fl_fclose(file);
+
+    free(ref);
+    fattest_files++;
+}
+
+/*
+ * compare directory listed by fat_io_lib with reference, then check its
+ * entries
+ */
+static void fattest_dir(const char *path, const char *hpath)
+{
+    FL_DIR dir;
+    fl_dirent ent;
+    DIR *hdir;
+    struct dirent *hent;
+    struct stat st;
+    int n, hn;
+    char sub[FATTEST_PATH_MAX];
+    char hsub[FATTEST_PATH_MAX];
+    char msg[128];
+
+    if (!fl_opendir(path, &dir))
+    {
+        fattest_fail(path, "opendir");
+        return;
+    }
+    n = 0;
+    while (fl_readdir(&dir, &ent) == 0)
+    {
+        if (!strcmp(ent.filename, ".") || !strcmp(ent.filename, ".."))
+            continue;
+        n++;
+        snprintf(hsub, sizeof(hsub), "%s/%s", hpath, ent.filename);
+        if (stat(hsub, &st) != 0)
+        {
+            fattest_fail(hsub, "listed, but not in reference");
+            continue;
+        }
+        if (!!ent.is_dir != !!S_ISDIR(st.st_mode))
+            fattest_fail(hsub, "type of entry");
+        if (!ent.is_dir && ent.size != (uint32)st.st_size)
+            fattest_fail(hsub, "size of entry");
+    }
+    fl_closedir(&dir);
+
+    hdir = opendir(hpath);
+    if (!hdir)
+    {
+        fattest_fail(hpath, "can't open reference");
+        return;
+    }
+    hn = 0;
+    while ((hent = readdir(hdir)) != NULL)
+    {
+        if (!strcmp(hent->d_name, ".") || !strcmp(hent->d_name, ".."))
+            continue;
+        hn++;
+        snprintf(sub, sizeof(sub), "%s%s%s", path, strcmp(path, "/") ? "/" : "", hent->d_name);
+        snprintf(hsub, sizeof(hsub), "%s/%s", hpath, hent->d_name);
+        if (stat(hsub, &st) != 0)
+            continue;
+        if (S_ISDIR(st.st_mode))
+            fattest_dir(sub, hsub);
+        else
+            fattest_file(sub, hsub);
+    }
+    closedir(hdir);
+
+    if (n != hn)
+    {
+        sprintf(msg, "%d entries listed, %d in reference", n, hn);
+        fattest_fail(path, msg);
+    }
+    fattest_dirs++;
+}
+
+int main(int argc, char **argv)
+{
+    int res;
+
+    if (argc != 3)
+    {
+        fprintf(stderr, "usage: %s image refdir\n", argv[0]);
+        return 2;
+    }
+
+    fattest_img = fopen(argv[1], "rb");
+    if (!fattest_img)
+    {
+        perror(argv[1]);
+        return 2;
+    }
+
+    fl_init();
+    res = fl_attach_media(fattest_read, fattest_write);
+    if (res != FAT_INIT_OK)
+    {
+        printf("FAIL attach media (%d)\n", res);
+        return 1;
+    }
+    fatfs_show_details(fl_get_fs());
+    printf("Free clusters = %u\n", fatfs_count_free_clusters(fl_get_fs()));
+
+    fattest_dir("/", argv[2]);
+
+    /* volume is mounted read only */
+    if (fl_fopen("/fattest.new", "w"))
+        fattest_fail("/fattest.new", "opened for write");
+    fl_shutdown();
+    if (fattest_writes)
+        fattest_fail(argv[1], "media written");
+
+    printf("%d directories, %d files, %d errors\n", fattest_dirs, fattest_files, fattest_errors);
+    fclose(fattest_img);
+
+    return fattest_errors ? 1 : 0;
+}
@@ -0,0 +1,71 @@
+#!/bin/sh
+#
+# create exFAT image of SD card with Linux tools and reference tree with
+# same content for fattest
+#
+# Usage:
+#     sudo ./mkimg.sh image refdir
+#
+# mkfs.exfat (exfatprogs) and exFAT driver of kernel are required, image is
+# mounted with loop device. Image has 4K clusters and holds:
+#     Track01.mp3          file written at once, single extent (NoFatChain)
+#     Frag/a.bin, b.bin    files written in turns by cluster, FAT chain
+#     Many Files/          directory of 300 files with long names, several
+#                          clusters, grows in turns with clusters of its
+#                          files so directory itself has FAT chain; some
+#                          files are removed (deleted entry sets)
+#     Empty/               empty directory
+#
+set -e
+
+if [ $# -ne 2 ]; then
+    echo "usage: $0 image refdir" >&2
+    exit 1
+fi
+IMG=$1
+REF=$2
+CLUSTER=4096
+
+rm -rf "$REF"
+mkdir -p "$REF/Frag" "$REF/Many Files" "$REF/Empty"
+
+dd if=/dev/urandom of="$REF/Track01.mp3" bs=1000 count=3001 status=none
+dd if=/dev/urandom of="$REF/Frag/a.bin" bs=$CLUSTER count=40 status=none
+dd if=/dev/urandom of="$REF/Frag/b.bin" bs=$CLUSTER count=33 status=none
+# last cluster of b.bin is partial
+dd if=/dev/urandom of="$REF/Frag/b.bin" bs=100 count=1 oflag=append conv=notrunc status=none
+
+rm -f "$IMG"
+truncate -s 64M "$IMG"
+mkfs.exfat -c $CLUSTER "$IMG" >/dev/null
+
+MNT=$(mktemp -d)
+mount -t exfat -o loop "$IMG" "$MNT"
+trap 'umount "$MNT"; rmdir "$MNT"' EXIT
+
+cp "$REF/Track01.mp3" "$MNT/"
+mkdir "$MNT/Frag" "$MNT/Many Files" "$MNT/Empty"
+
+i=0
+while [ $i -lt 40 ]; do
+    for f in a.bin b.bin; do
+        dd if="$REF/Frag/$f" of="$MNT/Frag/$f" bs=$CLUSTER skip=$i seek=$i count=1 conv=notrunc status=none
+    done
+    sync
+    i=$((i + 1))
+done
+
+i=0
+while [ $i -lt 300 ]; do
+    name="Long file name of entry number $i.txt"
+    echo "file $i" > "$REF/Many Files/$name"
+    cp "$REF/Many Files/$name" "$MNT/Many Files/$name"
+    sync
+    i=$((i + 1))
+done
+for i in 7 100 299; do
+    name="Long file name of entry number $i.txt"
+    rm "$REF/Many Files/$name" "$MNT/Many Files/$name"
+done
+
+sync
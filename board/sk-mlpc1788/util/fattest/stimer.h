@@ -0,0 +1,11 @@
+#ifndef STIMER_H
+#define STIMER_H
+
+/*
+ * timer of board is not used on host, fat_io_lib uses it only for
+ * statistics of write cache
+ */
+void stimer_settime(uint32 *t);
+uint32 stimer_deltatime(uint32 t);
+
+#endif
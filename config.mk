@@ -12,3 +12,8 @@ export BOARD = sk-mlpc1788
 # To build documentation set value of this variable to 1
 BUILD_DOC = 0
 
+# To collect stack usage and call graph of functions (GCC 10 or newer) set
+# value of this variable to 1, "make stack" generates stack sizes of tasks
+# from them.
+STACK_USAGE = 0
+
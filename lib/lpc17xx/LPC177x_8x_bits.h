@@ -76,6 +76,9 @@
 #define TCR_ENABLE  (1 << 0)
 #define TCR_RESET   (1 << 1)
 
+#define TIM_MCR_MR0I (1 << 0)
+#define TIM_IR_MR0   (1 << 0)
+
 /****************************
  * SSP
  ****************************/
@@ -1,26 +1,5 @@
 src/util.o: src/util.c src/util.h ../../lib/lpc17xx/types.h
-src/debug.o: src/debug.c \
- /usr/spkg/unsorted/arm-2012.09-63/bin/../lib/gcc/arm-none-eabi/4.7.2/include/stdarg.h \
- /usr/spkg/unsorted/arm-2012.09-63/bin/../lib/gcc/arm-none-eabi/4.7.2/../../../../arm-none-eabi/include/string.h \
- /usr/spkg/unsorted/arm-2012.09-63/bin/../lib/gcc/arm-none-eabi/4.7.2/../../../../arm-none-eabi/include/_ansi.h \
- /usr/spkg/unsorted/arm-2012.09-63/bin/../lib/gcc/arm-none-eabi/4.7.2/../../../../arm-none-eabi/include/newlib.h \
- /usr/spkg/unsorted/arm-2012.09-63/bin/../lib/gcc/arm-none-eabi/4.7.2/../../../../arm-none-eabi/include/sys/config.h \
- /usr/spkg/unsorted/arm-2012.09-63/bin/../lib/gcc/arm-none-eabi/4.7.2/../../../../arm-none-eabi/include/machine/ieeefp.h \
- /usr/spkg/unsorted/arm-2012.09-63/bin/../lib/gcc/arm-none-eabi/4.7.2/../../../../arm-none-eabi/include/sys/features.h \
- /usr/spkg/unsorted/arm-2012.09-63/bin/../lib/gcc/arm-none-eabi/4.7.2/../../../../arm-none-eabi/include/sys/reent.h \
- /usr/spkg/unsorted/arm-2012.09-63/bin/../lib/gcc/arm-none-eabi/4.7.2/../../../../arm-none-eabi/include/_ansi.h \
- /usr/spkg/unsorted/arm-2012.09-63/bin/../lib/gcc/arm-none-eabi/4.7.2/../../../../arm-none-eabi/include/sys/_types.h \
- /usr/spkg/unsorted/arm-2012.09-63/bin/../lib/gcc/arm-none-eabi/4.7.2/../../../../arm-none-eabi/include/machine/_types.h \
- /usr/spkg/unsorted/arm-2012.09-63/bin/../lib/gcc/arm-none-eabi/4.7.2/../../../../arm-none-eabi/include/machine/_default_types.h \
- /usr/spkg/unsorted/arm-2012.09-63/bin/../lib/gcc/arm-none-eabi/4.7.2/../../../../arm-none-eabi/include/sys/lock.h \
- /usr/spkg/unsorted/arm-2012.09-63/bin/../lib/gcc/arm-none-eabi/4.7.2/include/stddef.h \
- /usr/spkg/unsorted/arm-2012.09-63/bin/../lib/gcc/arm-none-eabi/4.7.2/../../../../arm-none-eabi/include/sys/string.h \
- src/debug.h \
- /usr/spkg/unsorted/arm-2012.09-63/bin/../lib/gcc/arm-none-eabi/4.7.2/../../../../arm-none-eabi/include/stdio.h \
- /usr/spkg/unsorted/arm-2012.09-63/bin/../lib/gcc/arm-none-eabi/4.7.2/../../../../arm-none-eabi/include/sys/types.h \
- /usr/spkg/unsorted/arm-2012.09-63/bin/../lib/gcc/arm-none-eabi/4.7.2/../../../../arm-none-eabi/include/machine/types.h \
- /usr/spkg/unsorted/arm-2012.09-63/bin/../lib/gcc/arm-none-eabi/4.7.2/../../../../arm-none-eabi/include/sys/stdio.h \
- ../../lib/lpc17xx/types.h
+src/debug.o: src/debug.c src/debug.h ../../lib/lpc17xx/types.h
 src/crc32.o: src/crc32.c ../../lib/lpc17xx/types.h
 src/crc16.o: src/crc16.c src/crc16.h
 src/pearson.o: src/pearson.c ../../lib/lpc17xx/types.h
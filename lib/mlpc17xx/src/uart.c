@@ -210,18 +210,172 @@ static void uart_defaultisr(void *u)
     }
 }
 
+/*
+ * Output of debug port. Characters are written to UART directly until
+ * driver registered with uart_dbg_async() and after uart_dbg_sync() (fault
+ * handlers), ring is flushed before, so order of characters is kept.
+ *
+ * In other contexts characters are queued, also where interrupt of driver
+ * can't be taken (interrupts disabled, handler of same or higher priority,
+ * DPort monitor). Part that is sent already is finished by DMA, rest of
+ * ring is sent when interrupt is taken.
+ */
+struct uart_dbg_t uart_dbg;
+
+static void uart_dbg_kick();
+static void uart_dbg_flush();
+
 /*
  * for printf 
  */
 int putChar(int c) 
 { 
-    while (!(DEBUG_UART->pm->LSR & UART_LSR_THRE))
-        ;
-    DEBUG_UART->pm->THR = c;
+    uint32 pm;
+
+    if (uart_dbg.start == NULL || uart_dbg.sync)
+    {
+        uart_dbg_flush();
+        while (!(DEBUG_UART->pm->LSR & UART_LSR_THRE))
+            ;
+        DEBUG_UART->pm->THR = c;
+
+        return c;
+    }
+
+    pm = __get_PRIMASK();
+    __disable_irq();
+    if ((uart_dbg.wp - uart_dbg.rp) >= UART_DBG_BUFSIZE)
+    {
+        uart_dbg.dropped++;
+    } else {
+        uart_dbg.buf[uart_dbg.wp & (UART_DBG_BUFSIZE - 1)] = c;
+        uart_dbg.wp++;
+        if (!uart_dbg.busy)
+            uart_dbg_kick();
+    }
+    __set_PRIMASK(pm);
 
     return c;
 }
 
+/*
+ * send output of debug port with driver
+ *
+ * ARGS
+ *     start    start send of part of ring, return number of characters
+ *              taken (may be less than "len")
+ *     stop     stop send, return number of characters of part that were
+ *              sent
+ */
+void uart_dbg_async(uint32 (*start)(uint8 *buf, uint32 len), uint32 (*stop)())
+{
+    /* Enable FIFO's, DMA mode, 0 characters for CTI interrupt (as in uart_setup()) */
+    DEBUG_UART->pm->FCR = (1 << 3) | (1 << 0) | (0 << 6);
+
+    uart_dbg.stop  = stop;
+    uart_dbg.start = start;
+}
+
+/*
+ * part of ring was sent, called by driver
+ */
+void uart_dbg_done()
+{
+    uint32 pm;
+
+    pm = __get_PRIMASK();
+    __disable_irq();
+    /* NOTE part may be taken back by uart_dbg_pause() already */
+    if (uart_dbg.busy)
+    {
+        uart_dbg.rp  += uart_dbg.busy;
+        uart_dbg.busy = 0;
+        if (uart_dbg.wp != uart_dbg.rp)
+            uart_dbg_kick();
+    }
+    __set_PRIMASK(pm);
+}
+
+/*
+ * stop driver, characters that were not sent stay in ring and are sent with
+ * next output
+ *
+ * NOTE called from DPort_Handler() to not mix output with replies of DPort
+ */
+void uart_dbg_pause()
+{
+    uint32 pm;
+
+    pm = __get_PRIMASK();
+    __disable_irq();
+    if (uart_dbg.busy)
+    {
+        uart_dbg.rp  += (*uart_dbg.stop)();
+        uart_dbg.busy = 0;
+    }
+    __set_PRIMASK(pm);
+}
+
+/*
+ * flush ring and write all further output to UART directly, for fault
+ * handlers
+ */
+void uart_dbg_sync()
+{
+    uart_dbg.sync = 1;
+    uart_dbg_flush();
+}
+
+/*
+ * start send of continuous part of ring, rest is sent after wrap
+ *
+ * NOTE this funciton should be call during interrupts disabled
+ */
+static void uart_dbg_kick()
+{
+    uint32 rp;
+    uint32 len;
+
+    rp  = uart_dbg.rp & (UART_DBG_BUFSIZE - 1);
+    len = uart_dbg.wp - uart_dbg.rp;
+    if (len > (UART_DBG_BUFSIZE - rp))
+        len = UART_DBG_BUFSIZE - rp;
+
+    asm volatile ("dmb\n"); /* NOTE characters are in memory before driver reads them */
+    uart_dbg.busy = (*uart_dbg.start)(&uart_dbg.buf[rp], len);
+}
+
+/*
+ * write characters left in ring to UART directly
+ */
+static void uart_dbg_flush()
+{
+    uint32 pm;
+    int c;
+
+    if (uart_dbg.start == NULL)
+        return;
+
+    uart_dbg_pause();
+    while (1)
+    {
+        pm = __get_PRIMASK();
+        __disable_irq();
+        if (uart_dbg.rp == uart_dbg.wp)
+        {
+            __set_PRIMASK(pm);
+            break;
+        }
+        c = uart_dbg.buf[uart_dbg.rp & (UART_DBG_BUFSIZE - 1)];
+        uart_dbg.rp++;
+        __set_PRIMASK(pm);
+
+        while (!(DEBUG_UART->pm->LSR & UART_LSR_THRE))
+            ;
+        DEBUG_UART->pm->THR = c;
+    }
+}
+
 ///*
 // * check if transmission already in progress
 // *
@@ -65,7 +65,30 @@ extern struct uart_t uart[UART_COUNT];
 
 #define DEBUG_UART (&uart[0])
 
+/*
+ * Asynchronous output of debug port. putChar() queues characters to ring,
+ * driver registered by uart_dbg_async() sends continuous part of ring and
+ * calls uart_dbg_done() when part is sent.
+ */
+#define UART_DBG_BUFSIZE 8192 /* power of two */
+struct uart_dbg_t {
+    uint8 buf[UART_DBG_BUFSIZE];
+    volatile uint32 wp;       /* characters queued */
+    volatile uint32 rp;       /* characters sent */
+    volatile uint32 busy;     /* length of part sent by driver, 0 - driver is idle */
+    uint32 dropped;           /* characters dropped on overflow of ring */
+    int sync;                 /* 1 - write characters to UART directly (uart_dbg_sync()) */
+
+    uint32 (*start)(uint8 *buf, uint32 len); /* start send, return number of characters taken */
+    uint32 (*stop)();                        /* stop send, return number of characters sent */
+};
+extern struct uart_dbg_t uart_dbg;
+
 int putChar(int c);
+void uart_dbg_async(uint32 (*start)(uint8 *buf, uint32 len), uint32 (*stop)());
+void uart_dbg_done();
+void uart_dbg_pause();
+void uart_dbg_sync();
 uint32 uart_setup(struct uart_t *pu, uint32 speed, struct uart_cb_t *cb);
 //void uart_send(struct uart_t *pu);
 //void uart_sendbuf(struct uart_t *pu, uint8 *buf, uint32 c);
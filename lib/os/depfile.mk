@@ -1,14 +1,26 @@
 src/os.o: src/os.c ../../lib/misc/src/debug.h ../../lib/lpc17xx/types.h \
  src/os.h src/os_config.h src/../../../board/sk-mlpc1788/src/os_config.h \
  src/os_flags.h src/os_bitobj.h src/os_queue.h src/os_mem.h \
- src/os_multi.h src/os_private.h src/port/ARMv7-M/port.h src/os_sched.h
+ src/os_multi.h src/os_private.h src/port/ARMv7-M/port.h src/os_sched.h \
+ src/os_pool.h \
+ src/os_rmutex.h \
+ src/os_trace.h \
+ src/os_cpustat.h \
+ src/os_irqstat.h \
+ src/os_timer.h src/os_work.h src/os_mbox.h
 src/os_sched.o: src/os_sched.c src/os_sched.h src/os_private.h \
  ../../lib/lpc17xx/types.h src/os_config.h \
  src/../../../board/sk-mlpc1788/src/os_config.h src/os_flags.h \
- src/port/ARMv7-M/port.h src/os_queue.h src/os_multi.h src/os_bitobj.h
+ src/port/ARMv7-M/port.h src/os_queue.h src/os_multi.h src/os_bitobj.h \
+ src/os_rmutex.h \
+ src/os_trace.h \
+ src/os_cpustat.h \
+ src/os_irqstat.h \
+ src/os_timer.h src/os_work.h src/os_mbox.h
 src/os_bitobj.o: src/os_bitobj.c src/os_private.h ../../lib/lpc17xx/types.h \
  src/os_config.h src/../../../board/sk-mlpc1788/src/os_config.h \
- src/os_flags.h src/port/ARMv7-M/port.h src/os_bitobj.h src/os_sched.h
+ src/os_flags.h src/port/ARMv7-M/port.h src/os_bitobj.h src/os_sched.h \
+ src/os_trace.h
 src/os_mem.o: src/os_mem.c src/os_private.h ../../lib/lpc17xx/types.h \
  src/os_config.h src/../../../board/sk-mlpc1788/src/os_config.h \
  src/os_flags.h src/port/ARMv7-M/port.h
@@ -20,15 +32,56 @@ src/os_mem2.o: src/os_mem2.c src/os_private.h ../../lib/lpc17xx/types.h \
  src/os_flags.h src/port/ARMv7-M/port.h src/os_mem.h src/os_bitobj.h
 src/os_mem3.o: src/os_mem3.c src/os_private.h ../../lib/lpc17xx/types.h \
  src/os_config.h src/../../../board/sk-mlpc1788/src/os_config.h \
- src/os_flags.h src/port/ARMv7-M/port.h src/os_mem.h
+ src/os_flags.h src/port/ARMv7-M/port.h src/os_mem.h \
+ src/os_bitobj.h
 src/os_queue.o: src/os_queue.c src/os_private.h ../../lib/lpc17xx/types.h \
  src/os_config.h src/../../../board/sk-mlpc1788/src/os_config.h \
  src/os_flags.h src/port/ARMv7-M/port.h src/os_queue.h src/os_bitobj.h \
- src/os_sched.h src/os_mem.h
+ src/os_sched.h src/os_mem.h \
+ src/os_trace.h
 src/os_multi.o: src/os_multi.c src/os_private.h ../../lib/lpc17xx/types.h \
  src/os_config.h src/../../../board/sk-mlpc1788/src/os_config.h \
  src/os_flags.h src/port/ARMv7-M/port.h src/os_multi.h src/os_bitobj.h \
  src/os_queue.h src/os_sched.h src/os_mem.h
+src/os_pool.o: src/os_pool.c src/os_private.h ../../lib/lpc17xx/types.h \
+ src/os_config.h src/../../../board/sk-mlpc1788/src/os_config.h \
+ src/os_flags.h src/port/ARMv7-M/port.h src/os_pool.h
+src/os_rmutex.o: src/os_rmutex.c src/os_private.h ../../lib/lpc17xx/types.h \
+ src/os_config.h src/../../../board/sk-mlpc1788/src/os_config.h \
+ src/os_flags.h src/port/ARMv7-M/port.h src/os_rmutex.h src/os_sched.h \
+ src/os_trace.h
+src/os_pt.o: src/os_pt.c src/os.h src/os_config.h \
+ src/../../../board/sk-mlpc1788/src/os_config.h src/os_flags.h \
+ src/os_bitobj.h src/os_rmutex.h src/os_queue.h src/os_mem.h \
+ src/os_multi.h src/os_pool.h src/os_pt.h src/os_private.h \
+ ../../lib/lpc17xx/types.h src/port/ARMv7-M/port.h src/os_sched.h
+src/os_trace.o: src/os_trace.c src/os_private.h ../../lib/lpc17xx/types.h \
+ src/os_config.h src/../../../board/sk-mlpc1788/src/os_config.h \
+ src/os_flags.h src/port/ARMv7-M/port.h src/os_trace.h
+src/os_cpustat.o: src/os_cpustat.c src/os_private.h ../../lib/lpc17xx/types.h \
+ src/os_config.h src/../../../board/sk-mlpc1788/src/os_config.h \
+ src/os_flags.h src/port/ARMv7-M/port.h src/os_trace.h src/os_cpustat.h \
+ src/os_irqstat.h \
+ src/os_timer.h src/os_work.h src/os_mbox.h
+src/os_irqstat.o: src/os_irqstat.c src/os_private.h ../../lib/lpc17xx/types.h \
+ src/os_config.h src/../../../board/sk-mlpc1788/src/os_config.h \
+ src/os_flags.h src/port/ARMv7-M/port.h src/os_trace.h src/os_cpustat.h \
+ src/os_irqstat.h \
+ src/os_timer.h src/os_work.h src/os_mbox.h
+src/os_timer.o: src/os_timer.c src/os_private.h ../../lib/lpc17xx/types.h \
+ src/os_config.h src/../../../board/sk-mlpc1788/src/os_config.h \
+ src/os_flags.h src/port/ARMv7-M/port.h src/os_trace.h src/os_cpustat.h \
+ src/os_irqstat.h src/os_timer.h src/os_work.h src/os_mbox.h src/os_sched.h src/os_bitobj.h
+src/os_work.o: src/os_work.c src/os.h src/os_config.h \
+ src/../../../board/sk-mlpc1788/src/os_config.h src/os_flags.h \
+ src/port/ARMv7-M/port.h ../../lib/lpc17xx/types.h src/os_trace.h \
+ src/os_cpustat.h src/os_irqstat.h src/os_timer.h src/os_work.h src/os_mbox.h \
+ src/os_private.h
+src/os_mbox.o: src/os_mbox.c src/os_private.h ../../lib/lpc17xx/types.h \
+ src/os_config.h src/../../../board/sk-mlpc1788/src/os_config.h \
+ src/os_flags.h src/port/ARMv7-M/port.h src/os_trace.h src/os_cpustat.h \
+ src/os_irqstat.h src/os_sched.h src/os_mem.h src/os_bitobj.h \
+ src/os_mbox.h
 src/port/ARMv7-M/port.o: src/port/ARMv7-M/port.c ../../lib/lpc17xx/cm3.h \
  ../../lib/lpc17xx/LPC177x_8x.h ../../lib/lpc17xx/core_cm3.h \
  ../../lib/lpc17xx/clk_cfg.h ../../lib/misc/src/debug.h \
@@ -36,8 +36,11 @@
 
 BASE_TYPE os_taskidx;                           /* number of current initialized tasks */
 struct os_trap_info_t os_trapinfo;              /* trap inforamtion */
-struct os_taskcb_t os_tasks[OS_CONFIG_TASK_COUNT + 1]; /* control block of task, NOTE os_task[0] is control block of idle task */
-volatile struct os_taskcb_t *os_current_taskcb; /* pointer to current task's control block */
+struct os_taskcb_t os_tasks[OS_CONFIG_TASK_COUNT + 1] OS_FASTBSS; /* control block of task, NOTE os_task[0] is control block of idle task */
+volatile struct os_taskcb_t *os_current_taskcb OS_FASTBSS; /* pointer to current task's control block */
+#if OS_USE_TIMEOUT && !(defined OS_CONFIG_TICKLESS)
+BASE_TYPE os_ticks;                             /* number of ticks since start */
+#endif
 
 #define IDLE_STACK       idle_stack
 #define IDLE_STACK_SIZE  (OS_STACK_MINSIZE + 16 /* XXX */)
@@ -52,6 +55,18 @@ void os_init()
 {
     OS_DISABLE_IRQ(); /* NOTE disable interrupts during initialization */
     port_init();
+#ifdef OS_CONFIG_USE_POOL
+    os_pool_init();
+#endif
+#ifdef OS_CONFIG_USE_TRACEBUF
+    os_trace_init();
+#endif
+#ifdef OS_CONFIG_USE_CPUSTAT
+    os_cpustat_init();
+#endif
+#ifdef OS_CONFIG_USE_IRQSTAT
+    os_irqstat_init();
+#endif
 
 #ifdef OS_CONFIG_TASK_NAME_SIZE
     OS_TASK_INIT("IDLE", IDLE_STACK, IDLE_STACK_SIZE, 0, IDLE_PROCESS, NULL);
@@ -141,6 +156,9 @@ struct os_taskcb_t* os_task_init(char *name, uint8 *stack, BASE_TYPE ssize, void
 
 #ifdef OS_CONFIG_USE_PRIORITY
     task->priority = priority;
+    #ifdef OS_CONFIG_USE_RMUTEX
+    task->bpriority = priority;
+    #endif
 #endif
 #if OS_USE_LOCK
     /* if task is not idle task (first) then add it to scheduler queue */
@@ -173,6 +191,8 @@ struct os_taskcb_t* os_task_init(char *name, uint8 *stack, BASE_TYPE ssize, void
 #if PORT_ARMV7M
         ct->pc   = (BASE_TYPE)process | 0x01;
         ct->lr   = ct->pc;
+#elif PORT_POSIX
+        port_task_init(task, process);
 #endif
     }
 
@@ -224,36 +244,23 @@ void *os_task_get_context()
  *
  * NOTE os_tick should be performed on timer with maximum priority
  */
-void os_tick()
+OS_RAMFUNC void os_tick()
 {
     BASE_TYPE suspend;
+#ifdef OS_CONFIG_USE_TASK_SLICE
     BASE_TYPE *timeout;
+#endif
 
 #ifdef OS_CONFIG_USE_TRACE
     os_current_taskcb->ticks++;     /* time of task in running state (system ticks) */
 #endif
 
     suspend = 0;
-#ifdef OS_USE_TIMEOUT
-    {
-        struct os_taskcb_t *ptask;
-
-        ptask = &os_tasks[1];
-        while (ptask < &os_tasks[os_taskidx])
-        {
-            timeout = &ptask->timeout;
-            if ((*timeout > 0) && (*timeout < OS_TIMEOUT_EXPIRED))
-            {
-                (*timeout)--;
-                if ((*timeout) == 0)
-                {
-                    *timeout = OS_TIMEOUT_EXPIRED;
-                    suspend = 1;
-                }
-            }
-            ptask++;
-        }
-    }
+#if OS_USE_TIMEOUT && !(defined OS_CONFIG_TICKLESS)
+    OS_DISABLE_IRQ();
+    os_ticks++;
+    suspend = os_sched_timeout();
+    OS_ENABLE_IRQ();
 #endif
 
 #ifdef OS_CONFIG_USE_TASK_SLICE
@@ -280,10 +287,16 @@ void os_tick()
     }
 #endif
 
+#if (defined OS_CONFIG_USE_TIMER) && !(defined OS_CONFIG_TICKLESS)
+    os_timer_expire();
+#endif
+
     if (suspend)
     {
 #if OS_USE_LOCK
+        OS_DISABLE_IRQ();
         os_sched_suspend_task();
+        OS_ENABLE_IRQ();
 #else
         os_task_switch();
 #endif
@@ -306,6 +319,26 @@ inline void os_respawn_tslice(volatile struct os_taskcb_t *task)
 
 #endif /* OS_CONFIG_TICK_PERIOD */
 
+#ifdef OS_CONFIG_TICKLESS
+/*
+ * expire timeouts, should be called from interrupt of application's clock
+ * alarm (look at osw_clock_alarm())
+ */
+OS_RAMFUNC void os_alarm()
+{
+#ifdef OS_CONFIG_USE_TIMER
+    /* NOTE before timeouts of tasks, alarm is set to next expiration there */
+    os_timer_expire();
+#endif
+    OS_DISABLE_IRQ();
+    {
+        if (os_sched_timeout())
+            os_sched_suspend_task();
+    }
+    OS_ENABLE_IRQ();
+}
+#endif
+
 /*
  * uncoditionally give control to other task
  */
@@ -360,7 +393,7 @@ STATIC void os_idle_process()
     while (1)
     {
 #if OS_USE_LOCK
-        asm volatile ("wfi\r\n");
+        PORT_IDLE();
 #else
         os_task_switch();
 #endif
@@ -372,7 +405,12 @@ STATIC void os_idle_process()
  */
 inline void os_disable_irq()
 {
+#ifdef OS_CONFIG_USE_IRQSTAT
+    PORT_DISABLE_IRQ();
+    OS_IRQSTAT_BEGIN(os_irqstat_caller(__builtin_return_address(0)));
+#else
     OS_DISABLE_IRQ();
+#endif
 }
 
 /*
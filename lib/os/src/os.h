@@ -47,8 +47,18 @@ void os_start();
 //#define OS_MS2TICK(ms) ((ms) * 1000 / OS_CONFIG_TICK_PERIOD)
 //#define OS_US2TICK(us) ((us) / OS_CONFIG_TICK_PERIOD)
 
-#define OS_MS2TICK(ms) ((((ms) * 1000) > OS_CONFIG_TICK_PERIOD) ? ((ms) * 1000 / OS_CONFIG_TICK_PERIOD) : (ms > 0 ? 1 : 0))
-#define OS_US2TICK(us) ( ((us) > OS_CONFIG_TICK_PERIOD)         ? ((us)        / OS_CONFIG_TICK_PERIOD) : (us > 0 ? 1 : 0))
+/* convert time to number of OS_CONFIG_TICK_PERIOD periods */
+#define OS_MS2PERIOD(ms) ((((ms) * 1000) > OS_CONFIG_TICK_PERIOD) ? ((ms) * 1000 / OS_CONFIG_TICK_PERIOD) : (ms > 0 ? 1 : 0))
+#define OS_US2PERIOD(us) ( ((us) > OS_CONFIG_TICK_PERIOD)         ? ((us)        / OS_CONFIG_TICK_PERIOD) : (us > 0 ? 1 : 0))
+
+#ifdef OS_CONFIG_TICKLESS
+    /* timeouts are specified in microseconds */
+    #define OS_MS2TICK(ms) ((ms) * 1000)
+    #define OS_US2TICK(us) (us)
+#else
+    #define OS_MS2TICK(ms) OS_MS2PERIOD(ms)
+    #define OS_US2TICK(us) OS_US2PERIOD(us)
+#endif
 
 
 #ifdef OS_CONFIG_USE_WAIT
@@ -60,14 +70,23 @@ void os_start();
 
 void os_yield();
 
+#ifdef OS_CONFIG_USE_DEADLINE
+    void os_deadline_set(BASE_TYPE period, BASE_TYPE budget);
+    void os_deadline_end();
+#endif
+
 #if (defined OS_CONFIG_USE_MUTEX) || (defined OS_CONFIG_USE_EVENT)
     #include "os_bitobj.h"
 #endif
 
+#ifdef OS_CONFIG_USE_RMUTEX
+    #include "os_rmutex.h"
+#endif
+
 #if (defined OS_CONFIG_USE_TASK_SLICE) && (defined OS_CONFIG_USE_VARIABLE_TASK_SLICE)
     void os_set_slice(BASE_TYPE ticks);
-    #define os_set_slice_ms(ms) os_set_slice(OS_MS2TICK(ms))
-    #define os_set_slice_us(ms) os_set_slice(OS_US2TICK(us))
+    #define os_set_slice_ms(ms) os_set_slice(OS_MS2PERIOD(ms))
+    #define os_set_slice_us(us) os_set_slice(OS_US2PERIOD(us))
 #endif
 
 #ifdef OS_CONFIG_USE_QUEUE
@@ -82,6 +101,60 @@ void os_yield();
     #include "os_multi.h"
 #endif
 
+#ifdef OS_CONFIG_USE_POOL
+    #include "os_pool.h"
+#endif
+
+#ifdef OS_CONFIG_USE_PT
+    #include "os_pt.h"
+#endif
+
+#ifdef OS_CONFIG_USE_TIMER
+    #include "os_timer.h"
+#endif
+
+#ifdef OS_CONFIG_USE_WORK
+    #include "os_work.h"
+#endif
+
+#ifdef OS_CONFIG_USE_MBOX
+    #include "os_mbox.h"
+#endif
+
+#ifdef OS_CONFIG_USE_TRACEBUF
+    #include "os_trace.h"
+#else
+    #define os_trace_mark(id, value)
+    #define os_trace_irq_enter(n)
+    #define os_trace_irq_exit(n)
+#endif
+
+#ifdef OS_CONFIG_USE_CPUSTAT
+    #include "os_cpustat.h"
+#else
+    #define os_cpustat_irq_enter()
+    #define os_cpustat_irq_exit()
+#endif
+
+#ifdef OS_CONFIG_USE_IRQSTAT
+    #include "os_irqstat.h"
+#else
+    #define os_irqstat_irq_enter(n)
+    #define os_irqstat_irq_exit(n)
+#endif
+
+/* should be called at entry and exit of interrupt handler, n - number of interrupt */
+#define os_irq_enter(n) {         \
+    os_cpustat_irq_enter();       \
+    os_irqstat_irq_enter(n);      \
+    os_trace_irq_enter(n);        \
+}
+#define os_irq_exit(n) {          \
+    os_trace_irq_exit(n);         \
+    os_irqstat_irq_exit(n);       \
+    os_cpustat_irq_exit();        \
+}
+
 #ifdef OS_CONFIG_USE_TRACE
     #include "os_private.h"
 #endif
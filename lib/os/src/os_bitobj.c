@@ -25,15 +25,148 @@
  * (INCLUDING NEGLIGENCE OR OTHERWISE) ARISING IN ANY WAY OUT OF THE USE OF THIS
  * SOFTWARE, EVEN IF ADVISED OF THE POSSIBILITY OF SUCH DAMAGE.
  * 
+ *
+ * Bits of objects are changed with exclusive load/store (if port supports
+ * it), so interrupts are not disabled by raise of event, lock and unlock
+ * of mutex. Interrupts are disabled only if there are tasks waiting for
+ * object, for time of os_sched_wake() (proportional to number of tasks
+ * waiting for objects with the same hash) and os_sched_suspend_task().
  */
 #include "os_private.h"
 #include "os_bitobj.h"
 #include "os_sched.h"
 #include "os_flags.h"
 
+#ifdef PORT_LDREX
+/*
+ * set bits, exclusive load/store
+ */
+static inline void os_bitobj_set(BASE_TYPE *p, BASE_TYPE mask)
+{
+    BASE_TYPE v;
+
+    do {
+        v = PORT_LDREX(p);
+    } while (PORT_STREX(p, v | mask));
+}
+
+/*
+ * clear bits, exclusive load/store
+ */
+static inline void os_bitobj_clear(BASE_TYPE *p, BASE_TYPE mask)
+{
+    BASE_TYPE v;
+
+    do {
+        v = PORT_LDREX(p);
+    } while (PORT_STREX(p, v & ~mask));
+}
+
+/*
+ * set bits if all of them are clear
+ *
+ * RETURN
+ *     one if bits was set, zero otherwise
+ */
+static inline BASE_TYPE os_bitobj_try_set(BASE_TYPE *p, BASE_TYPE mask)
+{
+    BASE_TYPE v;
+
+    do {
+        v = PORT_LDREX(p);
+        if (v & mask)
+        {
+            PORT_CLREX();
+            return 0;
+        }
+    } while (PORT_STREX(p, v | mask));
+    return 1;
+}
+
+/*
+ * clear bits if any of them is set
+ *
+ * RETURN
+ *     one if bits was cleared, zero otherwise
+ */
+static inline BASE_TYPE os_bitobj_try_clear(BASE_TYPE *p, BASE_TYPE mask)
+{
+    BASE_TYPE v;
+
+    do {
+        v = PORT_LDREX(p);
+        if (!(v & mask))
+        {
+            PORT_CLREX();
+            return 0;
+        }
+    } while (PORT_STREX(p, v & ~mask));
+    return 1;
+}
+#else
+/*
+ * Port has no exclusive load/store, disable interrupts.
+ */
+static inline void os_bitobj_set(BASE_TYPE *p, BASE_TYPE mask)
+{
+    OS_DISABLE_IRQ();
+    *p |= mask;
+    OS_ENABLE_IRQ();
+}
+
+static inline void os_bitobj_clear(BASE_TYPE *p, BASE_TYPE mask)
+{
+    OS_DISABLE_IRQ();
+    *p &= ~mask;
+    OS_ENABLE_IRQ();
+}
+
+static inline BASE_TYPE os_bitobj_try_set(BASE_TYPE *p, BASE_TYPE mask)
+{
+    BASE_TYPE ret;
+
+    OS_DISABLE_IRQ();
+    ret = !(*p & mask);
+    if (ret)
+        *p |= mask;
+    OS_ENABLE_IRQ();
+    return ret;
+}
+
+static inline BASE_TYPE os_bitobj_try_clear(BASE_TYPE *p, BASE_TYPE mask)
+{
+    BASE_TYPE ret;
 
-#define OS_BITMASK_SET(bitset, mask)   bitset |= mask
-#define OS_BITMASK_CLEAR(bitset, mask) bitset &= ~(mask)
+    OS_DISABLE_IRQ();
+    ret = (*p & mask) != 0;
+    if (ret)
+        *p &= ~mask;
+    OS_ENABLE_IRQ();
+    return ret;
+}
+#endif
+
+/*
+ * wake tasks waiting for object after it's bits was changed
+ *
+ * ARGS
+ *     pobj       pointer to bitobject
+ *     suspend    suspend current task to give control to waked tasks
+ */
+OS_RAMFUNC STATIC void os_bitobj_wake(BASE_TYPE *pobj, BASE_TYPE suspend)
+{
+    PORT_DATA_BARIER();
+    if (!os_sched_waiting(pobj))
+        return;
+
+    OS_DISABLE_IRQ();
+    {
+        os_sched_wake(pobj);
+        if (suspend)
+            os_sched_suspend_task();
+    }
+    OS_ENABLE_IRQ();
+}
 
 #ifdef OS_CONFIG_USE_MUTEX
 /*
@@ -66,50 +199,37 @@ BASE_TYPE os_mutex_lock(BASE_TYPE *pm, BASE_TYPE mask, BASE_TYPE flags, BASE_TYP
 
 BASE_TYPE os_mutex_lock_tm(BASE_TYPE *pm, BASE_TYPE mask, BASE_TYPE flags, BASE_TYPE *timeout)
 {
-    BASE_TYPE ret;
-
-    ret = OS_ERR_NONE;
-
-    OS_DISABLE_IRQ();
+    if (os_bitobj_try_set(pm, mask))
     {
         PORT_DATA_BARIER();
-        if ((*pm & mask) == 0)
-        {
-            OS_BITMASK_SET(*pm, mask); /* lock mutex */
-            PORT_DATA_BARIER();
-            ret = OS_ERR_NONE;
-            goto out;
-        }
-        if (flags & OS_FLAG_NOWAIT)
-        {
-            ret = OS_ERR_WOULDLOCK;
-            goto out;
-        }
+        OS_TRACE(OS_TRACE_MUTEX_LOCK, mask, pm);
+        return OS_ERR_NONE;
     }
-    OS_ENABLE_IRQ();
+    if (flags & OS_FLAG_NOWAIT)
+        return OS_ERR_WOULDLOCK;
 
     while (1)
     {
         *timeout = os_lock_task(OS_TASK_STATE_LOCKED_MUTEX, pm, mask, *timeout);
         if (*timeout == OS_TIMEOUT_EXPIRED)
         {
-            return OS_ERR_TIMEOUT;
-        } else {
+            /* 
+             * Task could be waked by unlock of mutex before timeout expired,
+             * pass unlocked mutex to other waiting task.
+             */
             OS_DISABLE_IRQ();
-            PORT_DATA_BARIER();
             if ((*pm & mask) == 0)
-            {
-                OS_BITMASK_SET(*pm, mask); /* lock mutex */
-                PORT_DATA_BARIER();
-                ret = OS_ERR_NONE;
-                goto out;
-            }
+                os_sched_wake(pm);
             OS_ENABLE_IRQ();
+            return OS_ERR_TIMEOUT;
+        }
+        if (os_bitobj_try_set(pm, mask))
+        {
+            PORT_DATA_BARIER();
+            OS_TRACE(OS_TRACE_MUTEX_LOCK, mask, pm);
+            return OS_ERR_NONE;
         }
     }
-out:
-    OS_ENABLE_IRQ();
-    return ret;
 }
 
 /*
@@ -120,14 +240,11 @@ out:
  */
 void os_mutex_unlock(BASE_TYPE *pm, BASE_TYPE mask)
 {
-    OS_DISABLE_IRQ();
-    {
-        OS_BITMASK_CLEAR(*pm, mask); /* unlock mutex */
-        PORT_DATA_BARIER();
-        /* suspend task to give other tasks capability to lock mutex */
-        os_sched_suspend_task();
-    }
-    OS_ENABLE_IRQ();
+    PORT_DATA_BARIER();
+    OS_TRACE(OS_TRACE_MUTEX_UNLOCK, mask, pm);
+    os_bitobj_clear(pm, mask); /* unlock mutex */
+    /* suspend task to give other tasks capability to lock mutex */
+    os_bitobj_wake(pm, 1);
 }
 
 /*
@@ -135,10 +252,10 @@ void os_mutex_unlock(BASE_TYPE *pm, BASE_TYPE mask)
  */
 void os_mutex_unlock_ns(BASE_TYPE *pm, BASE_TYPE mask)
 {
-    OS_DISABLE_IRQ();
-    OS_BITMASK_CLEAR(*pm, mask); /* unlock mutex */
     PORT_DATA_BARIER();
-    OS_ENABLE_IRQ();
+    OS_TRACE(OS_TRACE_MUTEX_UNLOCK, mask, pm);
+    os_bitobj_clear(pm, mask); /* unlock mutex */
+    os_bitobj_wake(pm, 0);
 }
 #endif /* OS_CONFIG_USE_MUTEX */
 
@@ -153,16 +270,12 @@ void os_mutex_unlock_ns(BASE_TYPE *pm, BASE_TYPE mask)
  *     pe          pointer to memory contained bits for events
  *     mask        mask of events to raise
  */
-void os_event_raise(BASE_TYPE *pe, BASE_TYPE mask)
+OS_RAMFUNC void os_event_raise(BASE_TYPE *pe, BASE_TYPE mask)
 {
-    OS_DISABLE_IRQ();
-    {
-        OS_BITMASK_SET(*pe, mask); /* raise event */
-        PORT_DATA_BARIER();
-        /* suspend task to give other tasks capability to handle event */
-        os_sched_suspend_task();
-    }
-    OS_ENABLE_IRQ();
+    OS_TRACE(OS_TRACE_EVENT_RAISE, mask, pe);
+    os_bitobj_set(pe, mask); /* raise event */
+    /* suspend task to give other tasks capability to handle event */
+    os_bitobj_wake(pe, 1);
 }
 
 /*
@@ -172,14 +285,11 @@ void os_event_raise(BASE_TYPE *pe, BASE_TYPE mask)
  *     pe          pointer to memory contained bits for events
  *     mask        mask of events to raise
  */
-void os_event_raise_ns(BASE_TYPE *pe, BASE_TYPE mask)
+OS_RAMFUNC void os_event_raise_ns(BASE_TYPE *pe, BASE_TYPE mask)
 {
-    OS_DISABLE_IRQ();
-    {
-        OS_BITMASK_SET(*pe, mask); /* raise event */
-        PORT_DATA_BARIER();
-    }
-    OS_ENABLE_IRQ();
+    OS_TRACE(OS_TRACE_EVENT_RAISE, mask, pe);
+    os_bitobj_set(pe, mask); /* raise event */
+    os_bitobj_wake(pe, 0);
 }
 
 /*
@@ -187,11 +297,7 @@ void os_event_raise_ns(BASE_TYPE *pe, BASE_TYPE mask)
  */
 void os_event_clear(BASE_TYPE *pe, BASE_TYPE mask)
 {
-    OS_DISABLE_IRQ();
-    {
-        OS_BITMASK_CLEAR(*pe, mask); /* clear event */
-    }
-    OS_ENABLE_IRQ();
+    os_bitobj_clear(pe, mask); /* clear event */
 }
 
 /*
@@ -225,51 +331,34 @@ BASE_TYPE os_event_wait(BASE_TYPE *pe, BASE_TYPE mask, BASE_TYPE flags, BASE_TYP
     return os_event_wait_tm(pe, mask, flags, &timeout);
 }
 
-BASE_TYPE os_event_wait_tm(BASE_TYPE *pe, BASE_TYPE mask, BASE_TYPE flags, BASE_TYPE *timeout)
+/*
+ * catch event
+ *
+ * RETURN
+ *     one if event present, zero otherwise
+ */
+static inline BASE_TYPE os_event_catch(BASE_TYPE *pe, BASE_TYPE mask, BASE_TYPE flags)
 {
-    BASE_TYPE ret;
-
-    ret = OS_ERR_NONE;
-
-    OS_DISABLE_IRQ();
-    {
-        if (*pe & mask)
-        {
-            ret = OS_ERR_NONE;
-            if (flags & OS_FLAG_CLEAR)
-                OS_BITMASK_CLEAR(*pe, mask);
-            goto out;
-        }
+    if (flags & OS_FLAG_CLEAR)
+        return os_bitobj_try_clear(pe, mask);
+    return (*(volatile BASE_TYPE*)pe & mask) != 0;
+}
 
-        if (flags & OS_FLAG_NOWAIT)
-        {
-            ret = OS_ERR_WOULDLOCK;
-            goto out;
-        }
-    }
-    OS_ENABLE_IRQ();
+BASE_TYPE os_event_wait_tm(BASE_TYPE *pe, BASE_TYPE mask, BASE_TYPE flags, BASE_TYPE *timeout)
+{
+    if (os_event_catch(pe, mask, flags))
+        return OS_ERR_NONE;
+    if (flags & OS_FLAG_NOWAIT)
+        return OS_ERR_WOULDLOCK;
 
     while (1)
     {
         *timeout = os_lock_task(OS_TASK_STATE_LOCKED_EVENT, pe, mask, *timeout);
         if (*timeout == OS_TIMEOUT_EXPIRED)
-        {
             return OS_ERR_TIMEOUT;
-        } else {
-            OS_DISABLE_IRQ();
-            if (*pe & mask)
-            {
-                ret = OS_ERR_NONE;
-                if (flags & OS_FLAG_CLEAR)
-                    OS_BITMASK_CLEAR(*pe, mask);
-                goto out;
-            }
-            OS_ENABLE_IRQ();
-        }
+        if (os_event_catch(pe, mask, flags))
+            return OS_ERR_NONE;
     }
-out:
-    OS_ENABLE_IRQ();
-    return ret;
 }
 #endif /* OS_CONFIG_USE_EVENT */
 
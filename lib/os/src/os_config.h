@@ -39,30 +39,56 @@
 
     #define OS_CONFIG_TASK_COUNT              2      /* number of tasks possible on system */
     #define OS_CONFIG_TICK_PERIOD             10000  /* period of OS timer, us */
+    #define OS_CONFIG_TICKLESS                       /* timeouts in microseconds, alarm at nearest deadline instead of periodic tick */
     #define OS_CONFIG_USE_TASK_SLICE                 /* perform preemption when time slice of task expired */
     #define OS_CONFIG_DEFAULT_TASK_SLICE      2      /* time that task will be run before it gives control to other tasks, ticks */
     #define OS_CONFIG_USE_VARIABLE_TASK_SLICE        /* enable set of time slice of current task dynamicly */
 
     #define OS_CONFIG_USE_PRIORITY                   /* use priorities for tasks */
+    #define OS_CONFIG_USE_DEADLINE                   /* deadline class, tasks with deadline are scheduled before others (EDF) */
 
     #define OS_CONFIG_USE_WAIT                       /* enable os_wait() functionality*/
     #define OS_CONFIG_USE_MUTEX                      /* enable os_mutex_lock(), os_mutex_unlock() functionality */
+    #define OS_CONFIG_USE_RMUTEX                     /* enable recursive mutexes with priority inheritance (os_rmutex_lock(), os_rmutex_unlock()) */
     #define OS_CONFIG_USE_EVENT                      /* enable os_event_raise(), os_event_wait() functionality */
     #define OS_CONFIG_USE_MULTI                      /* enable multiple events funcitons */
+    #define OS_CONFIG_USE_PT                         /* enable protothreads hosted by task (os_pt_host_run()) */
 
     #define OS_CONFIG_USE_QUEUE                      /* enable os_queue_ functionality */
 
     #define OS_CONFIG_USE_SCHEDLOCK                  /* enable os_sched_lock() and os_sched_unlock() functions */
+    #define OS_CONFIG_USE_SCHEDSTAT                  /* collect cost of scheduler calls in CPU cycles */
+    #define OS_CONFIG_USE_TRACEBUF                   /* record scheduler and object events to ring buffer (os_trace_start()) */
+    #define OS_CONFIG_TRACEBUF_SIZE           4096   /* number of events in trace buffer, power of two */
+    #define OS_CONFIG_USE_CPUSTAT                    /* measure CPU load of tasks and interrupts in cycles (os_cpustat) */
+    #define OS_CONFIG_USE_IRQSTAT                    /* histograms of length of interrupt handlers and of sections with masked interrupts (os_irqstat) */
+    #define OS_CONFIG_IRQSTAT_IRQS            41     /* number of interrupts (os_irq_enter()) */
+    #define OS_CONFIG_IRQSTAT_CALLERS         16     /* number of callers of os_disable_irq() */
+    #define OS_CONFIG_USE_TIMER                      /* software timers expired by os_tick() or os_alarm() (os_timer_start()) */
+    #define OS_CONFIG_USE_WORK                       /* work posted from interrupts and run by worker tasks (os_work_post()) */
+    #define OS_CONFIG_WORK_PRIOS              2      /* number of priorities of work */
+    #define OS_CONFIG_USE_MBOX                       /* conflating mailboxes and direct-handoff channels (os_mbox_post(), os_chan_send()) */
+    #define OS_CONFIG_USE_RAMFUNC                    /* place hot code and data to on-chip SRAM (OS_RAMFUNC, OS_FASTDATA, OS_FASTBSS) */
 
     #define OS_CONFIG_USE_DYNMEM                     /* enable dynamic memory functions */
     #define OS_CONFIG_DYNMEM_SIZE  (16 * 1024 * 1024)/* size of dynamic memory */
     #define OS_CONFIG_DYNMEM_2                       /* second implementation of dynamic memory */
+//  #define OS_CONFIG_DYNMEM_3                       /* third implementation of dynamic memory (TLSF) */
+//  #define OS_CONFIG_DYNMEM_TAG                     /* save address of os_malloc() caller in block (DYNMEM_3) */
+
+    #define OS_CONFIG_USE_POOL                       /* enable pools of fixed-size blocks (os_pool_alloc(), os_pool_free()) */
+    /* table of pools, OS_POOL(name, size of block, number of blocks), pool identifier is OS_POOL_name */
+    #define OS_CONFIG_POOL_TABLE                     \
+        OS_POOL(MSG,    32,   16)                    \
+        OS_POOL(FRAME,  1536, 4)
 
     #define OS_CONFIG_TRAP_SCHEDQ                    /* trap on scheduler queue errors */
     #define OS_CONFIG_TRAP_BITOBJ                    /* trap on bitobjects errors (mutexes, events) */
     #define OS_CONFIG_TRAP_DYNMEM                    /* trap on dynamic memory errors */
     #define OS_CONFIG_TRAP_QUEUE                     /* trap on queue errors */
     #define OS_CONFIG_TRAP_MULTI                     /* trap on multiple events errors */
+    #define OS_CONFIG_TRAP_POOL                      /* trap on free of pointer not belonging to pool */
+    #define OS_CONFIG_TRAP_RMUTEX                    /* trap on unlock of recursive mutex by task that does not own it */
 
 #endif
 
@@ -88,6 +114,27 @@
     #error "OS_CONFIG_USE_MULTI depends on OS_CONFIG_USE_DYNMEM"
 #endif
 
+#if (defined OS_CONFIG_USE_TRACEBUF) && (!(defined OS_CONFIG_TRACEBUF_SIZE) || \
+        (OS_CONFIG_TRACEBUF_SIZE & (OS_CONFIG_TRACEBUF_SIZE - 1)))
+    #error "OS_CONFIG_USE_TRACEBUF requires OS_CONFIG_TRACEBUF_SIZE, power of two"
+#endif
+
+#if (defined OS_CONFIG_USE_WORK) && (!(defined OS_CONFIG_USE_EVENT) || !(defined OS_CONFIG_WORK_PRIOS))
+    #error "OS_CONFIG_USE_WORK requires OS_CONFIG_USE_EVENT and OS_CONFIG_WORK_PRIOS"
+#endif
+
+#if (defined OS_CONFIG_USE_MBOX) && (!(defined OS_CONFIG_USE_EVENT) || !(defined OS_CONFIG_USE_DYNMEM))
+    #error "OS_CONFIG_USE_MBOX depends on OS_CONFIG_USE_EVENT and OS_CONFIG_USE_DYNMEM"
+#endif
+
+#if (defined OS_CONFIG_USE_IRQSTAT) && (!(defined OS_CONFIG_IRQSTAT_IRQS) || !(defined OS_CONFIG_IRQSTAT_CALLERS))
+    #error "OS_CONFIG_USE_IRQSTAT requires OS_CONFIG_IRQSTAT_IRQS and OS_CONFIG_IRQSTAT_CALLERS"
+#endif
+
+#if (defined OS_CONFIG_USE_PT) && (!(defined OS_CONFIG_USE_MULTI) || !(defined OS_CONFIG_USE_EVENT))
+    #error "OS_CONFIG_USE_PT depends on OS_CONFIG_USE_MULTI and OS_CONFIG_USE_EVENT"
+#endif
+
 #if (defined OS_CONFIG_USE_DYNMEM) && !( \
      (defined OS_CONFIG_DYNMEM_1) ||    \
      (defined OS_CONFIG_DYNMEM_2) ||    \
@@ -112,5 +159,32 @@
     #error "OS_CONFIG_DYNMEM_2 depends on OS_CONFIG_USE_MUTEX"
 #endif
 
+#if (defined OS_CONFIG_USE_POOL) && !(defined OS_CONFIG_POOL_TABLE)
+    #error "OS_CONFIG_USE_POOL defined, OS_CONFIG_POOL_TABLE should be defined also"
+#endif
+
+#if (defined OS_CONFIG_DYNMEM_3) && !(defined OS_CONFIG_USE_MUTEX)
+    #error "OS_CONFIG_DYNMEM_3 depends on OS_CONFIG_USE_MUTEX"
+#endif
+
+#if (defined OS_CONFIG_USE_DEADLINE) && !(defined OS_CONFIG_TICKLESS)
+    #error "OS_CONFIG_USE_DEADLINE depends on OS_CONFIG_TICKLESS"
+#endif
+
+/*
+ * Placement of code and data on hot paths (scheduler, interrupt handlers).
+ * Linker script of board places sections below to on-chip SRAM, startup
+ * code copies ".ramfunc" and ".fastdata" there and zeroes ".fastbss".
+ */
+#ifdef OS_CONFIG_USE_RAMFUNC
+    #define OS_RAMFUNC  __attribute__((section(".ramfunc"), noinline))
+    #define OS_FASTDATA __attribute__((section(".fastdata")))
+    #define OS_FASTBSS  __attribute__((section(".fastbss")))
+#else
+    #define OS_RAMFUNC
+    #define OS_FASTDATA
+    #define OS_FASTBSS
+#endif
+
 #endif /* OS_CONFIG_H */
 
@@ -0,0 +1,188 @@
+/*
+ *     Yet another operating system for microcontrollers.
+ *     CPU load of tasks and interrupts.
+ *
+ * Copyright (c) 2013, Dmitry Kobylin
+ * All rights reserved.
+ * 
+ * Redistribution and use in source and binary forms, with or without
+ * modification, are permitted provided that the following conditions are met: 
+ * 
+ * 1. Redistributions of source code must retain the above copyright notice, this
+ *    list of conditions and the following disclaimer. 
+ * 2. Redistributions in binary form must reproduce the above copyright notice,
+ *    this list of conditions and the following disclaimer in the documentation
+ *    and/or other materials provided with the distribution. 
+ * 
+ * THIS SOFTWARE IS PROVIDED BY THE COPYRIGHT HOLDERS AND CONTRIBUTORS "AS IS" AND
+ * ANY EXPRESS OR IMPLIED WARRANTIES, INCLUDING, BUT NOT LIMITED TO, THE IMPLIED
+ * WARRANTIES OF MERCHANTABILITY AND FITNESS FOR A PARTICULAR PURPOSE ARE
+ * DISCLAIMED. IN NO EVENT SHALL THE COPYRIGHT OWNER OR CONTRIBUTORS BE LIABLE FOR
+ * ANY DIRECT, INDIRECT, INCIDENTAL, SPECIAL, EXEMPLARY, OR CONSEQUENTIAL DAMAGES
+ * (INCLUDING, BUT NOT LIMITED TO, PROCUREMENT OF SUBSTITUTE GOODS OR SERVICES;
+ * LOSS OF USE, DATA, OR PROFITS; OR BUSINESS INTERRUPTION) HOWEVER CAUSED AND
+ * ON ANY THEORY OF LIABILITY, WHETHER IN CONTRACT, STRICT LIABILITY, OR TORT
+ * (INCLUDING NEGLIGENCE OR OTHERWISE) ARISING IN ANY WAY OUT OF THE USE OF THIS
+ * SOFTWARE, EVEN IF ADVISED OF THE POSSIBILITY OF SUCH DAMAGE.
+ * 
+ */
+#include "os_private.h"
+#include "os_cpustat.h"
+
+#ifdef OS_CONFIG_USE_CPUSTAT
+
+#if !OS_USE_TIMEOUT
+    #error "OS_CONFIG_USE_CPUSTAT requires OS clock (OS_CONFIG_TICKLESS or timeouts)"
+#endif
+
+/* length of window in units of OS_TIME() */
+#ifdef OS_CONFIG_TICKLESS
+    #define OS_CPUSTAT_PERIOD       1000000
+    #define OS_CPUSTAT_TIME2US(t)   (t)
+#else
+    #define OS_CPUSTAT_PERIOD       (1000000 / OS_CONFIG_TICK_PERIOD)
+    #define OS_CPUSTAT_TIME2US(t)   ((t) * OS_CONFIG_TICK_PERIOD)
+#endif
+
+struct os_cpustat_t os_cpustat;
+STATIC char *os_cpustatnames[OS_CONFIG_TASK_COUNT + 1];
+
+STATIC struct {
+    uint32 last;      /* PORT_CYCCNT at last accounting */
+    uint32 irq;       /* cycles of interrupts since last accounting */
+    uint32 irqstart;  /* PORT_CYCCNT at entry of outer interrupt */
+    BASE_TYPE nest;   /* nesting level of interrupts */
+    BASE_TYPE start;  /* OS time of start of current window */
+    BASE_TYPE widx;   /* index of last complete window in history */
+
+    uint32 cycles[OS_CPUSTAT_COUNT];                      /* cycles in current window */
+    uint32 hist[OS_CPUSTAT_WINDOWS][OS_CPUSTAT_COUNT];    /* cycles in last windows */
+    uint32 hlen[OS_CPUSTAT_WINDOWS];                      /* length of last windows, cycles */
+    uint64 sum[OS_CPUSTAT_COUNT];                         /* sum of history */
+    uint64 sumlen;                                        /* sum of lengths of last windows */
+} os_cpuacc;
+
+STATIC void os_cpustat_window(BASE_TYPE now);
+
+/*
+ *
+ */
+void os_cpustat_init()
+{
+    os_cpustat.ntasks  = 0;
+    os_cpustat.period  = OS_CPUSTAT_TIME2US(OS_CPUSTAT_PERIOD);
+    os_cpustat.windows = 0;
+    os_cpustat.names   = os_cpustatnames;
+    os_cpustat.magic   = OS_CPUSTAT_MAGIC;
+
+    os_cpuacc.last  = PORT_CYCCNT;
+    os_cpuacc.start = OS_TIME();
+}
+
+/*
+ * Should be called at entry of interrupt handler (os_irq_enter()).
+ *
+ * NOTE
+ *     Nested interrupt restores "nest" before return, so increment need not
+ *     be atomic.
+ */
+OS_RAMFUNC void os_cpustat_irq_enter()
+{
+    if (os_cpuacc.nest++ == 0)
+        os_cpuacc.irqstart = PORT_CYCCNT;
+}
+
+/*
+ * Should be called at exit of interrupt handler (os_irq_exit()).
+ */
+OS_RAMFUNC void os_cpustat_irq_exit()
+{
+    if (--os_cpuacc.nest == 0)
+        os_cpuacc.irq += PORT_CYCCNT - os_cpuacc.irqstart;
+}
+
+/*
+ * Charge current task with cycles since last call, close window if it is
+ * expired. Called by scheduler before switch of task.
+ *
+ * NOTE called during interrupts disabled
+ */
+OS_RAMFUNC void os_cpustat_account()
+{
+    uint32 now, cycles;
+    BASE_TYPE time;
+
+    now    = PORT_CYCCNT;
+    cycles = now - os_cpuacc.last;
+    cycles = cycles > os_cpuacc.irq ? cycles - os_cpuacc.irq : 0;
+
+    os_cpuacc.cycles[OS_CPUSTAT_TASK(os_current_taskcb - os_tasks)] += cycles;
+    os_cpuacc.cycles[OS_CPUSTAT_IRQ] += os_cpuacc.irq;
+    os_cpuacc.irq  = 0;
+    os_cpuacc.last = now;
+
+    time = OS_TIME();
+    if (!OS_TIME_BEFORE(time, os_cpuacc.start + OS_CPUSTAT_PERIOD))
+        os_cpustat_window(time);
+}
+
+/*
+ * Move cycles of current window to history and calculate loads.
+ */
+STATIC void os_cpustat_window(BASE_TYPE now)
+{
+    uint64 len;
+    uint32 busy, *hist;
+    BASE_TYPE i, w;
+
+    len = (uint64)OS_CPUSTAT_TIME2US(now - os_cpuacc.start) * PORT_CYCCNT_HZ / 1000000;
+    if (len > 0xffffffff)
+        len = 0xffffffff;
+    os_cpuacc.start = now;
+
+    w = os_cpuacc.widx + 1;
+    if (w == OS_CPUSTAT_WINDOWS)
+        w = 0;
+    os_cpuacc.widx = w;
+    hist    = os_cpuacc.hist[w];
+
+    /* drop oldest window from sums */
+    os_cpuacc.sumlen -= os_cpuacc.hlen[w];
+    for (i = 0; i < OS_CPUSTAT_COUNT; i++)
+        os_cpuacc.sum[i] -= hist[i];
+
+    /* idle time is rest of window */
+    busy = os_cpuacc.cycles[OS_CPUSTAT_IRQ];
+    for (i = OS_CPUSTAT_TASK(1); i < OS_CPUSTAT_COUNT; i++)
+        busy += os_cpuacc.cycles[i];
+    if (busy > len)
+        len = busy;
+    os_cpuacc.cycles[OS_CPUSTAT_TASK(0)] = len - busy;
+    os_cpuacc.cycles[OS_CPUSTAT_TOTAL]   = busy;
+
+    os_cpuacc.hlen[w] = len;
+    os_cpuacc.sumlen += len;
+    for (i = 0; i < OS_CPUSTAT_COUNT; i++)
+    {
+        hist[i]      = os_cpuacc.cycles[i];
+        os_cpuacc.sum[i]   += hist[i];
+        os_cpuacc.cycles[i] = 0;
+
+        os_cpustat.load[i].cycles = hist[i];
+        os_cpustat.load[i].load1  = len ? (uint64)hist[i] * 1000 / len : 0;
+        os_cpustat.load[i].load10 = os_cpuacc.sumlen ? os_cpuacc.sum[i] * 1000 / os_cpuacc.sumlen : 0;
+    }
+
+    for (i = 0; i < os_taskidx; i++)
+    {
+#ifdef OS_CONFIG_TASK_NAME_SIZE
+        os_cpustatnames[i] = os_tasks[i].name;
+#else
+        os_cpustatnames[i] = NULL;
+#endif
+    }
+    os_cpustat.ntasks = os_taskidx;
+    os_cpustat.windows++;
+}
+
+#endif /* OS_CONFIG_USE_CPUSTAT */
@@ -0,0 +1,77 @@
+/*
+ *     Yet another operating system for microcontrollers.
+ *     CPU load of tasks and interrupts.
+ *
+ * Copyright (c) 2013, Dmitry Kobylin
+ * All rights reserved.
+ * 
+ * Redistribution and use in source and binary forms, with or without
+ * modification, are permitted provided that the following conditions are met: 
+ * 
+ * 1. Redistributions of source code must retain the above copyright notice, this
+ *    list of conditions and the following disclaimer. 
+ * 2. Redistributions in binary form must reproduce the above copyright notice,
+ *    this list of conditions and the following disclaimer in the documentation
+ *    and/or other materials provided with the distribution. 
+ * 
+ * THIS SOFTWARE IS PROVIDED BY THE COPYRIGHT HOLDERS AND CONTRIBUTORS "AS IS" AND
+ * ANY EXPRESS OR IMPLIED WARRANTIES, INCLUDING, BUT NOT LIMITED TO, THE IMPLIED
+ * WARRANTIES OF MERCHANTABILITY AND FITNESS FOR A PARTICULAR PURPOSE ARE
+ * DISCLAIMED. IN NO EVENT SHALL THE COPYRIGHT OWNER OR CONTRIBUTORS BE LIABLE FOR
+ * ANY DIRECT, INDIRECT, INCIDENTAL, SPECIAL, EXEMPLARY, OR CONSEQUENTIAL DAMAGES
+ * (INCLUDING, BUT NOT LIMITED TO, PROCUREMENT OF SUBSTITUTE GOODS OR SERVICES;
+ * LOSS OF USE, DATA, OR PROFITS; OR BUSINESS INTERRUPTION) HOWEVER CAUSED AND
+ * ON ANY THEORY OF LIABILITY, WHETHER IN CONTRACT, STRICT LIABILITY, OR TORT
+ * (INCLUDING NEGLIGENCE OR OTHERWISE) ARISING IN ANY WAY OUT OF THE USE OF THIS
+ * SOFTWARE, EVEN IF ADVISED OF THE POSSIBILITY OF SUCH DAMAGE.
+ * 
+ */
+#ifndef OS_CPUSTAT_H
+#define OS_CPUSTAT_H
+
+#include <types.h>
+
+/*
+ * Time of every task is measured in cycles of PORT_CYCCNT at each call of
+ * scheduler, time of interrupt handlers (marked with os_irq_enter() and
+ * os_irq_exit()) is subtracted from time of interrupted task. Loads are
+ * calculated at end of each window (one second) for last window and for last
+ * OS_CPUSTAT_WINDOWS windows.
+ *
+ * Length of window is measured by OS clock, because cycle counter can stop
+ * during sleep of idle task. Idle time is rest of window not used by other
+ * tasks and interrupts.
+ */
+
+#define OS_CPUSTAT_WINDOWS    10    /* number of windows of long average */
+
+struct os_cpuload_t {
+    uint16 load1;   /* load in last window, 1/1000 */
+    uint16 load10;  /* load in last OS_CPUSTAT_WINDOWS windows, 1/1000 */
+    uint32 cycles;  /* cycles used in last window */
+};
+
+#define OS_CPUSTAT_MAGIC    0x43505553 /* "CPUS" */
+
+struct os_cpustat_t {
+    uint32 magic;
+    BASE_TYPE ntasks;   /* number of tasks */
+    BASE_TYPE period;   /* length of window, us */
+    BASE_TYPE windows;  /* number of complete windows since start */
+    char **names;       /* names of tasks */
+
+#define OS_CPUSTAT_TOTAL      0        /* all tasks except idle, and interrupts */
+#define OS_CPUSTAT_IRQ        1        /* interrupts */
+#define OS_CPUSTAT_TASK(n)    (2 + (n)) /* task with index n, n = 0 - idle task */
+#define OS_CPUSTAT_COUNT      OS_CPUSTAT_TASK(OS_CONFIG_TASK_COUNT + 1)
+    struct os_cpuload_t load[OS_CPUSTAT_COUNT];
+};
+
+extern struct os_cpustat_t os_cpustat;
+
+void os_cpustat_init();
+void os_cpustat_account();
+void os_cpustat_irq_enter();
+void os_cpustat_irq_exit();
+
+#endif /* OS_CPUSTAT_H */
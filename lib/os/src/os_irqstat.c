@@ -0,0 +1,145 @@
+/*
+ *     Yet another operating system for microcontrollers.
+ *     Length of interrupt handlers and of sections with masked interrupts.
+ *
+ * Copyright (c) 2013, Dmitry Kobylin
+ * All rights reserved.
+ * 
+ * Redistribution and use in source and binary forms, with or without
+ * modification, are permitted provided that the following conditions are met: 
+ * 
+ * 1. Redistributions of source code must retain the above copyright notice, this
+ *    list of conditions and the following disclaimer. 
+ * 2. Redistributions in binary form must reproduce the above copyright notice,
+ *    this list of conditions and the following disclaimer in the documentation
+ *    and/or other materials provided with the distribution. 
+ * 
+ * THIS SOFTWARE IS PROVIDED BY THE COPYRIGHT HOLDERS AND CONTRIBUTORS "AS IS" AND
+ * ANY EXPRESS OR IMPLIED WARRANTIES, INCLUDING, BUT NOT LIMITED TO, THE IMPLIED
+ * WARRANTIES OF MERCHANTABILITY AND FITNESS FOR A PARTICULAR PURPOSE ARE
+ * DISCLAIMED. IN NO EVENT SHALL THE COPYRIGHT OWNER OR CONTRIBUTORS BE LIABLE FOR
+ * ANY DIRECT, INDIRECT, INCIDENTAL, SPECIAL, EXEMPLARY, OR CONSEQUENTIAL DAMAGES
+ * (INCLUDING, BUT NOT LIMITED TO, PROCUREMENT OF SUBSTITUTE GOODS OR SERVICES;
+ * LOSS OF USE, DATA, OR PROFITS; OR BUSINESS INTERRUPTION) HOWEVER CAUSED AND
+ * ON ANY THEORY OF LIABILITY, WHETHER IN CONTRACT, STRICT LIABILITY, OR TORT
+ * (INCLUDING NEGLIGENCE OR OTHERWISE) ARISING IN ANY WAY OUT OF THE USE OF THIS
+ * SOFTWARE, EVEN IF ADVISED OF THE POSSIBILITY OF SUCH DAMAGE.
+ * 
+ */
+#include "os_private.h"
+#include "os_irqstat.h"
+
+#ifdef OS_CONFIG_USE_IRQSTAT
+
+struct os_irqstat_t os_irqstat;
+
+struct os_irqstat_site_t *os_irqstat_cursite; /* site of current section with masked interrupts */
+uint32 os_irqstat_curstart;                   /* PORT_CYCCNT at start of current section */
+
+STATIC struct os_irqstat_entry_t os_irqstat_irqs[OS_CONFIG_IRQSTAT_IRQS];
+STATIC uint32 os_irqstat_irqstart[OS_CONFIG_IRQSTAT_IRQS];
+STATIC struct os_irqstat_site_t os_irqstat_callers[OS_CONFIG_IRQSTAT_CALLERS];
+
+STATIC void os_irqstat_add(struct os_irqstat_entry_t *st, uint32 cycles);
+
+/*
+ * NOTE called during interrupts disabled, section opened by os_init() is
+ *      dropped
+ */
+void os_irqstat_init()
+{
+    os_irqstat.clock   = PORT_CYCCNT_HZ;
+    os_irqstat.buckets = OS_IRQSTAT_BUCKETS;
+    os_irqstat.shift   = OS_IRQSTAT_SHIFT;
+    os_irqstat.nirq    = OS_CONFIG_IRQSTAT_IRQS;
+    os_irqstat.irq     = os_irqstat_irqs;
+    os_irqstat.sites   = NULL;
+    os_irqstat.magic   = OS_IRQSTAT_MAGIC;
+
+    os_irqstat_cursite = NULL;
+}
+
+/*
+ * Find site of caller of os_disable_irq(), last site is shared by callers
+ * that do not fit to table.
+ *
+ * NOTE called during interrupts disabled
+ */
+struct os_irqstat_site_t *os_irqstat_caller(void *addr)
+{
+    struct os_irqstat_site_t *site;
+    BASE_TYPE i;
+
+    for (i = 0; i < OS_CONFIG_IRQSTAT_CALLERS - 1; i++)
+    {
+        site = &os_irqstat_callers[i];
+        if (site->line == (BASE_TYPE)addr || site->line == 0)
+            break;
+    }
+    site = &os_irqstat_callers[i];
+    if (site->line == 0)
+        site->line = (BASE_TYPE)addr;
+
+    return site;
+}
+
+/*
+ * Close current section with masked interrupts.
+ *
+ * NOTE called during interrupts disabled (OS_ENABLE_IRQ())
+ */
+void os_irqstat_mask_record()
+{
+    struct os_irqstat_site_t *site;
+
+    site = os_irqstat_cursite;
+    os_irqstat_cursite = NULL;
+
+    /* first section of site, add site to list */
+    if (!site->listed)
+    {
+        site->listed = 1;
+        site->next = os_irqstat.sites;
+        os_irqstat.sites = site;
+    }
+    os_irqstat_add(&site->st, PORT_CYCCNT - os_irqstat_curstart);
+}
+
+/*
+ * Should be called at entry of interrupt handler (os_irq_enter()).
+ */
+OS_RAMFUNC void os_irqstat_irq_enter(BASE_TYPE n)
+{
+    if ((uint32)n < OS_CONFIG_IRQSTAT_IRQS)
+        os_irqstat_irqstart[n] = PORT_CYCCNT;
+}
+
+/*
+ * Should be called at exit of interrupt handler (os_irq_exit()).
+ */
+OS_RAMFUNC void os_irqstat_irq_exit(BASE_TYPE n)
+{
+    if ((uint32)n < OS_CONFIG_IRQSTAT_IRQS)
+        os_irqstat_add(&os_irqstat_irqs[n], PORT_CYCCNT - os_irqstat_irqstart[n]);
+}
+
+/*
+ *
+ */
+STATIC void os_irqstat_add(struct os_irqstat_entry_t *st, uint32 cycles)
+{
+    uint32 v;
+    BASE_TYPE b;
+
+    v = cycles >> OS_IRQSTAT_SHIFT;
+    b = v ? 32 - __builtin_clz(v) : 0;
+    if (b >= OS_IRQSTAT_BUCKETS)
+        b = OS_IRQSTAT_BUCKETS - 1;
+
+    st->count++;
+    st->hist[b]++;
+    if (st->max < cycles)
+        st->max = cycles;
+}
+
+#endif /* OS_CONFIG_USE_IRQSTAT */
@@ -0,0 +1,92 @@
+/*
+ *     Yet another operating system for microcontrollers.
+ *     Length of interrupt handlers and of sections with masked interrupts.
+ *
+ * Copyright (c) 2013, Dmitry Kobylin
+ * All rights reserved.
+ * 
+ * Redistribution and use in source and binary forms, with or without
+ * modification, are permitted provided that the following conditions are met: 
+ * 
+ * 1. Redistributions of source code must retain the above copyright notice, this
+ *    list of conditions and the following disclaimer. 
+ * 2. Redistributions in binary form must reproduce the above copyright notice,
+ *    this list of conditions and the following disclaimer in the documentation
+ *    and/or other materials provided with the distribution. 
+ * 
+ * THIS SOFTWARE IS PROVIDED BY THE COPYRIGHT HOLDERS AND CONTRIBUTORS "AS IS" AND
+ * ANY EXPRESS OR IMPLIED WARRANTIES, INCLUDING, BUT NOT LIMITED TO, THE IMPLIED
+ * WARRANTIES OF MERCHANTABILITY AND FITNESS FOR A PARTICULAR PURPOSE ARE
+ * DISCLAIMED. IN NO EVENT SHALL THE COPYRIGHT OWNER OR CONTRIBUTORS BE LIABLE FOR
+ * ANY DIRECT, INDIRECT, INCIDENTAL, SPECIAL, EXEMPLARY, OR CONSEQUENTIAL DAMAGES
+ * (INCLUDING, BUT NOT LIMITED TO, PROCUREMENT OF SUBSTITUTE GOODS OR SERVICES;
+ * LOSS OF USE, DATA, OR PROFITS; OR BUSINESS INTERRUPTION) HOWEVER CAUSED AND
+ * ON ANY THEORY OF LIABILITY, WHETHER IN CONTRACT, STRICT LIABILITY, OR TORT
+ * (INCLUDING NEGLIGENCE OR OTHERWISE) ARISING IN ANY WAY OUT OF THE USE OF THIS
+ * SOFTWARE, EVEN IF ADVISED OF THE POSSIBILITY OF SUCH DAMAGE.
+ * 
+ */
+#ifndef OS_IRQSTAT_H
+#define OS_IRQSTAT_H
+
+#include <types.h>
+
+/*
+ * Sections with masked interrupts (OS_DISABLE_IRQ() ... OS_ENABLE_IRQ(),
+ * os_disable_irq() ... os_enable_irq(), scheduler) and interrupt handlers
+ * (os_irq_enter() ... os_irq_exit()) are measured in cycles of PORT_CYCCNT.
+ * Maximum and histogram are kept for every call site of OS_DISABLE_IRQ(),
+ * for every caller of os_disable_irq() and for every interrupt number.
+ *
+ * Bucket "b" of histogram counts lengths from (1 << (b + OS_IRQSTAT_SHIFT - 1))
+ * to (1 << (b + OS_IRQSTAT_SHIFT)) - 1 cycles, bucket 0 counts shorter
+ * lengths, last bucket counts all longer.
+ *
+ * NOTE
+ *     * length of handler includes time of nested handlers
+ *     * disable of already masked interrupts is not a new section, section is
+ *       ended (and charged to first site) by first enable
+ */
+
+#define OS_IRQSTAT_BUCKETS    16
+#define OS_IRQSTAT_SHIFT      4
+
+struct os_irqstat_entry_t {
+    uint32 count;
+    uint32 max;
+    uint32 hist[OS_IRQSTAT_BUCKETS];
+};
+
+/* call site, file is NULL for caller of os_disable_irq(), line is return address then */
+struct os_irqstat_site_t {
+    const char *file;
+    BASE_TYPE line;
+    BASE_TYPE listed;                  /* site is added to list */
+    struct os_irqstat_site_t *next;
+    struct os_irqstat_entry_t st;
+};
+
+#define OS_IRQSTAT_MAGIC    0x49525153 /* "IRQS" */
+
+struct os_irqstat_t {
+    uint32 magic;
+    BASE_TYPE clock;                   /* frequency of cycle counter, Hz */
+    BASE_TYPE buckets;                 /* OS_IRQSTAT_BUCKETS */
+    BASE_TYPE shift;                   /* OS_IRQSTAT_SHIFT */
+    BASE_TYPE nirq;                    /* OS_CONFIG_IRQSTAT_IRQS */
+    struct os_irqstat_entry_t *irq;    /* interrupt handlers, indexed by number of interrupt */
+    struct os_irqstat_site_t *sites;   /* list of sites with masked interrupts */
+};
+
+extern struct os_irqstat_t os_irqstat;
+
+extern struct os_irqstat_site_t *os_irqstat_cursite;
+extern uint32 os_irqstat_curstart;
+
+void os_irqstat_init();
+struct os_irqstat_site_t *os_irqstat_caller(void *addr);
+void os_irqstat_mask_record();
+void os_irqstat_irq_enter(BASE_TYPE n);
+void os_irqstat_irq_exit(BASE_TYPE n);
+
+#endif /* OS_IRQSTAT_H */
@@ -0,0 +1,262 @@
+/*
+ *     Yet another operating system for microcontrollers.
+ *     Mailboxes and direct-handoff channels.
+ *
+ * Copyright (c) 2013, Dmitry Kobylin
+ * All rights reserved.
+ * 
+ * Redistribution and use in source and binary forms, with or without
+ * modification, are permitted provided that the following conditions are met: 
+ * 
+ * 1. Redistributions of source code must retain the above copyright notice, this
+ *    list of conditions and the following disclaimer. 
+ * 2. Redistributions in binary form must reproduce the above copyright notice,
+ *    this list of conditions and the following disclaimer in the documentation
+ *    and/or other materials provided with the distribution. 
+ * 
+ * THIS SOFTWARE IS PROVIDED BY THE COPYRIGHT HOLDERS AND CONTRIBUTORS "AS IS" AND
+ * ANY EXPRESS OR IMPLIED WARRANTIES, INCLUDING, BUT NOT LIMITED TO, THE IMPLIED
+ * WARRANTIES OF MERCHANTABILITY AND FITNESS FOR A PARTICULAR PURPOSE ARE
+ * DISCLAIMED. IN NO EVENT SHALL THE COPYRIGHT OWNER OR CONTRIBUTORS BE LIABLE FOR
+ * ANY DIRECT, INDIRECT, INCIDENTAL, SPECIAL, EXEMPLARY, OR CONSEQUENTIAL DAMAGES
+ * (INCLUDING, BUT NOT LIMITED TO, PROCUREMENT OF SUBSTITUTE GOODS OR SERVICES;
+ * LOSS OF USE, DATA, OR PROFITS; OR BUSINESS INTERRUPTION) HOWEVER CAUSED AND
+ * ON ANY THEORY OF LIABILITY, WHETHER IN CONTRACT, STRICT LIABILITY, OR TORT
+ * (INCLUDING NEGLIGENCE OR OTHERWISE) ARISING IN ANY WAY OUT OF THE USE OF THIS
+ * SOFTWARE, EVEN IF ADVISED OF THE POSSIBILITY OF SUCH DAMAGE.
+ * 
+ *
+ * Messages are copied with disabled interrupts, so they should be small
+ * (few words of state or command).
+ */
+#include <string.h> /* for memcpy */
+#include "os_private.h"
+#include "os_sched.h"
+#include "os_flags.h"
+#include "os_mem.h"
+#include "os_bitobj.h"
+
+#ifdef OS_CONFIG_USE_MBOX
+#include "os_mbox.h"
+
+/*
+ * initialize mailbox
+ *
+ * ARGS
+ *     size    size of message in bytes
+ *     pe      pointer to memory contained bits for event raised on post,
+ *             NULL if consumer polls mailbox
+ *     mask    mask of event
+ *
+ * RETURN
+ *     pointer to allocated mailbox
+ */
+struct os_mbox_t *os_mbox_init(BASE_TYPE size, BASE_TYPE *pe, BASE_TYPE mask)
+{
+    struct os_mbox_t *mb;
+
+    mb = os_malloc(sizeof(struct os_mbox_t));
+
+    mb->size      = size;
+    mb->full      = 0;
+    mb->pe        = pe;
+    mb->mask      = mask;
+    mb->posts     = 0;
+    mb->conflated = 0;
+    mb->slot      = os_malloc(size);
+
+    return mb;
+}
+
+/*
+ * place message to mailbox, message that was not read is overwritten
+ *
+ * NOTE
+ *     * never waits, may be called from ISR
+ */
+void os_mbox_post(struct os_mbox_t *mb, void *data)
+{
+    OS_DISABLE_IRQ();
+    {
+        if (mb->full)
+            mb->conflated++;
+        memcpy(mb->slot, data, mb->size);
+        mb->full = 1;
+        mb->posts++;
+    }
+    OS_ENABLE_IRQ();
+
+    if (mb->pe)
+        os_event_raise(mb->pe, mb->mask);
+}
+
+/*
+ * read message from mailbox
+ *
+ * NOTE
+ *     * event of mailbox should be cleared before read, so post that
+ *       occurs after read raises it again
+ *
+ * RETURN
+ *     OS_ERR_NONE       if message was read
+ *     OS_ERR_WOULDLOCK  no new message since last read
+ */
+BASE_TYPE os_mbox_read(struct os_mbox_t *mb, void *data)
+{
+    OS_DISABLE_IRQ();
+    if (!mb->full)
+    {
+        OS_ENABLE_IRQ();
+        return OS_ERR_WOULDLOCK;
+    }
+    memcpy(data, mb->slot, mb->size);
+    mb->full = 0;
+    OS_ENABLE_IRQ();
+
+    return OS_ERR_NONE;
+}
+
+/*
+ * initialize channel
+ *
+ * ARGS
+ *     size    size of message in bytes
+ *
+ * RETURN
+ *     pointer to allocated channel
+ */
+struct os_chan_t *os_chan_init(BASE_TYPE size)
+{
+    struct os_chan_t *ch;
+
+    ch = os_malloc(sizeof(struct os_chan_t));
+
+    ch->event    = 0;
+    ch->size     = size;
+    ch->full     = 0;
+    ch->rbuf     = NULL;
+    ch->sends    = 0;
+    ch->handoffs = 0;
+    ch->slot     = os_malloc(size);
+
+    return ch;
+}
+
+/*
+ * send message to receiver of channel
+ *
+ * ARGS
+ *     ch          pointer to channel
+ *     data        message, "size" bytes
+ *     flags       
+ *                 OS_FLAG_NONE      no flag specified
+ *                 OS_FLAG_NOWAIT    don't wait if slot of channel is occupied,
+ *                                   return immediately
+ *     timeout     if specified wait with timeout when slot become free
+ *
+ * NOTE
+ *     * should not be called from ISR
+ *
+ * RETURN
+ *     OS_ERR_NONE       if message was passed to receiver or placed to slot
+ *     OS_ERR_TIMEOUT    timeout occured before slot was freed
+ *     OS_ERR_WOULDLOCK  slot is occupied but OS_FLAG_NOWAIT was specified
+ */
+BASE_TYPE os_chan_send(struct os_chan_t *ch, void *data, BASE_TYPE flags, BASE_TYPE timeout)
+{
+    while (1)
+    {
+        OS_DISABLE_IRQ();
+        if (ch->rbuf)
+        {
+            /* receiver waits, pass message to it and switch to receiver */
+            memcpy(ch->rbuf, data, ch->size);
+            ch->rbuf = NULL;
+            ch->sends++;
+            ch->handoffs++;
+            ch->event |= OS_CHAN_EVENT_RECV;
+            PORT_DATA_BARIER();
+            os_sched_wake(&ch->event);
+            os_sched_suspend_task();
+            OS_ENABLE_IRQ();
+            return OS_ERR_NONE;
+        }
+        if (!ch->full)
+        {
+            memcpy(ch->slot, data, ch->size);
+            ch->full = 1;
+            ch->sends++;
+            OS_ENABLE_IRQ();
+            return OS_ERR_NONE;
+        }
+        OS_ENABLE_IRQ();
+
+        if (flags & OS_FLAG_NOWAIT)
+            return OS_ERR_WOULDLOCK;
+        if (os_event_wait_tm(&ch->event, OS_CHAN_EVENT_FREE, OS_FLAG_CLEAR, &timeout) != OS_ERR_NONE)
+            return OS_ERR_TIMEOUT;
+    }
+}
+
+/*
+ * receive message from channel
+ *
+ * ARGS
+ *     ch          pointer to channel
+ *     data        buffer for message, "size" bytes
+ *     flags       
+ *                 OS_FLAG_NONE      no flag specified
+ *                 OS_FLAG_NOWAIT    don't wait if there is no message, return
+ *                                   immediately
+ *     timeout     if specified wait with timeout for message
+ *
+ * NOTE
+ *     * channel has one receiver
+ *     * should not be called from ISR
+ *
+ * RETURN
+ *     OS_ERR_NONE       if message was received
+ *     OS_ERR_TIMEOUT    timeout occured before message was sent
+ *     OS_ERR_WOULDLOCK  there is no message but OS_FLAG_NOWAIT was specified
+ */
+BASE_TYPE os_chan_recv(struct os_chan_t *ch, void *data, BASE_TYPE flags, BASE_TYPE timeout)
+{
+    BASE_TYPE err;
+
+    OS_DISABLE_IRQ();
+    if (ch->full)
+    {
+        memcpy(data, ch->slot, ch->size);
+        ch->full = 0;
+        OS_ENABLE_IRQ();
+
+        /* sender waiting for slot will run when receiver waits */
+        os_event_raise_ns(&ch->event, OS_CHAN_EVENT_FREE);
+        return OS_ERR_NONE;
+    }
+    if (flags & OS_FLAG_NOWAIT)
+    {
+        OS_ENABLE_IRQ();
+        return OS_ERR_WOULDLOCK;
+    }
+    ch->rbuf = data;
+    OS_ENABLE_IRQ();
+
+    err = os_event_wait(&ch->event, OS_CHAN_EVENT_RECV, OS_FLAG_CLEAR, timeout);
+    if (err != OS_ERR_NONE)
+    {
+        OS_DISABLE_IRQ();
+        if (ch->rbuf == NULL)
+        {
+            /* NOTE message could be passed just before timeout expired */
+            ch->event &= ~OS_CHAN_EVENT_RECV;
+            err = OS_ERR_NONE;
+        } else {
+            ch->rbuf = NULL;
+        }
+        OS_ENABLE_IRQ();
+    }
+    return err;
+}
+
+#endif /* OS_CONFIG_USE_MBOX */
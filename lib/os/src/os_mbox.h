@@ -0,0 +1,79 @@
+/*
+ *     Yet another operating system for microcontrollers.
+ *     Mailboxes and direct-handoff channels.
+ *
+ * Copyright (c) 2013, Dmitry Kobylin
+ * All rights reserved.
+ * 
+ * Redistribution and use in source and binary forms, with or without
+ * modification, are permitted provided that the following conditions are met: 
+ * 
+ * 1. Redistributions of source code must retain the above copyright notice, this
+ *    list of conditions and the following disclaimer. 
+ * 2. Redistributions in binary form must reproduce the above copyright notice,
+ *    this list of conditions and the following disclaimer in the documentation
+ *    and/or other materials provided with the distribution. 
+ * 
+ * THIS SOFTWARE IS PROVIDED BY THE COPYRIGHT HOLDERS AND CONTRIBUTORS "AS IS" AND
+ * ANY EXPRESS OR IMPLIED WARRANTIES, INCLUDING, BUT NOT LIMITED TO, THE IMPLIED
+ * WARRANTIES OF MERCHANTABILITY AND FITNESS FOR A PARTICULAR PURPOSE ARE
+ * DISCLAIMED. IN NO EVENT SHALL THE COPYRIGHT OWNER OR CONTRIBUTORS BE LIABLE FOR
+ * ANY DIRECT, INDIRECT, INCIDENTAL, SPECIAL, EXEMPLARY, OR CONSEQUENTIAL DAMAGES
+ * (INCLUDING, BUT NOT LIMITED TO, PROCUREMENT OF SUBSTITUTE GOODS OR SERVICES;
+ * LOSS OF USE, DATA, OR PROFITS; OR BUSINESS INTERRUPTION) HOWEVER CAUSED AND
+ * ON ANY THEORY OF LIABILITY, WHETHER IN CONTRACT, STRICT LIABILITY, OR TORT
+ * (INCLUDING NEGLIGENCE OR OTHERWISE) ARISING IN ANY WAY OUT OF THE USE OF THIS
+ * SOFTWARE, EVEN IF ADVISED OF THE POSSIBILITY OF SUCH DAMAGE.
+ * 
+ */
+#ifndef OS_MBOX_H
+#define OS_MBOX_H
+
+#include <types.h>
+
+/*
+ * Mailbox holds one message of state (position, level, mode), newest post
+ * overwrites message that was not read yet, so producer never waits and
+ * consumer always gets latest state. Consumer is notified by event.
+ */
+struct os_mbox_t {
+    BASE_TYPE size;     /* size of message in bytes */
+    BASE_TYPE full;     /* message was posted and not read yet */
+    BASE_TYPE *pe;      /* event raised by post, NULL if not used */
+    BASE_TYPE mask;
+
+    uint32 posts;       /* number of posts */
+    uint32 conflated;   /* number of messages overwritten before read */
+
+    uint8 *slot;
+};
+
+struct os_mbox_t *os_mbox_init(BASE_TYPE size, BASE_TYPE *pe, BASE_TYPE mask);
+void os_mbox_post(struct os_mbox_t *mb, void *data);
+BASE_TYPE os_mbox_read(struct os_mbox_t *mb, void *data);
+
+/*
+ * Channel passes commands from one or more senders to one receiver. If
+ * receiver waits for command then message is copied directly to buffer of
+ * receiver and sender switches to it. Otherwise message is left in slot of
+ * channel and sender waits only if previous message was not received yet.
+ */
+struct os_chan_t {
+#define OS_CHAN_EVENT_RECV    (1 << 0) /* message was passed to waiting receiver */
+#define OS_CHAN_EVENT_FREE    (1 << 1) /* slot was freed by receiver */
+    BASE_TYPE event;
+    BASE_TYPE size;     /* size of message in bytes */
+    BASE_TYPE full;     /* message in slot */
+    void *rbuf;         /* buffer of waiting receiver, NULL if receiver not waiting */
+
+    uint32 sends;       /* number of sent messages */
+    uint32 handoffs;    /* number of messages passed directly to receiver */
+
+    uint8 *slot;
+};
+
+struct os_chan_t *os_chan_init(BASE_TYPE size);
+BASE_TYPE os_chan_send(struct os_chan_t *ch, void *data, BASE_TYPE flags, BASE_TYPE timeout);
+BASE_TYPE os_chan_recv(struct os_chan_t *ch, void *data, BASE_TYPE flags, BASE_TYPE timeout);
+
+#endif
@@ -41,6 +41,21 @@ struct os_dmem_stat_t {
 extern struct os_dmem_stat_t os_dmstat;
 #endif
 
+#ifdef OS_CONFIG_DYNMEM_3
+struct os_dmem_stat_t {
+    BASE_TYPE size;        /* size of memory available for blocks */
+    BASE_TYPE used;        /* size of busy blocks including headers */
+    BASE_TYPE peak;        /* maximum value of used */
+    BASE_TYPE largest;     /* size of largest free block (updated by os_mem_stat()) */
+    BASE_TYPE busy_blocks;
+    BASE_TYPE free_blocks;
+};
+extern struct os_dmem_stat_t os_dmstat;
+
+void os_mem_stat(struct os_dmem_stat_t *st);
+void os_mem_walk(void (*cb)(void *p, BASE_TYPE size, void *tag));
+#endif
+
 extern uint8 dmem[OS_CONFIG_DYNMEM_SIZE];
 
 void *os_malloc(BASE_TYPE size);
@@ -26,13 +26,398 @@
  * SOFTWARE, EVEN IF ADVISED OF THE POSSIBILITY OF SUCH DAMAGE.
  * 
  *
- * 
+ * Two-level segregated fit allocator (TLSF). Free blocks are kept in
+ * lists indexed by first level (power of two of size) and second level
+ * (linear subdivision of power of two range). Non-empty lists are marked
+ * in bitmaps, so both allocation and freeing take constant time.
+ * Neighbour free blocks are joined on free.
+ *
+ * NOTE Mutex is used to deny semultaneous access from different tasks.
+ *      Don't run os_malloc() and os_mfree() from interrupts.
+ *
+ * NOTE If OS_CONFIG_DYNMEM_TAG defined then address of caller of os_malloc()
+ *      saved to header of every block, use os_mem_walk() to print it.
  */
 #include "os_private.h"
 #include "os_mem.h"
+#include "os_bitobj.h"
 
 #ifdef OS_CONFIG_DYNMEM_3
 
+#define ALIGN_LOG2        3                                   /* 8 bytes alignment of blocks */
+#define ALIGN_SIZE        (1 << ALIGN_LOG2)
+#define SL_INDEX_LOG2     4                                   /* 16 second level lists */
+#define SL_INDEX_COUNT    (1 << SL_INDEX_LOG2)
+#define FL_INDEX_SHIFT    (SL_INDEX_LOG2 + ALIGN_LOG2)
+#define FL_INDEX_MAX      26                                  /* blocks up to 64 MB */
+#define FL_INDEX_COUNT    (FL_INDEX_MAX - FL_INDEX_SHIFT + 1)
+#define SMALL_BLOCK_SIZE  (1 << FL_INDEX_SHIFT)               /* blocks smaller than this are in first list */
+
+#if OS_CONFIG_DYNMEM_SIZE >= (1 << FL_INDEX_MAX)
+    #error "OS_CONFIG_DYNMEM_SIZE too big, increase FL_INDEX_MAX"
+#endif
+
+struct block_t {
+    struct block_t *prev_phys;  /* previous block in memory, NULL for first block */
+#define BLOCK_FREE    (1 << 0)
+    uint32 size;                /* size of payload, bit 0 is set if block is free */
+#ifdef OS_CONFIG_DYNMEM_TAG
+    void *tag;                  /* address of os_malloc() caller */
+    uint32 reserved;            /* keep payload aligned */
+#endif
+    /* NOTE fields below are at start of payload and valid only for free block */
+    struct block_t *next_free;
+    struct block_t *prev_free;
+};
+
+#define BLOCK_HDR_SIZE     (sizeof(struct block_t) - 2 * sizeof(struct block_t*))
+#define BLOCK_SIZE_MIN     (2 * sizeof(struct block_t*))
+#define BLOCK_SIZE(b)      ((b)->size & ~BLOCK_FREE)
+#define BLOCK_IS_FREE(b)   ((b)->size & BLOCK_FREE)
+#define BLOCK_PAYLOAD(b)   ((void*)((uint8*)(b) + BLOCK_HDR_SIZE))
+#define BLOCK_NEXT(b)      ((struct block_t*)((uint8*)(b) + BLOCK_HDR_SIZE + BLOCK_SIZE(b)))
+#define BLOCK_FROM_PTR(p)  ((struct block_t*)((uint8*)(p) - BLOCK_HDR_SIZE))
+
+#define FLS(x)             (31 - PORT_CLZ(x))         /* index of most significant set bit */
+#define FFS(x)             (31 - PORT_CLZ((x) & (~(x) + 1))) /* index of least significant set bit */
+
+struct os_dmem_stat_t os_dmstat;
+STATIC BASE_TYPE initialized;
+STATIC uint32 fl_bitmap;
+STATIC uint32 sl_bitmap[FL_INDEX_COUNT];
+STATIC struct block_t *free_lists[FL_INDEX_COUNT][SL_INDEX_COUNT];
+#define MUTEX_MASK (1 << 0)
+STATIC BASE_TYPE mutex;
+
+/*
+ * obtain indexes of list where block of specified size is stored
+ */
+STATIC void os_mem_mapping(uint32 size, BASE_TYPE *fl, BASE_TYPE *sl)
+{
+    BASE_TYPE f;
+
+    if (size < SMALL_BLOCK_SIZE)
+    {
+        *fl = 0;
+        *sl = size >> ALIGN_LOG2;
+    } else {
+        f   = FLS(size);
+        *sl = (size >> (f - SL_INDEX_LOG2)) ^ (1 << SL_INDEX_LOG2);
+        *fl = f - (FL_INDEX_SHIFT - 1);
+    }
+}
+
+/*
+ * put free block to head of its list
+ */
+STATIC void os_mem_insert(struct block_t *block)
+{
+    struct block_t *head;
+    BASE_TYPE fl, sl;
+
+    os_mem_mapping(BLOCK_SIZE(block), &fl, &sl);
+
+    head = free_lists[fl][sl];
+    block->next_free = head;
+    block->prev_free = NULL;
+    if (head)
+        head->prev_free = block;
+    free_lists[fl][sl] = block;
+
+    fl_bitmap     |= (1 << fl);
+    sl_bitmap[fl] |= (1 << sl);
+
+    block->size |= BLOCK_FREE;
+    os_dmstat.free_blocks++;
+}
+
+/*
+ * remove free block from its list
+ */
+STATIC void os_mem_remove(struct block_t *block)
+{
+    BASE_TYPE fl, sl;
+
+    block->size &= ~BLOCK_FREE;
+    os_mem_mapping(block->size, &fl, &sl);
+
+    if (block->next_free)
+        block->next_free->prev_free = block->prev_free;
+    if (block->prev_free)
+    {
+        block->prev_free->next_free = block->next_free;
+    } else {
+        free_lists[fl][sl] = block->next_free;
+        if (!free_lists[fl][sl])
+        {
+            sl_bitmap[fl] &= ~(1 << sl);
+            if (!sl_bitmap[fl])
+                fl_bitmap &= ~(1 << fl);
+        }
+    }
+    os_dmstat.free_blocks--;
+}
+
+/*
+ * make one free block from whole dynamic memory
+ */
+STATIC void os_mem_init()
+{
+    struct block_t *block;
+    struct block_t *last;
+    uint32 start, end;
+
+    start = ((uint32)dmem + (ALIGN_SIZE - 1)) & ~(ALIGN_SIZE - 1);
+    end   = ((uint32)dmem + OS_CONFIG_DYNMEM_SIZE) & ~(ALIGN_SIZE - 1);
+
+    block = (struct block_t*)start;
+    block->prev_phys = NULL;
+    /* NOTE leave space for header of last block */
+    block->size = end - start - 2 * BLOCK_HDR_SIZE;
+
+    /* busy block with zero size terminates memory */
+    last = BLOCK_NEXT(block);
+    last->prev_phys = block;
+    last->size      = 0;
+
+    os_mem_insert(block);
+
+    os_dmstat.size = block->size & ~BLOCK_FREE;
+    initialized = 1;
+}
+
+/*
+ * ARGS
+ *     size    number of bytes to allocate
+ *
+ * RETURN
+ *     pointer to allocated memory or NULL if there is no free block of
+ *     required size
+ */
+void *os_malloc(BASE_TYPE size)
+{
+    struct block_t *block;
+    struct block_t *rest;
+    BASE_TYPE fl, sl;
+    uint32 asize;
+    uint32 map;
+    void *ret;
+
+    ret   = NULL;
+    block = NULL;
+
+    /* NOTE align size */
+    asize = ((uint32)size + (ALIGN_SIZE - 1)) & ~(ALIGN_SIZE - 1);
+    if (asize < BLOCK_SIZE_MIN)
+        asize = BLOCK_SIZE_MIN;
+
+    os_mutex_lock(&mutex, MUTEX_MASK, OS_FLAG_NONE, OS_WAIT_FOREVER);
+
+    if (!initialized)
+        os_mem_init();
+
+    if (size >= 0 && asize < OS_CONFIG_DYNMEM_SIZE)
+    {
+        /* 
+         * Round size up to next list, so any block of this list (and of
+         * lists above) is large enough.
+         */
+        if (asize >= SMALL_BLOCK_SIZE)
+            os_mem_mapping(asize + (1 << (FLS(asize) - SL_INDEX_LOG2)) - 1, &fl, &sl);
+        else
+            os_mem_mapping(asize, &fl, &sl);
+
+        if (fl < FL_INDEX_COUNT)
+        {
+            map = sl_bitmap[fl] & (~0UL << sl);
+            if (!map)
+            {
+                map = fl_bitmap & (~0UL << (fl + 1));
+                if (map)
+                {
+                    fl  = FFS(map);
+                    map = sl_bitmap[fl];
+                }
+            }
+            if (map)
+            {
+                sl    = FFS(map);
+                block = free_lists[fl][sl];
+            }
+        }
+
+        /* 
+         * NOTE There may be no lists above, check first block of list
+         *      where block of required size would be stored.
+         */
+        if (!block)
+        {
+            os_mem_mapping(asize, &fl, &sl);
+            block = free_lists[fl][sl];
+            if (block && BLOCK_SIZE(block) < asize)
+                block = NULL;
+        }
+    }
+
+    if (block)
+    {
+        os_mem_remove(block);
+
+        /* if block contain enough space for another block then split it */
+        if (block->size >= asize + BLOCK_HDR_SIZE + BLOCK_SIZE_MIN)
+        {
+            rest = (struct block_t*)((uint8*)BLOCK_PAYLOAD(block) + asize);
+            rest->prev_phys = block;
+            rest->size      = block->size - asize - BLOCK_HDR_SIZE;
+            BLOCK_NEXT(rest)->prev_phys = rest;
+
+            block->size = asize;
+            os_mem_insert(rest);
+        }
+#ifdef OS_CONFIG_DYNMEM_TAG
+        block->tag = __builtin_return_address(0);
+#endif
+        os_dmstat.busy_blocks++;
+        os_dmstat.used += block->size + BLOCK_HDR_SIZE;
+        if (os_dmstat.used > os_dmstat.peak)
+            os_dmstat.peak = os_dmstat.used;
+
+        ret = BLOCK_PAYLOAD(block);
+    }
+
+    os_mutex_unlock(&mutex, MUTEX_MASK);
+
+#ifdef OS_CONFIG_TRAP_DYNMEM
+    if (!ret)
+    {
+        os_trapinfo.err = OS_TRAP_ERR_DYNMEM_EXHAUST;
+        os_trap();
+    }
+#endif
+    return ret;
+}
+
+/*
+ * ARGS
+ *     p    pointer to memory allocated by os_malloc(), NULL is ignored
+ */
+void os_mfree(void *p)
+{
+    struct block_t *block;
+    struct block_t *prev;
+    struct block_t *next;
+
+    if (!p)
+        return;
+
+    block = BLOCK_FROM_PTR(p);
+
+    os_mutex_lock(&mutex, MUTEX_MASK, OS_FLAG_NONE, OS_WAIT_FOREVER);
+#ifdef OS_CONFIG_TRAP_DYNMEM
+    if (BLOCK_IS_FREE(block))
+    {
+        os_trapinfo.err = OS_TRAP_ERR_DYNMEM_DOUBLEFREE;
+        os_trap();
+    }
+    /* NOTE also catches free of block that was joined with previous free block */
+    if (BLOCK_NEXT(block)->prev_phys != block ||
+            (block->prev_phys && BLOCK_NEXT(block->prev_phys) != block))
+    {
+        os_trapinfo.err = OS_TRAP_ERR_DYNMEM_MAGIC;
+        os_trap();
+    }
+#endif
+    os_dmstat.busy_blocks--;
+    os_dmstat.used -= block->size + BLOCK_HDR_SIZE;
+
+    /* join with previous and next blocks if they are free */
+    prev = block->prev_phys;
+    if (prev && BLOCK_IS_FREE(prev))
+    {
+        os_mem_remove(prev);
+        prev->size += BLOCK_HDR_SIZE + block->size;
+        block = prev;
+    }
+    next = BLOCK_NEXT(block);
+    if (BLOCK_IS_FREE(next))
+    {
+        os_mem_remove(next);
+        block->size += BLOCK_HDR_SIZE + next->size;
+    }
+    BLOCK_NEXT(block)->prev_phys = block;
+
+    os_mem_insert(block);
+
+    os_mutex_unlock(&mutex, MUTEX_MASK);
+}
+
+/*
+ * obtain statistics of dynamic memory
+ *
+ * ARGS
+ *     st    pointer to structure where statistics will be copied
+ *
+ * NOTE Size of largest free block is found by scan of highest non-empty list.
+ */
+void os_mem_stat(struct os_dmem_stat_t *st)
+{
+    struct block_t *block;
+    BASE_TYPE fl, sl;
+
+    os_mutex_lock(&mutex, MUTEX_MASK, OS_FLAG_NONE, OS_WAIT_FOREVER);
+
+    if (!initialized)
+        os_mem_init();
+
+    os_dmstat.largest = 0;
+    if (fl_bitmap)
+    {
+        fl = FLS(fl_bitmap);
+        sl = FLS(sl_bitmap[fl]);
+        for (block = free_lists[fl][sl]; block != NULL; block = block->next_free)
+        {
+            if (BLOCK_SIZE(block) > os_dmstat.largest)
+                os_dmstat.largest = BLOCK_SIZE(block);
+        }
+    }
+    *st = os_dmstat;
+
+    os_mutex_unlock(&mutex, MUTEX_MASK);
+}
+
+/*
+ * run callback for every busy block
+ *
+ * ARGS
+ *     cb    callback, receives pointer to payload of block, its size and
+ *           address of caller of os_malloc() (NULL if OS_CONFIG_DYNMEM_TAG
+ *           not defined)
+ *
+ * NOTE Scan all blocks, should be used only for debug purposes.
+ */
+void os_mem_walk(void (*cb)(void *p, BASE_TYPE size, void *tag))
+{
+    struct block_t *block;
+
+    os_mutex_lock(&mutex, MUTEX_MASK, OS_FLAG_NONE, OS_WAIT_FOREVER);
+
+    if (initialized)
+    {
+        block = (struct block_t*)(((uint32)dmem + (ALIGN_SIZE - 1)) & ~(ALIGN_SIZE - 1));
+        for (; block->size != 0; block = BLOCK_NEXT(block))
+        {
+            if (BLOCK_IS_FREE(block))
+                continue;
+#ifdef OS_CONFIG_DYNMEM_TAG
+            cb(BLOCK_PAYLOAD(block), block->size, block->tag);
+#else
+            cb(BLOCK_PAYLOAD(block), block->size, NULL);
+#endif
+        }
+    }
+
+    os_mutex_unlock(&mutex, MUTEX_MASK);
+}
 
 #endif /* OS_CONFIG_DYNMEM_3 */
 
@@ -48,14 +48,12 @@ struct os_multi_event_t *os_multi_init(BASE_TYPE count)
 {
     struct os_multi_event_t *m;
 
-    OS_DISABLE_IRQ();
     m = os_malloc(sizeof(struct os_multi_event_t));
 
     m->count  = count;
     m->n      = 0;
     m->events = os_malloc(sizeof(struct os_task_lock_t) * count);
 
-    OS_ENABLE_IRQ();
     return m;
 }
 
@@ -0,0 +1,187 @@
+/*
+ *     Yet another operating system for microcontrollers.
+ *     Pools of fixed-size blocks.
+ *
+ * Copyright (c) 2013, Dmitry Kobylin
+ * All rights reserved.
+ * 
+ * Redistribution and use in source and binary forms, with or without
+ * modification, are permitted provided that the following conditions are met: 
+ * 
+ * 1. Redistributions of source code must retain the above copyright notice, this
+ *    list of conditions and the following disclaimer. 
+ * 2. Redistributions in binary form must reproduce the above copyright notice,
+ *    this list of conditions and the following disclaimer in the documentation
+ *    and/or other materials provided with the distribution. 
+ * 
+ * THIS SOFTWARE IS PROVIDED BY THE COPYRIGHT HOLDERS AND CONTRIBUTORS "AS IS" AND
+ * ANY EXPRESS OR IMPLIED WARRANTIES, INCLUDING, BUT NOT LIMITED TO, THE IMPLIED
+ * WARRANTIES OF MERCHANTABILITY AND FITNESS FOR A PARTICULAR PURPOSE ARE
+ * DISCLAIMED. IN NO EVENT SHALL THE COPYRIGHT OWNER OR CONTRIBUTORS BE LIABLE FOR
+ * ANY DIRECT, INDIRECT, INCIDENTAL, SPECIAL, EXEMPLARY, OR CONSEQUENTIAL DAMAGES
+ * (INCLUDING, BUT NOT LIMITED TO, PROCUREMENT OF SUBSTITUTE GOODS OR SERVICES;
+ * LOSS OF USE, DATA, OR PROFITS; OR BUSINESS INTERRUPTION) HOWEVER CAUSED AND
+ * ON ANY THEORY OF LIABILITY, WHETHER IN CONTRACT, STRICT LIABILITY, OR TORT
+ * (INCLUDING NEGLIGENCE OR OTHERWISE) ARISING IN ANY WAY OUT OF THE USE OF THIS
+ * SOFTWARE, EVEN IF ADVISED OF THE POSSIBILITY OF SUCH DAMAGE.
+ * 
+ *
+ * Every pool is static array of blocks (slab) with list of free blocks.
+ * Blocks are linked by index, index of first free block stored in head of
+ * pool (0 - pool is empty).
+ *
+ * NOTE os_pool_alloc() and os_pool_free() use exclusive load/store instead of
+ *      disabling of interrupts and may be called from interrupts. Store fails
+ *      if interrupt or task switch occured after load (exclusive monitor is
+ *      cleared on exception entry/return), in this case operation is retried.
+ */
+#include "os_private.h"
+
+#ifdef OS_CONFIG_USE_POOL
+#include "os_pool.h"
+
+struct os_pool_t {
+    char *name;
+    uint8 *mem;                 /* slab */
+    BASE_TYPE size;             /* size of block (aligned) */
+    BASE_TYPE count;            /* number of blocks */
+    volatile BASE_TYPE head;    /* index of first free block plus one, 0 if pool is empty */
+    volatile BASE_TYPE used;
+    volatile BASE_TYPE peak;
+    volatile BASE_TYPE fails;
+};
+
+/* NOTE block holds index of next free block while it is free */
+#define POOL_BLOCK_SIZE(size)   (((size) + 7) & ~7)
+#define POOL_BLOCK(pool, idx)   \
+    ((BASE_TYPE*)&(pool)->mem[((idx) - 1) * (pool)->size])
+
+#define OS_POOL(name, size, count)                                   \
+    STATIC uint8 os_pool_##name[POOL_BLOCK_SIZE(size) * (count)] \
+        __attribute__((aligned(8)));
+OS_CONFIG_POOL_TABLE
+#undef OS_POOL
+
+#define OS_POOL(name, size, count)                                   \
+    {#name, os_pool_##name, POOL_BLOCK_SIZE(size), (count)},
+STATIC struct os_pool_t os_pools[OS_POOL_COUNT] = {
+    OS_CONFIG_POOL_TABLE
+};
+#undef OS_POOL
+
+/*
+ * link blocks of all pools to free lists
+ *
+ * NOTE called from os_init()
+ */
+void os_pool_init()
+{
+    struct os_pool_t *pool;
+    BASE_TYPE i;
+
+    for (pool = os_pools; pool < &os_pools[OS_POOL_COUNT]; pool++)
+    {
+        for (i = 1; i < pool->count; i++)
+            *POOL_BLOCK(pool, i) = i + 1;
+        *POOL_BLOCK(pool, pool->count) = 0;
+        pool->head = 1;
+    }
+}
+
+/*
+ * add value to counter of used blocks and update maximum
+ */
+STATIC void os_pool_count(struct os_pool_t *pool, BASE_TYPE add)
+{
+    BASE_TYPE used;
+
+    do {
+        used = PORT_LDREX(&pool->used) + add;
+    } while (PORT_STREX(&pool->used, used));
+
+    while (used > PORT_LDREX(&pool->peak))
+    {
+        if (!PORT_STREX(&pool->peak, used))
+            return;
+    }
+    PORT_CLREX();
+}
+
+/*
+ * ARGS
+ *     pool    identifier of pool (OS_POOL_name)
+ *
+ * RETURN
+ *     pointer to block or NULL if pool is empty
+ */
+void *os_pool_alloc(BASE_TYPE pool)
+{
+    struct os_pool_t *p;
+    BASE_TYPE idx;
+
+    p = &os_pools[pool];
+    do {
+        idx = PORT_LDREX(&p->head);
+        if (!idx)
+        {
+            PORT_CLREX();
+            do {
+                idx = PORT_LDREX(&p->fails);
+            } while (PORT_STREX(&p->fails, idx + 1));
+            return NULL;
+        }
+    } while (PORT_STREX(&p->head, *POOL_BLOCK(p, idx)));
+
+    os_pool_count(p, 1);
+    return POOL_BLOCK(p, idx);
+}
+
+/*
+ * ARGS
+ *     pool    identifier of pool, should be same as for os_pool_alloc()
+ *     ptr     pointer to block
+ */
+void os_pool_free(BASE_TYPE pool, void *ptr)
+{
+    struct os_pool_t *p;
+    BASE_TYPE idx;
+
+    p   = &os_pools[pool];
+    idx = ((uint8*)ptr - p->mem) / p->size + 1;
+#ifdef OS_CONFIG_TRAP_POOL
+    if ((uint8*)ptr < p->mem || idx > p->count || (BASE_TYPE*)ptr != POOL_BLOCK(p, idx))
+    {
+        os_trapinfo.err = OS_TRAP_ERR_POOL_PTR;
+        os_trap();
+    }
+#endif
+
+    do {
+        *(BASE_TYPE*)ptr = PORT_LDREX(&p->head);
+    } while (PORT_STREX(&p->head, idx));
+
+    os_pool_count(p, -1);
+}
+
+/*
+ * obtain statistics of pool
+ *
+ * ARGS
+ *     pool    identifier of pool
+ *     st      pointer to structure where statistics will be copied
+ */
+void os_pool_stat(BASE_TYPE pool, struct os_pool_stat_t *st)
+{
+    struct os_pool_t *p;
+
+    p = &os_pools[pool];
+    st->name  = p->name;
+    st->size  = p->size;
+    st->count = p->count;
+    st->used  = p->used;
+    st->peak  = p->peak;
+    st->fails = p->fails;
+}
+
+#endif /* OS_CONFIG_USE_POOL */
+
@@ -0,0 +1,60 @@
+/*
+ *     Yet another operating system for microcontrollers.
+ *     Pools of fixed-size blocks.
+ *
+ * Copyright (c) 2013, Dmitry Kobylin
+ * All rights reserved.
+ * 
+ * Redistribution and use in source and binary forms, with or without
+ * modification, are permitted provided that the following conditions are met: 
+ * 
+ * 1. Redistributions of source code must retain the above copyright notice, this
+ *    list of conditions and the following disclaimer. 
+ * 2. Redistributions in binary form must reproduce the above copyright notice,
+ *    this list of conditions and the following disclaimer in the documentation
+ *    and/or other materials provided with the distribution. 
+ * 
+ * THIS SOFTWARE IS PROVIDED BY THE COPYRIGHT HOLDERS AND CONTRIBUTORS "AS IS" AND
+ * ANY EXPRESS OR IMPLIED WARRANTIES, INCLUDING, BUT NOT LIMITED TO, THE IMPLIED
+ * WARRANTIES OF MERCHANTABILITY AND FITNESS FOR A PARTICULAR PURPOSE ARE
+ * DISCLAIMED. IN NO EVENT SHALL THE COPYRIGHT OWNER OR CONTRIBUTORS BE LIABLE FOR
+ * ANY DIRECT, INDIRECT, INCIDENTAL, SPECIAL, EXEMPLARY, OR CONSEQUENTIAL DAMAGES
+ * (INCLUDING, BUT NOT LIMITED TO, PROCUREMENT OF SUBSTITUTE GOODS OR SERVICES;
+ * LOSS OF USE, DATA, OR PROFITS; OR BUSINESS INTERRUPTION) HOWEVER CAUSED AND
+ * ON ANY THEORY OF LIABILITY, WHETHER IN CONTRACT, STRICT LIABILITY, OR TORT
+ * (INCLUDING NEGLIGENCE OR OTHERWISE) ARISING IN ANY WAY OUT OF THE USE OF THIS
+ * SOFTWARE, EVEN IF ADVISED OF THE POSSIBILITY OF SUCH DAMAGE.
+ * 
+ */
+#ifndef OS_POOL_H
+#define OS_POOL_H
+
+#include <types.h>
+
+/* 
+ * Identifiers of pools (OS_POOL_name) obtained from OS_CONFIG_POOL_TABLE,
+ * look at os_config.h
+ */
+#define OS_POOL(name, size, count) OS_POOL_##name,
+enum {
+    OS_CONFIG_POOL_TABLE
+    OS_POOL_COUNT
+};
+#undef OS_POOL
+
+struct os_pool_stat_t {
+    char *name;
+    BASE_TYPE size;   /* size of block in bytes */
+    BASE_TYPE count;  /* number of blocks */
+    BASE_TYPE used;   /* number of allocated blocks */
+    BASE_TYPE peak;   /* maximum number of allocated blocks */
+    BASE_TYPE fails;  /* number of allocations failed because pool was empty */
+};
+
+void os_pool_init();
+void *os_pool_alloc(BASE_TYPE pool);
+void os_pool_free(BASE_TYPE pool, void *p);
+void os_pool_stat(BASE_TYPE pool, struct os_pool_stat_t *st);
+
+#endif
+
@@ -66,6 +66,12 @@
     #define OS_CONTEXT_SIZE        (32 + 32) /* XXX should sizeof(os_task_context_t) be used instead ? */
     #define OS_STACK_MINSIZE       (OS_CONTEXT_SIZE + 32)
     #define OS_STACK_DIR_DECREASE
+#elif PORT_POSIX
+    #include "port/POSIX/port.h"
+
+    #define OS_CONTEXT_SIZE        sizeof(struct os_task_context_t)
+    #define OS_STACK_MINSIZE       (OS_CONTEXT_SIZE + 32)
+    #define OS_STACK_DIR_DECREASE
 #else
     #error "unknown OS port"
 #endif
@@ -74,17 +80,24 @@
                         (defined OS_CONFIG_USE_WAIT)       || \
                         (defined OS_CONFIG_USE_TASK_SLICE) || \
                         (defined OS_CONFIG_USE_MUTEX)      || \
+                        (defined OS_CONFIG_USE_RMUTEX)     || \
+                        (defined OS_CONFIG_USE_DEADLINE)   || \
                         (defined OS_CONFIG_USE_EVENT)      || \
                         (defined OS_CONFIG_USE_QUEUE)         \
                        )
 #define OS_USE_TIMEOUT (\
                         (defined OS_CONFIG_USE_WAIT)  || \
                         (defined OS_CONFIG_USE_MUTEX) || \
+                        (defined OS_CONFIG_USE_RMUTEX) || \
+                        (defined OS_CONFIG_USE_DEADLINE) || \
                         (defined OS_CONFIG_USE_EVENT) ||\
                         (defined OS_CONFIG_USE_QUEUE) \
                        )
 
 #if OS_USE_LOCK
+struct os_taskcb_t;
+struct os_rmutex_t;
+
 struct os_task_lock_t {
     void *pobj;                /* pointer to object which cause lock of task */
     BASE_TYPE mask;            /* mask of mutex or event if lock type is mutex or event */
@@ -100,7 +113,38 @@ struct os_task_lock_t {
     #define OS_TASK_STATE_LOCKED_QUEUE_FULL  (0x50 | OS_TASK_LOCKED)
     #define OS_TASK_STATE_LOCKED_QUEUE_EMPTY (0x60 | OS_TASK_LOCKED)
     #define OS_TASK_STATE_LOCKED_MULTI       (0x70 | OS_TASK_LOCKED)
+    #define OS_TASK_STATE_LOCKED_RMUTEX      (0x80 | OS_TASK_LOCKED)
     BASE_TYPE state;           /* type of lock or state of task */
+
+    /* wait list of object */
+    volatile struct os_taskcb_t *task; /* task waiting for object */
+    struct os_task_lock_t *wprev;
+    struct os_task_lock_t *wnext;
+};
+#endif
+
+#ifdef OS_CONFIG_USE_DEADLINE
+/*
+ * Job parameters and statistics of task in deadline class (time is in
+ * microseconds)
+ */
+struct os_deadline_t {
+    BASE_TYPE period;     /* relative deadline of job, zero if task is not in deadline class */
+    BASE_TYPE budget;     /* CPU time allowed to job, zero - not limited */
+#define OS_DEADLINE_IDLE         0 /* job ended, next job is released when task wakes */
+#define OS_DEADLINE_ACTIVE       1 /* job is scheduled by deadline */
+#define OS_DEADLINE_THROTTLED    2 /* job exhausted budget, it is scheduled by priority until end */
+    BASE_TYPE state;
+    BASE_TYPE release;    /* time of release of job */
+    BASE_TYPE deadline;   /* absolute deadline of job */
+    BASE_TYPE used;       /* CPU time used by job */
+    BASE_TYPE start;      /* time when task was switched in */
+
+    BASE_TYPE jobs;       /* number of ended jobs */
+    BASE_TYPE misses;     /* number of jobs ended after deadline */
+    BASE_TYPE overruns;   /* number of jobs exhausted budget */
+    BASE_TYPE used_max;   /* maximum CPU time used by job */
+    BASE_TYPE resp_max;   /* maximum time from release to end of job */
 };
 #endif
 
@@ -119,10 +163,14 @@ struct os_taskcb_t {
 
 #if OS_USE_TIMEOUT
     BASE_TYPE timeout;
+    BASE_TYPE deadline;  /* time when timeout expires */
+    volatile struct os_taskcb_t *tprev; /* list of tasks sorted by deadline */
+    volatile struct os_taskcb_t *tnext;
 #endif
 
     volatile struct os_taskcb_t *prev;
     volatile struct os_taskcb_t *next;
+    BASE_TYPE waiting;   /* task is locked and placed to wait lists */
 #ifdef OS_CONFIG_USE_TASK_SLICE
     BASE_TYPE tslice;    /* time slice of task in units of OS_CONFIG_TICK_PERIOD */
     #ifdef OS_CONFIG_USE_VARIABLE_TASK_SLICE
@@ -132,6 +180,15 @@ struct os_taskcb_t {
 
 #ifdef OS_CONFIG_USE_PRIORITY
     BASE_TYPE priority;
+    #ifdef OS_CONFIG_USE_RMUTEX
+    BASE_TYPE bpriority; /* base priority, priority is raised above it while task holds mutex other task waits for */
+    #endif
+#endif
+#ifdef OS_CONFIG_USE_RMUTEX
+    struct os_rmutex_t *rmutex; /* list of recursive mutexes held by task */
+#endif
+#ifdef OS_CONFIG_USE_DEADLINE
+    struct os_deadline_t dl;
 #endif
 
 #endif /* OS_USE_LOCK */
@@ -168,12 +225,27 @@ struct os_trap_info_t {
 #define OS_TRAP_ERR_DYNMEM_DOUBLEFREE    0x22
 #define OS_TRAP_ERR_QUEUE_MSIZE          0x30
 #define OS_TRAP_ERR_MULTI_ECOUNT         0x40
+#define OS_TRAP_ERR_POOL_PTR             0x50
+#define OS_TRAP_ERR_RMUTEX_OWNER         0x60
     BASE_TYPE err;         /* last error code, should be second member */
 };
 
+#ifdef OS_CONFIG_USE_SCHEDSTAT
+struct os_schedstat_t {
+    BASE_TYPE switches;                              /* number of scheduler calls */
+    BASE_TYPE cycles_last;                           /* CPU cycles spent by last scheduler call */
+    BASE_TYPE cycles_max[OS_CONFIG_TASK_COUNT + 1];  /* maximum of cycles, indexed by number of locked tasks */
+};
+
+extern struct os_schedstat_t os_schedstat;             /* scheduler statistics */
+#endif
+
 extern volatile struct os_taskcb_t *os_current_taskcb;          /* pointer to current task's control block */
 extern struct os_trap_info_t os_trapinfo;              /* trap inforamtion */
 extern BASE_TYPE os_taskidx;                           /* number of current initialized tasks */
+#if OS_USE_TIMEOUT && !(defined OS_CONFIG_TICKLESS)
+extern BASE_TYPE os_ticks;                             /* number of ticks since start */
+#endif
 
 #define OS_IDLE_TASKCB (&os_tasks[0])
 extern struct os_taskcb_t os_tasks[OS_CONFIG_TASK_COUNT + 1]; /* control block of task, NOTE os_task[0] is control block of idle task */
@@ -185,13 +257,86 @@ extern struct os_taskcb_t os_tasks[OS_CONFIG_TASK_COUNT + 1]; /* control block o
 void port_task_switch();
 #define os_task_switch() port_task_switch()
 
-#define OS_DISABLE_IRQ() PORT_DISABLE_IRQ()
-#define OS_ENABLE_IRQ()  PORT_ENABLE_IRQ()
+#ifdef OS_CONFIG_USE_IRQSTAT
+    #include "os_irqstat.h"
+    /* start section with masked interrupts, disable inside of section does not start new one */
+    #define OS_IRQSTAT_BEGIN(site) do {              \
+        if (!os_irqstat_cursite)                     \
+        {                                            \
+            os_irqstat_cursite  = (site);            \
+            os_irqstat_curstart = PORT_CYCCNT;       \
+        }                                            \
+    } while (0)
+    #define OS_IRQSTAT_END() do {                    \
+        if (os_irqstat_cursite)                      \
+            os_irqstat_mask_record();                \
+    } while (0)
+
+    #define OS_DISABLE_IRQ() do {                                                   \
+        static struct os_irqstat_site_t os_irqstat_site = {__FILE__, __LINE__};     \
+        PORT_DISABLE_IRQ();                                                         \
+        OS_IRQSTAT_BEGIN(&os_irqstat_site);                                         \
+    } while (0)
+    #define OS_ENABLE_IRQ() do {                     \
+        OS_IRQSTAT_END();                            \
+        PORT_ENABLE_IRQ();                           \
+    } while (0)
+#else
+    #define OS_DISABLE_IRQ() PORT_DISABLE_IRQ()
+    #define OS_ENABLE_IRQ()  PORT_ENABLE_IRQ()
+#endif
 
 #define OS_TIMEOUT_EXPIRED    BASE_TYPE_MAX
 
+/* current time, in ticks or in microseconds of application's clock in tickless mode */
+#ifdef OS_CONFIG_TICKLESS
+    #define OS_TIME()    osw_clock_time()
+#else
+    #define OS_TIME()    os_ticks
+#endif
+/* time "a" is before time "b", clock wrap is allowed */
+#define OS_TIME_BEFORE(a, b)    ((BASE_TYPE)((a) - (b)) < 0)
+
+#ifdef OS_CONFIG_USE_TRACEBUF
+    #include "os_trace.h"
+    #define OS_TRACE(type, info, arg) os_trace(type, info, (BASE_TYPE)(arg))
+#else
+    #define OS_TRACE(type, info, arg)
+#endif
+
+#ifdef OS_CONFIG_USE_CPUSTAT
+    #include "os_cpustat.h"
+#endif
+
+#ifdef OS_CONFIG_USE_TIMER
+    #include "os_timer.h"
+    void os_timer_expire();
+    #ifdef OS_CONFIG_TICKLESS
+        BASE_TYPE os_timer_next(BASE_TYPE *time);
+    #endif
+#endif
+
+/* periodic tick is not used in tickless mode, except for time slices */
+#define OS_USE_PERIODIC_TICK (\
+                        (defined OS_CONFIG_TICK_PERIOD) && \
+                        (!(defined OS_CONFIG_TICKLESS) || (defined OS_CONFIG_USE_TASK_SLICE)) \
+                       )
+
 void os_trap();
 void os_tick();
 
+#ifdef OS_CONFIG_TICKLESS
+/*
+ * Implemented by application. Free running clock with period of 1us and
+ * one-shot alarm, os_alarm() should be called from interrupt when clock
+ * reaches time of alarm. Alarm with time already passed should fire
+ * immediately.
+ */
+BASE_TYPE osw_clock_time();
+void osw_clock_alarm(BASE_TYPE time);
+
+void os_alarm();
+#endif
+
 #endif
 
@@ -0,0 +1,217 @@
+/*
+ *     Yet another operating system for microcontrollers.
+ *     Protothreads, stackless cooperative threads hosted by task.
+ *
+ * Copyright (c) 2013, Dmitry Kobylin
+ * All rights reserved.
+ * 
+ * Redistribution and use in source and binary forms, with or without
+ * modification, are permitted provided that the following conditions are met: 
+ * 
+ * 1. Redistributions of source code must retain the above copyright notice, this
+ *    list of conditions and the following disclaimer. 
+ * 2. Redistributions in binary form must reproduce the above copyright notice,
+ *    this list of conditions and the following disclaimer in the documentation
+ *    and/or other materials provided with the distribution. 
+ * 
+ * THIS SOFTWARE IS PROVIDED BY THE COPYRIGHT HOLDERS AND CONTRIBUTORS "AS IS" AND
+ * ANY EXPRESS OR IMPLIED WARRANTIES, INCLUDING, BUT NOT LIMITED TO, THE IMPLIED
+ * WARRANTIES OF MERCHANTABILITY AND FITNESS FOR A PARTICULAR PURPOSE ARE
+ * DISCLAIMED. IN NO EVENT SHALL THE COPYRIGHT OWNER OR CONTRIBUTORS BE LIABLE FOR
+ * ANY DIRECT, INDIRECT, INCIDENTAL, SPECIAL, EXEMPLARY, OR CONSEQUENTIAL DAMAGES
+ * (INCLUDING, BUT NOT LIMITED TO, PROCUREMENT OF SUBSTITUTE GOODS OR SERVICES;
+ * LOSS OF USE, DATA, OR PROFITS; OR BUSINESS INTERRUPTION) HOWEVER CAUSED AND
+ * ON ANY THEORY OF LIABILITY, WHETHER IN CONTRACT, STRICT LIABILITY, OR TORT
+ * (INCLUDING NEGLIGENCE OR OTHERWISE) ARISING IN ANY WAY OUT OF THE USE OF THIS
+ * SOFTWARE, EVEN IF ADVISED OF THE POSSIBILITY OF SUCH DAMAGE.
+ * 
+ */
+#include "os.h"
+#include "os_private.h"
+#include "os_pt.h"
+#include "os_sched.h"
+#include "os_flags.h"
+
+#ifdef OS_CONFIG_USE_PT
+
+/*
+ * initialize host of protothreads
+ *
+ * ARGS
+ *     host     pointer to host structure
+ *     count    maximum number of protothreads that wait for events or
+ *              queues at the same time
+ *     poll     period of check of conditions of OS_PT_WAIT_UNTIL(), in ticks,
+ *              if zero then host is not locked while some protothread waits
+ *              for condition
+ */
+void os_pt_host_init(struct os_pt_host_t *host, BASE_TYPE count, BASE_TYPE poll)
+{
+    host->head  = NULL;
+    host->multi = os_multi_init(count);
+    host->poll  = poll;
+}
+
+/*
+ * add protothread to host
+ *
+ * ARGS
+ *     host       pointer to host structure
+ *     pt         pointer to protothread structure
+ *     run        function of protothread
+ *     context    user data, accessible with OS_PT_CONTEXT()
+ *
+ * NOTE
+ *     should be called from host task or before os_pt_host_run()
+ */
+void os_pt_start(struct os_pt_host_t *host, struct os_pt_t *pt, BASE_TYPE (*run)(struct os_pt_t *pt), void *context)
+{
+    pt->lc      = 0;
+    pt->wait    = OS_PT_ON_NONE;
+    pt->flags   = 0;
+    pt->err     = OS_ERR_NONE;
+    pt->run     = run;
+    pt->context = context;
+
+    pt->next    = host->head;
+    host->head  = pt;
+}
+
+/*
+ * run protothreads, should be called from host task
+ *
+ * Every protothread is called once per pass. Then host task is locked
+ * until one of events or queues that protothreads wait for is triggered
+ * or until nearest timeout expires.
+ *
+ * RETURN
+ *     when all protothreads are ended
+ */
+void os_pt_host_run(struct os_pt_host_t *host)
+{
+    struct os_pt_t *pt, **ppt;
+    BASE_TYPE timeout, left;
+
+    while (host->head)
+    {
+        os_multi_reset(host->multi);
+        timeout = OS_WAIT_FOREVER;
+
+        ppt = &host->head;
+        while ((pt = *ppt))
+        {
+            if (pt->run(pt) == OS_PT_ENDED)
+            {
+                *ppt = pt->next;
+                continue;
+            }
+            ppt = &pt->next;
+
+            switch (pt->wait)
+            {
+                case OS_PT_ON_NONE:
+                    timeout = -1;
+                    break;
+                case OS_PT_ON_COND:
+                    if (!host->poll)
+                        timeout = -1;
+                    else if (timeout == OS_WAIT_FOREVER || timeout > host->poll)
+                        timeout = host->poll;
+                    break;
+                case OS_PT_ON_EVENT:
+                    os_multi_add_event(host->multi, pt->pobj, pt->mask);
+                    break;
+#ifdef OS_CONFIG_USE_QUEUE
+                case OS_PT_ON_QUEUE:
+                    os_multi_add_queue(host->multi, pt->pobj, OS_MULTI_QUEUE_NOT_EMPTY);
+                    break;
+#endif
+            }
+
+            if (timeout >= 0 && (pt->flags & OS_PT_FLAG_TIMED))
+            {
+                left = pt->deadline - OS_TIME();
+                if (left <= 0)
+                    timeout = -1;
+                else if (timeout == OS_WAIT_FOREVER || left < timeout)
+                    timeout = left;
+            }
+        }
+
+        if (!host->head)
+            break;
+
+        /* some protothread is ready already, let other tasks run and start next pass */
+        if (timeout < 0)
+        {
+            os_yield();
+            continue;
+        }
+
+        /* NOTE OR-lock of multiple event without events is ready immediately */
+        if (host->multi->n)
+            os_multi_wait(host->multi, OS_MULTI_LOCK_OR, timeout);
+        else
+            os_lock_task(OS_TASK_STATE_LOCKED_WAIT, NULL, 0, timeout);
+    }
+}
+
+/*
+ * start wait of protothread, used by OS_PT_WAIT() macro
+ */
+void os_pt_wait(struct os_pt_t *pt, BASE_TYPE on, void *pobj, BASE_TYPE mask, BASE_TYPE flags, BASE_TYPE timeout)
+{
+    pt->wait  = on;
+    pt->pobj  = pobj;
+    pt->mask  = mask;
+    pt->flags = flags;
+    pt->err   = OS_ERR_NONE;
+
+    if (timeout != OS_WAIT_FOREVER)
+    {
+        pt->flags   |= OS_PT_FLAG_TIMED;
+        pt->deadline = OS_TIME() + timeout;
+    }
+}
+
+/*
+ * check if wait of protothread is completed, used by OS_PT_WAIT() macro
+ *
+ * RETURN
+ *     0    protothread should wait further
+ *     1    wait completed, result of wait is in "err" field
+ */
+BASE_TYPE os_pt_check(struct os_pt_t *pt)
+{
+    switch (pt->wait)
+    {
+        case OS_PT_ON_NONE:
+            goto done;
+        case OS_PT_ON_EVENT:
+            if (os_event_wait(pt->pobj, pt->mask,
+                        OS_FLAG_NOWAIT | (pt->flags & OS_FLAG_CLEAR), 0) == OS_ERR_NONE)
+                goto done;
+            break;
+#ifdef OS_CONFIG_USE_QUEUE
+        case OS_PT_ON_QUEUE:
+            if (((struct os_queue_t*)pt->pobj)->count)
+                goto done;
+            break;
+#endif
+    }
+
+    if ((pt->flags & OS_PT_FLAG_TIMED) && !OS_TIME_BEFORE(OS_TIME(), pt->deadline))
+    {
+        if (pt->wait != OS_PT_ON_TIME)
+            pt->err = OS_ERR_TIMEOUT;
+        goto done;
+    }
+
+    return 0;
+done:
+    pt->wait  = OS_PT_ON_NONE;
+    pt->flags = 0;
+    return 1;
+}
+
+#endif /* OS_CONFIG_USE_PT */
@@ -0,0 +1,139 @@
+/*
+ *     Yet another operating system for microcontrollers.
+ *     Protothreads, stackless cooperative threads hosted by task.
+ *
+ * Copyright (c) 2013, Dmitry Kobylin
+ * All rights reserved.
+ * 
+ * Redistribution and use in source and binary forms, with or without
+ * modification, are permitted provided that the following conditions are met: 
+ * 
+ * 1. Redistributions of source code must retain the above copyright notice, this
+ *    list of conditions and the following disclaimer. 
+ * 2. Redistributions in binary form must reproduce the above copyright notice,
+ *    this list of conditions and the following disclaimer in the documentation
+ *    and/or other materials provided with the distribution. 
+ * 
+ * THIS SOFTWARE IS PROVIDED BY THE COPYRIGHT HOLDERS AND CONTRIBUTORS "AS IS" AND
+ * ANY EXPRESS OR IMPLIED WARRANTIES, INCLUDING, BUT NOT LIMITED TO, THE IMPLIED
+ * WARRANTIES OF MERCHANTABILITY AND FITNESS FOR A PARTICULAR PURPOSE ARE
+ * DISCLAIMED. IN NO EVENT SHALL THE COPYRIGHT OWNER OR CONTRIBUTORS BE LIABLE FOR
+ * ANY DIRECT, INDIRECT, INCIDENTAL, SPECIAL, EXEMPLARY, OR CONSEQUENTIAL DAMAGES
+ * (INCLUDING, BUT NOT LIMITED TO, PROCUREMENT OF SUBSTITUTE GOODS OR SERVICES;
+ * LOSS OF USE, DATA, OR PROFITS; OR BUSINESS INTERRUPTION) HOWEVER CAUSED AND
+ * ON ANY THEORY OF LIABILITY, WHETHER IN CONTRACT, STRICT LIABILITY, OR TORT
+ * (INCLUDING NEGLIGENCE OR OTHERWISE) ARISING IN ANY WAY OUT OF THE USE OF THIS
+ * SOFTWARE, EVEN IF ADVISED OF THE POSSIBILITY OF SUCH DAMAGE.
+ * 
+ */
+#ifndef OS_PT_H
+#define OS_PT_H
+
+#include <types.h>
+#include "os_multi.h"
+
+/*
+ * Protothread is function that is called by host task again and again,
+ * it returns to host at every wait and continues from that wait on next
+ * call (local continuation is line number of wait, switch statement is
+ * used to jump to it). Protothreads have no own stack, so
+ *     * local variables are not preserved across waits (use context or
+ *       static variables)
+ *     * waits can be used in body of protothread only, not in functions
+ *       called from it
+ *     * switch statement can not be used around waits
+ *
+ * Example
+ *     BASE_TYPE blink(struct os_pt_t *pt)
+ *     {
+ *         OS_PT_BEGIN(pt);
+ *         while (1)
+ *         {
+ *             OS_PT_WAIT_EVENT(pt, &ev, EV_BLINK, OS_FLAG_CLEAR, OS_MS2TICK(500));
+ *             if (OS_PT_ERR(pt) == OS_ERR_TIMEOUT)
+ *                 continue;
+ *             led_toggle();
+ *             OS_PT_SLEEP(pt, OS_MS2TICK(100));
+ *         }
+ *         OS_PT_END(pt);
+ *     }
+ */
+struct os_pt_t {
+    BASE_TYPE lc;               /* local continuation, line of wait, zero - start */
+#define OS_PT_ON_NONE     0     /* not waiting (yield) */
+#define OS_PT_ON_TIME     1
+#define OS_PT_ON_COND     2     /* condition polled by host */
+#define OS_PT_ON_EVENT    3
+#define OS_PT_ON_QUEUE    4     /* queue not empty */
+    BASE_TYPE wait;             /* what protothread waits for */
+#define OS_PT_FLAG_TIMED  (1 << 8)
+    BASE_TYPE flags;            /* OS_FLAG_CLEAR of event wait, OS_PT_FLAG_TIMED if wait has timeout */
+    BASE_TYPE err;              /* result of last wait, OS_ERR_NONE or OS_ERR_TIMEOUT */
+    void *pobj;                 /* object waited for */
+    BASE_TYPE mask;             /* mask of event waited for */
+    BASE_TYPE deadline;         /* time when timeout expires */
+    BASE_TYPE (*run)(struct os_pt_t *pt);
+    void *context;
+    struct os_pt_t *next;       /* next protothread of host */
+};
+
+struct os_pt_host_t {
+    struct os_pt_t *head;           /* list of protothreads */
+    struct os_multi_event_t *multi; /* objects protothreads wait for */
+    BASE_TYPE poll;                 /* period of check of conditions of OS_PT_WAIT_UNTIL() */
+};
+
+/* value returned by protothread */
+#define OS_PT_WAITING    0
+#define OS_PT_ENDED      1
+
+#define OS_PT_BEGIN(pt)    switch ((pt)->lc) { case 0:
+#define OS_PT_END(pt)      } (pt)->lc = 0; return OS_PT_ENDED
+#define OS_PT_EXIT(pt)     do { (pt)->lc = 0; return OS_PT_ENDED; } while (0)
+#define OS_PT_ERR(pt)      ((pt)->err)
+#define OS_PT_CONTEXT(pt)  ((pt)->context)
+
+#define OS_PT_WAIT(pt, on, pobj, mask, flags, timeout)                  \
+    do {                                                                \
+        os_pt_wait((pt), (on), (pobj), (mask), (flags), (timeout));     \
+        (pt)->lc = __LINE__;                                            \
+    case __LINE__:                                                      \
+        if (!os_pt_check(pt))                                           \
+            return OS_PT_WAITING;                                       \
+    } while (0)
+
+/* wait for event, flags - OS_FLAG_NONE or OS_FLAG_CLEAR */
+#define OS_PT_WAIT_EVENT(pt, pe, mask, flags, timeout) \
+    OS_PT_WAIT(pt, OS_PT_ON_EVENT, pe, mask, flags, timeout)
+/* wait for message in queue, message should be removed with OS_FLAG_NOWAIT */
+#define OS_PT_WAIT_QUEUE(pt, q, timeout) \
+    OS_PT_WAIT(pt, OS_PT_ON_QUEUE, q, 0, 0, timeout)
+#define OS_PT_SLEEP(pt, ticks) \
+    OS_PT_WAIT(pt, OS_PT_ON_TIME, NULL, 0, 0, ticks)
+/* return to host, protothread continues on next pass of host */
+#define OS_PT_YIELD(pt)                                                 \
+    do {                                                                \
+        os_pt_wait((pt), OS_PT_ON_NONE, NULL, 0, 0, 0);                 \
+        (pt)->lc = __LINE__;                                            \
+        return OS_PT_WAITING;                                           \
+    case __LINE__:                                                      \
+        ;                                                               \
+    } while (0)
+/* wait for condition, condition is checked every "poll" period of host */
+#define OS_PT_WAIT_UNTIL(pt, cond)                                      \
+    do {                                                                \
+        os_pt_wait((pt), OS_PT_ON_COND, NULL, 0, 0, 0);                 \
+        (pt)->lc = __LINE__;                                            \
+    case __LINE__:                                                      \
+        if (!(cond))                                                    \
+            return OS_PT_WAITING;                                       \
+    } while (0)
+
+void os_pt_host_init(struct os_pt_host_t *host, BASE_TYPE count, BASE_TYPE poll);
+void os_pt_start(struct os_pt_host_t *host, struct os_pt_t *pt, BASE_TYPE (*run)(struct os_pt_t *pt), void *context);
+void os_pt_host_run(struct os_pt_host_t *host);
+
+void os_pt_wait(struct os_pt_t *pt, BASE_TYPE on, void *pobj, BASE_TYPE mask, BASE_TYPE flags, BASE_TYPE timeout);
+BASE_TYPE os_pt_check(struct os_pt_t *pt);
+
+#endif /* OS_PT_H */
@@ -29,14 +29,25 @@
 #include <string.h> /* for memcpy, TODO write own function? */
 #include "os_private.h"
 #include "os_queue.h"
-#include "os_bitobj.h"
 #include "os_sched.h"
 #include "os_flags.h"
 #include "os_mem.h"
 
+/*
+ * Queue is ring of slots of equal size. Slot passes through states:
+ *     free -> reserved (producer fills message in place) -> committed ->
+ *     peeked (consumer reads message in place) -> released -> free
+ * Counters of queue are changed with disabled interrupts, messages are
+ * copied with enabled interrupts. Slots are committed and released in
+ * order of ring, so if message committed (released) before previous
+ * messages then it waits for them.
+ */
+
 #if (defined OS_CONFIG_USE_QUEUE)
 
 struct os_qmsg_head_t {
+#define OS_QMSG_RESERVED    (-1)  /* slot reserved, message not committed yet */
+#define OS_QMSG_RELEASED    (-2)  /* message released by consumer */
     BASE_TYPE len;
 };
 
@@ -45,11 +56,26 @@ struct os_qmsg_t {
     uint8 data[1];
 };
 
+#define QMSG_HEAD_SIZE          (sizeof(struct os_qmsg_head_t))
+#define QMSG_FROM_DATA(data)    ((struct os_qmsg_t *)((uint8*)(data) - QMSG_HEAD_SIZE))
+
+/*
+ * obtain slot located "back" bytes before write pointer
+ */
+STATIC struct os_qmsg_t *os_queue_slot(struct os_queue_t *q, BASE_TYPE back)
+{
+    BASE_TYPE offset;
+
+    offset = q->wp - back;
+    if (offset < 0)
+        offset += q->qsize;
+    return (struct os_qmsg_t *)&q->spool[offset];
+}
+
 /*
  * initialize queue
  *
  * ARGS
- *     midx     mutex associated with queue
  *     len      number of messages in queue
  *     msize    size of message in bytes (only size of data field)
  *
@@ -60,89 +86,232 @@ struct os_queue_t *os_queue_init(BASE_TYPE len, BASE_TYPE msize)
 {
     struct os_queue_t *q;
 
-    OS_DISABLE_IRQ();
     q = os_malloc(sizeof(struct os_queue_t));
 
-    q->mutex = 0;
-    q->msize = msize + sizeof(struct os_qmsg_head_t);
-    q->qsize = len * q->msize;
-    q->count = 0;
-    q->wp    = 0;
-    q->spool = os_malloc(q->qsize);
-    OS_ENABLE_IRQ();
+    /* NOTE keep data of messages aligned */
+    q->msize    = (msize + QMSG_HEAD_SIZE + sizeof(BASE_TYPE) - 1) & ~(sizeof(BASE_TYPE) - 1);
+    q->qsize    = len * q->msize;
+    q->used     = 0;
+    q->reserved = 0;
+    q->count    = 0;
+    q->wp       = 0;
+    q->spool    = os_malloc(q->qsize);
 
     return q;
 }
 
 /*
+ * reserve slot for message, message should be placed to slot and
+ * os_queue_commit() called after that
+ *
  * ARGS
  *     q           pointer to queue structure
  *     flags       
  *                 OS_FLAG_NONE      no flag specified
  *                 OS_FLAG_NOWAIT    don't wait if queue is full, return
- *                                   immediately with OS_ERR_WOULDLOCK error code
+ *                                   immediately
  *     timeout     if specified wait with timeout when queue become not full
- *     data        pointer to data that should be placed to queue
- *     len         length of data to place
  *
  * NOTE
- *     * OS_TIME2TICK_MS() and OS_TIME2TICK_US() macro should be
- *       used to specify time interval for timeout in milliseconds and microsecnds.
- *     * should not be called from ISR
+ *     * may be called from ISR with OS_FLAG_NOWAIT
  *
  * RETURN
- *     OS_ERR_NONE       if message sucessuflly was added to queue
- *     OS_ERR_TIMEOUT    timeout occured before space appeared in queue
- *     OS_ERR_WOULDLOCK  queue was full but OS_FLAG_NOWAIT was specified
+ *     pointer to data field of slot, NULL if queue is full
  */
-BASE_TYPE os_queue_add(struct os_queue_t *q, BASE_TYPE flags, BASE_TYPE timeout, void *data, BASE_TYPE len)
+void *os_queue_reserve(struct os_queue_t *q, BASE_TYPE flags, BASE_TYPE timeout)
 {
-    BASE_TYPE ret;
+    struct os_qmsg_t *qmsg;
+
+    while (1)
+    {
+        OS_DISABLE_IRQ();
+        if (q->used < q->qsize)
+        {
+            qmsg = (struct os_qmsg_t *)&q->spool[q->wp];
+            qmsg->head.len = OS_QMSG_RESERVED;
+
+            q->used     += q->msize;
+            q->reserved += q->msize;
+            q->wp       += q->msize;
+            if (q->wp >= q->qsize)
+                q->wp = 0;
+            OS_ENABLE_IRQ();
+            return qmsg->data;
+        }
+        OS_ENABLE_IRQ();
+
+        if (flags & OS_FLAG_NOWAIT)
+            return NULL;
+
+        timeout = os_lock_task(OS_TASK_STATE_LOCKED_QUEUE_FULL, q, 0, timeout);
+        if (timeout == OS_TIMEOUT_EXPIRED)
+            return NULL;
+    }
+}
+
+/*
+ * pass message placed to reserved slot to consumers
+ *
+ * ARGS
+ *     q           pointer to queue structure
+ *     data        pointer returned by os_queue_reserve()
+ *     len         length of message
+ *
+ * NOTE
+ *     * may be called from ISR
+ */
+void os_queue_commit(struct os_queue_t *q, void *data, BASE_TYPE len)
+{
+    struct os_qmsg_t *qmsg;
 
 #ifdef OS_CONFIG_TRAP_QUEUE
-    if ((len + sizeof(struct os_qmsg_head_t)) > q->msize)
+    if ((len + QMSG_HEAD_SIZE) > q->msize)
     {
         os_trapinfo.err = OS_TRAP_ERR_QUEUE_MSIZE;
         os_trap();
     }
 #endif
-    ret = OS_ERR_NONE;
-    while (1)
+    qmsg = QMSG_FROM_DATA(data);
+    OS_TRACE(OS_TRACE_QUEUE_ADD, len, q);
+
+    OS_DISABLE_IRQ();
     {
-        /* lock mutex with timeout */
-        if (os_mutex_lock_tm(&q->mutex, 0x01, OS_FLAG_NONE, &timeout) == OS_ERR_TIMEOUT)
-            return OS_ERR_TIMEOUT;
+        qmsg->head.len = len;
 
-        /* check that there is enough space in queue */
-        if (q->count < q->qsize)
+        /* move oldest committed slots to consumers */
+        while (q->reserved)
         {
-            struct os_qmsg_t *qmsg;
+            qmsg = os_queue_slot(q, q->reserved);
+            if (qmsg->head.len == OS_QMSG_RESERVED)
+                break;
+            q->reserved -= q->msize;
+            q->count    += q->msize;
+        }
+        PORT_DATA_BARIER();
+        os_sched_wake(q);
+        os_sched_suspend_task();
+    }
+    OS_ENABLE_IRQ();
+}
 
-            qmsg = (struct os_qmsg_t *)&q->spool[q->wp];
-            qmsg->head.len = len;
-            memcpy(qmsg->data, data, len);
+/*
+ * obtain oldest message, message stays in queue until os_queue_release()
+ *
+ * ARGS
+ *     q           pointer to queue structure
+ *     flags       
+ *                 OS_FLAG_NONE      no flag specified
+ *                 OS_FLAG_NOWAIT    don't wait if queue is empty, return
+ *                                   immediately
+ *     timeout     if specified wait with timeout when queue become not empty
+ *     len         pointer to length of message, NULL if not care
+ *
+ * NOTE
+ *     * may be called from ISR with OS_FLAG_NOWAIT
+ *
+ * RETURN
+ *     pointer to message, NULL if queue is empty
+ */
+void *os_queue_peek(struct os_queue_t *q, BASE_TYPE flags, BASE_TYPE timeout, BASE_TYPE *len)
+{
+    struct os_qmsg_t *qmsg;
 
-            q->count += q->msize;
-            q->wp    += q->msize;
-            if (q->wp >= q->qsize)
-                q->wp = 0;
-            goto out;
-        } else {
-            if (flags & OS_FLAG_NOWAIT)
-            {
-                ret = OS_ERR_WOULDLOCK;
-                goto out;
-            }
-
-            os_mutex_unlock(&q->mutex, 0x01);
-            timeout = os_lock_task(OS_TASK_STATE_LOCKED_QUEUE_FULL, q, 0, timeout);
-            if (timeout == OS_TIMEOUT_EXPIRED)
-                return OS_ERR_TIMEOUT;
+    while (1)
+    {
+        OS_DISABLE_IRQ();
+        if (q->count > 0)
+        {
+            qmsg = os_queue_slot(q, q->reserved + q->count);
+            q->count -= q->msize;
+            OS_ENABLE_IRQ();
+
+            if (len)
+                *len = qmsg->head.len;
+            return qmsg->data;
         }
+        OS_ENABLE_IRQ();
+
+        if (flags & OS_FLAG_NOWAIT)
+            return NULL;
+
+        timeout = os_lock_task(OS_TASK_STATE_LOCKED_QUEUE_EMPTY, q, 0, timeout);
+        if (timeout == OS_TIMEOUT_EXPIRED)
+            return NULL;
     }
-out:
-    os_mutex_unlock(&q->mutex, 0x01);
-    return ret;
+}
+
+/*
+ * free slot of message obtained by os_queue_peek()
+ *
+ * ARGS
+ *     q           pointer to queue structure
+ *     data        pointer returned by os_queue_peek()
+ *
+ * NOTE
+ *     * may be called from ISR
+ */
+void os_queue_release(struct os_queue_t *q, void *data)
+{
+    struct os_qmsg_t *qmsg;
+    BASE_TYPE back;
+
+    qmsg = QMSG_FROM_DATA(data);
+    OS_TRACE(OS_TRACE_QUEUE_REMOVE, 0, q);
+
+    OS_DISABLE_IRQ();
+    {
+        qmsg->head.len = OS_QMSG_RELEASED;
+
+        /* free oldest released slots */
+        back = q->used;
+        while (back > q->reserved + q->count)
+        {
+            qmsg = os_queue_slot(q, back);
+            if (qmsg->head.len != OS_QMSG_RELEASED)
+                break;
+            back    -= q->msize;
+            q->used -= q->msize;
+        }
+        PORT_DATA_BARIER();
+        os_sched_wake(q);
+        os_sched_suspend_task();
+    }
+    OS_ENABLE_IRQ();
+}
+
+/*
+ * ARGS
+ *     q           pointer to queue structure
+ *     flags       
+ *                 OS_FLAG_NONE      no flag specified
+ *                 OS_FLAG_NOWAIT    don't wait if queue is full, return
+ *                                   immediately with OS_ERR_WOULDLOCK error code
+ *     timeout     if specified wait with timeout when queue become not full
+ *     data        pointer to data that should be placed to queue
+ *     len         length of data to place
+ *
+ * NOTE
+ *     * OS_TIME2TICK_MS() and OS_TIME2TICK_US() macro should be
+ *       used to specify time interval for timeout in milliseconds and microsecnds.
+ *     * may be called from ISR with OS_FLAG_NOWAIT (look at os_queue_post())
+ *
+ * RETURN
+ *     OS_ERR_NONE       if message sucessuflly was added to queue
+ *     OS_ERR_TIMEOUT    timeout occured before space appeared in queue
+ *     OS_ERR_WOULDLOCK  queue was full but OS_FLAG_NOWAIT was specified
+ */
+BASE_TYPE os_queue_add(struct os_queue_t *q, BASE_TYPE flags, BASE_TYPE timeout, void *data, BASE_TYPE len)
+{
+    void *p;
+
+    p = os_queue_reserve(q, flags, timeout);
+    if (!p)
+        return (flags & OS_FLAG_NOWAIT) ? OS_ERR_WOULDLOCK : OS_ERR_TIMEOUT;
+
+    memcpy(p, data, len);
+    os_queue_commit(q, p, len);
+
+    return OS_ERR_NONE;
 }
 
 /*
@@ -159,7 +328,7 @@ out:
  * NOTE
  *     * OS_TIME2TICK_MS() and OS_TIME2TICK_US() macro should be
  *       used to specify time interval for timeout in milliseconds and microsecnds.
- *     * should not be called from ISR
+ *     * may be called from ISR with OS_FLAG_NOWAIT
  *
  * RETURN
  *     OS_ERR_NONE       if message sucessuflly was added to queue
@@ -168,61 +337,35 @@ out:
  */
 BASE_TYPE os_queue_remove(struct os_queue_t *q, BASE_TYPE flags, BASE_TYPE timeout, void *data, BASE_TYPE *len)
 {
-    BASE_TYPE ret;
+    void *p;
+    BASE_TYPE plen;
 
-    ret = OS_ERR_NONE;
-    while (1)
-    {
-        /* lock mutex with timeout */
-        if (os_mutex_lock_tm(&q->mutex, 0x01, OS_FLAG_NONE, &timeout) == OS_ERR_TIMEOUT)
-            return OS_ERR_TIMEOUT;
+    p = os_queue_peek(q, flags, timeout, &plen);
+    if (!p)
+        return (flags & OS_FLAG_NOWAIT) ? OS_ERR_WOULDLOCK : OS_ERR_TIMEOUT;
 
-        /* check that queue not empty */
-        if (q->count > 0)
-        {
-            struct os_qmsg_t *qmsg;
-
-            if (q->wp >= q->count)
-                qmsg = (struct os_qmsg_t *)&q->spool[q->wp - q->count];
-            else
-                qmsg = (struct os_qmsg_t *)&q->spool[q->qsize - q->count + q->wp];
+    if (len)
+        *len = plen;
+    memcpy(data, p, plen);
+    os_queue_release(q, p);
 
-            if (len)
-                *len = qmsg->head.len;
-            memcpy(data, qmsg->data, qmsg->head.len);
-
-            q->count -= q->msize;
-            goto out;
-        } else {
-            if (flags & OS_FLAG_NOWAIT)
-            {
-                ret = OS_ERR_WOULDLOCK;
-                goto out;
-            }
-
-            os_mutex_unlock(&q->mutex, 0x01);
-            timeout = os_lock_task(OS_TASK_STATE_LOCKED_QUEUE_EMPTY, q, 0, timeout);
-            if (timeout == OS_TIMEOUT_EXPIRED)
-                return OS_ERR_TIMEOUT;
-        }
-    }
-out:
-    os_mutex_unlock(&q->mutex, 0x01);
-    return ret;
+    return OS_ERR_NONE;
 }
-#endif /* defined OS_CONFIG_USE_QUEUE */
 
 /*
  * remove all entries from queue
  *
  * ARGS
  *     q           pointer to queue structure
+ *
+ * NOTE messages reserved by producers or peeked by consumers are not touched
  */
 void os_queue_flush(struct os_queue_t *q)
 {
-    os_mutex_lock_tm(&q->mutex, 0x01, OS_FLAG_NONE, OS_WAIT_FOREVER);
-    q->count = 0;
-    q->wp = 0;
-    os_mutex_unlock(&q->mutex, 0x01);
+    void *p;
+
+    while ((p = os_queue_peek(q, OS_FLAG_NOWAIT, 0, NULL)) != NULL)
+        os_queue_release(q, p);
 }
+#endif /* defined OS_CONFIG_USE_QUEUE */
 
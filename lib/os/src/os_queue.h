@@ -32,18 +32,26 @@
 #include <types.h>
 
 struct os_queue_t {
-    BASE_TYPE mutex; /* mutex associated with queue */
-    BASE_TYPE qsize; /* size of queue in bytes (size of occupied area of spool) */
-    BASE_TYPE msize; /* size of message in bytes */
-    BASE_TYPE count; /* count of bytes contained in queue */
-    BASE_TYPE wp;    /* write pointer */
+    BASE_TYPE qsize;    /* size of queue in bytes (size of occupied area of spool) */
+    BASE_TYPE msize;    /* size of slot in bytes (message and its header) */
+    BASE_TYPE used;     /* count of bytes of slots that are not free */
+    BASE_TYPE reserved; /* count of bytes of slots reserved by producers and not passed to consumers */
+    BASE_TYPE count;    /* count of bytes of committed messages not obtained by consumers */
+    BASE_TYPE wp;       /* write pointer */
 
-    uint8 *spool;    /* pointer to spool */
+    uint8 *spool;       /* pointer to spool */
 };
 
 struct os_queue_t *os_queue_init(BASE_TYPE len, BASE_TYPE msize);
 BASE_TYPE os_queue_add(struct os_queue_t *q, BASE_TYPE flags, BASE_TYPE timeout, void *data, BASE_TYPE len);
 BASE_TYPE os_queue_remove(struct os_queue_t *q, BASE_TYPE flags, BASE_TYPE timeout, void *data, BASE_TYPE *len);
 void os_queue_flush(struct os_queue_t *q);
-#endif
 
+void *os_queue_reserve(struct os_queue_t *q, BASE_TYPE flags, BASE_TYPE timeout);
+void os_queue_commit(struct os_queue_t *q, void *data, BASE_TYPE len);
+void *os_queue_peek(struct os_queue_t *q, BASE_TYPE flags, BASE_TYPE timeout, BASE_TYPE *len);
+void os_queue_release(struct os_queue_t *q, void *data);
+
+/* add message to queue without waiting, may be used from ISR */
+#define os_queue_post(q, data, len)   os_queue_add(q, OS_FLAG_NOWAIT, 0, data, len)
+#endif
@@ -0,0 +1,246 @@
+/*
+ *     Yet another operating system for microcontrollers.
+ *     Recursive mutexes with owner and priority inheritance.
+ *
+ * Copyright (c) 2013, Dmitry Kobylin
+ * All rights reserved.
+ * 
+ * Redistribution and use in source and binary forms, with or without
+ * modification, are permitted provided that the following conditions are met: 
+ * 
+ * 1. Redistributions of source code must retain the above copyright notice, this
+ *    list of conditions and the following disclaimer. 
+ * 2. Redistributions in binary form must reproduce the above copyright notice,
+ *    this list of conditions and the following disclaimer in the documentation
+ *    and/or other materials provided with the distribution. 
+ * 
+ * THIS SOFTWARE IS PROVIDED BY THE COPYRIGHT HOLDERS AND CONTRIBUTORS "AS IS" AND
+ * ANY EXPRESS OR IMPLIED WARRANTIES, INCLUDING, BUT NOT LIMITED TO, THE IMPLIED
+ * WARRANTIES OF MERCHANTABILITY AND FITNESS FOR A PARTICULAR PURPOSE ARE
+ * DISCLAIMED. IN NO EVENT SHALL THE COPYRIGHT OWNER OR CONTRIBUTORS BE LIABLE FOR
+ * ANY DIRECT, INDIRECT, INCIDENTAL, SPECIAL, EXEMPLARY, OR CONSEQUENTIAL DAMAGES
+ * (INCLUDING, BUT NOT LIMITED TO, PROCUREMENT OF SUBSTITUTE GOODS OR SERVICES;
+ * LOSS OF USE, DATA, OR PROFITS; OR BUSINESS INTERRUPTION) HOWEVER CAUSED AND
+ * ON ANY THEORY OF LIABILITY, WHETHER IN CONTRACT, STRICT LIABILITY, OR TORT
+ * (INCLUDING NEGLIGENCE OR OTHERWISE) ARISING IN ANY WAY OUT OF THE USE OF THIS
+ * SOFTWARE, EVEN IF ADVISED OF THE POSSIBILITY OF SUCH DAMAGE.
+ * 
+ *
+ * Mutex is owned by task that locked it and may be locked by owner again,
+ * mutex is unlocked when os_rmutex_unlock() called as many times as it was
+ * locked. On unlock mutex is passed directly to highest priority waiter, so
+ * other task can not take mutex before waked task starts.
+ *
+ * If OS_CONFIG_USE_PRIORITY defined then owner of mutex inherits priority
+ * of tasks waiting for it (and passes it further if owner waits for other
+ * mutex itself). Priority is restored when owner unlocks mutex.
+ *
+ * NOTE priority of owner is not lowered if waiter leaves by timeout, it is
+ *      restored on unlock only.
+ */
+#include "os_private.h"
+#include "os_rmutex.h"
+#include "os_sched.h"
+#include "os_flags.h"
+
+#ifdef OS_CONFIG_USE_RMUTEX
+
+/*
+ * make task owner of mutex
+ *
+ * NOTE this funciton should be call during interrupts disabled
+ */
+STATIC void os_rmutex_take(struct os_rmutex_t *m, volatile struct os_taskcb_t *task)
+{
+    m->owner     = task;
+    m->count     = 1;
+    m->next      = task->rmutex;
+    task->rmutex = m;
+}
+
+#ifdef OS_CONFIG_USE_PRIORITY
+/*
+ * Raise priority of owner of mutex to priority of current task. If owner
+ * waits for other mutex then raise priority of owner of that mutex too.
+ *
+ * NOTE this funciton should be call during interrupts disabled
+ */
+STATIC void os_rmutex_inherit(struct os_rmutex_t *m)
+{
+    volatile struct os_taskcb_t *owner;
+    BASE_TYPE priority;
+
+    priority = os_current_taskcb->priority;
+    owner    = m->owner;
+    while (owner != NULL && owner->priority > priority)
+    {
+        os_sched_set_priority(owner, priority);
+        if (!owner->waiting || owner->lock.state != OS_TASK_STATE_LOCKED_RMUTEX)
+            break;
+        owner = ((struct os_rmutex_t*)owner->lock.pobj)->owner;
+    }
+}
+
+/*
+ * Set priority of task to base priority or to priority of highest waiter
+ * of mutexes held by task.
+ *
+ * NOTE this funciton should be call during interrupts disabled
+ */
+STATIC void os_rmutex_restore(volatile struct os_taskcb_t *task)
+{
+    volatile struct os_taskcb_t *waiter;
+    struct os_rmutex_t *m;
+    BASE_TYPE priority;
+
+    priority = task->bpriority;
+    for (m = task->rmutex; m != NULL; m = m->next)
+    {
+        waiter = os_sched_waiter(m);
+        if (waiter != NULL && waiter->priority < priority)
+            priority = waiter->priority;
+    }
+    os_sched_set_priority(task, priority);
+}
+#endif /* OS_CONFIG_USE_PRIORITY */
+
+/*
+ * initialize mutex
+ */
+void os_rmutex_init(struct os_rmutex_t *m)
+{
+    m->owner = NULL;
+    m->count = 0;
+    m->next  = NULL;
+}
+
+/*
+ * lock mutex
+ *
+ * ARGS
+ *     m           pointer to mutex
+ *     flags       
+ *                 OS_FLAG_NONE      no flag specified
+ *                 OS_FLAG_NOWAIT    don't wait if mutex is locked by other task,
+ *                                   return immediately with OS_ERR_WOULDLOCK error code
+ *
+ *     timeout     if specified wait with timeout for mutex unlock
+ *
+ * NOTE
+ *     * should not be called from ISR
+ *
+ * RETURN
+ *     OS_ERR_NONE       if mutex locked
+ *     OS_ERR_TIMEOUT    timeout occured before mutex was unlocked
+ *     OS_ERR_WOULDLOCK  mutex was locked but OS_FLAG_NOWAIT was specified
+ */
+BASE_TYPE os_rmutex_lock(struct os_rmutex_t *m, BASE_TYPE flags, BASE_TYPE timeout)
+{
+    OS_DISABLE_IRQ();
+    if (m->owner == os_current_taskcb)
+    {
+        /* nested lock */
+        m->count++;
+        OS_ENABLE_IRQ();
+        return OS_ERR_NONE;
+    }
+
+    while (1)
+    {
+        if (m->owner == NULL)
+        {
+            os_rmutex_take(m, os_current_taskcb);
+            OS_ENABLE_IRQ();
+            OS_TRACE(OS_TRACE_MUTEX_LOCK, 0, m);
+            return OS_ERR_NONE;
+        }
+        if (flags & OS_FLAG_NOWAIT)
+        {
+            OS_ENABLE_IRQ();
+            return OS_ERR_WOULDLOCK;
+        }
+#ifdef OS_CONFIG_USE_PRIORITY
+        os_rmutex_inherit(m);
+#endif
+        OS_ENABLE_IRQ();
+
+        timeout = os_lock_task(OS_TASK_STATE_LOCKED_RMUTEX, m, 0, timeout);
+
+        OS_DISABLE_IRQ();
+        /* 
+         * NOTE mutex could be passed to task by os_rmutex_unlock() just
+         * before timeout expired
+         */
+        if (m->owner == os_current_taskcb)
+        {
+            OS_ENABLE_IRQ();
+            OS_TRACE(OS_TRACE_MUTEX_LOCK, 0, m);
+            return OS_ERR_NONE;
+        }
+        if (timeout == OS_TIMEOUT_EXPIRED)
+        {
+            OS_ENABLE_IRQ();
+            return OS_ERR_TIMEOUT;
+        }
+    }
+}
+
+/*
+ * unlock mutex
+ *
+ * NOTE
+ *     * should be called by owner of mutex
+ *     * should not be called from ISR
+ */
+void os_rmutex_unlock(struct os_rmutex_t *m)
+{
+    volatile struct os_taskcb_t *task;
+    struct os_rmutex_t **pm;
+
+    OS_DISABLE_IRQ();
+    {
+        if (m->owner != os_current_taskcb)
+        {
+#ifdef OS_CONFIG_TRAP_RMUTEX
+            os_trapinfo.err = OS_TRAP_ERR_RMUTEX_OWNER;
+            os_trap();
+#endif
+            OS_ENABLE_IRQ();
+            return;
+        }
+        if (--m->count)
+        {
+            OS_ENABLE_IRQ();
+            return;
+        }
+
+        OS_TRACE(OS_TRACE_MUTEX_UNLOCK, 0, m);
+
+        /* remove mutex from list of mutexes held by task */
+        pm = (struct os_rmutex_t **)&os_current_taskcb->rmutex;
+        while (*pm != m)
+            pm = &(*pm)->next;
+        *pm = m->next;
+
+        /* pass mutex to highest priority waiter */
+        task = os_sched_waiter(m);
+        if (task != NULL)
+        {
+            os_sched_wake_task(task);
+            os_rmutex_take(m, task);
+#ifdef OS_CONFIG_USE_PRIORITY
+            os_rmutex_restore(task);
+#endif
+        } else {
+            m->owner = NULL;
+        }
+#ifdef OS_CONFIG_USE_PRIORITY
+        os_rmutex_restore(os_current_taskcb);
+#endif
+        if (task != NULL)
+            os_sched_suspend_task();
+    }
+    OS_ENABLE_IRQ();
+}
+
+#endif /* OS_CONFIG_USE_RMUTEX */
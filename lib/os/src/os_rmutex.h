@@ -0,0 +1,47 @@
+/*
+ *     Yet another operating system for microcontrollers.
+ *     Recursive mutexes with owner and priority inheritance.
+ *
+ * Copyright (c) 2013, Dmitry Kobylin
+ * All rights reserved.
+ * 
+ * Redistribution and use in source and binary forms, with or without
+ * modification, are permitted provided that the following conditions are met: 
+ * 
+ * 1. Redistributions of source code must retain the above copyright notice, this
+ *    list of conditions and the following disclaimer. 
+ * 2. Redistributions in binary form must reproduce the above copyright notice,
+ *    this list of conditions and the following disclaimer in the documentation
+ *    and/or other materials provided with the distribution. 
+ * 
+ * THIS SOFTWARE IS PROVIDED BY THE COPYRIGHT HOLDERS AND CONTRIBUTORS "AS IS" AND
+ * ANY EXPRESS OR IMPLIED WARRANTIES, INCLUDING, BUT NOT LIMITED TO, THE IMPLIED
+ * WARRANTIES OF MERCHANTABILITY AND FITNESS FOR A PARTICULAR PURPOSE ARE
+ * DISCLAIMED. IN NO EVENT SHALL THE COPYRIGHT OWNER OR CONTRIBUTORS BE LIABLE FOR
+ * ANY DIRECT, INDIRECT, INCIDENTAL, SPECIAL, EXEMPLARY, OR CONSEQUENTIAL DAMAGES
+ * (INCLUDING, BUT NOT LIMITED TO, PROCUREMENT OF SUBSTITUTE GOODS OR SERVICES;
+ * LOSS OF USE, DATA, OR PROFITS; OR BUSINESS INTERRUPTION) HOWEVER CAUSED AND
+ * ON ANY THEORY OF LIABILITY, WHETHER IN CONTRACT, STRICT LIABILITY, OR TORT
+ * (INCLUDING NEGLIGENCE OR OTHERWISE) ARISING IN ANY WAY OUT OF THE USE OF THIS
+ * SOFTWARE, EVEN IF ADVISED OF THE POSSIBILITY OF SUCH DAMAGE.
+ * 
+ */
+#ifndef OS_RMUTEX_H
+#define OS_RMUTEX_H
+
+#include <types.h>
+
+/*
+ * NOTE zero filled structure is unlocked mutex
+ */
+struct os_rmutex_t {
+    volatile struct os_taskcb_t *owner; /* task that holds mutex, NULL if mutex is unlocked */
+    BASE_TYPE count;                    /* number of nested locks of owner */
+    struct os_rmutex_t *next;           /* list of mutexes held by owner */
+};
+
+void os_rmutex_init(struct os_rmutex_t *m);
+BASE_TYPE os_rmutex_lock(struct os_rmutex_t *m, BASE_TYPE flags, BASE_TYPE timeout);
+void os_rmutex_unlock(struct os_rmutex_t *m);
+
+#endif /* OS_RMUTEX_H */
@@ -29,11 +29,72 @@
 #include "os_sched.h"
 #include "os_queue.h"
 #include "os_multi.h"
+#include "os_rmutex.h"
 
 #if OS_USE_LOCK
-STATIC volatile struct os_taskcb_t *sqhead; /* pointer to head of scheduler queue */
-STATIC volatile struct os_taskcb_t *sqtail; /* pointer to end of scheduler queue */
-STATIC inline BASE_TYPE os_sched_task_ready(struct os_task_lock_t *lock);
+/*
+ * Tasks that are ready to run are kept in per-priority FIFO lists. Bit of
+ * os_rqmap is set if list of corresponding priority level is not empty (MSB
+ * is level 0, highest priority), so highest ready level obtained with single
+ * CLZ instruction.
+ *
+ * Locked task is placed to wait list of object it waits for (task waiting for
+ * multiple event is placed to wait lists of all objects of multiple event).
+ * Objects are plain words so wait lists are selected by hash of object's
+ * address. When object is signaled os_sched_wake() moves waiters of this
+ * object only to ready lists. Task locked by os_wait() is not placed to any
+ * wait list, it is waked by os_sched_wake_task() when timeout expired.
+ *
+ * Tasks of deadline class (os_deadline_set()) with active job are kept in
+ * separate list sorted by absolute deadline, this list is served before
+ * ready lists of priorities (EDF). Job of such task is released when task
+ * wakes after os_deadline_end() and ends by next os_deadline_end(). If job
+ * exhausts it's budget it is scheduled by priority of task until it ends.
+ *
+ * NOTE current task is not in any list while it is running
+ */
+#ifdef OS_CONFIG_USE_PRIORITY
+    #define OS_SCHED_LEVELS          32
+    /* priorities above lowest level share lowest level */
+    #define OS_SCHED_LEVEL(task)     ((uint32)(task)->priority < OS_SCHED_LEVELS ? (task)->priority : OS_SCHED_LEVELS - 1)
+#else
+    #define OS_SCHED_LEVELS          1
+    #define OS_SCHED_LEVEL(task)     0
+#endif
+#define OS_SCHED_LEVEL_BIT(level)    (0x80000000 >> (level))
+
+STATIC uint32 os_rqmap OS_FASTBSS;                                       /* map of not empty ready lists */
+STATIC volatile struct os_taskcb_t *rqhead[OS_SCHED_LEVELS] OS_FASTBSS;  /* heads of ready lists */
+STATIC volatile struct os_taskcb_t *rqtail[OS_SCHED_LEVELS] OS_FASTBSS;  /* tails of ready lists */
+#define OS_WAITQ_SIZE                16 /* number of wait lists, should be power of two */
+#define OS_WAITQ_HASH(pobj)          ((((uint32)(pobj)) >> 2) & (OS_WAITQ_SIZE - 1))
+
+STATIC struct os_task_lock_t *wqhead[OS_WAITQ_SIZE];               /* heads of wait lists */
+STATIC struct os_task_lock_t *wqtail[OS_WAITQ_SIZE];               /* tails of wait lists */
+STATIC BASE_TYPE wqcount;                                          /* number of locked tasks in wait lists */
+#ifdef OS_CONFIG_USE_DEADLINE
+/* task is scheduled by deadline */
+#define OS_DL_READY(task)    ((task)->dl.period && (task)->dl.state == OS_DEADLINE_ACTIVE)
+
+STATIC volatile struct os_taskcb_t *dqhead;                        /* head of list of deadline class sorted by deadline */
+#endif
+static inline BASE_TYPE os_sched_task_ready(struct os_task_lock_t *lock);
+#endif
+
+#if OS_USE_TIMEOUT
+/*
+ * Tasks locked with timeout are kept in list sorted by deadline, so only
+ * head of list is checked on tick (or alarm in tickless mode). Time is
+ * counted in ticks, or in microseconds of application's clock in tickless
+ * mode.
+ */
+STATIC volatile struct os_taskcb_t *tqhead; /* head of list of tasks sorted by deadline */
+STATIC void os_timeq_put(volatile struct os_taskcb_t *task, BASE_TYPE timeout);
+STATIC void os_timeq_remove(volatile struct os_taskcb_t *task);
+#endif
+
+#ifdef OS_CONFIG_USE_SCHEDSTAT
+struct os_schedstat_t os_schedstat;
 #endif
 
 #if (OS_USE_LOCK)
@@ -67,6 +128,10 @@ BASE_TYPE os_lock_task(BASE_TYPE type, void *pobj, BASE_TYPE mask, BASE_TYPE tim
         os_current_taskcb->lock.state   = type;
         os_current_taskcb->lock.pobj    = pobj;
         os_current_taskcb->lock.mask    = mask;
+#if OS_USE_TIMEOUT
+        if (timeout)
+            os_timeq_put(os_current_taskcb, timeout);
+#endif
 #ifdef OS_CONFIG_USE_TASK_SLICE
         /* task was locked, respawn it's time slice */
         os_respawn_tslice(os_current_taskcb);
@@ -86,6 +151,16 @@ BASE_TYPE os_lock_task(BASE_TYPE type, void *pobj, BASE_TYPE mask, BASE_TYPE tim
         DEBUG_OS_HEX_WRAP(", state = ", &os_current_taskcb->state, 4);
 #endif
         ret                = os_current_taskcb->timeout;
+#if OS_USE_TIMEOUT
+        if (ret != 0 && ret != OS_TIMEOUT_EXPIRED)
+        {
+            /* task was unlocked before timeout expired, return remaining time */
+            os_timeq_remove(os_current_taskcb);
+            ret = os_current_taskcb->deadline - OS_TIME();
+            if (ret <= 0)
+                ret = 1;
+        }
+#endif
         os_current_taskcb->timeout      = 0; /* NOTE */
         os_current_taskcb->lock.state   = OS_TASK_STATE_RUN;
     }
@@ -94,62 +169,604 @@ BASE_TYPE os_lock_task(BASE_TYPE type, void *pobj, BASE_TYPE mask, BASE_TYPE tim
     return ret;
 }
 
+#ifdef OS_CONFIG_USE_DEADLINE
+/*
+ * Insert task to list of deadline class after tasks with the same or
+ * earlier deadline.
+ */
+STATIC void os_dqueue_put(volatile struct os_taskcb_t *task)
+{
+    volatile struct os_taskcb_t *pt;
+    volatile struct os_taskcb_t *prev;
+
+    prev = NULL;
+    for (pt = dqhead; pt != NULL; pt = pt->next)
+    {
+        if (OS_TIME_BEFORE(task->dl.deadline, pt->dl.deadline))
+            break;
+        prev = pt;
+    }
+
+    task->next = pt;
+    if (prev)
+        prev->next = task;
+    else
+        dqhead = task;
+}
+
+/*
+ * Release job of task.
+ *
+ * ARGS
+ *     time    time of release
+ */
+STATIC void os_deadline_release(volatile struct os_taskcb_t *task, BASE_TYPE time)
+{
+    task->dl.state    = OS_DEADLINE_ACTIVE;
+    task->dl.release  = time;
+    task->dl.deadline = time + task->dl.period;
+    task->dl.used     = 0;
+}
+
+/*
+ * Charge CPU time to job of task that is switched out, throttle job if it
+ * exhausted budget.
+ *
+ * ARGS
+ *     ready    task stays ready to run (did not block)
+ *     now      current time
+ */
+STATIC void os_deadline_charge(volatile struct os_taskcb_t *task, BASE_TYPE ready, BASE_TYPE now)
+{
+    if (task->dl.period == 0)
+        return;
+
+    if (task->dl.state == OS_DEADLINE_IDLE)
+    {
+        if (!ready)
+            return;
+        /* task did not block after end of job, next job released at that moment */
+        os_deadline_release(task, task->dl.start);
+    }
+
+    task->dl.used += now - task->dl.start;
+    if (task->dl.state == OS_DEADLINE_ACTIVE && task->dl.budget &&
+        task->dl.used >= task->dl.budget)
+    {
+        task->dl.state = OS_DEADLINE_THROTTLED;
+        task->dl.overruns++;
+    }
+}
+#endif /* OS_CONFIG_USE_DEADLINE */
+
+/*
+ * Add task to tail of ready list of it's priority.
+ */
+OS_RAMFUNC STATIC void os_rqueue_put(volatile struct os_taskcb_t *task)
+{
+    BASE_TYPE level;
+
+#ifdef OS_CONFIG_USE_DEADLINE
+    if (OS_DL_READY(task))
+    {
+        os_dqueue_put(task);
+        return;
+    }
+#endif
+    level = OS_SCHED_LEVEL(task);
+
+    task->next = NULL;
+    if (rqhead[level] == NULL)
+    {
+        rqhead[level] = task;
+        os_rqmap |= OS_SCHED_LEVEL_BIT(level);
+    } else {
+        rqtail[level]->next = task;
+    }
+    rqtail[level] = task;
+}
+
+/*
+ * Remove task from head of highest priority ready list.
+ *
+ * RETURN
+ *     pointer to task, NULL if there is no ready task
+ */
+OS_RAMFUNC STATIC volatile struct os_taskcb_t *os_rqueue_get()
+{
+    volatile struct os_taskcb_t *task;
+    BASE_TYPE level;
+
+#ifdef OS_CONFIG_USE_DEADLINE
+    if (dqhead)
+    {
+        task   = dqhead;
+        dqhead = task->next;
+        return task;
+    }
+#endif
+    if (os_rqmap == 0)
+        return NULL;
+
+    level = PORT_CLZ(os_rqmap);
+    task  = rqhead[level];
+#ifdef OS_CONFIG_TRAP_SCHEDQ
+    if (task == NULL)
+    {
+        os_trapinfo.err = OS_TRAP_ERR_SCHEDQ_EMPTY_QUEUE;
+        os_trap();
+    }
+#endif
+    rqhead[level] = task->next;
+    if (rqhead[level] == NULL)
+        os_rqmap &= ~OS_SCHED_LEVEL_BIT(level);
+
+    return task;
+}
+
+#ifdef OS_CONFIG_USE_PRIORITY
+/*
+ * Remove task from ready list of it's priority.
+ */
+OS_RAMFUNC STATIC void os_rqueue_remove(volatile struct os_taskcb_t *task)
+{
+    volatile struct os_taskcb_t *pt;
+    volatile struct os_taskcb_t *prev;
+    BASE_TYPE level;
+
+    level = OS_SCHED_LEVEL(task);
+
+    prev = NULL;
+    for (pt = rqhead[level]; pt != NULL; pt = pt->next)
+    {
+        if (pt == task)
+            break;
+        prev = pt;
+    }
+    if (pt == NULL)
+        return;
+
+    if (prev)
+        prev->next = task->next;
+    else
+        rqhead[level] = task->next;
+    if (rqtail[level] == task)
+        rqtail[level] = prev;
+    if (rqhead[level] == NULL)
+        os_rqmap &= ~OS_SCHED_LEVEL_BIT(level);
+}
+#endif
+
+/*
+ * Add lock to tail of wait list of it's object.
+ */
+STATIC void os_waitq_link(volatile struct os_taskcb_t *task, struct os_task_lock_t *lock)
+{
+    BASE_TYPE h;
+
+    h = OS_WAITQ_HASH(lock->pobj);
+
+    lock->task  = task;
+    lock->wnext = NULL;
+    lock->wprev = wqtail[h];
+    if (wqtail[h])
+        wqtail[h]->wnext = lock;
+    else
+        wqhead[h] = lock;
+    wqtail[h] = lock;
+}
+
+/*
+ * Remove lock from wait list of it's object.
+ */
+STATIC void os_waitq_unlink(struct os_task_lock_t *lock)
+{
+    BASE_TYPE h;
+
+    h = OS_WAITQ_HASH(lock->pobj);
+
+    if (lock->wprev)
+        lock->wprev->wnext = lock->wnext;
+    else
+        wqhead[h] = lock->wnext;
+    if (lock->wnext)
+        lock->wnext->wprev = lock->wprev;
+    else
+        wqtail[h] = lock->wprev;
+}
+
+/*
+ * Place locked task to wait lists of objects it waits for.
+ */
+STATIC void os_waitq_put(volatile struct os_taskcb_t *task)
+{
+    struct os_task_lock_t *lock;
+#ifdef OS_CONFIG_USE_MULTI
+    struct os_multi_event_t *multi;
+    BASE_TYPE n;
+#endif
+
+    lock = (struct os_task_lock_t*)&task->lock;
+    switch (lock->state)
+    {
+        case OS_TASK_STATE_LOCKED_WAIT:
+            /* only timeout can unlock task */
+            break;
+#ifdef OS_CONFIG_USE_MULTI
+        case OS_TASK_STATE_LOCKED_MULTI:
+            multi = (struct os_multi_event_t *)lock->pobj;
+            for (n = 0; n < multi->n; n++)
+                os_waitq_link(task, &multi->events[n]);
+            break;
+#endif
+        default:
+            os_waitq_link(task, lock);
+            break;
+    }
+    task->waiting = 1;
+    wqcount++;
+}
+
+/*
+ * Remove locked task from wait lists.
+ */
+STATIC void os_waitq_remove(volatile struct os_taskcb_t *task)
+{
+    struct os_task_lock_t *lock;
+#ifdef OS_CONFIG_USE_MULTI
+    struct os_multi_event_t *multi;
+    BASE_TYPE n;
+#endif
+
+    lock = (struct os_task_lock_t*)&task->lock;
+    switch (lock->state)
+    {
+        case OS_TASK_STATE_LOCKED_WAIT:
+            break;
+#ifdef OS_CONFIG_USE_MULTI
+        case OS_TASK_STATE_LOCKED_MULTI:
+            multi = (struct os_multi_event_t *)lock->pobj;
+            for (n = 0; n < multi->n; n++)
+                os_waitq_unlink(&multi->events[n]);
+            break;
+#endif
+        default:
+            os_waitq_unlink(lock);
+            break;
+    }
+    task->waiting = 0;
+    wqcount--;
+#ifdef OS_CONFIG_USE_DEADLINE
+    /* task wakes, release next job */
+    if (task->dl.period && task->dl.state == OS_DEADLINE_IDLE)
+        os_deadline_release(task, OS_TIME());
+#endif
+}
+
 /*
  * Add task to scheduler queue.
  */
 void os_squeue_addtask(volatile struct os_taskcb_t *task)
 {
-    if (sqhead == NULL)
+    os_rqueue_put(task);
+}
+
+/*
+ * Move tasks waiting for object which lock condition is accomplished to
+ * ready lists. Should be called after state of object was changed.
+ *
+ * Only one waiter is waked for each unlocked mutex bit, other waiters stay
+ * in wait list until next unlock.
+ *
+ * NOTE this funciton should be call during interrupts disabled
+ *
+ * ARGS
+ *     pobj    pointer to object (mutex/event word, queue)
+ */
+OS_RAMFUNC void os_sched_wake(void *pobj)
+{
+    struct os_task_lock_t *lock;
+    struct os_task_lock_t *next;
+    volatile struct os_taskcb_t *task;
+    BASE_TYPE taken;
+
+    taken = 0;
+    for (lock = wqhead[OS_WAITQ_HASH(pobj)]; lock != NULL; lock = next)
     {
-        sqhead = task;
-        sqtail = task;
-    } else {
-        task->prev   = sqtail;
-        task->next   = NULL;
-        sqtail->next = task;
-        sqtail       = task;
+        next = lock->wnext;
+        if (lock->pobj != pobj)
+            continue;
+#ifdef OS_CONFIG_USE_MUTEX
+        if (lock->state == OS_TASK_STATE_LOCKED_MUTEX && (lock->mask & taken))
+            continue;
+#endif
+        task = lock->task;
+        if (!os_sched_task_ready((struct os_task_lock_t*)&task->lock))
+            continue;
+#ifdef OS_CONFIG_USE_MUTEX
+        if (lock->state == OS_TASK_STATE_LOCKED_MUTEX)
+            taken |= lock->mask;
+#endif
+        os_waitq_remove(task);
+        os_rqueue_put(task);
+        OS_TRACE(OS_TRACE_WAKE, task - os_tasks, pobj);
+#ifdef OS_CONFIG_USE_MULTI
+        /* next entry can belong to the same multiple event, start over */
+        if (task->lock.state == OS_TASK_STATE_LOCKED_MULTI)
+            next = wqhead[OS_WAITQ_HASH(pobj)];
+#endif
     }
 }
 
 /*
- * move task to tail of queue (last task that will be checked by scheduler)
+ * Check if there are tasks in wait list of object (or of other objects with
+ * the same hash).
+ *
+ * NOTE May be called with interrupts enabled. Scheduler checks condition
+ *      of lock and places task to wait list with interrupts disabled, so if
+ *      state of object was changed before this check then either task is
+ *      already in wait list or it will not be placed there.
+ *
+ * ARGS
+ *     pobj    pointer to object (mutex/event word, queue)
+ */
+BASE_TYPE os_sched_waiting(void *pobj)
+{
+    return wqhead[OS_WAITQ_HASH(pobj)] != NULL;
+}
+
+/*
+ * Find task with highest priority in wait list of object (first of tasks
+ * with equal priority).
+ *
+ * NOTE this funciton should be call during interrupts disabled
+ *
+ * RETURN
+ *     pointer to task, NULL if there is no task waiting for object
  */
-void os_squeue_task2tail(volatile struct os_taskcb_t *task)
+volatile struct os_taskcb_t *os_sched_waiter(void *pobj)
 {
-    /* nothing to do if task already in tail */
-    if (task == sqtail)
+    struct os_task_lock_t *lock;
+    volatile struct os_taskcb_t *task;
+
+    task = NULL;
+    for (lock = wqhead[OS_WAITQ_HASH(pobj)]; lock != NULL; lock = lock->wnext)
+    {
+        if (lock->pobj != pobj)
+            continue;
+#ifdef OS_CONFIG_USE_PRIORITY
+        if (task == NULL || lock->task->priority < task->priority)
+            task = lock->task;
+#else
+        return lock->task;
+#endif
+    }
+    return task;
+}
+
+#ifdef OS_CONFIG_USE_PRIORITY
+/*
+ * Change priority of task. Task is moved to ready list of new priority if
+ * it is ready to run.
+ *
+ * NOTE this funciton should be call during interrupts disabled
+ */
+void os_sched_set_priority(volatile struct os_taskcb_t *task, BASE_TYPE priority)
+{
+    if (task->priority == priority)
         return;
 
-    if (task == sqhead)
+#ifdef OS_CONFIG_USE_DEADLINE
+    if (task == os_current_taskcb || task->waiting || OS_DL_READY(task))
+#else
+    if (task == os_current_taskcb || task->waiting)
+#endif
     {
-        sqhead = sqhead->next;
-        sqhead->prev = NULL;
+        /* task is not in ready list of priority */
+        task->priority = priority;
     } else {
-        task->prev->next = task->next;
-        task->next->prev = task->prev;
+        os_rqueue_remove(task);
+        task->priority = priority;
+        os_rqueue_put(task);
     }
+}
+#endif
 
-    sqtail->next = task;
-    task->prev   = sqtail;
-    task->next   = NULL;
-    sqtail       = task;
+/*
+ * Move locked task to ready list (timeout of task expired).
+ *
+ * NOTE this funciton should be call during interrupts disabled
+ */
+OS_RAMFUNC void os_sched_wake_task(volatile struct os_taskcb_t *task)
+{
+    if (task->waiting)
+    {
+        os_waitq_remove(task);
+        os_rqueue_put(task);
+        OS_TRACE(OS_TRACE_WAKE, task - os_tasks, NULL);
+    }
 }
 
+#if OS_USE_TIMEOUT
+#ifdef OS_CONFIG_TICKLESS
 /*
- * suspend current task execution
+ * Set alarm to deadline of first task in list (or to expiration of first
+ * timer if it is earlier).
  *
  * NOTE this funciton should be call during interrupts disabled
  */
-void os_sched_suspend_task()
+OS_RAMFUNC void os_sched_alarm()
+{
+    BASE_TYPE alarm;
+#ifdef OS_CONFIG_USE_TIMER
+    BASE_TYPE expire;
+#endif
+
+    if (tqhead)
+        alarm = tqhead->deadline;
+    else
+        alarm = osw_clock_time() + (BASE_TYPE_MAX >> 1); /* NOTE maximum time ahead */
+#ifdef OS_CONFIG_USE_TIMER
+    if (os_timer_next(&expire) && OS_TIME_BEFORE(expire, alarm))
+        alarm = expire;
+#endif
+#ifdef OS_CONFIG_USE_DEADLINE
+    /* current job exhausts budget earlier */
+    if (OS_DL_READY(os_current_taskcb) && os_current_taskcb->dl.budget)
+    {
+        BASE_TYPE exhaust;
+
+        exhaust = os_current_taskcb->dl.start + os_current_taskcb->dl.budget - os_current_taskcb->dl.used;
+        if (OS_TIME_BEFORE(exhaust, alarm))
+            alarm = exhaust;
+    }
+#endif
+    osw_clock_alarm(alarm);
+}
+#endif
+
+/*
+ * Add task to list of tasks with timeout.
+ *
+ * ARGS
+ *     timeout    time to wait (in ticks or in microseconds in tickless mode)
+ */
+OS_RAMFUNC STATIC void os_timeq_put(volatile struct os_taskcb_t *task, BASE_TYPE timeout)
 {
-#ifdef OS_CONFIG_USE_PRIORITY
     volatile struct os_taskcb_t *pt;
+    volatile struct os_taskcb_t *prev;
+
+    task->deadline = OS_TIME() + timeout;
+
+    prev = NULL;
+    for (pt = tqhead; pt != NULL; pt = pt->tnext)
+    {
+        if (OS_TIME_BEFORE(task->deadline, pt->deadline))
+            break;
+        prev = pt;
+    }
+
+    task->tprev = prev;
+    task->tnext = pt;
+    if (pt)
+        pt->tprev = task;
+    if (prev)
+    {
+        prev->tnext = task;
+    } else {
+        tqhead = task;
+#ifdef OS_CONFIG_TICKLESS
+        /* task has nearest deadline */
+        os_sched_alarm();
+#endif
+    }
+}
+
+/*
+ * Remove task from list of tasks with timeout.
+ */
+OS_RAMFUNC STATIC void os_timeq_remove(volatile struct os_taskcb_t *task)
+{
+    if (task->tprev)
+        task->tprev->tnext = task->tnext;
+    else
+        tqhead = task->tnext;
+    if (task->tnext)
+        task->tnext->tprev = task->tprev;
+    /* NOTE alarm is not changed if first task was removed, it fires earlier */
+}
+
+/*
+ * Expire timeouts of tasks which deadline has come, move these tasks to
+ * ready lists.
+ *
+ * NOTE this funciton should be call during interrupts disabled
+ *
+ * RETURN
+ *     number of tasks with expired timeout (plus one if job of current task
+ *     exhausted budget)
+ */
+OS_RAMFUNC BASE_TYPE os_sched_timeout()
+{
+    volatile struct os_taskcb_t *task;
+    BASE_TYPE now;
+    BASE_TYPE n;
+
+    now = OS_TIME();
+    n   = 0;
+    while (tqhead && !OS_TIME_BEFORE(now, tqhead->deadline))
+    {
+        task   = tqhead;
+        tqhead = task->tnext;
+        if (tqhead)
+            tqhead->tprev = NULL;
+
+        task->timeout = OS_TIMEOUT_EXPIRED;
+        os_sched_wake_task(task);
+        n++;
+    }
+#ifdef OS_CONFIG_USE_DEADLINE
+    /* current job exhausted budget, it should be switched out to throttle it */
+    if (OS_DL_READY(os_current_taskcb) && os_current_taskcb->dl.budget &&
+        (now - os_current_taskcb->dl.start) + os_current_taskcb->dl.used >= os_current_taskcb->dl.budget)
+        n++;
+#endif
+#ifdef OS_CONFIG_TICKLESS
+    os_sched_alarm();
 #endif
+    return n;
+}
+#endif /* OS_USE_TIMEOUT */
+
+#ifdef OS_CONFIG_USE_DEADLINE
+/*
+ * Check if current task of deadline class should be switched out: job
+ * exhausted budget or there is ready job with earlier deadline.
+ */
+STATIC BASE_TYPE os_deadline_preempt()
+{
+    volatile struct os_taskcb_t *task;
+
+    task = os_current_taskcb;
+    if (task->dl.budget && (OS_TIME() - task->dl.start) + task->dl.used >= task->dl.budget)
+        return 1;
+    return dqhead && OS_TIME_BEFORE(dqhead->dl.deadline, task->dl.deadline);
+}
+#endif
+
+/*
+ * suspend current task execution
+ *
+ * NOTE this funciton should be call during interrupts disabled
+ */
+OS_RAMFUNC void os_sched_suspend_task()
+{
     if (os_current_taskcb == OS_IDLE_TASKCB)
     {
-        /* IDLE task not in scheduler queue switch it simply */
-        os_task_switch();
+        /* IDLE task not in scheduler queue, switch it if there is ready task */
+#ifdef OS_CONFIG_USE_DEADLINE
+        if (os_rqmap || dqhead)
+#else
+        if (os_rqmap)
+#endif
+            os_task_switch();
     } else {
+#ifdef OS_CONFIG_USE_DEADLINE
+        /* 
+         * Task of deadline class preempts other tasks, job of deadline
+         * class is preempted by earlier deadline only.
+         */
+        if (OS_DL_READY(os_current_taskcb) || dqhead)
+        {
+            if (os_current_taskcb->lock.state == OS_TASK_STATE_RUN &&
+                (!OS_DL_READY(os_current_taskcb) || os_deadline_preempt()))
+            {
+                os_current_taskcb->lock.state = OS_TASK_STATE_SUSPEND;
+                os_task_switch();
+            }
+            return;
+        }
+#endif
         /* 
          * This function can be called from ISR (os_tick() or other ISR
          * with os_event_raise()). State of task must be set to suspend
@@ -157,31 +774,14 @@ void os_sched_suspend_task()
          */
 #ifdef OS_CONFIG_USE_PRIORITY
         /* 
-         * Check priority of current task.
+         * Suspend current task if there is ready task with
+         * the same or higher priority.
          */
-        if (os_current_taskcb->lock.state == OS_TASK_STATE_RUN)
+        if (os_current_taskcb->lock.state == OS_TASK_STATE_RUN &&
+            os_rqmap && PORT_CLZ(os_rqmap) <= OS_SCHED_LEVEL(os_current_taskcb))
         {
-            for (pt = sqhead; pt != NULL; pt = pt->next)
-            {
-                /* don't check current task for priority */
-                if (pt == os_current_taskcb)
-                    continue;
-
-                if (pt->lock.state == OS_TASK_STATE_SUSPEND ||
-                    os_sched_task_ready((struct os_task_lock_t*)&pt->lock))
-                {
-                    /* 
-                     * Suspend current task if there is ready task with
-                     * the same or higher priority in the queue.
-                     */
-                    if (pt->priority <= os_current_taskcb->priority)
-                    {
-                        os_current_taskcb->lock.state = OS_TASK_STATE_SUSPEND;
-                        os_task_switch();
-                        return;
-                    }
-                }
-            }
+            os_current_taskcb->lock.state = OS_TASK_STATE_SUSPEND;
+            os_task_switch();
         }
 #else
         if (os_current_taskcb->lock.state == OS_TASK_STATE_RUN)
@@ -192,11 +792,96 @@ void os_sched_suspend_task()
 #endif
     }
 }
+
+#ifdef OS_CONFIG_USE_DEADLINE
+/*
+ * Place current task to deadline class or remove it from class. Job is
+ * released immediately if task was not in class.
+ *
+ * ARGS
+ *     period    relative deadline of each job, zero - remove task from class
+ *     budget    CPU time allowed to each job, zero - not limited
+ *
+ * NOTE
+ *     * OS_MS2TICK() and OS_US2TICK() macro should be used to specify
+ *       period and budget
+ *     * should not be called from ISR
+ */
+void os_deadline_set(BASE_TYPE period, BASE_TYPE budget)
+{
+    volatile struct os_taskcb_t *task;
+    BASE_TYPE now;
+
+    OS_DISABLE_IRQ();
+    {
+        task = os_current_taskcb;
+        now  = OS_TIME();
+
+        if (period)
+        {
+            if (task->dl.period == 0 || task->dl.state == OS_DEADLINE_IDLE)
+            {
+                task->dl.period = period;
+                os_deadline_release(task, now);
+                task->dl.start = now;
+            } else {
+                /* change parameters of current job */
+                task->dl.period   = period;
+                task->dl.deadline = task->dl.release + period;
+            }
+            task->dl.budget = budget;
+            os_sched_alarm();
+        } else {
+            task->dl.period = 0;
+            task->dl.state  = OS_DEADLINE_IDLE;
+        }
+        /* jobs of other tasks may preempt */
+        os_sched_suspend_task();
+    }
+    OS_ENABLE_IRQ();
+}
+
+/*
+ * End job of current task. Next job is released when task wakes (or at
+ * this moment if task does not block before it is switched out).
+ *
+ * NOTE should not be called from ISR
+ */
+void os_deadline_end()
+{
+    volatile struct os_taskcb_t *task;
+    BASE_TYPE now;
+    BASE_TYPE t;
+
+    OS_DISABLE_IRQ();
+    {
+        task = os_current_taskcb;
+        if (task->dl.period && task->dl.state != OS_DEADLINE_IDLE)
+        {
+            now = OS_TIME();
+
+            task->dl.used += now - task->dl.start;
+            task->dl.start = now;
+            task->dl.state = OS_DEADLINE_IDLE;
+
+            task->dl.jobs++;
+            if (OS_TIME_BEFORE(task->dl.deadline, now))
+                task->dl.misses++;
+            if (task->dl.used_max < task->dl.used)
+                task->dl.used_max = task->dl.used;
+            t = now - task->dl.release;
+            if (task->dl.resp_max < t)
+                task->dl.resp_max = t;
+        }
+    }
+    OS_ENABLE_IRQ();
+}
+#endif /* OS_CONFIG_USE_DEADLINE */
 #else /* !OS_USE_LOCK */
 /*
  * find next task to task given in argument
  */
-STATIC struct os_taskcb_t* os_task_next(volatile struct os_taskcb_t *task)
+OS_RAMFUNC STATIC struct os_taskcb_t* os_task_next(volatile struct os_taskcb_t *task)
 {
     task++;
     if ((BASE_TYPE)task > ((BASE_TYPE)&os_tasks[os_taskidx - 1]))
@@ -209,98 +894,113 @@ STATIC struct os_taskcb_t* os_task_next(volatile struct os_taskcb_t *task)
 /*
  *
  */
-void os_scheduler()
+OS_RAMFUNC void os_scheduler()
 {
 #if OS_USE_LOCK
     volatile struct os_taskcb_t *pt;
-    volatile struct os_taskcb_t *readytask;
-    volatile struct os_taskcb_t *susptask;
     struct os_task_lock_t *lock;
-#ifdef OS_CONFIG_USE_PRIORITY
-    volatile struct os_taskcb_t *priotask;
+    BASE_TYPE ready;
 #endif
-    /*
-     * Scheduler was called, so task was interrupted for some reason.
-     * Move current task to end of queue.
-     */
-    if (os_current_taskcb != OS_IDLE_TASKCB)
-        os_squeue_task2tail(os_current_taskcb); 
+#ifdef OS_CONFIG_USE_IRQSTAT
+    /* interrupts are masked by PendSV for time of scheduler */
+    static struct os_irqstat_site_t schedsite = {"os_scheduler", 0};
 
-#ifdef DEBUG_OS_PRINT
-    DEBUG_OS_STR("sched chain:\r\n");
-    for (pt = sqhead; pt != NULL; pt = pt->next)
-    {
-        DEBUG_OS_STR("    task "); DEBUG_OS_HEX(&pt, 4);
-        DEBUG_OS_HEX_WRAP(", state = ", &pt->state, 4);
-    }
+    OS_IRQSTAT_BEGIN(&schedsite);
 #endif
+#ifdef OS_CONFIG_USE_DEADLINE
+    BASE_TYPE now;
 
-#ifdef OS_CONFIG_TRAP_SCHEDQ
-    if (sqhead == NULL)
-    {
-        os_trapinfo.err = OS_TRAP_ERR_SCHEDQ_EMPTY_QUEUE;
-        os_trap();
-    }
+    now = OS_TIME();
 #endif
+#ifdef OS_CONFIG_USE_SCHEDSTAT
+    BASE_TYPE cycles;
 
-    readytask = NULL;
-    susptask  = NULL;
-#ifdef OS_CONFIG_USE_PRIORITY
-    priotask  = NULL;
+    cycles = PORT_CYCCNT;
 #endif
-    for (pt = sqhead; pt != NULL; pt = pt->next)
+#ifdef OS_CONFIG_USE_CPUSTAT
+    /* charge task that was running until now */
+    os_cpustat_account();
+#endif
+
+#if OS_USE_LOCK
+    /*
+     * Scheduler was called, so task was interrupted for some reason. Place
+     * current task to tail of it's ready list or to wait lists.
+     */
+    pt = os_current_taskcb;
+    if (pt != OS_IDLE_TASKCB)
     {
         lock = (struct os_task_lock_t*)&pt->lock;
 
-        if (!(lock->state & OS_TASK_LOCKED))
+        ready = !(lock->state & OS_TASK_LOCKED) ||
+            pt->timeout == OS_TIMEOUT_EXPIRED ||
+            os_sched_task_ready(lock);
+#ifdef OS_CONFIG_USE_DEADLINE
+        os_deadline_charge(pt, ready, now);
+#endif
+        if (ready)
+            os_rqueue_put(pt);
+        else
+            os_waitq_put(pt);
+    }
+
+    while (1)
+    {
+        pt = os_rqueue_get();
+        /* no one task ready - run idle task */
+        if (pt == NULL)
         {
-            if (susptask == NULL)
-                susptask = pt;
-            continue;
+            pt = OS_IDLE_TASKCB;
+            break;
         }
-        if (pt->timeout == OS_TIMEOUT_EXPIRED)
-            goto ready;
-        if (os_sched_task_ready(lock))
-            goto ready;
-
-        continue;
-ready:
-        readytask = pt;
-#ifdef OS_CONFIG_USE_PRIORITY
-        if (priotask == NULL)
+
+        lock = (struct os_task_lock_t*)&pt->lock;
+        if (!(lock->state & OS_TASK_LOCKED))
         {
-            priotask = readytask;
-        } else {
-            /* lower number - higher priority */
-            if (readytask->priority < priotask->priority)
-                priotask = readytask;
+            /* resume suspended task */
+            lock->state = OS_TASK_STATE_RUN;
+            break;
         }
-#else
-        break;
-#endif
+        /* 
+         * Condition of lock object can be changed again by other task since
+         * task was waked, return it to wait lists in this case.
+         */
+        if (pt->timeout == OS_TIMEOUT_EXPIRED || os_sched_task_ready(lock))
+            break;
+        os_waitq_put(pt);
     }
 
-#ifdef OS_CONFIG_USE_PRIORITY
-    if (priotask)
-        readytask = priotask;
+#ifdef OS_CONFIG_USE_TRACEBUF
+    if (pt != os_current_taskcb)
+        OS_TRACE(OS_TRACE_SWITCH,
+                (pt - os_tasks) | ((os_current_taskcb->lock.state & 0xff) << 8),
+                (os_current_taskcb->lock.state & OS_TASK_LOCKED) ? os_current_taskcb->lock.pobj : NULL);
 #endif
-
-    /* if no one task ready and there is suspended task in queue - resume suspended task */
-    if (readytask == NULL && susptask)
+    os_current_taskcb = pt;
+#ifdef OS_CONFIG_USE_DEADLINE
+    if (pt->dl.period)
     {
-        susptask->lock.state = OS_TASK_STATE_RUN;
-        readytask = susptask;
+        pt->dl.start = now;
+        /* set alarm to exhaust of budget */
+        if (OS_DL_READY(pt) && pt->dl.budget)
+            os_sched_alarm();
     }
-
-    /* no one task ready - run idle task */
-    if (readytask == NULL)
-        readytask = OS_IDLE_TASKCB;
-
-    os_current_taskcb = readytask;
+#endif
 #else /* !OS_USE_LOCK */
     os_current_taskcb = os_task_next(os_current_taskcb);
 #endif /* OS_USE_LOCK */
 
+#ifdef OS_CONFIG_USE_SCHEDSTAT
+    cycles = PORT_CYCCNT - cycles;
+
+    os_schedstat.switches++;
+    os_schedstat.cycles_last = cycles;
+    #if OS_USE_LOCK
+    if (os_schedstat.cycles_max[wqcount] < cycles)
+        os_schedstat.cycles_max[wqcount] = cycles;
+    #endif
+#endif
+
 #ifdef OS_CONFIG_USE_TRACE
     os_current_taskcb->schedhit++; /* count of scheduler hits of this task */
     #ifdef OS_STACK_DIR_DECREASE
@@ -311,6 +1011,9 @@ ready:
         os_current_taskcb->tos_max = os_current_taskcb->tos;
     #endif
 #endif
+#ifdef OS_CONFIG_USE_IRQSTAT
+    OS_IRQSTAT_END();
+#endif
 }
 
 #if OS_USE_LOCK
@@ -320,7 +1023,7 @@ ready:
  * RETURN
  *     zero if task not ready to run, one otherwise
  */
-STATIC inline BASE_TYPE os_sched_task_ready(struct os_task_lock_t *lock)
+static inline BASE_TYPE os_sched_task_ready(struct os_task_lock_t *lock)
 {
 #ifdef OS_CONFIG_USE_MULTI
     BASE_TYPE n, nready;
@@ -336,13 +1039,24 @@ STATIC inline BASE_TYPE os_sched_task_ready(struct os_task_lock_t *lock)
     if (lock->state == OS_TASK_STATE_LOCKED_EVENT &&  ((*(BASE_TYPE*)lock->pobj) & lock->mask))
         return 1;
 #endif
+#ifdef OS_CONFIG_USE_RMUTEX
+    if (lock->state == OS_TASK_STATE_LOCKED_RMUTEX)
+    {
+        struct os_rmutex_t *m;
+
+        /* mutex is unlocked or was passed to task by os_rmutex_unlock() */
+        m = (struct os_rmutex_t*)lock->pobj;
+        if (m->owner == NULL || m->owner == lock->task)
+            return 1;
+    }
+#endif
 #ifdef OS_CONFIG_USE_QUEUE
     if (lock->state == OS_TASK_STATE_LOCKED_QUEUE_FULL)
     {
         struct os_queue_t *q;
        
         q = (struct os_queue_t*)lock->pobj;
-        if (q->count < q->qsize)
+        if (q->used < q->qsize)
             return 1;
     } else if (lock->state == OS_TASK_STATE_LOCKED_QUEUE_EMPTY) {
         struct os_queue_t *q;
@@ -34,8 +34,20 @@
 #if OS_USE_LOCK
 BASE_TYPE os_lock_task(BASE_TYPE type, void *pobj, BASE_TYPE mask, BASE_TYPE timeout);
 void os_squeue_addtask(volatile struct os_taskcb_t *task);
-void os_squeue_task2tail(volatile struct os_taskcb_t *task);
+void os_sched_wake(void *pobj);
+BASE_TYPE os_sched_waiting(void *pobj);
+volatile struct os_taskcb_t *os_sched_waiter(void *pobj);
+#ifdef OS_CONFIG_USE_PRIORITY
+void os_sched_set_priority(volatile struct os_taskcb_t *task, BASE_TYPE priority);
+#endif
+void os_sched_wake_task(volatile struct os_taskcb_t *task);
 void os_sched_suspend_task();
+#if OS_USE_TIMEOUT
+BASE_TYPE os_sched_timeout();
+#ifdef OS_CONFIG_TICKLESS
+void os_sched_alarm();
+#endif
+#endif
 
 #endif /* OS_USE_LOCK */
 void os_scheduler();
@@ -0,0 +1,235 @@
+/*
+ *     Yet another operating system for microcontrollers.
+ *     Software timers.
+ *
+ * Copyright (c) 2013, Dmitry Kobylin
+ * All rights reserved.
+ * 
+ * Redistribution and use in source and binary forms, with or without
+ * modification, are permitted provided that the following conditions are met: 
+ * 
+ * 1. Redistributions of source code must retain the above copyright notice, this
+ *    list of conditions and the following disclaimer. 
+ * 2. Redistributions in binary form must reproduce the above copyright notice,
+ *    this list of conditions and the following disclaimer in the documentation
+ *    and/or other materials provided with the distribution. 
+ * 
+ * THIS SOFTWARE IS PROVIDED BY THE COPYRIGHT HOLDERS AND CONTRIBUTORS "AS IS" AND
+ * ANY EXPRESS OR IMPLIED WARRANTIES, INCLUDING, BUT NOT LIMITED TO, THE IMPLIED
+ * WARRANTIES OF MERCHANTABILITY AND FITNESS FOR A PARTICULAR PURPOSE ARE
+ * DISCLAIMED. IN NO EVENT SHALL THE COPYRIGHT OWNER OR CONTRIBUTORS BE LIABLE FOR
+ * ANY DIRECT, INDIRECT, INCIDENTAL, SPECIAL, EXEMPLARY, OR CONSEQUENTIAL DAMAGES
+ * (INCLUDING, BUT NOT LIMITED TO, PROCUREMENT OF SUBSTITUTE GOODS OR SERVICES;
+ * LOSS OF USE, DATA, OR PROFITS; OR BUSINESS INTERRUPTION) HOWEVER CAUSED AND
+ * ON ANY THEORY OF LIABILITY, WHETHER IN CONTRACT, STRICT LIABILITY, OR TORT
+ * (INCLUDING NEGLIGENCE OR OTHERWISE) ARISING IN ANY WAY OUT OF THE USE OF THIS
+ * SOFTWARE, EVEN IF ADVISED OF THE POSSIBILITY OF SUCH DAMAGE.
+ * 
+ *
+ * Periodic timer is restarted from time of previous expiration, so period
+ * does not drift because of latency of interrupt or of callbacks. If timer
+ * missed whole period (interrupts were masked for long time) missed
+ * expirations are skipped.
+ */
+#include "os_private.h"
+
+#ifdef OS_CONFIG_USE_TIMER
+#include "os_sched.h"
+#include "os_timer.h"
+#ifdef OS_CONFIG_USE_EVENT
+    #include "os_bitobj.h"
+#endif
+
+#if !OS_USE_TIMEOUT
+    #error "OS_CONFIG_USE_TIMER requires time of OS, enable OS_CONFIG_USE_WAIT or other object with timeout"
+#endif
+
+STATIC struct os_timer_t *os_timer_head; /* list of active timers sorted by time of expiration */
+
+STATIC void os_timer_insert(struct os_timer_t *t);
+STATIC void os_timer_remove(struct os_timer_t *t);
+
+/*
+ * ARGS
+ *     callback    function called on expiration of timer (from interrupt)
+ *     arg         argument of callback
+ */
+void os_timer_init(struct os_timer_t *t, void (*callback)(void *arg), void *arg)
+{
+    t->next     = NULL;
+    t->active   = 0;
+    t->period   = 0;
+    t->callback = callback;
+    t->arg      = arg;
+#ifdef OS_CONFIG_USE_EVENT
+    t->event    = NULL;
+    t->mask     = 0;
+#endif
+}
+
+#ifdef OS_CONFIG_USE_EVENT
+/*
+ * Initialize timer that raises event on expiration.
+ *
+ * ARGS
+ *     event    pointer to memory contained bits for events
+ *     mask     mask of events to raise
+ */
+void os_timer_init_event(struct os_timer_t *t, BASE_TYPE *event, BASE_TYPE mask)
+{
+    os_timer_init(t, NULL, NULL);
+    t->event = event;
+    t->mask  = mask;
+}
+#endif
+
+/*
+ * Start timer, restart timer if it is already started.
+ *
+ * NOTE can be called from ISR
+ *
+ * ARGS
+ *     delay     time to first expiration (in ticks or in microseconds in
+ *               tickless mode)
+ *     period    period of timer, 0 for one-shot timer
+ */
+void os_timer_start(struct os_timer_t *t, BASE_TYPE delay, BASE_TYPE period)
+{
+    OS_DISABLE_IRQ();
+    {
+        if (t->active)
+            os_timer_remove(t);
+
+        t->expire = OS_TIME() + delay;
+        t->period = period;
+        os_timer_insert(t);
+#ifdef OS_CONFIG_TICKLESS
+        /* timer has nearest expiration */
+        if (os_timer_head == t)
+            os_sched_alarm();
+#endif
+    }
+    OS_ENABLE_IRQ();
+}
+
+/*
+ * NOTE can be called from ISR
+ */
+void os_timer_stop(struct os_timer_t *t)
+{
+    OS_DISABLE_IRQ();
+    {
+        if (t->active)
+            os_timer_remove(t);
+        /* NOTE alarm is not changed if first timer was removed, it fires earlier */
+    }
+    OS_ENABLE_IRQ();
+}
+
+/*
+ * Expire timers which time has come.
+ *
+ * NOTE called from os_tick() or from os_alarm() in tickless mode
+ */
+void os_timer_expire()
+{
+    struct os_timer_t *t;
+    void (*callback)(void *arg);
+    void *arg;
+#ifdef OS_CONFIG_USE_EVENT
+    BASE_TYPE *event;
+    BASE_TYPE mask;
+#endif
+    BASE_TYPE now;
+
+    OS_DISABLE_IRQ();
+    now = OS_TIME();
+    while (os_timer_head && !OS_TIME_BEFORE(now, os_timer_head->expire))
+    {
+        t = os_timer_head;
+        os_timer_head = t->next;
+        t->active = 0;
+
+        if (t->period)
+        {
+            t->expire += t->period;
+            if (!OS_TIME_BEFORE(now, t->expire))
+                t->expire = now + t->period;
+            os_timer_insert(t);
+        }
+
+        callback = t->callback;
+        arg      = t->arg;
+#ifdef OS_CONFIG_USE_EVENT
+        event    = t->event;
+        mask     = t->mask;
+#endif
+        OS_ENABLE_IRQ();
+
+        if (callback)
+            callback(arg);
+#ifdef OS_CONFIG_USE_EVENT
+        else if (event)
+            os_event_raise(event, mask);
+#endif
+
+        OS_DISABLE_IRQ();
+    }
+    OS_ENABLE_IRQ();
+}
+
+#ifdef OS_CONFIG_TICKLESS
+/*
+ * RETURN
+ *     1 if there is active timer, time of nearest expiration is stored to
+ *     "time"
+ *
+ * NOTE this funciton should be call during interrupts disabled
+ */
+BASE_TYPE os_timer_next(BASE_TYPE *time)
+{
+    if (!os_timer_head)
+        return 0;
+    *time = os_timer_head->expire;
+    return 1;
+}
+#endif
+
+/*
+ * Add timer to list, keep list sorted by time of expiration.
+ *
+ * NOTE this funciton should be call during interrupts disabled
+ */
+STATIC void os_timer_insert(struct os_timer_t *t)
+{
+    struct os_timer_t **pt;
+
+    for (pt = &os_timer_head; *pt; pt = &(*pt)->next)
+    {
+        if (OS_TIME_BEFORE(t->expire, (*pt)->expire))
+            break;
+    }
+    t->next   = *pt;
+    *pt       = t;
+    t->active = 1;
+}
+
+/*
+ * NOTE this funciton should be call during interrupts disabled
+ */
+STATIC void os_timer_remove(struct os_timer_t *t)
+{
+    struct os_timer_t **pt;
+
+    for (pt = &os_timer_head; *pt; pt = &(*pt)->next)
+    {
+        if (*pt == t)
+        {
+            *pt = t->next;
+            break;
+        }
+    }
+    t->active = 0;
+}
+
+#endif /* OS_CONFIG_USE_TIMER */
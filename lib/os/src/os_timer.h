@@ -0,0 +1,69 @@
+/*
+ *     Yet another operating system for microcontrollers.
+ *     Software timers.
+ *
+ * Copyright (c) 2013, Dmitry Kobylin
+ * All rights reserved.
+ * 
+ * Redistribution and use in source and binary forms, with or without
+ * modification, are permitted provided that the following conditions are met: 
+ * 
+ * 1. Redistributions of source code must retain the above copyright notice, this
+ *    list of conditions and the following disclaimer. 
+ * 2. Redistributions in binary form must reproduce the above copyright notice,
+ *    this list of conditions and the following disclaimer in the documentation
+ *    and/or other materials provided with the distribution. 
+ * 
+ * THIS SOFTWARE IS PROVIDED BY THE COPYRIGHT HOLDERS AND CONTRIBUTORS "AS IS" AND
+ * ANY EXPRESS OR IMPLIED WARRANTIES, INCLUDING, BUT NOT LIMITED TO, THE IMPLIED
+ * WARRANTIES OF MERCHANTABILITY AND FITNESS FOR A PARTICULAR PURPOSE ARE
+ * DISCLAIMED. IN NO EVENT SHALL THE COPYRIGHT OWNER OR CONTRIBUTORS BE LIABLE FOR
+ * ANY DIRECT, INDIRECT, INCIDENTAL, SPECIAL, EXEMPLARY, OR CONSEQUENTIAL DAMAGES
+ * (INCLUDING, BUT NOT LIMITED TO, PROCUREMENT OF SUBSTITUTE GOODS OR SERVICES;
+ * LOSS OF USE, DATA, OR PROFITS; OR BUSINESS INTERRUPTION) HOWEVER CAUSED AND
+ * ON ANY THEORY OF LIABILITY, WHETHER IN CONTRACT, STRICT LIABILITY, OR TORT
+ * (INCLUDING NEGLIGENCE OR OTHERWISE) ARISING IN ANY WAY OUT OF THE USE OF THIS
+ * SOFTWARE, EVEN IF ADVISED OF THE POSSIBILITY OF SUCH DAMAGE.
+ * 
+ */
+#ifndef OS_TIMER_H
+#define OS_TIMER_H
+
+#include <types.h>
+
+/*
+ * Timers are kept in list sorted by time of expiration and are expired by
+ * os_tick() or by os_alarm() in tickless mode, so there is no task for
+ * timers and no wakeups until timer expires.
+ *
+ * On expiration timer calls callback or raises event (os_timer_init_event()).
+ *
+ * NOTE callback is called from interrupt with interrupts enabled, it should
+ *      be short and may use only functions allowed in ISR (os_event_raise(),
+ *      os_queue_post(), os_timer_start(), os_timer_stop() ...)
+ */
+struct os_timer_t {
+    struct os_timer_t *next;
+    BASE_TYPE expire;                  /* time of expiration, OS_TIME() */
+    BASE_TYPE period;                  /* period of periodic timer, 0 - one-shot timer */
+    BASE_TYPE active;                  /* timer is in list */
+
+    void (*callback)(void *arg);
+    void *arg;
+#ifdef OS_CONFIG_USE_EVENT
+    BASE_TYPE *event;                  /* raised if callback is NULL */
+    BASE_TYPE mask;
+#endif
+};
+
+void os_timer_init(struct os_timer_t *t, void (*callback)(void *arg), void *arg);
+#ifdef OS_CONFIG_USE_EVENT
+void os_timer_init_event(struct os_timer_t *t, BASE_TYPE *event, BASE_TYPE mask);
+#endif
+void os_timer_start(struct os_timer_t *t, BASE_TYPE delay, BASE_TYPE period);
+void os_timer_stop(struct os_timer_t *t);
+
+/* delay and period in milliseconds */
+#define os_timer_start_ms(t, delay, period) os_timer_start(t, OS_MS2TICK(delay), OS_MS2TICK(period))
+
+#endif /* OS_TIMER_H */
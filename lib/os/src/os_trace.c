@@ -0,0 +1,111 @@
+/*
+ *     Yet another operating system for microcontrollers.
+ *     Trace of scheduler and object events.
+ *
+ * Copyright (c) 2013, Dmitry Kobylin
+ * All rights reserved.
+ * 
+ * Redistribution and use in source and binary forms, with or without
+ * modification, are permitted provided that the following conditions are met: 
+ * 
+ * 1. Redistributions of source code must retain the above copyright notice, this
+ *    list of conditions and the following disclaimer. 
+ * 2. Redistributions in binary form must reproduce the above copyright notice,
+ *    this list of conditions and the following disclaimer in the documentation
+ *    and/or other materials provided with the distribution. 
+ * 
+ * THIS SOFTWARE IS PROVIDED BY THE COPYRIGHT HOLDERS AND CONTRIBUTORS "AS IS" AND
+ * ANY EXPRESS OR IMPLIED WARRANTIES, INCLUDING, BUT NOT LIMITED TO, THE IMPLIED
+ * WARRANTIES OF MERCHANTABILITY AND FITNESS FOR A PARTICULAR PURPOSE ARE
+ * DISCLAIMED. IN NO EVENT SHALL THE COPYRIGHT OWNER OR CONTRIBUTORS BE LIABLE FOR
+ * ANY DIRECT, INDIRECT, INCIDENTAL, SPECIAL, EXEMPLARY, OR CONSEQUENTIAL DAMAGES
+ * (INCLUDING, BUT NOT LIMITED TO, PROCUREMENT OF SUBSTITUTE GOODS OR SERVICES;
+ * LOSS OF USE, DATA, OR PROFITS; OR BUSINESS INTERRUPTION) HOWEVER CAUSED AND
+ * ON ANY THEORY OF LIABILITY, WHETHER IN CONTRACT, STRICT LIABILITY, OR TORT
+ * (INCLUDING NEGLIGENCE OR OTHERWISE) ARISING IN ANY WAY OUT OF THE USE OF THIS
+ * SOFTWARE, EVEN IF ADVISED OF THE POSSIBILITY OF SUCH DAMAGE.
+ * 
+ */
+#include "os_private.h"
+#include "os_trace.h"
+
+#ifdef OS_CONFIG_USE_TRACEBUF
+
+struct os_trace_buf_t os_tracebuf;
+STATIC char *os_tracenames[OS_CONFIG_TASK_COUNT + 1];
+STATIC struct os_trace_event_t os_traceev[OS_CONFIG_TRACEBUF_SIZE] __attribute__((section("trace")));
+
+/*
+ * initialize trace buffer, recording is disabled
+ */
+void os_trace_init()
+{
+    os_tracebuf.enabled = 0;
+    os_tracebuf.size    = OS_CONFIG_TRACEBUF_SIZE;
+    os_tracebuf.head    = 0;
+    os_tracebuf.clock   = PORT_CYCCNT_HZ;
+    os_tracebuf.ntasks  = 0;
+    os_tracebuf.names   = os_tracenames;
+    os_tracebuf.events  = os_traceev;
+    os_tracebuf.magic   = OS_TRACE_MAGIC;
+}
+
+/*
+ * clear trace buffer and start recording
+ */
+void os_trace_start()
+{
+    BASE_TYPE i;
+
+    os_tracebuf.enabled = 0;
+    for (i = 0; i < os_taskidx; i++)
+    {
+#ifdef OS_CONFIG_TASK_NAME_SIZE
+        os_tracenames[i] = os_tasks[i].name;
+#else
+        os_tracenames[i] = NULL;
+#endif
+    }
+    os_tracebuf.ntasks  = os_taskidx;
+    os_tracebuf.head    = 0;
+    PORT_DATA_BARIER();
+    os_tracebuf.enabled = 1;
+}
+
+/*
+ * stop recording, buffer is kept for dump
+ */
+void os_trace_stop()
+{
+    os_tracebuf.enabled = 0;
+}
+
+/*
+ * record event
+ *
+ * NOTE
+ *     * can be called from ISR and with interrupts disabled
+ *     * slot is reserved before timestamp is taken, so interrupt can
+ *       record event with later slot and earlier timestamp
+ */
+OS_RAMFUNC void os_trace(BASE_TYPE type, BASE_TYPE info, BASE_TYPE arg)
+{
+    struct os_trace_event_t *ev;
+    BASE_TYPE idx;
+
+    if (!os_tracebuf.enabled)
+        return;
+
+    do {
+        idx = PORT_LDREX(&os_tracebuf.head);
+    } while (PORT_STREX(&os_tracebuf.head, idx + 1));
+
+    ev = &os_traceev[idx & (OS_CONFIG_TRACEBUF_SIZE - 1)];
+    ev->time = PORT_CYCCNT;
+    ev->type = type;
+    ev->task = os_current_taskcb - os_tasks;
+    ev->info = info;
+    ev->arg  = arg;
+}
+
+#endif /* OS_CONFIG_USE_TRACEBUF */
@@ -0,0 +1,88 @@
+/*
+ *     Yet another operating system for microcontrollers.
+ *     Trace of scheduler and object events.
+ *
+ * Copyright (c) 2013, Dmitry Kobylin
+ * All rights reserved.
+ * 
+ * Redistribution and use in source and binary forms, with or without
+ * modification, are permitted provided that the following conditions are met: 
+ * 
+ * 1. Redistributions of source code must retain the above copyright notice, this
+ *    list of conditions and the following disclaimer. 
+ * 2. Redistributions in binary form must reproduce the above copyright notice,
+ *    this list of conditions and the following disclaimer in the documentation
+ *    and/or other materials provided with the distribution. 
+ * 
+ * THIS SOFTWARE IS PROVIDED BY THE COPYRIGHT HOLDERS AND CONTRIBUTORS "AS IS" AND
+ * ANY EXPRESS OR IMPLIED WARRANTIES, INCLUDING, BUT NOT LIMITED TO, THE IMPLIED
+ * WARRANTIES OF MERCHANTABILITY AND FITNESS FOR A PARTICULAR PURPOSE ARE
+ * DISCLAIMED. IN NO EVENT SHALL THE COPYRIGHT OWNER OR CONTRIBUTORS BE LIABLE FOR
+ * ANY DIRECT, INDIRECT, INCIDENTAL, SPECIAL, EXEMPLARY, OR CONSEQUENTIAL DAMAGES
+ * (INCLUDING, BUT NOT LIMITED TO, PROCUREMENT OF SUBSTITUTE GOODS OR SERVICES;
+ * LOSS OF USE, DATA, OR PROFITS; OR BUSINESS INTERRUPTION) HOWEVER CAUSED AND
+ * ON ANY THEORY OF LIABILITY, WHETHER IN CONTRACT, STRICT LIABILITY, OR TORT
+ * (INCLUDING NEGLIGENCE OR OTHERWISE) ARISING IN ANY WAY OUT OF THE USE OF THIS
+ * SOFTWARE, EVEN IF ADVISED OF THE POSSIBILITY OF SUCH DAMAGE.
+ * 
+ */
+#ifndef OS_TRACE_H
+#define OS_TRACE_H
+
+#include <types.h>
+
+/*
+ * Events are recorded to ring buffer with timestamp of PORT_CYCCNT, oldest
+ * events are overwritten. Recording is enabled by os_trace_start() or by
+ * write of nonzero value to "enabled" field of os_tracebuf (debugger).
+ * Buffer is dumped by debugger, structure of os_tracebuf is found by
+ * symbol and "magic" field.
+ */
+
+/* types of events */
+#define OS_TRACE_SWITCH          1  /* info - index of next task | lock state of previous task << 8, arg - object previous task waits for */
+#define OS_TRACE_WAKE            2  /* info - index of waked task, arg - object (zero if timeout expired) */
+#define OS_TRACE_MUTEX_LOCK      3  /* info - mask of mutex, arg - mutex */
+#define OS_TRACE_MUTEX_UNLOCK    4  /* info - mask of mutex, arg - mutex */
+#define OS_TRACE_EVENT_RAISE     5  /* info - mask of event, arg - event */
+#define OS_TRACE_QUEUE_ADD       6  /* info - length of message, arg - queue */
+#define OS_TRACE_QUEUE_REMOVE    7  /* arg - queue */
+#define OS_TRACE_IRQ_ENTER       8  /* info - number of interrupt */
+#define OS_TRACE_IRQ_EXIT        9  /* info - number of interrupt */
+#define OS_TRACE_MARK           10  /* info - identifier of marker, arg - value */
+
+struct os_trace_event_t {
+    uint32 time;  /* PORT_CYCCNT */
+    uint8  type;
+    uint8  task;  /* index of current task, zero - idle task */
+    uint16 info;
+    uint32 arg;
+};
+
+#define OS_TRACE_MAGIC    0x54524345 /* "TRCE" */
+
+struct os_trace_buf_t {
+    uint32 magic;
+    BASE_TYPE enabled;  /* events are recorded if nonzero */
+    BASE_TYPE size;     /* number of events in buffer */
+    BASE_TYPE head;     /* number of events recorded, next event is written to (head % size) */
+    BASE_TYPE clock;    /* frequency of timestamps, Hz */
+    BASE_TYPE ntasks;   /* number of tasks */
+    char **names;       /* names of tasks, indexed by "task" field of event */
+    struct os_trace_event_t *events;
+};
+
+extern struct os_trace_buf_t os_tracebuf;
+
+void os_trace_init();
+void os_trace_start();
+void os_trace_stop();
+void os_trace(BASE_TYPE type, BASE_TYPE info, BASE_TYPE arg);
+
+/* user marker */
+#define os_trace_mark(id, value) os_trace(OS_TRACE_MARK, id, value)
+/* should be called at entry and exit of interrupt handler */
+#define os_trace_irq_enter(n)    os_trace(OS_TRACE_IRQ_ENTER, n, 0)
+#define os_trace_irq_exit(n)     os_trace(OS_TRACE_IRQ_EXIT, n, 0)
+
+#endif /* OS_TRACE_H */
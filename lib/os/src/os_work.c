@@ -0,0 +1,212 @@
+/*
+ *     Yet another operating system for microcontrollers.
+ *     Deferred work (bottom halves of interrupts).
+ *
+ * Copyright (c) 2013, Dmitry Kobylin
+ * All rights reserved.
+ * 
+ * Redistribution and use in source and binary forms, with or without
+ * modification, are permitted provided that the following conditions are met: 
+ * 
+ * 1. Redistributions of source code must retain the above copyright notice, this
+ *    list of conditions and the following disclaimer. 
+ * 2. Redistributions in binary form must reproduce the above copyright notice,
+ *    this list of conditions and the following disclaimer in the documentation
+ *    and/or other materials provided with the distribution. 
+ * 
+ * THIS SOFTWARE IS PROVIDED BY THE COPYRIGHT HOLDERS AND CONTRIBUTORS "AS IS" AND
+ * ANY EXPRESS OR IMPLIED WARRANTIES, INCLUDING, BUT NOT LIMITED TO, THE IMPLIED
+ * WARRANTIES OF MERCHANTABILITY AND FITNESS FOR A PARTICULAR PURPOSE ARE
+ * DISCLAIMED. IN NO EVENT SHALL THE COPYRIGHT OWNER OR CONTRIBUTORS BE LIABLE FOR
+ * ANY DIRECT, INDIRECT, INCIDENTAL, SPECIAL, EXEMPLARY, OR CONSEQUENTIAL DAMAGES
+ * (INCLUDING, BUT NOT LIMITED TO, PROCUREMENT OF SUBSTITUTE GOODS OR SERVICES;
+ * LOSS OF USE, DATA, OR PROFITS; OR BUSINESS INTERRUPTION) HOWEVER CAUSED AND
+ * ON ANY THEORY OF LIABILITY, WHETHER IN CONTRACT, STRICT LIABILITY, OR TORT
+ * (INCLUDING NEGLIGENCE OR OTHERWISE) ARISING IN ANY WAY OUT OF THE USE OF THIS
+ * SOFTWARE, EVEN IF ADVISED OF THE POSSIBILITY OF SUCH DAMAGE.
+ * 
+ */
+#include "os.h"
+#include "os_private.h"
+
+#ifdef OS_CONFIG_USE_WORK
+#include "os_work.h"
+
+struct os_work_t *os_work_list; /* all initialized works, for statistics */
+
+STATIC void os_work_put(struct os_work_t *w);
+STATIC struct os_work_t *os_work_get(struct os_workq_t *wq);
+
+/*
+ *
+ */
+void os_workq_init(struct os_workq_t *wq)
+{
+    BASE_TYPE i;
+
+    for (i = 0; i < OS_CONFIG_WORK_PRIOS; i++)
+    {
+        wq->head[i] = NULL;
+        wq->tail[i] = NULL;
+    }
+    wq->event = 0;
+}
+
+/*
+ * ARGS
+ *     wq         queue that runs work
+ *     prio       priority of work in queue, 0 - highest
+ *     handler    function of work, called by worker task
+ *     arg        argument of handler
+ *     name       name of work for statistics
+ */
+void os_work_init(struct os_work_t *w, struct os_workq_t *wq, BASE_TYPE prio,
+        void (*handler)(void *arg), void *arg, char *name)
+{
+    w->next      = NULL;
+    w->wq        = wq;
+    w->prio      = prio < OS_CONFIG_WORK_PRIOS ? prio : OS_CONFIG_WORK_PRIOS - 1;
+    w->state     = 0;
+    w->handler   = handler;
+    w->arg       = arg;
+    w->name      = name;
+    w->runs      = 0;
+    w->coalesced = 0;
+    w->latmax    = 0;
+    w->latsum    = 0;
+    w->runmax    = 0;
+
+    OS_DISABLE_IRQ();
+    w->lnext     = os_work_list;
+    os_work_list = w;
+    OS_ENABLE_IRQ();
+}
+
+/*
+ * Post work to its queue.
+ *
+ * NOTE can be called from ISR
+ */
+void os_work_post(struct os_work_t *w)
+{
+    OS_DISABLE_IRQ();
+    {
+        if (w->state & OS_WORK_STATE_PENDING)
+        {
+            w->coalesced++;
+            OS_ENABLE_IRQ();
+            return;
+        }
+
+        w->state |= OS_WORK_STATE_PENDING;
+        w->posted = PORT_CYCCNT;
+        /* running work is put to queue again by worker when handler returns */
+        if (!(w->state & OS_WORK_STATE_RUNNING))
+            os_work_put(w);
+    }
+    OS_ENABLE_IRQ();
+
+    os_event_raise(&w->wq->event, OS_WORKQ_EVENT_POST);
+}
+
+/*
+ * Run works of queue, body of worker task. Does not return.
+ */
+void os_workq_run(struct os_workq_t *wq)
+{
+    struct os_work_t *w;
+    uint32 start, lat;
+
+    while (1)
+    {
+        os_event_wait(&wq->event, OS_WORKQ_EVENT_POST, OS_FLAG_CLEAR, OS_WAIT_FOREVER);
+
+        while (1)
+        {
+            OS_DISABLE_IRQ();
+            w = os_work_get(wq);
+            if (!w)
+            {
+                OS_ENABLE_IRQ();
+                break;
+            }
+            w->state = OS_WORK_STATE_RUNNING;
+            start = PORT_CYCCNT;
+            OS_ENABLE_IRQ();
+
+            lat = start - w->posted;
+            w->latsum += lat;
+            if (w->latmax < lat)
+                w->latmax = lat;
+
+            w->handler(w->arg);
+
+            lat = PORT_CYCCNT - start;
+            if (w->runmax < lat)
+                w->runmax = lat;
+            w->runs++;
+
+            OS_DISABLE_IRQ();
+            w->state &= ~OS_WORK_STATE_RUNNING;
+            /* posted while running */
+            if (w->state & OS_WORK_STATE_PENDING)
+                os_work_put(w);
+            OS_ENABLE_IRQ();
+        }
+    }
+}
+
+/*
+ * Entry of worker task, context of task is queue of work.
+ *
+ * Example
+ *     OS_TASK_INIT("Work", stack, sizeof(stack), 0, os_workq_task, &workq);
+ */
+void os_workq_task()
+{
+    os_workq_run(os_task_get_context());
+}
+
+/*
+ * Add work to tail of list of its priority.
+ *
+ * NOTE this funciton should be call during interrupts disabled
+ */
+STATIC void os_work_put(struct os_work_t *w)
+{
+    struct os_workq_t *wq;
+
+    wq = w->wq;
+    w->next = NULL;
+    if (wq->tail[w->prio])
+        wq->tail[w->prio]->next = w;
+    else
+        wq->head[w->prio] = w;
+    wq->tail[w->prio] = w;
+}
+
+/*
+ * Remove work of highest priority.
+ *
+ * NOTE this funciton should be call during interrupts disabled
+ */
+STATIC struct os_work_t *os_work_get(struct os_workq_t *wq)
+{
+    struct os_work_t *w;
+    BASE_TYPE i;
+
+    for (i = 0; i < OS_CONFIG_WORK_PRIOS; i++)
+    {
+        w = wq->head[i];
+        if (w)
+        {
+            wq->head[i] = w->next;
+            if (!wq->head[i])
+                wq->tail[i] = NULL;
+            return w;
+        }
+    }
+    return NULL;
+}
+
+#endif /* OS_CONFIG_USE_WORK */
@@ -0,0 +1,89 @@
+/*
+ *     Yet another operating system for microcontrollers.
+ *     Deferred work (bottom halves of interrupts).
+ *
+ * Copyright (c) 2013, Dmitry Kobylin
+ * All rights reserved.
+ * 
+ * Redistribution and use in source and binary forms, with or without
+ * modification, are permitted provided that the following conditions are met: 
+ * 
+ * 1. Redistributions of source code must retain the above copyright notice, this
+ *    list of conditions and the following disclaimer. 
+ * 2. Redistributions in binary form must reproduce the above copyright notice,
+ *    this list of conditions and the following disclaimer in the documentation
+ *    and/or other materials provided with the distribution. 
+ * 
+ * THIS SOFTWARE IS PROVIDED BY THE COPYRIGHT HOLDERS AND CONTRIBUTORS "AS IS" AND
+ * ANY EXPRESS OR IMPLIED WARRANTIES, INCLUDING, BUT NOT LIMITED TO, THE IMPLIED
+ * WARRANTIES OF MERCHANTABILITY AND FITNESS FOR A PARTICULAR PURPOSE ARE
+ * DISCLAIMED. IN NO EVENT SHALL THE COPYRIGHT OWNER OR CONTRIBUTORS BE LIABLE FOR
+ * ANY DIRECT, INDIRECT, INCIDENTAL, SPECIAL, EXEMPLARY, OR CONSEQUENTIAL DAMAGES
+ * (INCLUDING, BUT NOT LIMITED TO, PROCUREMENT OF SUBSTITUTE GOODS OR SERVICES;
+ * LOSS OF USE, DATA, OR PROFITS; OR BUSINESS INTERRUPTION) HOWEVER CAUSED AND
+ * ON ANY THEORY OF LIABILITY, WHETHER IN CONTRACT, STRICT LIABILITY, OR TORT
+ * (INCLUDING NEGLIGENCE OR OTHERWISE) ARISING IN ANY WAY OUT OF THE USE OF THIS
+ * SOFTWARE, EVEN IF ADVISED OF THE POSSIBILITY OF SUCH DAMAGE.
+ * 
+ */
+#ifndef OS_WORK_H
+#define OS_WORK_H
+
+#include <types.h>
+
+/*
+ * Work is function posted from interrupt (or task) to be run by worker task,
+ * so interrupt handler only acknowledges device and posts work.
+ *
+ * Every queue of work has OS_CONFIG_WORK_PRIOS priorities, worker runs
+ * pending work of highest priority (lower number) first, work of same
+ * priority is run in order of posts. Queue may be served by one or more
+ * worker tasks (os_workq_run()), work is never run by two workers at once.
+ *
+ * Post of work that is already pending is coalesced with pending one, post
+ * of work that is running makes it pending again, so handler should process
+ * all that device has ready.
+ *
+ * Latency of work is time from first post to start of handler.
+ */
+struct os_work_t {
+    struct os_work_t *next;            /* next work in list of queue */
+    struct os_workq_t *wq;
+    BASE_TYPE prio;
+#define OS_WORK_STATE_PENDING    (1 << 0)
+#define OS_WORK_STATE_RUNNING    (1 << 1)
+    BASE_TYPE state;
+    uint32 posted;                     /* PORT_CYCCNT at first post */
+
+    void (*handler)(void *arg);
+    void *arg;
+    char *name;
+
+    /* statistics, times in cycles of PORT_CYCCNT */
+    uint32 runs;                       /* number of runs of handler */
+    uint32 coalesced;                  /* number of posts coalesced with pending work */
+    uint32 latmax;                     /* maximum latency */
+    uint64 latsum;                     /* sum of latencies, for average */
+    uint32 runmax;                     /* maximum time of run of handler */
+
+    struct os_work_t *lnext;           /* list of all works (os_work_list) */
+};
+
+struct os_workq_t {
+    struct os_work_t *head[OS_CONFIG_WORK_PRIOS];
+    struct os_work_t *tail[OS_CONFIG_WORK_PRIOS];
+#define OS_WORKQ_EVENT_POST    (1 << 0)
+    BASE_TYPE event;
+};
+
+extern struct os_work_t *os_work_list;
+
+void os_workq_init(struct os_workq_t *wq);
+void os_workq_run(struct os_workq_t *wq);
+void os_workq_task();
+
+void os_work_init(struct os_work_t *w, struct os_workq_t *wq, BASE_TYPE prio,
+        void (*handler)(void *arg), void *arg, char *name);
+void os_work_post(struct os_work_t *w);
+
+#endif /* OS_WORK_H */
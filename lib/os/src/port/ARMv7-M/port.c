@@ -37,6 +37,9 @@
 
 void os_scheduler();
 
+/* frequency of DWT cycle counter */
+const BASE_TYPE port_cyccnt_hz = CLK_CCLK;
+
 /* initial context of task */
 const struct os_task_context_t icontext = {
     0x00004444, /* r4   */
@@ -62,7 +65,7 @@ const struct os_task_context_t icontext = {
  */
 void port_init()
 {
-#ifdef OS_CONFIG_TICK_PERIOD
+#if OS_USE_PERIODIC_TICK
     /* initialize system tick timer */
     {
         SysTick->CTRL = 0; /* disable timer */
@@ -74,7 +77,7 @@ void port_init()
         SysTick->RELOAD = (BASE_TYPE)SYSTICK_RELOAD;
         SysTick->CURR   = (BASE_TYPE)SYSTICK_RELOAD;
     }
-#endif /* OS_CONFIG_TICK_PERIOD */
+#endif /* OS_USE_PERIODIC_TICK */
 
     /*
      * set priority groups, priority of interrupts
@@ -93,10 +96,17 @@ void port_init()
 
         /* set PendSV lowest priority, SysTick highest priority (but not higher than debug port)  */
         SCB->SHP[10] = 0xff;
-#ifdef OS_CONFIG_TICK_PERIOD
+#if OS_USE_PERIODIC_TICK
         SCB->SHP[11] = (1 << 5) | (0 << 3);
 #endif
     }
+
+#if (defined OS_CONFIG_USE_SCHEDSTAT) || (defined OS_CONFIG_USE_TRACEBUF) || \
+    (defined OS_CONFIG_USE_CPUSTAT) || (defined OS_CONFIG_USE_IRQSTAT) || (defined OS_CONFIG_USE_WORK)
+    /* enable DWT cycle counter, used by statistics of scheduler, interrupts and work, trace and CPU load */
+    *(volatile BASE_TYPE*)0xE000EDFC |= (1 << 24); /* DEMCR.TRCENA */
+    *(volatile BASE_TYPE*)0xE0001000 |= (1 << 0);  /* DWT_CTRL.CYCCNTENA */
+#endif
 }
 
 /*
@@ -114,7 +124,7 @@ void port_start()
         "mov r1,#2                               \n"
         "msr control, r1                         \n"
     );
-#ifdef OS_CONFIG_TICK_PERIOD
+#if OS_USE_PERIODIC_TICK
     /*
      * Start system tick timer, enable it's interrupt.
      * NOTE RELOAD value should be enough to not generate
@@ -134,7 +144,7 @@ void port_start()
 /*
  * XXX should macro be used instead?
  */
-void __attribute__((naked)) port_task_switch()
+OS_RAMFUNC void __attribute__((naked)) port_task_switch()
 {
     /* set PendSV to pending */
     asm volatile (
@@ -150,9 +160,10 @@ void __attribute__((naked)) port_task_switch()
 }
 
 /*
- *
+ * NOTE literal of os_current_taskcb is placed by assembler to section of
+ * handler (".ramfunc"), label of port_start() may be out of reach from there
  */
-void __attribute__((naked)) PendSV_Handler(void)
+OS_RAMFUNC void __attribute__((naked)) PendSV_Handler(void)
 {
     PORT_DISABLE_IRQ();
     asm volatile (
@@ -160,7 +171,7 @@ void __attribute__((naked)) PendSV_Handler(void)
         "mrs r0, psp        \n"
         "stmdb r0!,{r4-r11} \n"
         /* save new TOS */
-        "ldr r2, current_taskcb \n"
+        "ldr r2, =os_current_taskcb \n"
         "ldr r2, [r2, #0]       \n"
         "str r0, [r2, #0]       \n"
 
@@ -172,7 +183,7 @@ void __attribute__((naked)) PendSV_Handler(void)
         "pop {lr}              \n"
 
         /* restore context of new task */
-        "ldr r2, current_taskcb \n"
+        "ldr r2, =os_current_taskcb \n"
         "ldr r2, [r2, #0]       \n"
         "ldr r0, [r2, #0]       \n"
         "ldmia r0!, {r4-r11}    \n"
@@ -209,9 +220,9 @@ void SVCall_Handler(void)
 /*
  *
  */
-void SysTick_Handler(void)
+OS_RAMFUNC void SysTick_Handler(void)
 {
-#ifdef OS_CONFIG_TICK_PERIOD
+#if OS_USE_PERIODIC_TICK
     os_tick();
 #endif
 }
@@ -76,5 +76,38 @@ BASE_TYPE port_in_irq();
         )
 #define PORT_DATA_BARIER() \
         asm volatile("dmb\n")
+/* number of leading zeros, CLZ instruction */
+#define PORT_CLZ(x) __builtin_clz(x)
+/* DWT cycle counter */
+#define PORT_CYCCNT (*(volatile BASE_TYPE*)0xE0001004)
+extern const BASE_TYPE port_cyccnt_hz;
+#define PORT_CYCCNT_HZ port_cyccnt_hz
+/* wait for interrupt */
+#define PORT_IDLE() asm volatile ("wfi\r\n")
+
+/*
+ * Exclusive load/store of word. PORT_STREX() returns 0 if store succeed.
+ * NOTE Exception entry and return clear exclusive monitor, so store fails
+ *      if interrupt or task switch occured after PORT_LDREX().
+ */
+static inline BASE_TYPE port_ldrex(volatile BASE_TYPE *p)
+{
+    BASE_TYPE v;
+
+    asm volatile ("ldrex %0, [%1]\n" : "=r" (v) : "r" (p) : "memory");
+    return v;
+}
+
+static inline BASE_TYPE port_strex(volatile BASE_TYPE *p, BASE_TYPE v)
+{
+    BASE_TYPE ret;
+
+    asm volatile ("strex %0, %2, [%1]\n" : "=&r" (ret) : "r" (p), "r" (v) : "memory");
+    return ret;
+}
+
+#define PORT_LDREX(p)     port_ldrex(p)
+#define PORT_STREX(p, v)  port_strex(p, v)
+#define PORT_CLREX()      asm volatile ("clrex\n" ::: "memory")
 #endif
 
@@ -0,0 +1,371 @@
+/*
+ *     Yet another operating system for microcontrollers.
+ *     This file provide functions to run operating system on POSIX host
+ *     (tasks are threads, tested on Linux).
+ *
+ * Copyright (c) 2013, Dmitry Kobylin
+ * All rights reserved.
+ * 
+ * Redistribution and use in source and binary forms, with or without
+ * modification, are permitted provided that the following conditions are met: 
+ * 
+ * 1. Redistributions of source code must retain the above copyright notice, this
+ *    list of conditions and the following disclaimer. 
+ * 2. Redistributions in binary form must reproduce the above copyright notice,
+ *    this list of conditions and the following disclaimer in the documentation
+ *    and/or other materials provided with the distribution. 
+ * 
+ * THIS SOFTWARE IS PROVIDED BY THE COPYRIGHT HOLDERS AND CONTRIBUTORS "AS IS" AND
+ * ANY EXPRESS OR IMPLIED WARRANTIES, INCLUDING, BUT NOT LIMITED TO, THE IMPLIED
+ * WARRANTIES OF MERCHANTABILITY AND FITNESS FOR A PARTICULAR PURPOSE ARE
+ * DISCLAIMED. IN NO EVENT SHALL THE COPYRIGHT OWNER OR CONTRIBUTORS BE LIABLE FOR
+ * ANY DIRECT, INDIRECT, INCIDENTAL, SPECIAL, EXEMPLARY, OR CONSEQUENTIAL DAMAGES
+ * (INCLUDING, BUT NOT LIMITED TO, PROCUREMENT OF SUBSTITUTE GOODS OR SERVICES;
+ * LOSS OF USE, DATA, OR PROFITS; OR BUSINESS INTERRUPTION) HOWEVER CAUSED AND
+ * ON ANY THEORY OF LIABILITY, WHETHER IN CONTRACT, STRICT LIABILITY, OR TORT
+ * (INCLUDING NEGLIGENCE OR OTHERWISE) ARISING IN ANY WAY OUT OF THE USE OF THIS
+ * SOFTWARE, EVEN IF ADVISED OF THE POSSIBILITY OF SUCH DAMAGE.
+ * 
+ */
+#define _GNU_SOURCE
+#include <pthread.h>
+#include <semaphore.h>
+#include <signal.h>
+#include <string.h>
+#include <errno.h>
+#include <time.h>
+#include "port.h"
+#include "../../os.h"
+#include "../../os_private.h"
+#include "../../os_config.h"
+
+void os_scheduler();
+void os_idle_process();
+
+/* initial context of task */
+const struct os_task_context_t icontext = {{0, 0, 0, 0}};
+
+STATIC uint32 port_excl_gen;                /* generation of exclusive monitor, guarded by port_irq_mutex */
+STATIC __thread uint32 port_monitor;        /* generation at PORT_LDREX() of this thread */
+STATIC __thread BASE_TYPE port_monitor_set; /* PORT_LDREX() was done, no PORT_STREX() or PORT_CLREX() yet */
+
+struct port_thread_t {
+    pthread_t thread;
+    sem_t run;             /* posted when task becomes current */
+    void (*process)();
+};
+
+STATIC struct port_thread_t port_threads[OS_CONFIG_TASK_COUNT + 1];
+#define PORT_THREAD(task) (&port_threads[(task) - os_tasks])
+
+STATIC pthread_mutex_t port_irq_mutex = PTHREAD_MUTEX_INITIALIZER;
+STATIC volatile BASE_TYPE port_switch_pending;   /* switch of task requested */
+STATIC sem_t port_wfi;                           /* posted on every interrupt, wakes idle task */
+
+STATIC __thread volatile BASE_TYPE port_irq_disabled; /* this thread holds port_irq_mutex */
+STATIC __thread volatile BASE_TYPE port_running;      /* this thread is thread of current task */
+STATIC __thread BASE_TYPE port_isr;                   /* this thread runs interrupt handler */
+
+STATIC void port_switch();
+STATIC void port_preempt(int sig);
+STATIC void *port_task_entry(void *arg);
+#if OS_USE_PERIODIC_TICK
+STATIC void *port_tick_thread(void *arg);
+#endif
+
+/*
+ *
+ */
+void port_init()
+{
+    struct sigaction sa;
+
+    /* NOTE interrupts already disabled in os_init() */
+    sem_init(&port_wfi, 0, 0);
+    /* idle task runs in thread that called os_start() */
+    sem_init(&port_threads[0].run, 0, 0);
+
+    memset(&sa, 0, sizeof(sa));
+    sa.sa_handler = port_preempt;
+    sigemptyset(&sa.sa_mask);
+    sigaction(SIGUSR1, &sa, NULL);
+}
+
+/*
+ *
+ */
+void port_start()
+{
+#if OS_USE_PERIODIC_TICK
+    pthread_t tick;
+#endif
+
+    port_threads[0].thread = pthread_self();
+    port_running = 1;
+#if OS_USE_PERIODIC_TICK
+    pthread_create(&tick, NULL, port_tick_thread, NULL);
+#endif
+    /* enable interrupts previosly disabled in os_init() */
+    PORT_ENABLE_IRQ();
+    os_idle_process();
+}
+
+/*
+ * create thread of task, thread waits until task becomes current
+ */
+void port_task_init(struct os_taskcb_t *task, void (*process)())
+{
+    struct port_thread_t *t;
+    pthread_attr_t attr;
+
+    t = PORT_THREAD(task);
+    t->process = process;
+    sem_init(&t->run, 0, 0);
+
+    pthread_attr_init(&attr);
+    pthread_attr_setdetachstate(&attr, PTHREAD_CREATE_DETACHED);
+    pthread_create(&t->thread, &attr, port_task_entry, t);
+    pthread_attr_destroy(&attr);
+}
+
+/*
+ *
+ */
+STATIC void *port_task_entry(void *arg)
+{
+    struct port_thread_t *t = arg;
+
+    while (sem_wait(&t->run))
+        ;
+    port_running = 1;
+    /* switch may be requested before thread started */
+    port_switch();
+
+    /* NOTE process is started again on return, as on ARMv7-M (lr = pc) */
+    while (1)
+        t->process();
+
+    return NULL;
+}
+
+/*
+ * Call scheduler and pass control to thread of new current task, return
+ * when task of this thread becomes current again.
+ *
+ * NOTE called by thread of current task with interrupts enabled
+ */
+STATIC void port_switch()
+{
+    volatile struct os_taskcb_t *prev, *next;
+
+    while (port_switch_pending)
+    {
+        port_irq_disabled = 1;
+        pthread_mutex_lock(&port_irq_mutex);
+
+        port_switch_pending = 0;
+        /* NOTE switch of task (PendSV) clears exclusive monitor */
+        port_excl_gen++;
+        prev = os_current_taskcb;
+        os_scheduler();
+        next = os_current_taskcb;
+        if (next != prev)
+            port_running = 0;
+
+        pthread_mutex_unlock(&port_irq_mutex);
+        port_irq_disabled = 0;
+
+        if (next != prev)
+        {
+            sem_post(&PORT_THREAD(next)->run);
+            while (sem_wait(&PORT_THREAD(prev)->run))
+                ;
+            port_running = 1;
+        }
+    }
+}
+
+/*
+ * request switch of task
+ */
+void port_task_switch()
+{
+    port_switch_pending = 1;
+    if (!port_irq_disabled && port_running && !port_isr)
+        port_switch();
+}
+
+/*
+ * Preemption of current task by interrupt. If task is in critical section
+ * then switch is performed by port_enable_irq().
+ */
+STATIC void port_preempt(int sig)
+{
+    int err;
+
+    err = errno;
+    if (port_running && !port_irq_disabled)
+        port_switch();
+    errno = err;
+}
+
+/*
+ * NOTE not nested, as cpsid/cpsie on ARMv7-M
+ */
+void port_disable_irq()
+{
+    if (!port_irq_disabled)
+    {
+        port_irq_disabled = 1;
+        pthread_mutex_lock(&port_irq_mutex);
+    }
+}
+
+/*
+ *
+ */
+void port_enable_irq()
+{
+    if (port_irq_disabled)
+    {
+        pthread_mutex_unlock(&port_irq_mutex);
+        port_irq_disabled = 0;
+    }
+    /* switch is performed when interrupts are enabled, as PendSV on ARMv7-M */
+    if (port_switch_pending && port_running && !port_isr)
+        port_switch();
+}
+
+/*
+ * Run interrupt handler, should be called by thread that emulates
+ * interrupt (application's threads may use it too, for example to call
+ * os_alarm() in tickless mode).
+ */
+void port_irq(void (*handler)())
+{
+    volatile struct os_taskcb_t *task;
+
+    port_isr = 1;
+    port_disable_irq();
+    /* NOTE exception entry and return clear exclusive monitor */
+    port_excl_gen++;
+    handler();
+    port_excl_gen++;
+    task = os_current_taskcb;
+    port_enable_irq();
+    port_isr = 0;
+
+    if (port_switch_pending)
+        pthread_kill(PORT_THREAD(task)->thread, SIGUSR1);
+    sem_post(&port_wfi);
+}
+
+/*
+ * NOTE exclusive access is serialized with interrupts and with exclusive
+ * access of other threads by port_irq_mutex, it may be already held by
+ * this thread (PORT_LDREX()/PORT_STREX() in critical section)
+ */
+BASE_TYPE port_ldrex(volatile BASE_TYPE *p)
+{
+    BASE_TYPE v, locked;
+
+    locked = !port_irq_disabled;
+    port_disable_irq();
+    port_monitor     = port_excl_gen;
+    port_monitor_set = 1;
+    v = *p;
+    if (locked)
+        port_enable_irq();
+
+    return v;
+}
+
+/*
+ * RETURN
+ *     0 if word was stored, 1 otherwise
+ */
+BASE_TYPE port_strex(volatile BASE_TYPE *p, BASE_TYPE v)
+{
+    BASE_TYPE res, locked;
+
+    res = 1;
+    locked = !port_irq_disabled;
+    port_disable_irq();
+    if (port_monitor_set && port_monitor == port_excl_gen)
+    {
+        *p = v;
+        port_excl_gen++;
+        res = 0;
+    }
+    port_monitor_set = 0;
+    if (locked)
+        port_enable_irq();
+
+    return res;
+}
+
+/*
+ *
+ */
+void port_clrex()
+{
+    port_monitor_set = 0;
+}
+
+/*
+ * wait for interrupt, used by idle task
+ */
+void port_idle()
+{
+    while (sem_wait(&port_wfi))
+        ;
+}
+
+/*
+ * check whether call done from irq or not
+ *
+ * RETURN
+ *     0   thread mode
+ *     >0  interrupt handler is running
+ */
+BASE_TYPE port_in_irq()
+{
+    return port_isr;
+}
+
+/*
+ * nanoseconds of monotonic clock, used instead of DWT cycle counter
+ */
+BASE_TYPE port_cycles()
+{
+    struct timespec ts;
+
+    clock_gettime(CLOCK_MONOTONIC, &ts);
+    return (BASE_TYPE)(ts.tv_sec * 1000000000ULL + ts.tv_nsec);
+}
+
+#if OS_USE_PERIODIC_TICK
+/*
+ * system tick
+ */
+STATIC void *port_tick_thread(void *arg)
+{
+    struct timespec t;
+
+    clock_gettime(CLOCK_MONOTONIC, &t);
+    while (1)
+    {
+        t.tv_nsec += OS_CONFIG_TICK_PERIOD * 1000;
+        while (t.tv_nsec >= 1000000000)
+        {
+            t.tv_nsec -= 1000000000;
+            t.tv_sec++;
+        }
+        while (clock_nanosleep(CLOCK_MONOTONIC, TIMER_ABSTIME, &t, NULL) == EINTR)
+            ;
+        port_irq(os_tick);
+    }
+
+    return NULL;
+}
+#endif
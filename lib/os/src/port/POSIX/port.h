@@ -0,0 +1,103 @@
+/*
+ *     Yet another operating system for microcontrollers.
+ *     This file provide functions to run operating system on POSIX host
+ *     (tasks are threads, tested on Linux).
+ *
+ * Copyright (c) 2013, Dmitry Kobylin
+ * All rights reserved.
+ * 
+ * Redistribution and use in source and binary forms, with or without
+ * modification, are permitted provided that the following conditions are met: 
+ * 
+ * 1. Redistributions of source code must retain the above copyright notice, this
+ *    list of conditions and the following disclaimer. 
+ * 2. Redistributions in binary form must reproduce the above copyright notice,
+ *    this list of conditions and the following disclaimer in the documentation
+ *    and/or other materials provided with the distribution. 
+ * 
+ * THIS SOFTWARE IS PROVIDED BY THE COPYRIGHT HOLDERS AND CONTRIBUTORS "AS IS" AND
+ * ANY EXPRESS OR IMPLIED WARRANTIES, INCLUDING, BUT NOT LIMITED TO, THE IMPLIED
+ * WARRANTIES OF MERCHANTABILITY AND FITNESS FOR A PARTICULAR PURPOSE ARE
+ * DISCLAIMED. IN NO EVENT SHALL THE COPYRIGHT OWNER OR CONTRIBUTORS BE LIABLE FOR
+ * ANY DIRECT, INDIRECT, INCIDENTAL, SPECIAL, EXEMPLARY, OR CONSEQUENTIAL DAMAGES
+ * (INCLUDING, BUT NOT LIMITED TO, PROCUREMENT OF SUBSTITUTE GOODS OR SERVICES;
+ * LOSS OF USE, DATA, OR PROFITS; OR BUSINESS INTERRUPTION) HOWEVER CAUSED AND
+ * ON ANY THEORY OF LIABILITY, WHETHER IN CONTRACT, STRICT LIABILITY, OR TORT
+ * (INCLUDING NEGLIGENCE OR OTHERWISE) ARISING IN ANY WAY OUT OF THE USE OF THIS
+ * SOFTWARE, EVEN IF ADVISED OF THE POSSIBILITY OF SUCH DAMAGE.
+ * 
+ */
+#ifndef OS_POSIX_PORT_H
+#define OS_POSIX_PORT_H
+
+#include <types.h>
+
+/*
+ * Every task runs in its own thread, only thread of current task is not
+ * blocked on semaphore. Interrupts are emulated by threads that call
+ * port_irq() (periodic tick is such thread). Disable of interrupts locks
+ * mutex, so interrupt handler is not run at the same time with code of
+ * task in critical section. Preemption is done by signal (SIGUSR1) sent to
+ * thread of current task, it is delayed until interrupts are enabled,
+ * as PendSV on ARMv7-M.
+ *
+ * NOTE
+ *     * BASE_TYPE is 32-bit and it is used to hold pointers, so 32-bit
+ *       code should be generated (-m32)
+ *     * stack given to os_task_init() is not used, task runs on stack of
+ *       its thread
+ *     * task that is preempted inside of C library (malloc(), printf())
+ *       may hold lock of library, use of the same functions by other tasks
+ *       can lock forever
+ */
+
+/*
+ * context of task
+ * NOTE real context is kept by thread of task
+ */
+struct os_task_context_t {
+    BASE_TYPE unused[4];
+};
+
+extern const struct os_task_context_t icontext;
+
+struct os_taskcb_t;
+
+void port_init();
+void port_start();
+void port_task_init(struct os_taskcb_t *task, void (*process)());
+void port_task_switch();
+BASE_TYPE port_in_irq();
+void port_irq(void (*handler)());
+void port_idle();
+void port_disable_irq();
+void port_enable_irq();
+BASE_TYPE port_cycles();
+
+#define PORT_DISABLE_IRQ() port_disable_irq()
+#define PORT_ENABLE_IRQ()  port_enable_irq()
+#define PORT_DATA_BARIER() __sync_synchronize()
+/* number of leading zeros */
+#define PORT_CLZ(x) __builtin_clz(x)
+/* nanoseconds of monotonic clock instead of cycle counter */
+#define PORT_CYCCNT port_cycles()
+#define PORT_CYCCNT_HZ 1000000000
+/* wait for interrupt */
+#define PORT_IDLE() port_idle()
+
+/*
+ * Exclusive load/store of word. Exclusive monitor is emulated with
+ * generation counter, it is incremented by every successful store and on
+ * entry and exit of interrupt handler (port_irq()). Store fails if counter
+ * was changed after PORT_LDREX() of this thread, as after exception or
+ * exclusive store of other task on ARMv7-M. Value of word is not compared,
+ * so word that was changed and changed back (ABA) fails store too.
+ */
+BASE_TYPE port_ldrex(volatile BASE_TYPE *p);
+BASE_TYPE port_strex(volatile BASE_TYPE *p, BASE_TYPE v);
+void port_clrex();
+
+#define PORT_LDREX(p)     port_ldrex(p)
+#define PORT_STREX(p, v)  port_strex(p, v)
+#define PORT_CLREX()      port_clrex()
+#endif
@@ -93,5 +93,237 @@ proc pt {} {
     userf 0
 }
 
+#
+# print statistics (FS write cache, stack usage of tasks, etc.)
+#
+proc pst {} {
+    userf 1
+}
+
+#
+# print busy blocks of dynamic memory (address, size, caller of os_malloc)
+#
+proc phe {} {
+    userf 2
+}
+
+#
+# address of symbol in ELF image of firmware
+#
+proc symaddr {name} {
+    set sym [exec arm-none-eabi-nm ../../board/sk-mlpc1788/main.out]
+    if {![regexp -line "^(\[0-9a-fA-F\]+) \[bBdD\] $name\$" $sym -> addr]} {
+        error "$name not found"
+    }
+    return 0x$addr
+}
+
+#
+# print CPU load of tasks and interrupts (os_cpustat), returns list of
+# {name load1 load10 cycles}, loads in 1/1000 of last window (second) and of
+# last 10 windows
+#
+proc pcpu {{addr {}}} {
+    set OS_CPUSTAT_MAGIC 0x43505553
+
+    if {$addr eq {}} {
+        set addr [symaddr os_cpustat]
+    }
+
+    set hdr [readmem $addr 20]
+    if {[bin2num $hdr 0 4] != $OS_CPUSTAT_MAGIC} {
+        puts stderr "CPU statistics magic mismatch"
+        return
+    }
+    set ntasks [bin2num $hdr  4 4]
+    set names  [bin2num $hdr 16 4]
+
+    set lnames [list Total IRQ]
+    set ptrs [readmem $names [expr {$ntasks * 4}]]
+    for {set i 0} {$i < $ntasks} {incr i} {
+        set p [bin2num $ptrs [expr {$i * 4}] 4]
+        set name "task$i"
+        if {$p} {
+            set name [string trim [lindex [split [readmem $p 16] "\0"] 0]]
+        }
+        lappend lnames $name
+    }
+
+    set data [readmem [expr {$addr + 20}] [expr {[llength $lnames] * 8}]]
+    set result {}
+    set i 0
+    puts [format "%-16s %7s %7s %12s" Name "1 s" "10 s" Cycles]
+    foreach name $lnames {
+        binary scan $data @[expr {$i * 8}]susuiu load1 load10 cycles
+        puts [format "%-16s %6.1f%% %6.1f%% %12u" $name \
+            [expr {$load1 / 10.0}] [expr {$load10 / 10.0}] $cycles]
+        lappend result [list $name $load1 $load10 $cycles]
+        incr i
+    }
+
+    return $result
+}
+
+#
+# print length of interrupt handlers and of sections with masked interrupts
+# (os_irqstat), longest first. Returns list of {name count max hist}, lengths
+# in cycles. "pirq reset" clears statistics.
+#
+proc pirq {{cmd {}} {addr {}}} {
+    set OS_IRQSTAT_MAGIC 0x49525153
+
+    if {$addr eq {}} {
+        set addr [symaddr os_irqstat]
+    }
+
+    set hdr [readmem $addr 28]
+    if {[bin2num $hdr 0 4] != $OS_IRQSTAT_MAGIC} {
+        puts stderr "interrupt statistics magic mismatch"
+        return
+    }
+    set clock   [bin2num $hdr  4 4]
+    set buckets [bin2num $hdr  8 4]
+    set shift   [bin2num $hdr 12 4]
+    set nirq    [bin2num $hdr 16 4]
+    set irq     [bin2num $hdr 20 4]
+    set site    [bin2num $hdr 24 4]
+    set esize   [expr {(2 + $buckets) * 4}]
+
+    # entries of statistics, {name address}
+    set entries {}
+    for {set i 0} {$i < $nirq} {incr i} {
+        lappend entries [list "IRQ $i" [expr {$irq + $i * $esize}]]
+    }
+    while {$site} {
+        set data [readmem $site 16]
+        set file [bin2num $data  0 4]
+        set line [bin2num $data  4 4]
+        if {$file} {
+            set name [lindex [split [readmem $file 64] "\0"] 0]
+            set name [file tail $name]
+            if {$line} {
+                append name ":$line"
+            }
+        } else {
+            set name "caller [format 0x%08X $line]"
+        }
+        lappend entries [list $name [expr {$site + 16}]]
+        set site [bin2num $data 12 4]
+    }
+
+    if {$cmd eq "reset"} {
+        foreach e $entries {
+            writemem [lindex $e 1] [string repeat "\0" $esize]
+        }
+        return
+    }
+
+    set result {}
+    foreach e $entries {
+        set data [readmem [lindex $e 1] $esize]
+        binary scan $data iu* st
+        if {[lindex $st 0] == 0} {
+            continue
+        }
+        lappend result [list [lindex $e 0] [lindex $st 0] [lindex $st 1] [lrange $st 2 end]]
+    }
+    set result [lsort -integer -decreasing -index 2 $result]
+
+    puts [format "%-24s %10s %10s  %s" Name Count "Max, us" "Histogram (less than, us: count)"]
+    foreach r $result {
+        set hist {}
+        set b 0
+        foreach n [lindex $r 3] {
+            if {$n} {
+                if {$b == $buckets - 1} {
+                    lappend hist "more:$n"
+                } else {
+                    lappend hist [format "%.2f:%u" [expr {(1 << ($b + $shift)) * 1000000.0 / $clock}] $n]
+                }
+            }
+            incr b
+        }
+        puts [format "%-24s %10u %10.2f  %s" [lindex $r 0] [lindex $r 1] \
+            [expr {[lindex $r 2] * 1000000.0 / $clock}] [join $hist " "]]
+    }
+
+    return $result
+}
+
+#
+# start or stop recording of OS events to trace buffer
+#
+proc ttr {} {
+    userf 3
+}
+
+source [file join [file dirname [info script]] trace2json.tcl]
+
+#
+# stop recording of OS events, dump trace buffer to "dump" and convert it to
+# Chrome trace JSON "out" (see trace2json.tcl)
+#
+# Address of os_tracebuf is printed by "ttr" or taken from ELF image.
+#
+proc ptrace {{out trace.json} {dump trace.bin} {addr {}}} {
+    global TRACE_NAME_SIZE TRACE_EVENT_SIZE
+
+    set OS_TRACE_MAGIC 0x54524345
+
+    if {$addr eq {}} {
+        set addr [symaddr os_tracebuf]
+    }
+
+    set hdr [readmem $addr 32]
+    if {[bin2num $hdr 0 4] != $OS_TRACE_MAGIC} {
+        puts stderr "trace buffer magic mismatch"
+        return
+    }
+
+    # stop recording
+    writemem [expr {$addr + 4}] [num2bin 0 4]
+
+    set size   [bin2num $hdr  8 4]
+    set head   [bin2num $hdr 12 4]
+    set clock  [bin2num $hdr 16 4]
+    set ntasks [bin2num $hdr 20 4]
+    set names  [bin2num $hdr 24 4]
+    set events [bin2num $hdr 28 4]
+
+    if {$head > $size} {
+        set start [expr {$head % $size}]
+        set count $size
+    } else {
+        set start 0
+        set count $head
+    }
+
+    set fd [open $dump w]
+    fconfigure $fd -translation binary
+    puts -nonewline $fd [num2bin $clock 4][num2bin $ntasks 4][num2bin $count 4]
+
+    set ptrs [readmem $names [expr {$ntasks * 4}]]
+    for {set i 0} {$i < $ntasks} {incr i} {
+        set p [bin2num $ptrs [expr {$i * 4}] 4]
+        if {$p} {
+            puts -nonewline $fd [readmem $p $TRACE_NAME_SIZE]
+        } else {
+            puts -nonewline $fd [string repeat "\0" $TRACE_NAME_SIZE]
+        }
+    }
+
+    # oldest events first, read by chunks
+    set chunk 256
+    for {set i 0} {$i < $count} {incr i $n} {
+        set idx [expr {($start + $i) % $size}]
+        set n [expr {min($chunk, $count - $i, $size - $idx)}]
+        puts -nonewline $fd [readmem [expr {$events + $idx * $TRACE_EVENT_SIZE}] \
+            [expr {$n * $TRACE_EVENT_SIZE}]]
+    }
+    close $fd
+
+    trace2json $dump $out
+}
+
 #quit ; # exit from program
 
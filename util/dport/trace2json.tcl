@@ -0,0 +1,220 @@
+#
+# convert dump of OS trace buffer (lib/os/src/os_trace.h) to Chrome trace
+# JSON, open result in chrome://tracing or https://ui.perfetto.dev
+#
+# Standalone usage:
+#     tclsh trace2json.tcl trace.bin trace.json
+#
+# Dump is written by "ptrace" command of dport.tcl, all numbers are little
+# endian:
+#     uint32 clock      frequency of timestamps, Hz
+#     uint32 ntasks     number of tasks
+#     uint32 count      number of events
+#     char   names[ntasks][TRACE_NAME_SIZE]
+#     struct os_trace_event_t events[count], oldest first
+#
+
+set TRACE_NAME_SIZE   16
+set TRACE_EVENT_SIZE  12
+# thread identifier of interrupt is TRACE_IRQ_TID + number of interrupt
+set TRACE_IRQ_TID     1000
+
+array set trace_types {
+    1 switch
+    2 wake
+    3 mutex_lock
+    4 mutex_unlock
+    5 event_raise
+    6 queue_add
+    7 queue_remove
+    8 irq_enter
+    9 irq_exit
+    10 mark
+}
+
+# OS_TASK_STATE_* of os_private.h
+array set trace_states {
+    0x00 run
+    0x10 suspend
+    0x21 wait
+    0x31 mutex
+    0x41 event
+    0x51 queue_full
+    0x61 queue_empty
+    0x71 multi
+    0x81 rmutex
+}
+
+proc trace_json_str {s} {
+    return "\"[string map {\\ \\\\ \" \\\"} $s]\""
+}
+
+#
+# write one event of Chrome trace format
+#
+proc trace_json_ev {fd first ph tid ts name {attrs {}}} {
+    upvar $first f
+
+    set s "\{\"ph\":\"$ph\",\"pid\":1,\"tid\":$tid,\"ts\":[format %.3f $ts]"
+    if {$name ne ""} {
+        append s ",\"name\":[trace_json_str $name]"
+    }
+    if {$ph eq "i"} {
+        append s ",\"s\":\"t\""
+    }
+    if {[llength $attrs]} {
+        set a {}
+        foreach {k v} $attrs {
+            lappend a "[trace_json_str $k]:[trace_json_str $v]"
+        }
+        append s ",\"args\":\{[join $a ,]\}"
+    }
+    append s "\}"
+
+    if {$f} {
+        puts $fd "  $s"
+        set f 0
+    } else {
+        puts $fd " ,$s"
+    }
+}
+
+proc trace_json_meta {fd first tid name} {
+    upvar $first f
+
+    set s "\{\"ph\":\"M\",\"pid\":1,\"tid\":$tid,\"name\":\"thread_name\",\"args\":\{\"name\":[trace_json_str $name]\}\}"
+    if {$f} {
+        puts $fd "  $s"
+        set f 0
+    } else {
+        puts $fd " ,$s"
+    }
+}
+
+#
+# convert dump file "in" to JSON file "out"
+#
+proc trace2json {in out} {
+    global TRACE_NAME_SIZE TRACE_EVENT_SIZE TRACE_IRQ_TID
+    global trace_types trace_states
+
+    set fd [open $in r]
+    fconfigure $fd -translation binary
+    set data [read $fd]
+    close $fd
+
+    binary scan $data iuiuiu clock ntasks count
+    set off 12
+    for {set i 0} {$i < $ntasks} {incr i} {
+        set name [string range $data $off [expr {$off + $TRACE_NAME_SIZE - 1}]]
+        set name [lindex [split $name "\0"] 0]
+        if {$name eq ""} {
+            set name "task$i"
+        }
+        set names($i) $name
+        incr off $TRACE_NAME_SIZE
+    }
+
+    set fd [open $out w]
+    puts $fd "\{\"displayTimeUnit\":\"ns\",\"traceEvents\":\["
+    set first 1
+
+    for {set i 0} {$i < $ntasks} {incr i} {
+        trace_json_meta $fd first $i $names($i)
+    }
+
+    set running -1
+    set irqs {}
+    set ts 0.0
+    set t 0
+    for {set i 0} {$i < $count} {incr i; incr off $TRACE_EVENT_SIZE} {
+        binary scan $data @${off}iucucusuiu time type task info arg
+
+        # timestamps are 32-bit counter, unwrap them
+        if {$i == 0} {
+            set prev $time
+        }
+        set delta [expr {($time - $prev) & 0xffffffff}]
+        if {$delta >= 0x80000000} {
+            # interrupt recorded event with later slot and earlier timestamp
+            set delta [expr {$delta - 0x100000000}]
+        }
+        incr t $delta
+        set prev $time
+        set ts [expr {$t * 1000000.0 / $clock}]
+
+        if {$running < 0} {
+            set running $task
+            trace_json_ev $fd first B $running $ts "run"
+        }
+
+        set obj [format 0x%08X $arg]
+        switch -- $type {
+            1 {
+                set next  [expr {$info & 0xff}]
+                set state [format 0x%02X [expr {($info >> 8) & 0xff}]]
+                if {[info exists trace_states($state)]} {
+                    set state $trace_states($state)
+                }
+                trace_json_ev $fd first E $running $ts "" [list state $state object $obj]
+                set running $next
+                trace_json_ev $fd first B $running $ts "run"
+            }
+            8 {
+                set tid [expr {$TRACE_IRQ_TID + $info}]
+                if {![info exists irqname($tid)]} {
+                    set irqname($tid) 1
+                    trace_json_meta $fd first $tid "IRQ $info"
+                }
+                lappend irqs $tid
+                trace_json_ev $fd first B $tid $ts "IRQ $info"
+            }
+            9 {
+                set tid [expr {$TRACE_IRQ_TID + $info}]
+                # skip exit of interrupt entered before start of trace
+                set idx [lsearch -exact $irqs $tid]
+                if {$idx >= 0} {
+                    set irqs [lreplace $irqs $idx $idx]
+                    trace_json_ev $fd first E $tid $ts ""
+                }
+            }
+            10 {
+                trace_json_ev $fd first i $task $ts "mark $info" [list value $arg]
+            }
+            default {
+                if {[info exists trace_types($type)]} {
+                    set name $trace_types($type)
+                } else {
+                    set name "type $type"
+                }
+                if {$type == 2 && [info exists names($info)]} {
+                    set attrs [list task $names($info) object $obj]
+                } else {
+                    set attrs [list info $info object $obj]
+                }
+                trace_json_ev $fd first i $task $ts $name $attrs
+            }
+        }
+    }
+
+    # close slices which are open at end of trace
+    if {$running >= 0} {
+        trace_json_ev $fd first E $running $ts ""
+    }
+    foreach tid $irqs {
+        trace_json_ev $fd first E $tid $ts ""
+    }
+
+    puts $fd "\]\}"
+    close $fd
+
+    puts "$count events, [format %.3f [expr {$ts / 1000.0}]] ms"
+}
+
+if {[info exists argv0] && [file tail $argv0] eq [file tail [info script]]} {
+    if {[llength $argv] != 2} {
+        puts stderr "usage: tclsh trace2json.tcl trace.bin trace.json"
+        exit 1
+    }
+    trace2json [lindex $argv 0] [lindex $argv 1]
+}
@@ -0,0 +1,281 @@
+#
+# compute worst case stack usage of tasks from call graph of objects and
+# generate header with stack sizes of tasks
+#
+# Usage:
+#     tclsh stackusage.tcl ?options? file.ci ...
+#
+#     -tasks file         source that specifies stacks of tasks by
+#                         OSW_STACK_SIZE(entry), entry is function of task
+#     -out file           generated header, OSW_STACK_<entry> for every task
+#     -calls list         targets of indirect calls, list of pairs
+#                         {caller {callee ...}}, caller is glob pattern
+#                         matched against "file.c:name" of function
+#     -recursion list     bound of recursion, list of pairs {function depth}
+#     -extra n            bytes added to worst case (context of task saved by
+#                         scheduler, frame stacked by interrupt), default 128
+#     -margin n           percents added to worst case, default 25
+#     -align n            size of stack is multiple of n bytes, default 256
+#
+# Call graph is written by GCC 10 or newer with -fcallgraph-info=su option
+# (one .ci file per object, VCG format). Function that is inlined is part of
+# caller. Functions without stack information (libc, assembler) and indirect
+# calls without targets specified by -calls are counted as zero and listed as
+# unknown, recursion without bound is cut and listed too.
+#
+
+set STACK_DEFAULT   "(32 * 1024)"
+set STACK_INDIRECT  __indirect_call
+
+#
+# read call graph from .ci file
+#
+proc su_read {path} {
+    global su_size su_dynamic su_callees su_src
+
+    set fd [open $path r]
+    set data [read $fd]
+    close $fd
+
+    foreach line [split $data "\n"] {
+        if {[regexp {^node: \{ title: "([^"]+)" label: "([^"]*)"} $line -> title label]} {
+            if {[regexp {\\n(\d+) bytes \(([^)]*)\)} $label -> bytes kind]} {
+                set su_size($title) $bytes
+                if {$kind ne "static"} {
+                    set su_dynamic($title) $kind
+                }
+                if {[regexp {^[^\\]*\\n([^:]+):\d+} $label -> src]} {
+                    set su_src($title) "$src:[su_name $title]"
+                }
+            }
+            if {![info exists su_callees($title)]} {
+                set su_callees($title) {}
+            }
+        } elseif {[regexp {^edge: \{ sourcename: "([^"]+)" targetname: "([^"]+)"} $line -> src dst]} {
+            if {[lsearch -exact $su_callees($src) $dst] < 0} {
+                lappend su_callees($src) $dst
+            }
+        }
+    }
+}
+
+#
+# find function by name, static function is found by name without file
+#
+proc su_resolve {name} {
+    global su_size
+
+    if {[info exists su_size($name)]} {
+        return $name
+    }
+    set found [array names su_size "*:$name"]
+    if {[llength $found] == 1} {
+        return [lindex $found 0]
+    }
+    if {[llength $found] > 1} {
+        puts stderr "warning: $name is ambiguous ([join $found {, }])"
+    }
+    return $name
+}
+
+#
+# targets of indirect calls of function
+#
+proc su_indirect {fn} {
+    global su_calls su_src
+
+    set targets {}
+    foreach {pattern callees} $su_calls {
+        if {[info exists su_src($fn)] && [string match $pattern $su_src($fn)]} {
+            foreach c $callees {
+                lappend targets [su_resolve $c]
+            }
+        }
+    }
+    return $targets
+}
+
+#
+# worst case of stack usage of function and its callees
+#
+# RETURN
+#     list {bytes path unknown}, path is list of functions of worst case,
+#     unknown is list of functions, indirect calls and recursions that are
+#     not counted
+#
+proc su_worst {fn} {
+    global su_size su_callees su_memo su_path su_depth STACK_INDIRECT
+
+    if {[info exists su_memo($fn)]} {
+        return $su_memo($fn)
+    }
+    if {![info exists su_size($fn)]} {
+        return [list 0 [list $fn] [list $fn]]
+    }
+
+    set su_path($fn) 1
+    set unknown {}
+    set callees {}
+    foreach c $su_callees($fn) {
+        if {$c eq $STACK_INDIRECT} {
+            set targets [su_indirect $fn]
+            if {![llength $targets]} {
+                lappend unknown "indirect call of [su_name $fn]"
+            }
+            set callees [concat $callees $targets]
+        } else {
+            lappend callees $c
+        }
+    }
+
+    set max 0
+    set maxpath {}
+    foreach c $callees {
+        if {[info exists su_path($c)]} {
+            if {$c ne $fn || ![info exists su_depth($fn)]} {
+                lappend unknown "recursion [su_name $fn] > [su_name $c]"
+            }
+            continue
+        }
+        lassign [su_worst $c] bytes path u
+        set unknown [concat $unknown $u]
+        if {$bytes > $max || ![llength $maxpath]} {
+            set max $bytes
+            set maxpath $path
+        }
+    }
+    unset su_path($fn)
+
+    set own $su_size($fn)
+    if {[info exists su_depth($fn)]} {
+        set own [expr {$own * $su_depth($fn)}]
+    }
+    set su_memo($fn) [list [expr {$own + $max}] [concat [list $fn] $maxpath] [lsort -unique $unknown]]
+    return $su_memo($fn)
+}
+
+#
+# entry points of tasks in order of OSW_STACK_SIZE() in source
+#
+proc su_tasks {path} {
+    set fd [open $path r]
+    set data [read $fd]
+    close $fd
+
+    set tasks {}
+    foreach {-> entry} [regexp -all -inline {OSW_STACK_SIZE\((\w+)\)} $data] {
+        if {$entry ne "entry" && [lsearch -exact $tasks $entry] < 0} {
+            lappend tasks $entry
+        }
+    }
+    return $tasks
+}
+
+proc su_name {fn} {
+    return [lindex [split $fn :] end]
+}
+
+proc stackusage {argv} {
+    global su_calls su_depth su_dynamic STACK_DEFAULT
+
+    set su_calls {}
+    set tasksrc {}
+    set out {}
+    set extra 128
+    set margin 25
+    set align 256
+    set files {}
+    while {[llength $argv]} {
+        set argv [lassign $argv arg]
+        switch -- $arg {
+            -tasks     { set argv [lassign $argv tasksrc] }
+            -out       { set argv [lassign $argv out] }
+            -calls     { set argv [lassign $argv su_calls] }
+            -recursion { set argv [lassign $argv recursion] }
+            -extra     { set argv [lassign $argv extra] }
+            -margin    { set argv [lassign $argv margin] }
+            -align     { set argv [lassign $argv align] }
+            default    { lappend files $arg }
+        }
+    }
+    if {$tasksrc eq "" || ![llength $files]} {
+        puts stderr "usage: tclsh stackusage.tcl -tasks osw_objects.c ?-out osw_stack.h? ?options? file.ci ..."
+        exit 1
+    }
+
+    foreach f $files {
+        su_read $f
+    }
+    if {[info exists recursion]} {
+        foreach {fn depth} $recursion {
+            set su_depth([su_resolve $fn]) $depth
+        }
+    }
+
+    set lines {}
+    set total {}
+    foreach entry [su_tasks $tasksrc] {
+        set fn [su_resolve $entry]
+        if {![info exists ::su_size($fn)]} {
+            puts stderr "warning: task $entry not found in call graph, default size"
+            lappend lines "/* $entry not found in call graph */"
+            lappend lines [format "#define %-32s %s" OSW_STACK_$entry OSW_STACK_DEFAULT]
+            lappend total OSW_STACK_DEFAULT
+            continue
+        }
+
+        lassign [su_worst $fn] worst path unknown
+        set size [expr {($worst + $extra) * (100 + $margin) / 100}]
+        set size [expr {($size + $align - 1) / $align * $align}]
+
+        set names {}
+        foreach p $path {
+            lappend names [su_name $p]
+        }
+        foreach p $path {
+            if {[info exists su_dynamic($p)]} {
+                lappend unknown "[su_name $p] ($su_dynamic($p))"
+            }
+        }
+
+        puts [format "%-20s %7d %7d  %s" $entry $worst $size [join $names " > "]]
+        if {[llength $unknown]} {
+            puts "    unknown: [join $unknown {, }]"
+        }
+
+        lappend lines "/* worst $worst: [join $names { > }] */"
+        if {[llength $unknown]} {
+            lappend lines "/* unknown: [join $unknown {, }] */"
+        }
+        lappend lines [format "#define %-32s %d" OSW_STACK_$entry $size]
+        lappend total OSW_STACK_$entry
+    }
+
+    if {$out eq ""} {
+        return
+    }
+    set fd [open $out w]
+    puts $fd "/*"
+    puts $fd " * Stack sizes of tasks, generated by util/stackusage.tcl (\"make stack\"),"
+    puts $fd " * do not edit."
+    puts $fd " *"
+    puts $fd " * size = (worst + $extra) * (100 + $margin) / 100, multiple of $align"
+    puts $fd " */"
+    puts $fd "#ifndef OSW_STACK_H"
+    puts $fd "#define OSW_STACK_H"
+    puts $fd ""
+    puts $fd "#define OSW_STACK_DEFAULT    $STACK_DEFAULT"
+    puts $fd ""
+    foreach l $lines {
+        puts $fd $l
+    }
+    puts $fd ""
+    puts $fd "#define OSW_STACK_SPOOL_SIZE ([join $total { + }])"
+    puts $fd ""
+    puts $fd "#endif"
+    close $fd
+}
+
+if {[info exists argv0] && [file tail $argv0] eq [file tail [info script]]} {
+    stackusage $argv
+}